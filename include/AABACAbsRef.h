@@ -8,12 +8,12 @@ typedef struct AbsRef {
     int round;
 
     // The set of rules selected by the forward rule-selection strategy
-    HashSet *pSetF;
+    IntSet *pSetF;
     HashMap *pMapReachableAVs;
     HashMap *pMapReachableAVsInc;
 
     // The set of rules selected by the backward rule-selection strategy
-    HashSet *pSetB;
+    IntSet *pSetB;
     HashMap *pMapUsefulAVs;
     HashMap *pMapUsefulAVsInc;
 
@@ -22,6 +22,10 @@ typedef struct AbsRef {
 
     // The global rule list before abstraction refinement
     Vector *pOriVecRules;
+    // The compiled form of @{pOriVecRules}
+    RuleStore *pOriRuleStore;
+    // The memory pool of the current round, holding the user conditions of the cloned rules
+    Pool *pRoundPool;
 } AbsRef;
 
 /**
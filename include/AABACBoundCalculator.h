@@ -13,4 +13,14 @@
  */
 BigInteger computeBound(AABACInstance *pInst, int tightLevel);
 
+/**
+ * Estimate the length of the shortest counterexample of an AABAC instance, i.e. a lower bound on the number of actions
+ * that reach the safety query. It is the larger of the number of query attributes not initially at their query values,
+ * and the number of forward reachability layers (as in forward slicing) needed to reach all the query attribute values.
+ * 
+ * @param pInst[in]: The AABAC instance
+ * @return The estimated length, or -1 if the query attribute values are not all forward reachable
+ */
+int computeQueryDepth(AABACInstance *pInst);
+
 #endif // AABAC_BOUND_CALCULATOR_H
@@ -11,6 +11,18 @@
  */
 AABACInstance *readAABACInstance(char *filename);
 
+/**
+ * Read an AABAC instance from a file, loading only the rules that may lead to the safety query.
+ * Rule lines are first indexed by their targets; once the query is read, only the rules reachable backwards
+ * from the query attribute-value pairs (through both admin and user conditions) have their conditions parsed.
+ * The loaded rules are a superset of what @{backwardSlice} keeps on the full instance, so the verification result
+ * is unchanged, but attribute domains only cover the loaded rules. Non-regular files are read in full.
+ *
+ * @param filename[in]: The path of the file to read
+ * @return The AABAC instance
+ */
+AABACInstance *readAABACInstanceForQuery(char *filename);
+
 /**
  * Read an ARBAC instance from a file and convert it to an AABAC instance
  * 
@@ -28,4 +40,41 @@ AABACInstance *readARBACInstance(char *filename);
  */
 int writeAABACInstance(AABACInstance *pInst, char *filename);
 
+/**
+ * Write an AABAC instance to a file on a background writer thread.
+ * The instance and the rules it uses are copied before the function returns, so the caller may modify or finalize
+ * the instance, or replace the global rule list, right away. The copies are written in the order of the calls.
+ * 
+ * @param pInst[in]: The AABAC instance to write
+ * @param filename[in]: The path of the file to write
+ * @return 0 if the instance is queued, -1 if failed
+ */
+int writeAABACInstanceAsync(AABACInstance *pInst, char *filename);
+
+/**
+ * Wait until every instance queued by @{writeAABACInstanceAsync} has been written, then stop the writer thread.
+ * 
+ * @return The number of queued instances that failed to be written
+ */
+int waitAABACWrites();
+
+/**
+ * Write an initialized AABAC instance, together with the global symbol tables, conditions and rules,
+ * to a binary image that @{readAABACImage} loads without parsing or calling @{init}
+ * 
+ * @param pInst[in]: The AABAC instance to write, which must have been initialized by @{init}
+ * @param filename[in]: The path of the image file to write
+ * @return 0 if write successfully, -1 if failed
+ */
+int writeAABACImage(AABACInstance *pInst, char *filename);
+
+/**
+ * Read an AABAC instance from a binary image written by @{writeAABACImage}.
+ * The global variables are set up as if the original policy had been read and initialized.
+ * 
+ * @param filename[in]: The path of the image file to read
+ * @return The initialized AABAC instance, or NULL if the image cannot be read
+ */
+AABACInstance *readAABACImage(char *filename);
+
 #endif
\ No newline at end of file
@@ -4,32 +4,40 @@
 #include "ccl/containers.h"
 #include "ccl/ccl_internal.h"
 #include "hashBasedTable.h"
-#include "AABACRule.h"
+#include "packedTable.h"
+#include "frozenDict.h"
+#include "ruleStore.h"
 
 typedef struct _AABACInstance
 {
+    // The memory pool of the instance
+    // The instance itself and all its members except @{pVecUserIndices} are allocated from the pool,
+    // so that finalizing the instance releases them at once
+    Pool *pool;
+
     // List of user indices
     Vector *pVecUserIndices;
     
     // A map from an attribute to its domain
-    // The attribute domain is a hashset of value indices
+    // The attribute domain is an IntSet of value indices
     HashMap *pMapAttr2Dom;
 
     // A map from a user-attribute pair to the initial value
     // E.g., if in the initial state, the value of attribute a for user u is v, then (u, a) -> v
     HashBasedTable *pTableInitState;
     
-    // List of rule indices
-    HashSet *pSetRuleIdxes;
+    // Set of rule indices
+    IntSet *pSetRuleIdxes;
 
-    // A map from an attribute-value pair to a set of rules whose target is the pair
+    // A map from an attribute-value pair to a set (IntSet) of rules whose target is the pair
     // E.g., if rule r=(cond1, cond2, a, v), then (a, v) -> {r}
-    HashBasedTable *pTableTargetAV2Rule;
+    // The row view is enabled, so the values of an attribute can be enumerated with GetRow
+    PackedTable *pTableTargetAV2Rule;
 
-    // A map from an attribute-value pair to a set of rules for which the pair is necessary for the rule to fire
+    // A map from an attribute-value pair to a set (IntSet) of rules for which the pair is necessary for the rule to fire
     // Note: the admin condition is ignored
     // E.g., if rule r=(a'=v', a1=v1 & a2=v2, a3, v3), then (a1, v1) -> {r}, (a2, v2) -> {r}
-    HashBasedTable *pTablePrecond2Rule;
+    PackedTable *pTablePrecond2Rule;
     
     // The index of the target user in the safety query
     int queryUserIdx;
@@ -39,6 +47,12 @@ typedef struct _AABACInstance
     HashMap *pmapQueryAVs;
 } AABACInstance;
 
+// A rendered attribute value, see @{getValueToken}
+typedef struct _ValueToken {
+    char *str; // 以'\0'结尾的取值字符串
+    int len;   // 字符串长度
+} ValueToken;
+
 // A global string list storing all user names
 extern strCollection *pscUsers;
 
@@ -57,15 +71,23 @@ extern strCollection *pscValues;
 // A global map from string values to their indices in the @{pscValues} list
 extern Dictionary *pdictValue2Index;
 
-// A global map from attribute indices to their data types
-extern HashMap *pmapAttr2Type;
+// A global array from attribute indices to their data types
+// Attribute indices are dense, so the entry of attribute a is pAttr2Type[a]
+extern AttrType *pAttr2Type;
 
-// A global map from attribute indices to the indices of their default values
-extern HashMap *pmapAttr2DefVal;
+// A global array from attribute indices to the indices of their default values
+extern int *pAttr2DefVal;
+
+// The number of attributes recorded in @{pAttr2Type} and @{pAttr2DefVal}
+extern int nAttrMeta;
 
 // A global list storing all rules (NOT rule pointers)
 extern Vector *pVecRules;
 
+// The compiled form of @{pVecRules}, built by @{init}
+// Whoever modifies the user condition of a rule afterwards must recompile it with iRuleStore.Update
+extern RuleStore *pRuleStore;
+
 /**
  * Allocate memory for the global variables
  */
@@ -76,6 +98,13 @@ void initGlobalVars();
  */
 void finalizeGlobalVars();
 
+/**
+ * Freeze the name dictionaries @{pdictUser2Index}, @{pdictAttr2Index} and @{pdictValue2Index} into minimal perfect hash tables.
+ * Called once the policy has been read; afterwards @{getUserIndex}, @{getAttrIndex} and @{getValueIndex} resolve
+ * a known name with one hash and one string comparison. Names added after the freeze are still found in the dictionaries.
+ */
+void freezeSymbolTables();
+
 /**
  * Create an AABAC instance and allocate memory for its members.
  * 
@@ -84,12 +113,56 @@ void finalizeGlobalVars();
 AABACInstance *createAABACInstance();
 
 /**
- * Free the memory allocated for the instance and its members.
+ * Free the memory allocated for the instance and its members by releasing its memory pool.
+ * Objects taken from the instance (e.g. the attribute domain map) become invalid as well.
  * 
  * @param pInst[in] A pointer to the AABAC instance to be finalized
  */
 void finalizeAABACInstance(AABACInstance *pInst);
 
+/**
+ * Copy the initial state @{pTableInitState} of an instance into another instance.
+ * The attribute domain of the destination is not updated.
+ * 
+ * @param pDst[in] The destination instance
+ * @param pSrc[in] The source instance
+ */
+void copyInitState(AABACInstance *pDst, AABACInstance *pSrc);
+
+/**
+ * Copy the safety query, i.e. @{queryUserIdx} and @{pmapQueryAVs}, of an instance into another instance.
+ * 
+ * @param pDst[in] The destination instance
+ * @param pSrc[in] The source instance
+ */
+void copyQuery(AABACInstance *pDst, AABACInstance *pSrc);
+
+/**
+ * Record the datatype and default value of a newly declared attribute in @{pAttr2Type} and @{pAttr2DefVal}.
+ * The arrays grow as needed; the attribute index must be the next index, i.e. @{nAttrMeta}.
+ * 
+ * @param attrIdx[in] The index of the attribute
+ * @param attrType[in] The datatype of the attribute
+ * @param defValIdx[in] The index of the default value
+ */
+void addAttrMeta(int attrIdx, AttrType attrType, int defValIdx);
+
+/**
+ * Overwrite the default value of a declared attribute.
+ * 
+ * @param attrIdx[in] The index of the attribute
+ * @param defValIdx[in] The index of the default value
+ */
+void setAttrDefVal(int attrIdx, int defValIdx);
+
+/**
+ * Get the index of the default value of an attribute.
+ * 
+ * @param attrIdx[in] The index of the attribute
+ * @return The index of the default value
+ */
+int getAttrDefVal(int attrIdx);
+
 /**
  * Get the index of a user in the global list of users @{pscUsers}.
  * 
@@ -122,6 +195,18 @@ int getAttrIndex(char *attr);
  */
 int getValueIndex(AttrType attrType, char *value, int *pValueIdx);
 
+/**
+ * Get the index of a given attribute value like @{getValueIndex}, but never add a string value to @{pscValues}.
+ * It only reads the global dictionaries, so several threads may call it as long as none of them modifies the dictionaries.
+ *
+ * @param attrType[in] The datatype of the attribute
+ * @param value[in] An attribute value
+ * @param pValueIdx[out] A pointer to the index of the value
+ * @return 0 if the value index is successfully obtained, 1 if the attribute is string and the value is not in @{pscValues} yet,
+ *      or -1 if the value is illegal for the datatype
+ */
+int findValueIndex(AttrType attrType, char *value, int *pValueIdx);
+
 /**
  * Get the datatype of an attribute.
  * 
@@ -143,13 +228,34 @@ AttrType getAttrTypeByIdx(int attrIdx);
  * If the attribute is boolean, the value is "true" if the index is 1, and "false" if the index is 0.
  * If the attribute is integer, the value is the integer itself.
  * If the attribute is string, the value is the string in the global list of strings @{pscValues} indexed by the given index.
+ * The value is taken from the value token table (see @{getValueToken}), so it must not be freed or modified.
  * 
  * @param attrType[in] The datatype of the attribute
  * @param valueIdx[in] The index of the value
- * @return The corresponding value
+ * @return The corresponding value, valid until @{finalizeGlobalVars}
  */
 char *getValueByIndex(AttrType attrType, int valueIdx);
 
+/**
+ * Render every value that may appear in the attribute domains of an instance into the global value token table.
+ * Called at the end of @{init}; afterwards @{getValueToken} and @{getValueByIndex} find these values with one array access.
+ * Calling it again rebuilds the table.
+ * 
+ * @param pInst[in] The AABAC instance
+ */
+void buildValueTokens(AABACInstance *pInst);
+
+/**
+ * Get the pre-rendered string of an attribute value together with its length.
+ * Values not covered by @{buildValueTokens} are rendered on first use and kept until @{finalizeGlobalVars},
+ * so the returned token is always stable. Several threads may call it concurrently.
+ * 
+ * @param attrType[in] The datatype of the attribute
+ * @param valueIdx[in] The index of the value
+ * @return The token of the value, which must not be freed or modified
+ */
+const ValueToken *getValueToken(AttrType attrType, int valueIdx);
+
 /**
  * Get the initial value of an attribute for a given user.
  * 
@@ -184,18 +290,39 @@ int addUAV(AABACInstance *pInst, char *user, char *attr, char *value);
  */
 int addUAVByIdx(AABACInstance *pInst, int userIdx, int attrIdx, int valueIdx);
 
+/**
+ * Add a value to the domain of an attribute in @{pMapAttr2Dom} without touching the initial state.
+ * 
+ * @param pInst[in] The AABAC instance
+ * @param attrIdx[in] The index of the attribute
+ * @param valueIdx[in] The index of the value
+ */
+void addAVByIdx(AABACInstance *pInst, int attrIdx, int valueIdx);
+
 /**
  * Add a rule index to the list of rule indices @{pSetRuleIdxes} of the AABAC instance.
  * The attribute domain @{pMapAttr2Dom}, tables @{pTableTargetAV2Rule} and @{pTablePrecond2Rule} are updated accordingly.
  * 
+ * Rules are identified by index only; rules with the same content are merged by @{dedupRules} and @{init}.
+ * 
  * @param pInst[in] The AABAC instance
  * @param ruleIdx[in] The index of the rule
- * @return 1 if the rule is successfully added, 0 if the rule already exists
+ * @return 1 if the rule is successfully added, 0 if the rule index already exists
  */
 int addRule(AABACInstance *pInst, int ruleIdx);
 
+/**
+ * Remove rules whose content equals that of another rule in the instance, keeping the one with the smallest index.
+ * The tables @{pTableTargetAV2Rule} and @{pTablePrecond2Rule} are rebuilt if any rule is removed.
+ * 
+ * @param pInst[in] The AABAC instance
+ * @return The number of removed rules
+ */
+int dedupRules(AABACInstance *pInst);
+
 /**
  * Initialize the AABAC instance.
+ * The user conditions of the rules are discretized and the global rule store @{pRuleStore} is compiled.
  * 
  * @param pInst[in] The AABAC instance
  */
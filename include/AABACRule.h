@@ -3,6 +3,7 @@
 
 #include "ccl/containers.h"
 #include "hashSet.h"
+#include "intSet.h"
 
 /* The comparison operator. {=, !=, <, >, <=, >=} */
 typedef enum {
@@ -28,33 +29,58 @@ typedef struct {
     comparisonOperator op;
 } AtomCondition;
 
+/*
+ * A condition, i.e. a conjunction of atomic conditions. Conditions are hash-consed: identical conditions are
+ * stored once in a global condition table and shared by all rules, so two conditions are equal iff they are
+ * the same object (equivalently, have the same id). A condition is immutable once interned.
+ */
+typedef struct _Condition {
+    HashSet *atoms;        // 原子条件（AtomCondition）集合，空集表示TRUE
+    unsigned int hashCode; // 内容哈希，等于iHashSet.HashCode(&atoms)
+    int id;                // 在条件表中的编号，从0开始连续分配
+} Condition;
+
 /* A rule, consisting of an administrator condition, a user condition, a target attribute, and a target value. */
 typedef struct _Rule {
-    HashSet *adminCond;
-    HashSet *userCond;
+    Condition *adminCond;
+    Condition *userCond;
     int targetAttrIdx;
     int targetValueIdx;
 
-    // The map from an attribute to the set of its values that can satisfy the user condition
+    // The map from an attribute to the set (IntSet) of its values that can satisfy the user condition
     HashMap *pmapUserCondValue;
+
+    // The cached content hash, refreshed by Create and DiscreteCond
+    unsigned int hashCode;
 } Rule;
 
 typedef struct _AtomConditionInterface {
     int (*Evaluate)(AtomCondition *atomCond, int valIdx);
-    void (*FindEffectiveValues)(AtomCondition *atomdCond, HashSet *domain, HashSet *effectiveValues);
+    void (*FindEffectiveValues)(AtomCondition *atomdCond, IntSet *domain, IntSet *effectiveValues);
     unsigned int (*HashCode)(void *pAtomCond);
     int (*Equal)(void *pAtomCond1, void *pAtomCond2);
 } AtomConditionInterface;
 
 extern AtomConditionInterface iAtomCondition;
 
+typedef struct _ConditionInterface {
+    Condition *(*Intern)(HashSet *atoms); // 返回与atoms内容相同的共享条件，atoms的所有权转移给条件表（已存在时被释放）
+    Condition *(*True)(void);             // 返回共享的空条件
+    Condition *(*GetById)(int id);
+    int (*Count)(void);                   // 条件表中的条件数，即下一个分配的编号
+    void (*ClearTable)(void);             // 释放条件表中的所有条件
+} ConditionInterface;
+
+extern ConditionInterface iCondition;
+
 typedef struct _RuleInterface {
-    Rule *(*Create)(HashSet *adminCond, HashSet *userCond, int targetAttrIdx, int targetValueIdx);
+    Rule *(*Create)(HashSet *adminCond, HashSet *userCond, int targetAttrIdx, int targetValueIdx); // 两个条件经iCondition.Intern驻留
     int (*DiscreteCond)(Rule *r, HashMap *reachableAVs);
     int (*CanBeManaged)(Rule *r, HashMap *userState);
     int (*IsEffective)(Rule *r, HashMap *reachableAVs);
     unsigned int (*HashCode)(void *pRule);
     int (*Equal)(void *pRule1, void *pRule2);
+    void (*UpdateHashCode)(Rule *r); // 规则条件被修改后刷新缓存的哈希值
 } RuleInterface;
 
 extern RuleInterface iRule;
@@ -3,4 +3,16 @@
 #define ALIAS_SUFFIX "_2"
 #define ALIAS_SUFFIX_LEN 2
 
-int translate(AABACInstance *instance, char *nusmvFilePath, int sliced);
\ No newline at end of file
+/**
+ * Translate an AABAC instance into a NuSMV model. The model is assembled in a large output buffer
+ * from pre-rendered attribute and value tokens, so translation costs no allocation per emitted value.
+ *
+ * @param instance[in]: The AABAC instance to translate
+ * @param nusmvFilePath[in]: The path of the NuSMV file to write
+ * @param sliced[in]: Whether the attribute domains have been computed by slicing already
+ * @param ruleComments[in]: Whether to precede each case branch with a comment showing the rule it comes from
+ * @param invarSpec[in]: Whether to state the query as an INVARSPEC invariant instead of an LTLSPEC G formula,
+ *                       so that the invariant engines of the model checker can be used
+ * @return 0 if the model is written successfully, -1 otherwise
+ */
+int translate(AABACInstance *instance, char *nusmvFilePath, int sliced, int ruleComments, int invarSpec);
\ No newline at end of file
@@ -3,7 +3,181 @@
 
 #include "AABACResult.h"
 
-char *runModelChecker(char *modelCheckerPath, char *nusmvFilePath, char *resultFilePath, long timeout, char *bound);
+/* Model checking engines */
+#define MC_ENGINE_BMC 0        // bounded model checking up to the bound
+#define MC_ENGINE_BDD 1        // BDD-based symbolic model checking (smc)
+#define MC_ENGINE_IC3 2        // IC3
+#define MC_ENGINE_KIND 3       // k-induction up to the bound, INVARSPEC models only
+#define MC_ENGINE_BMC_LENGTH 4 // BMC of paths of exactly the bound (one problem per length), used by iterative deepening
+
+/**
+ * Create an anonymous in-memory file to hold a NuSMV model, so that the model does not go through the log directory.
+ * The model checker opens the model through the returned /proc/<pid>/fd path, which also works for a session
+ * started before the file was created.
+ * Translating into the path truncates the file, so the same file may be reused.
+ *
+ * @param name[in]: The name of the in-memory file, only shown in /proc
+ * @param pPath[out]: The path to pass to @{translate} and @{runModelChecker}, which the caller frees
+ * @return The file descriptor, which the caller closes, or -1 if in-memory files are not supported
+ */
+int createModelMemFile(char *name, char **pPath);
+
+/**
+ * Copy the NuSMV model held in an in-memory file to a regular file.
+ *
+ * @param fd[in]: The descriptor returned by @{createModelMemFile}
+ * @param filePath[in]: The path of the file to write
+ * @return 0 if the model is written successfully, -1 otherwise
+ */
+int saveModelMemFile(int fd, char *filePath);
+
+/**
+ * Set the files BMC progress is kept in. When BMC on an LTLSPEC model times out, the deepest length it has checked
+ * without finding a counterexample is appended to the record file, together with a fingerprint of the model. When the
+ * same model is checked with BMC again and the resume file has a length for it, BMC continues from the next length
+ * (one problem per length, like plain BMC) instead of starting over.
+ *
+ * @param recordPath[in]: The file to append progress to, or NULL not to record it; it must stay valid
+ * @param resumePath[in]: The file to read progress from, or NULL not to resume; it must stay valid
+ */
+void setBMCProgressFiles(char *recordPath, char *resumePath);
+
+/**
+ * Read the deepest BMC length recorded for a model from a progress file. Each line of the file is
+ * "<fingerprint> <length>", the fingerprint in hexadecimal; a model may have several lines, of which the deepest wins.
+ *
+ * @param path[in]: The progress file
+ * @param fingerprint[in]: The fingerprint of the model
+ * @return The deepest length checked without a counterexample, or -1 if the file has none for the model
+ */
+int loadBMCProgress(char *path, unsigned long long fingerprint);
+
+/**
+ * Append the deepest BMC length checked for a model to a progress file, in the format read by @{loadBMCProgress}.
+ *
+ * @param path[in]: The progress file
+ * @param fingerprint[in]: The fingerprint of the model
+ * @param depth[in]: The deepest length checked without a counterexample
+ * @return 0 if the line is written successfully, -1 otherwise
+ */
+int saveBMCProgress(char *path, unsigned long long fingerprint, int depth);
+
+/**
+ * Run the model checker on a NuSMV model. The output is parsed line by line as it arrives and copied to the result file.
+ * As soon as the verdict and the whole counterexample trace have been read, the model checker is killed without
+ * waiting for it to exit on its own. BDD, and BMC on an LTLSPEC model, run in batch mode; the other engines run
+ * their commands (e.g. check_invar_ic3, check_invar_bmc -a een-sorensson) from a -source script.
+ *
+ * @param modelCheckerPath[in]: The path of the model checker
+ * @param nusmvFilePath[in]: The path of the NuSMV model
+ * @param resultFilePath[in]: The path of the file to copy the output of the model checker to
+ * @param timeout[in]: The timeout in seconds, which may be fractional
+ * @param engine[in]: The engine, one of MC_ENGINE_*
+ * @param invarSpec[in]: Whether the query of the model is an INVARSPEC rather than an LTLSPEC
+ * @param bound[in]: The bound of BMC and k-induction, or NULL to use the default of the model checker
+ * @param pInst[in]: The AABAC instance the model is translated from
+ * @param showRules[in]: Whether to find the rules associated with the actions of a counterexample
+ * @return The result of the model checking
+ */
+AABACResult runModelChecker(char *modelCheckerPath, char *nusmvFilePath, char *resultFilePath, double timeout, int engine, int invarSpec,
+                            char *bound, AABACInstance *pInst, int showRules);
+
+/**
+ * Race several engines on the same NuSMV model: BMC at the given bound, BDD-based SMC, IC3, and k-induction for
+ * INVARSPEC models. At most maxEngines of them run at a time, the next one starting when one ends without a conclusion.
+ * The first conclusive answer is returned and the other engines are killed. The output of each engine is copied to
+ * the result file path with the engine name inserted before the suffix, e.g. smvOutput0.smc.txt.
+ *
+ * @param modelCheckerPath[in]: The path of the model checker
+ * @param nusmvFilePath[in]: The path of the NuSMV model
+ * @param resultFilePath[in]: The path the result files of the engines are derived from
+ * @param timeout[in]: The timeout in seconds of the whole portfolio, which may be fractional
+ * @param bound[in]: The bound of the BMC engine, or NULL to leave BMC out
+ * @param boundConclusive[in]: Whether finding no counterexample up to the bound proves the query unreachable
+ * @param invarSpec[in]: Whether the query of the model is an INVARSPEC rather than an LTLSPEC
+ * @param maxEngines[in]: The maximum number of engines running at the same time
+ * @param cpuBudget[in]: The CPU seconds shared evenly by the engines, or 0 for no limit
+ * @param pInst[in]: The AABAC instance the model is translated from
+ * @param showRules[in]: Whether to find the rules associated with the actions of a counterexample
+ * @return The first conclusive result, a timeout, or an error if no engine concludes
+ */
+AABACResult runModelCheckerPortfolio(char *modelCheckerPath, char *nusmvFilePath, char *resultFilePath, double timeout, char *bound,
+                                     int boundConclusive, int invarSpec, int maxEngines, double cpuBudget, AABACInstance *pInst, int showRules);
+
+/* A model checker kept running in interactive mode (-int) across refinement rounds */
+typedef struct _MCSession MCSession;
+
+/**
+ * Create a model checker session. The model checker is started on first use, so that process startup, banner and
+ * initialization are paid once for all the rounds instead of once per round.
+ *
+ * @param modelCheckerPath[in]: The path of the model checker, which must support nuXmv's interactive commands
+ * @return The session
+ */
+MCSession *createModelCheckerSession(char *modelCheckerPath);
+
+/**
+ * Check a NuSMV model in a session, with the same result as @{runModelChecker}. The model is loaded with a
+ * reset/read_model/go/check script for the engine on the standard input, and the end of its output is recognized by an echoed
+ * marker. If the session does not answer before the timeout it is killed and restarted on next use; if it exits
+ * unexpectedly the round is retried once in a new session.
+ *
+ * @param session[in]: The session
+ * @param nusmvFilePath[in]: The path of the NuSMV model
+ * @param resultFilePath[in]: The path of the file to copy the output of this round to
+ * @param timeout[in]: The timeout in seconds, which may be fractional
+ * @param engine[in]: The engine, one of MC_ENGINE_*
+ * @param invarSpec[in]: Whether the query of the model is an INVARSPEC rather than an LTLSPEC
+ * @param bound[in]: The bound of BMC and k-induction, or NULL to use the default of the model checker
+ * @param pInst[in]: The AABAC instance the model is translated from
+ * @param showRules[in]: Whether to find the rules associated with the actions of a counterexample
+ * @return The result of the model checking
+ */
+AABACResult runModelCheckerSession(MCSession *session, char *nusmvFilePath, char *resultFilePath, double timeout, int engine,
+                                   int invarSpec, char *bound, AABACInstance *pInst, int showRules);
+
+/**
+ * Ask the model checker of a session to quit, kill it if it does not, and free the session.
+ *
+ * @param session[in]: The session
+ */
+void destroyModelCheckerSession(MCSession *session);
+
+/**
+ * Iterative-deepening BMC: run BMC at a geometric schedule of lengths, startLength, startLength * factor, ..., each length
+ * as a single problem, and stop at the first counterexample. The last length is the full bound, which is checked like
+ * plain BMC. Once the schedule has spent budget * timeout seconds, or has reached a bound that is not conclusive, the rest
+ * of the timeout goes to BDD-based symbolic model checking, which is complete. Reachable instances thus return in time
+ * proportional to the length of the witness rather than to the bound.
+ *
+ * @param modelCheckerPath[in]: The path of the model checker
+ * @param session[in]: The session to run the model checker in, or NULL to start a model checker for every length
+ * @param nusmvFilePath[in]: The path of the NuSMV model
+ * @param resultFilePath[in]: The path of the file to copy the output of the last model checker run to
+ * @param timeout[in]: The timeout in seconds, which may be fractional
+ * @param invarSpec[in]: Whether the query of the model is an INVARSPEC rather than an LTLSPEC
+ * @param bound[in]: The full bound
+ * @param boundConclusive[in]: Whether finding no counterexample up to the full bound proves the query unreachable
+ * @param startLength[in]: The first length, e.g. from @{computeQueryDepth}
+ * @param factor[in]: The growth factor of the lengths, greater than 1
+ * @param budget[in]: The fraction of the timeout the schedule may spend, between 0 and 1
+ * @param pInst[in]: The AABAC instance the model is translated from
+ * @param showRules[in]: Whether to find the rules associated with the actions of a counterexample
+ * @return The result of the model checking
+ */
+AABACResult runModelCheckerDeepening(char *modelCheckerPath, MCSession *session, char *nusmvFilePath, char *resultFilePath,
+                                     double timeout, int invarSpec, char *bound, int boundConclusive, int startLength, double factor,
+                                     double budget, AABACInstance *pInst, int showRules);
+
+/**
+ * Analyze the complete output of a model checker run, with the same parser @{runModelChecker} uses on the fly.
+ *
+ * @param output[in]: The output of the model checker, which is modified, or "timeout" followed by the partial output
+ * @param pInst[in]: The AABAC instance the model is translated from
+ * @param boundStr[in]: The bound of bounded model checking, or NULL for symbolic model checking
+ * @param showRules[in]: Whether to find the rules associated with the actions of a counterexample
+ * @return The result of the model checking
+ */
 AABACResult analyzeModelCheckerOutput(char *output, AABACInstance *pInst, char *boundStr, int showRules);
 
 #endif // NUSMV_RUNNER_H
@@ -0,0 +1,31 @@
+#ifndef _FROZENDICT_H
+#define _FROZENDICT_H
+
+#include "ccl/containers.h"
+
+/*
+ * 只读的字符串到int的字典，由ccl的Dictionary在其不再修改后冻结得到。
+ * 使用hash-and-displace构造的最小完美哈希：键串连续存放在同一块字符串区中，
+ * 查找时对键计算一次64位哈希，由高32位选桶、低32位加上桶的位移得到唯一的槽，再做一次字符串比较。
+ */
+typedef struct _FrozenDict {
+    char *arena;             // 字符串区，依次存放所有以'\0'结尾的键
+    int *keyOffsets;         // 每个槽中键在字符串区中的偏移，-1表示空槽
+    int *values;             // 每个槽中的值
+    unsigned int *disps;     // 每个桶的位移
+    int nSlots;              // 槽数，通常等于键数
+    int nBuckets;            // 桶数
+    int size;                // 键数
+    unsigned long long seed; // 哈希种子
+} FrozenDict;
+
+typedef struct _FrozenDictInterface {
+    FrozenDict *(*Create)(Dictionary *dict);          // 冻结值类型为int的Dictionary，原Dictionary保持不变
+    int *(*Get)(FrozenDict *frozenDict, const char *key); // 返回指向键对应值的指针，键不存在时返回NULL
+    int (*Size)(FrozenDict *frozenDict);
+    void (*Finalize)(FrozenDict *frozenDict);
+} FrozenDictInterface;
+
+extern FrozenDictInterface iFrozenDict;
+
+#endif // _FROZENDICT_H
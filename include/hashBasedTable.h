@@ -11,10 +11,12 @@ typedef struct _HashBasedTable {
     KeyEqual colKeyEqual;
     DestructFn destructCol;
     DestructFn destructValue;
+    Pool *pool; // 内存池，非NULL时行表与各列表都从该池分配
 } HashBasedTable;
 
 typedef struct _HashBasedTableInterface {
     HashBasedTable *(*Create)(int rowKeySize, int colKeySize, int valueSize, Hashcode rowHashCode, KeyEqual rowKeyEqual, Hashcode colHashCode, KeyEqual colKeyEqual);
+    HashBasedTable *(*CreateInPool)(Pool *pool, int rowKeySize, int colKeySize, int valueSize, Hashcode rowHashCode, KeyEqual rowKeyEqual, Hashcode colHashCode, KeyEqual colKeyEqual);
     int (*Put)(HashBasedTable *hashTable, void *rowKey, void *colKey, void *value);
     void *(*Get)(HashBasedTable *hashTable, void *rowKey, void *colKey);
     HashMap *(*GetRow)(HashBasedTable *hashTable, void *rowKey);
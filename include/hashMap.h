@@ -1,11 +1,18 @@
 #ifndef _HASHMAP_H
 #define _HASHMAP_H
 
+#include <stddef.h>
+
+#include "ccl/containers.h"
+
+/*
+ * 哈希表节点视图。键值对内联存储在哈希表的槽数组中，HashNode只是迭代时指向某个槽的视图，
+ * 其中的key与value指针在哈希表扩容之前有效。
+ */
 typedef struct _HashNode {
     unsigned int hash;      // 哈希值
     void *key;              // 键
     void *value;            // 值
-    struct _HashNode *next; // 下一个节点
 } HashNode;
 
 typedef unsigned int (*Hashcode)(void *key);     // 哈希函数类型
@@ -14,20 +21,29 @@ typedef char *(*KeyToString)(void *key);
 typedef char *(*ValueToString)(void *value);
 typedef void (*DestructFn)(void *ptr);
 
+/*
+ * 开放寻址哈希表。每个槽对应一个控制字节（空、已删除、或哈希值的7位标签），槽本身依次内联存放
+ * 哈希值、键和值，查找时先比较控制字节，只有标签相同时才访问槽并调用判等函数。
+ */
 typedef struct _HashMap {
-    HashNode **table; // 哈希表
-    int tableLen;
-    int size;
+    unsigned char *ctrl; // 控制字节数组，长度为tableLen
+    char *slots;         // 槽数组，长度为tableLen * slotSize，与ctrl共用一次内存分配
+    int tableLen;        // 槽数，为2的幂
+    int size;            // 键值对数量
+    int tombstones;      // 已删除槽的数量
+    int threshold;       // size + tombstones达到该值时重建哈希表
     int keySize;
     int valueSize;
-    int threshold;
-    int loadFactor;
+    int keyOffset;       // 键在槽内的偏移
+    int valueOffset;     // 值在槽内的偏移
+    int slotSize;        // 槽的大小
     Hashcode hashcode;
     KeyEqual equal;
     KeyToString keyToString;
     ValueToString valueToString;
     DestructFn destructKey;
     DestructFn destructValue;
+    Pool *pool;          // 内存池，非NULL时哈希表及其槽数组都从该池分配，随池一并释放
 } HashMap;
 
 typedef struct _HashNodeIterator {
@@ -35,13 +51,16 @@ typedef struct _HashNodeIterator {
     void *(*GetNext)(struct _HashNodeIterator *it); // 获取下一个元素函数
     void (*Remove)(struct _HashNodeIterator *it);   // 删除当前元素函数
     HashMap *hashMap;
-    HashNode *current;
-    HashNode *next;
-    int index; // 当前索引
+    HashNode node; // GetNext返回的节点视图
+    int current;   // 当前元素所在的槽，-1表示没有当前元素
+    int index;     // 下一个待检查的槽
 } HashNodeIterator;
 
 typedef struct _HashMapInterface {
     HashMap *(*Create)(int keySize, int valueSize, Hashcode hashCode, KeyEqual keyEqual); // 创建哈希表函数
+    HashMap *(*CreateWithCapacity)(int keySize, int valueSize, Hashcode hashCode, KeyEqual keyEqual, int capacity); // 创建可容纳capacity个键值对而无需扩容的哈希表
+    HashMap *(*CreateInPool)(Pool *pool, int keySize, int valueSize, Hashcode hashCode, KeyEqual keyEqual); // 在内存池中创建哈希表，其值只能是同一池中的对象
+    int (*Reserve)(HashMap *hashMap, int capacity);                                          // 预留空间，使哈希表可容纳capacity个键值对而无需扩容
     int (*Put)(HashMap *hashMap, void *key, void *value);                                    // 添加键值对函数
     int (*ContainsKey)(HashMap *hashMap, void *key);                                         // 判断键是否存在函数
     void *(*Get)(HashMap *hashMap, void *key);                                               // 获取键值对函数
@@ -49,7 +68,7 @@ typedef struct _HashMapInterface {
     int (*Remove)(HashMap *hashMap, void *key);                                         // 删除键值对函数
     void (*Clear)(HashMap *hashMap);                                                      // 清空哈希表函数
     int (*Size)(HashMap *hashMap);                                                        // 获取哈希表大小函数
-    void (*Finalize)(HashMap *hashMap);                                                   // 释放哈希表函数
+    void (*Finalize)(HashMap *hashMap);                                                   // 释放哈希表函数，池中的哈希表不做任何事
     KeyToString (*SetKeyToString)(HashMap *hashMap, KeyToString keyToString);             // 设置键转换为字符串函数
     ValueToString (*SetValueToString)(HashMap *hashMap, ValueToString valueToString);     // 设置值转换为字符串函数
     DestructFn (*SetDestructKey)(HashMap *hashMap, DestructFn destructKey);             // 设置键析构函数
@@ -57,10 +76,38 @@ typedef struct _HashMapInterface {
     void (*DestructPointer)(void *pHashMap);
     HashNodeIterator *(*NewIterator)(HashMap *hashMap);                                   // 创建迭代器函数
     HashNodeIterator *(*DeleteIterator)(HashNodeIterator *it);                            // 删除迭代器函数
+    void (*InitIterator)(HashMap *hashMap, HashNodeIterator *it);                         // 初始化调用者提供的（如栈上的）迭代器，无需DeleteIterator
     int (*HashCode)(HashMap *hashMap);                                                    // 获取哈希值函数
     int (*Equal)(HashMap *hashMap, HashMap *hashMap2);                                    // 判断两个哈希表是否相等函数
 } HashMapInterface;
 
 extern HashMapInterface iHashMap; // 哈希表接口
 
+/*
+ * 内联遍历接口。直接扫描控制字节数组，不分配迭代器也不经过函数指针，供热点循环使用。
+ * 遍历过程中不得向哈希表插入或删除键值对（删除请使用迭代器的Remove）。
+ */
+
+// 返回下标不小于i的第一个非空槽，不存在时返回tableLen
+static inline int HashMapNextSlot(HashMap *hashMap, int i) {
+    while (i < hashMap->tableLen && !(hashMap->ctrl[i] & 0x80)) {
+        i++;
+    }
+    return i;
+}
+
+// 槽i中的键
+static inline void *HashMapSlotKey(HashMap *hashMap, int i) {
+    return hashMap->slots + (size_t)i * hashMap->slotSize + hashMap->keyOffset;
+}
+
+// 槽i中的值
+static inline void *HashMapSlotValue(HashMap *hashMap, int i) {
+    return hashMap->slots + (size_t)i * hashMap->slotSize + hashMap->valueOffset;
+}
+
+// 遍历哈希表的所有非空槽，slot为循环内声明的槽下标
+#define HASHMAP_FOREACH(slot, hashMap) \
+    for (int slot = HashMapNextSlot((hashMap), 0); slot < (hashMap)->tableLen; slot = HashMapNextSlot((hashMap), slot + 1))
+
 #endif // _HASHMAP_H
\ No newline at end of file
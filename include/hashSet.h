@@ -9,6 +9,8 @@ typedef HashNodeIterator HashSetIterator;
 
 typedef struct _HashSetInterface {
     HashSet *(*Create)(int valueSize, Hashcode hashCode, KeyEqual keyEqual); // 创建HashSet
+    HashSet *(*CreateWithCapacity)(int valueSize, Hashcode hashCode, KeyEqual keyEqual, int capacity); // 创建可容纳capacity个元素而无需扩容的HashSet
+    int (*Reserve)(HashSet *hashSet, int capacity); // 预留空间，使HashSet可容纳capacity个元素而无需扩容
     int (*Add)(HashSet *hashSet, void *newval);
     int (*Contains)(HashSet *hashSet, void *element);
     int (*containsAll)(HashSet *hashSet1, HashSet *hashSet2);
@@ -26,8 +28,17 @@ typedef struct _HashSetInterface {
     void (*DestructPointer)(void *pHashSet);
     HashSetIterator *(*NewIterator)(HashSet *hashSet);
     HashSetIterator *(*DeleteIterator)(HashSetIterator *it);
+    void (*InitIterator)(HashSet *hashSet, HashSetIterator *it); // 初始化调用者提供的（如栈上的）迭代器，无需DeleteIterator
 } HashSetInterface;
 
 extern HashSetInterface iHashSet;
 
+// 槽slot中的元素
+static inline void *HashSetSlotElement(HashSet *hashSet, int slot) {
+    return HashMapSlotKey(hashSet, slot);
+}
+
+// 遍历集合的所有元素，slot为循环内声明的槽下标，元素通过HashSetSlotElement获取
+#define HASHSET_FOREACH(slot, hashSet) HASHMAP_FOREACH(slot, hashSet)
+
 #endif // _HASHSET_H
\ No newline at end of file
@@ -0,0 +1,100 @@
+#ifndef _INTSET_H
+#define _INTSET_H
+
+#include "hashMap.h"
+
+#define INTSET_INLINE_CAPACITY 6 // 内联存储的元素个数
+#define INTSET_WORD_BITS 64      // 位图每个字的位数
+
+/*
+ * 整数集合，用于存放属性值域、条件取值等值下标集合。
+ * 元素较少时以有序数组存放（不超过INTSET_INLINE_CAPACITY个元素时直接存放在结构体内），
+ * 元素较稠密时转为位图，位图的第i个字表示区间[64 * (firstWord + i), 64 * (firstWord + i + 1))。
+ * 两种形式下均按从小到大的顺序遍历。
+ */
+typedef struct _IntSet {
+    int size;                                   // 元素个数
+    int capacity;                               // 有序数组的容量
+    int *elements;                              // 有序数组，指向inlineElements或堆内存；位图形式下为NULL
+    unsigned long long *words;                  // 位图；有序数组形式下为NULL
+    int firstWord;                              // 位图第一个字的下标
+    int nWords;                                 // 位图的字数
+    int inlineElements[INTSET_INLINE_CAPACITY]; // 内联元素
+    KeyToString elementToString;
+    Pool *pool;                                 // 内存池，非NULL时集合及其元素存储都从该池分配，随池一并释放
+} IntSet;
+
+typedef struct _IntSetIterator {
+    int (*HasNext)(struct _IntSetIterator *it);   // 是否还有下一个元素函数
+    void *(*GetNext)(struct _IntSetIterator *it); // 获取下一个元素函数，返回指向该元素的int指针
+    void (*Remove)(struct _IntSetIterator *it);   // 删除当前元素函数
+    IntSet *intSet;
+    int index;   // 有序数组形式下为下一个元素之后的位置，位图形式下为下一个元素之后的位
+    int hasNext; // 是否还有下一个元素
+    int next;    // 下一个元素
+    int current; // 是否有当前元素，-1表示没有当前元素
+    int value;   // 当前元素
+} IntSetIterator;
+
+typedef struct _IntSetInterface {
+    IntSet *(*Create)(void);                              // 创建IntSet
+    IntSet *(*Clone)(IntSet *intSet);                     // 复制IntSet
+    IntSet *(*CreateInPool)(Pool *pool);                  // 在内存池中创建IntSet
+    IntSet *(*CloneInPool)(IntSet *intSet, Pool *pool);   // 将IntSet复制到内存池中
+    int (*Add)(IntSet *intSet, int value);                // 添加元素，返回1表示集合被修改
+    int (*AddAll)(IntSet *intSet1, IntSet *intSet2);      // 并集，返回1表示intSet1被修改
+    int (*Contains)(IntSet *intSet, int value);
+    int (*ContainsAll)(IntSet *intSet1, IntSet *intSet2); // intSet2是否为intSet1的子集
+    int (*Intersects)(IntSet *intSet1, IntSet *intSet2);  // 两集合是否有公共元素
+    int (*RetainAll)(IntSet *intSet1, IntSet *intSet2);   // 交集，返回1表示intSet1被修改
+    int (*Remove)(IntSet *intSet, int value);             // 删除元素，返回1表示集合被修改
+    int (*Size)(IntSet *intSet);
+    void (*Clear)(IntSet *intSet);
+    void (*Finalize)(IntSet *intSet);                     // 释放IntSet，池中的IntSet不做任何事
+    unsigned int (*HashCode)(void *pIntSet);
+    int (*Equal)(void *pIntSet1, void *pIntSet2);
+    char *(*ToString)(void *pIntSet); // 转换为字符串函数
+    KeyToString (*SetElementToString)(IntSet *intSet, KeyToString elementToString); // 设置元素转换为字符串函数
+    void (*DestructPointer)(void *pIntSet);
+    IntSetIterator *(*NewIterator)(IntSet *intSet);
+    IntSetIterator *(*DeleteIterator)(IntSetIterator *it);
+    void (*InitIterator)(IntSet *intSet, IntSetIterator *it); // 初始化调用者提供的（如栈上的）迭代器，无需DeleteIterator
+} IntSetInterface;
+
+extern IntSetInterface iIntSet;
+
+/*
+ * 读取游标pos之后的元素并将游标移到该元素之后，pos初始为0。
+ * 有序数组形式下pos为数组下标，位图形式下pos为位下标。返回1表示读到元素，0表示遍历结束。
+ */
+static inline int IntSetNextElement(IntSet *intSet, int *pos, int *value) {
+    if (intSet->words == NULL) {
+        if (*pos >= intSet->size) {
+            return 0;
+        }
+        *value = intSet->elements[(*pos)++];
+        return 1;
+    }
+    int w = *pos / INTSET_WORD_BITS;
+    if (w >= intSet->nWords) {
+        return 0;
+    }
+    unsigned long long word = intSet->words[w] & (~0ULL << (*pos % INTSET_WORD_BITS));
+    while (word == 0) {
+        if (++w >= intSet->nWords) {
+            *pos = intSet->nWords * INTSET_WORD_BITS;
+            return 0;
+        }
+        word = intSet->words[w];
+    }
+    int bit = __builtin_ctzll(word);
+    *pos = w * INTSET_WORD_BITS + bit + 1;
+    *value = (intSet->firstWord + w) * INTSET_WORD_BITS + bit;
+    return 1;
+}
+
+// 按从小到大的顺序遍历集合，value为循环内声明的int变量。遍历过程中不得修改集合
+#define INTSET_FOREACH(value, intSet) \
+    for (int value##_pos = 0, value = 0; IntSetNextElement((intSet), &value##_pos, &value);)
+
+#endif // _INTSET_H
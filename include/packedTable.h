@@ -0,0 +1,42 @@
+#ifndef _PACKEDTABLE_H
+#define _PACKEDTABLE_H
+
+#include "hashMap.h"
+#include "intSet.h"
+
+/*
+ * 以(row, col)两个int打包成的64位键为键的二维表。所有单元格存放在同一个扁平哈希表中，
+ * Get只需一次探测；与HashBasedTable相比省去了先查行、再查列的两次探测与一次指针解引用。
+ * 创建时可选择维护行视图：行键到该行所有列键（IntSet）的索引，用于按行遍历。
+ */
+typedef struct _PackedTable {
+    HashMap *pCellMap;  // 打包键 -> 值
+    HashMap *pRowView;  // 行键 -> 该行的列键集合（IntSet *），未启用行视图时为NULL
+    int valueSize;
+    Pool *pool;         // 内存池，非NULL时表、行视图及其中的列键集合都从该池分配
+} PackedTable;
+
+typedef struct _PackedTableInterface {
+    PackedTable *(*Create)(int valueSize, int withRowView);         // 创建二维表，withRowView非0时维护行视图
+    PackedTable *(*CreateInPool)(Pool *pool, int valueSize, int withRowView); // 在内存池中创建二维表，其值只能是同一池中的对象
+    int (*Put)(PackedTable *table, int row, int col, void *value);  // 添加或覆盖单元格
+    void *(*Get)(PackedTable *table, int row, int col);             // 获取单元格的值，不存在时返回NULL
+    IntSet *(*GetRow)(PackedTable *table, int row);                 // 获取某行的列键集合，行不存在或未启用行视图时返回NULL
+    int (*Size)(PackedTable *table);                                // 单元格数量
+    DestructFn (*SetDestructValue)(PackedTable *table, DestructFn destructValue);
+    void (*Clear)(PackedTable *table);
+    void (*Finalize)(PackedTable *table);                           // 释放二维表，池中的二维表不做任何事
+} PackedTableInterface;
+
+extern PackedTableInterface iPackedTable;
+
+// 从pCellMap的打包键中取出行键与列键，行键在高32位，列键在低32位
+static inline int PackedTableKeyRow(unsigned long long key) {
+    return (int)(unsigned int)(key >> 32);
+}
+
+static inline int PackedTableKeyCol(unsigned long long key) {
+    return (int)(unsigned int)key;
+}
+
+#endif // _PACKEDTABLE_H
@@ -0,0 +1,82 @@
+#ifndef _RULESTORE_H
+#define _RULESTORE_H
+
+#include <stdio.h>
+
+#include "AABACRule.h"
+
+#define RULESTORE_WORD_BITS 64 // 位图每个字的位数
+
+/*
+ * 编译后的规则存储，与规则列表按下标一一对应，以数组的结构（struct-of-arrays）存放规则的目标与用户条件，
+ * 按规则扫描时只需顺序访问几个连续数组，而不必经过每条规则各自的哈希表与集合。
+ * 用户条件以CSR形式存放：规则r的条件项为[condBegin[r], condEnd[r])，每个条件项是一个属性及其允许取值的位图，
+ * 条件项i的位图为words[condWordBegin[i], condWordEnd[i])，其第j个字表示区间[64 * (condFirstWord[i] + j), 64 * (condFirstWord[i] + j + 1))。
+ * 条件项取自规则的pmapUserCondValue，用户条件尚未离散化（pmapUserCondValue为NULL）的规则没有条件项。
+ */
+typedef struct _RuleStore {
+    int nRules;                 // 规则数
+    int *targetAttrs;           // 每条规则的目标属性
+    int *targetValues;          // 每条规则的目标值
+    int *condBegin;             // 每条规则第一个条件项的下标
+    int *condEnd;               // 每条规则最后一个条件项之后的下标
+    int nConds;                 // 已使用的条件项数
+    int condCapacity;           // 条件项数组的容量
+    int *condAttrs;             // 每个条件项的属性
+    int *condFirstWord;         // 每个条件项位图第一个字对应的区间下标
+    int *condWordBegin;         // 每个条件项位图在words中的起始下标
+    int *condWordEnd;           // 每个条件项位图在words中的结束下标
+    int nWords;                 // 已使用的字数
+    int wordCapacity;           // 位图数组的容量
+    unsigned long long *words;  // 所有条件项的位图
+} RuleStore;
+
+typedef struct _RuleStoreInterface {
+    RuleStore *(*Create)(Vector *pVecRules);                                 // 编译规则列表（元素为Rule）
+    RuleStore *(*Clone)(RuleStore *store);
+    void (*Update)(RuleStore *store, int ruleIdx, Rule *r);                  // 规则的用户条件被修改后重新编译该规则
+    int (*IsEffective)(RuleStore *store, int ruleIdx, HashMap *reachableAVs); // 每个条件属性是否至少有一个取值可达，同iRule.IsEffective
+    int (*CanBeManaged)(RuleStore *store, int ruleIdx, HashMap *userState);  // 用户状态是否满足用户条件，同iRule.CanBeManaged
+    int (*Allows)(RuleStore *store, int cond, int value);                    // 条件项是否允许某个取值
+    int (*CountValues)(RuleStore *store, int cond);                          // 条件项允许的取值个数
+    int (*Save)(RuleStore *store, FILE *fp);                                 // 以二进制形式写入文件，成功返回0
+    RuleStore *(*Load)(const void *data, size_t size, size_t *pConsumed);    // 从Save写入的数据中读取，pConsumed返回读取的字节数，数据不完整或下标越界时返回NULL
+    void (*Finalize)(RuleStore *store);
+} RuleStoreInterface;
+
+extern RuleStoreInterface iRuleStore;
+
+/*
+ * 读取条件项cond中游标pos之后的取值并将游标移到该取值之后，pos初始为0，为相对于条件项位图起点的位下标。
+ * 返回1表示读到取值，0表示遍历结束。
+ */
+static inline int RuleStoreNextValue(RuleStore *store, int cond, int *pos, int *value) {
+    int w = store->condWordBegin[cond] + *pos / RULESTORE_WORD_BITS;
+    int end = store->condWordEnd[cond];
+    if (w >= end) {
+        return 0;
+    }
+    unsigned long long word = store->words[w] & (~0ULL << (*pos % RULESTORE_WORD_BITS));
+    while (word == 0) {
+        if (++w >= end) {
+            *pos = (end - store->condWordBegin[cond]) * RULESTORE_WORD_BITS;
+            return 0;
+        }
+        word = store->words[w];
+    }
+    int bit = __builtin_ctzll(word);
+    w -= store->condWordBegin[cond];
+    *pos = w * RULESTORE_WORD_BITS + bit + 1;
+    *value = (store->condFirstWord[cond] + w) * RULESTORE_WORD_BITS + bit;
+    return 1;
+}
+
+// 遍历规则ruleIdx的条件项，cond为循环内声明的int变量
+#define RULESTORE_COND_FOREACH(cond, store, ruleIdx) \
+    for (int cond = (store)->condBegin[(ruleIdx)]; cond < (store)->condEnd[(ruleIdx)]; cond++)
+
+// 按从小到大的顺序遍历条件项cond允许的取值，value为循环内声明的int变量
+#define RULESTORE_VALUE_FOREACH(value, store, cond) \
+    for (int value##_pos = 0, value = 0; RuleStoreNextValue((store), (cond), &value##_pos, &value);)
+
+#endif // _RULESTORE_H
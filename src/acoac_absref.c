@@ -7,14 +7,16 @@ AbsRef *createAbsRef(AABACInstance *pOriInst) {
     AbsRef *pAbsRef = (AbsRef *)malloc(sizeof(AbsRef));
     pAbsRef->pOriInst = pOriInst;
     pAbsRef->pOriVecRules = pVecRules;
+    pAbsRef->pOriRuleStore = pRuleStore;
     pAbsRef->round = 0;
 
-    pAbsRef->pSetF = iHashSet.Create(sizeof(int), IntHashCode, IntEqual);
-    pAbsRef->pSetB = iHashSet.Create(sizeof(int), IntHashCode, IntEqual);
+    pAbsRef->pSetF = iIntSet.Create();
+    pAbsRef->pSetB = iIntSet.Create();
     pAbsRef->pMapReachableAVs = NULL;
     pAbsRef->pMapReachableAVsInc = NULL;
     pAbsRef->pMapUsefulAVs = NULL;
     pAbsRef->pMapUsefulAVsInc = NULL;
+    pAbsRef->pRoundPool = NULL;
     return pAbsRef;
 }
 
@@ -28,101 +30,87 @@ static int forwardSearch(AbsRef *pAbsRef) {
     int ret = 0;
 
     if (pAbsRef->pMapReachableAVsInc == NULL) {
-        pAbsRef->pMapReachableAVs = iHashMap.Create(sizeof(int), sizeof(HashSet *), IntHashCode, IntEqual);
-        iHashMap.SetDestructValue(pAbsRef->pMapReachableAVs, iHashSet.DestructPointer);
-        pAbsRef->pMapReachableAVsInc = iHashMap.Create(sizeof(int), sizeof(HashSet *), IntHashCode, IntEqual);
-        iHashMap.SetDestructValue(pAbsRef->pMapReachableAVsInc, iHashSet.DestructPointer);
+        pAbsRef->pMapReachableAVs = iHashMap.Create(sizeof(int), sizeof(IntSet *), IntHashCode, IntEqual);
+        iHashMap.SetDestructValue(pAbsRef->pMapReachableAVs, iIntSet.DestructPointer);
+        pAbsRef->pMapReachableAVsInc = iHashMap.Create(sizeof(int), sizeof(IntSet *), IntHashCode, IntEqual);
+        iHashMap.SetDestructValue(pAbsRef->pMapReachableAVsInc, iIntSet.DestructPointer);
 
         HashNodeIterator *itMap = iHashMap.NewIterator(
             *(HashMap **)iHashMap.Get(pAbsRef->pOriInst->pTableInitState->pRowMap, &pAbsRef->pOriInst->queryUserIdx));
         HashNode *node;
-        HashSet *pSet;
+        IntSet *pSet;
         while (itMap->HasNext(itMap)) {
             node = itMap->GetNext(itMap);
-            pSet = iHashSet.Create(sizeof(int), IntHashCode, IntEqual);
-            iHashSet.Add(pSet, node->value);
+            pSet = iIntSet.Create();
+            iIntSet.Add(pSet, *(int *)node->value);
             iHashMap.Put(pAbsRef->pMapReachableAVs, node->key, &pSet);
 
-            pSet = iHashSet.Create(sizeof(int), IntHashCode, IntEqual);
-            iHashSet.Add(pSet, node->value);
+            pSet = iIntSet.Create();
+            iIntSet.Add(pSet, *(int *)node->value);
             iHashMap.Put(pAbsRef->pMapReachableAVsInc, node->key, &pSet);
         }
         iHashMap.DeleteIterator(itMap);
     }
 
-    HashBasedTable *pTablePrecond2Rule = pAbsRef->pOriInst->pTablePrecond2Rule;
-    HashMap *pMapNewReachableAVsInc = iHashMap.Create(sizeof(int), sizeof(HashSet *), IntHashCode, IntEqual);
-    iHashMap.SetDestructValue(pMapNewReachableAVsInc, iHashSet.DestructPointer);
+    PackedTable *pTablePrecond2Rule = pAbsRef->pOriInst->pTablePrecond2Rule;
+    RuleStore *pOriRuleStore = pAbsRef->pOriRuleStore;
+    HashMap *pMapNewReachableAVsInc = iHashMap.Create(sizeof(int), sizeof(IntSet *), IntHashCode, IntEqual);
+    iHashMap.SetDestructValue(pMapNewReachableAVsInc, iIntSet.DestructPointer);
 
     /* Traverse the newly reachable attribute values, find the rules that may become reachable
      * because of the newly reachable attribute values. If these rules are not in pf, and the 
      * current reachable attribute key-value pair can satisfy the userCond of the rule, then
      * add the rule to pf, and update the reachable attribute key-value pair */
-    HashNodeIterator *itMap = iHashMap.NewIterator(pAbsRef->pMapReachableAVsInc);
+    HashMap *pMapReachableAVsInc = pAbsRef->pMapReachableAVsInc;
     HashNode *node;
-    HashSet **ppSetRuleIdxes, *pSetValIdxes, **ppSetValIdxes;
-    HashSetIterator *itSetValIdx, *itSetRuleIdx;
-    int *pAttrIdx, *pValueIdx, *pRuleIdx, targetAttrIdx, targetValueIdx;
-    Rule *pRule;
-    while (itMap->HasNext(itMap)) {
-        node = itMap->GetNext(itMap);
-        pAttrIdx = (int *)node->key;
-        itSetValIdx = iHashSet.NewIterator(*(HashSet **)node->value);
-        while (itSetValIdx->HasNext(itSetValIdx)) {
-            pValueIdx = (int *)itSetValIdx->GetNext(itSetValIdx);
-            ppSetRuleIdxes = iHashBasedTable.Get(pTablePrecond2Rule, pAttrIdx, pValueIdx);
+    IntSet **ppSetRuleIdxes, *pSetValIdxes, **ppSetValIdxes;
+    int *pAttrIdx, targetAttrIdx, targetValueIdx;
+    HASHMAP_FOREACH(slot, pMapReachableAVsInc) {
+        pAttrIdx = (int *)HashMapSlotKey(pMapReachableAVsInc, slot);
+        INTSET_FOREACH(valueIdx, *(IntSet **)HashMapSlotValue(pMapReachableAVsInc, slot)) {
+            ppSetRuleIdxes = iPackedTable.Get(pTablePrecond2Rule, *pAttrIdx, valueIdx);
             if (ppSetRuleIdxes == NULL) {
                 continue;
             }
-            itSetRuleIdx = iHashSet.NewIterator(*ppSetRuleIdxes);
-            while (itSetRuleIdx->HasNext(itSetRuleIdx)) {
-                pRuleIdx = (int *)itSetRuleIdx->GetNext(itSetRuleIdx);
-                pRule = iVector.GetElement(pAbsRef->pOriVecRules, *pRuleIdx);
-                if (iHashSet.Contains(pAbsRef->pSetF, pRuleIdx)) {
+            INTSET_FOREACH(ruleIdx, *ppSetRuleIdxes) {
+                if (iIntSet.Contains(pAbsRef->pSetF, ruleIdx)) {
                     continue;
                 }
-                if (!iRule.IsEffective(pRule, pAbsRef->pMapReachableAVs)) {
+                if (!iRuleStore.IsEffective(pOriRuleStore, ruleIdx, pAbsRef->pMapReachableAVs)) {
                     continue;
                 }
                 ret = 1;
-                iHashSet.Add(pAbsRef->pSetF, pRuleIdx);
-                targetAttrIdx = pRule->targetAttrIdx;
-                targetValueIdx = pRule->targetValueIdx;
+                iIntSet.Add(pAbsRef->pSetF, ruleIdx);
+                targetAttrIdx = pOriRuleStore->targetAttrs[ruleIdx];
+                targetValueIdx = pOriRuleStore->targetValues[ruleIdx];
                 ppSetValIdxes = iHashMap.Get(pAbsRef->pMapReachableAVs, &targetAttrIdx);
-                if (ppSetValIdxes == NULL || !iHashSet.Contains(*ppSetValIdxes, &targetValueIdx)) {
+                if (ppSetValIdxes == NULL || !iIntSet.Contains(*ppSetValIdxes, targetValueIdx)) {
                     ppSetValIdxes = iHashMap.Get(pMapNewReachableAVsInc, &targetAttrIdx);
                     if (ppSetValIdxes == NULL) {
-                        pSetValIdxes = iHashSet.Create(sizeof(int), IntHashCode, IntEqual);
+                        pSetValIdxes = iIntSet.Create();
                         ppSetValIdxes = &pSetValIdxes;
                         iHashMap.Put(pMapNewReachableAVsInc, &targetAttrIdx, ppSetValIdxes);
                     }
-                    iHashSet.Add(*ppSetValIdxes, &targetValueIdx);
+                    iIntSet.Add(*ppSetValIdxes, targetValueIdx);
                 }
             }
-            iHashSet.DeleteIterator(itSetRuleIdx);
         }
-        iHashSet.DeleteIterator(itSetValIdx);
     }
-    iHashMap.DeleteIterator(itMap);
 
     // Add the new reachable attribute-value pairs in pMapNewReachableAVsInc to pMapReachableAVs
-    itMap = iHashMap.NewIterator(pMapNewReachableAVsInc);
-    while (itMap->HasNext(itMap)) {
-        node = itMap->GetNext(itMap);
+    HashNodeIterator itMap;
+    iHashMap.InitIterator(pMapNewReachableAVsInc, &itMap);
+    while (itMap.HasNext(&itMap)) {
+        node = itMap.GetNext(&itMap);
         pAttrIdx = (int *)node->key;
         ppSetValIdxes = iHashMap.Get(pAbsRef->pMapReachableAVs, pAttrIdx);
         if (ppSetValIdxes == NULL) {
-            pSetValIdxes = iHashSet.Create(sizeof(int), IntHashCode, IntEqual);
+            pSetValIdxes = iIntSet.Create();
             ppSetValIdxes = &pSetValIdxes;
             iHashMap.Put(pAbsRef->pMapReachableAVs, pAttrIdx, ppSetValIdxes);
         }
-        itSetValIdx = iHashSet.NewIterator(*(HashSet **)node->value);
-        while (itSetValIdx->HasNext(itSetValIdx)) {
-            iHashSet.Add(*ppSetValIdxes, itSetValIdx->GetNext(itSetValIdx));
-        }
-        iHashSet.DeleteIterator(itSetValIdx);
+        iIntSet.AddAll(*ppSetValIdxes, *(IntSet **)node->value);
     }
-    iHashMap.DeleteIterator(itMap);
 
     iHashMap.Finalize(pAbsRef->pMapReachableAVsInc);
     pAbsRef->pMapReachableAVsInc = pMapNewReachableAVsInc;
@@ -139,22 +127,22 @@ static int backwardSearch(AbsRef *pAbsRef) {
     int ret = 0;
     if (pAbsRef->pMapUsefulAVsInc == NULL) {
         // Initialize pMapUsefulAVs with pMapQueryAVs
-        pAbsRef->pMapUsefulAVs = iHashMap.Create(sizeof(int), sizeof(HashSet *), IntHashCode, IntEqual);
-        iHashMap.SetDestructValue(pAbsRef->pMapUsefulAVs, iHashSet.DestructPointer);
-        pAbsRef->pMapUsefulAVsInc = iHashMap.Create(sizeof(int), sizeof(HashSet *), IntHashCode, IntEqual);
-        iHashMap.SetDestructValue(pAbsRef->pMapUsefulAVsInc, iHashSet.DestructPointer);
+        pAbsRef->pMapUsefulAVs = iHashMap.Create(sizeof(int), sizeof(IntSet *), IntHashCode, IntEqual);
+        iHashMap.SetDestructValue(pAbsRef->pMapUsefulAVs, iIntSet.DestructPointer);
+        pAbsRef->pMapUsefulAVsInc = iHashMap.Create(sizeof(int), sizeof(IntSet *), IntHashCode, IntEqual);
+        iHashMap.SetDestructValue(pAbsRef->pMapUsefulAVsInc, iIntSet.DestructPointer);
 
         HashNodeIterator *itMap = iHashMap.NewIterator(pAbsRef->pOriInst->pmapQueryAVs);
         HashNode *node;
-        HashSet *pSet;
+        IntSet *pSet;
         while (itMap->HasNext(itMap)) {
             node = itMap->GetNext(itMap);
-            pSet = iHashSet.Create(sizeof(int), IntHashCode, IntEqual);
-            iHashSet.Add(pSet, node->value);
+            pSet = iIntSet.Create();
+            iIntSet.Add(pSet, *(int *)node->value);
             iHashMap.Put(pAbsRef->pMapUsefulAVs, node->key, &pSet);
 
-            pSet = iHashSet.Create(sizeof(int), IntHashCode, IntEqual);
-            iHashSet.Add(pSet, node->value);
+            pSet = iIntSet.Create();
+            iIntSet.Add(pSet, *(int *)node->value);
             iHashMap.Put(pAbsRef->pMapUsefulAVsInc, node->key, &pSet);
         }
         iHashMap.DeleteIterator(itMap);
@@ -164,68 +152,51 @@ static int backwardSearch(AbsRef *pAbsRef) {
         return 0;
     }
 
-    HashMap *pMapNewUsefulAVsInc = iHashMap.Create(sizeof(int), sizeof(HashSet *), IntHashCode, IntEqual);
-    iHashMap.SetDestructValue(pMapNewUsefulAVsInc, iHashSet.DestructPointer);
+    HashMap *pMapNewUsefulAVsInc = iHashMap.Create(sizeof(int), sizeof(IntSet *), IntHashCode, IntEqual);
+    iHashMap.SetDestructValue(pMapNewUsefulAVsInc, iIntSet.DestructPointer);
 
-    HashNodeIterator *itMap = iHashMap.NewIterator(pAbsRef->pMapUsefulAVsInc), *itMap2;
-    HashNode *node, *node2;
-    HashSet **ppSetRuleIdxes, *pSetValIdxes, **ppSetValIdxes;
-    HashSetIterator *itSetValIdx, *itSetValIdx2, *itSetRuleIdx;
-    int *pAttrIdx, *pAttrIdx2, *pValueIdx, *pValueIdx2, *pRuleIdx;
-    Rule *pRule;
+    HashMap *pMapUsefulAVsInc = pAbsRef->pMapUsefulAVsInc;
+    RuleStore *pOriRuleStore = pAbsRef->pOriRuleStore;
+    IntSet **ppSetRuleIdxes, *pSetValIdxes, **ppSetValIdxes;
+    int *pAttrIdx, *pAttrIdx2;
 
-    while (itMap->HasNext(itMap)) {
-        node = itMap->GetNext(itMap);
-        pAttrIdx = (int *)node->key;
-        itSetValIdx = iHashSet.NewIterator(*(HashSet **)node->value);
-        while (itSetValIdx->HasNext(itSetValIdx)) {
-            pValueIdx = (int *)itSetValIdx->GetNext(itSetValIdx);
-            ppSetRuleIdxes = iHashBasedTable.Get(pAbsRef->pOriInst->pTableTargetAV2Rule, pAttrIdx, pValueIdx);
+    HASHMAP_FOREACH(slot, pMapUsefulAVsInc) {
+        pAttrIdx = (int *)HashMapSlotKey(pMapUsefulAVsInc, slot);
+        INTSET_FOREACH(valueIdx, *(IntSet **)HashMapSlotValue(pMapUsefulAVsInc, slot)) {
+            ppSetRuleIdxes = iPackedTable.Get(pAbsRef->pOriInst->pTableTargetAV2Rule, *pAttrIdx, valueIdx);
             if (ppSetRuleIdxes == NULL) {
                 continue;
             }
-            itSetRuleIdx = iHashSet.NewIterator(*ppSetRuleIdxes);
-            while (itSetRuleIdx->HasNext(itSetRuleIdx)) {
-                pRuleIdx = (int *)itSetRuleIdx->GetNext(itSetRuleIdx);
-                if (!iHashSet.Add(pAbsRef->pSetB, pRuleIdx)) {
+            INTSET_FOREACH(ruleIdx, *ppSetRuleIdxes) {
+                if (!iIntSet.Add(pAbsRef->pSetB, ruleIdx)) {
                     continue;
                 }
                 ret = 1;
-                pRule = iVector.GetElement(pAbsRef->pOriVecRules, *pRuleIdx);
-                itMap2 = iHashMap.NewIterator(pRule->pmapUserCondValue);
-                while (itMap2->HasNext(itMap2)) {
-                    node2 = itMap2->GetNext(itMap2);
-                    pAttrIdx2 = (int *)node2->key;
-                    itSetValIdx2 = iHashSet.NewIterator(*(HashSet **)node2->value);
-                    while (itSetValIdx2->HasNext(itSetValIdx2)) {
-                        pValueIdx2 = (int *)itSetValIdx2->GetNext(itSetValIdx2);
+                RULESTORE_COND_FOREACH(cond, pOriRuleStore, ruleIdx) {
+                    pAttrIdx2 = &pOriRuleStore->condAttrs[cond];
+                    RULESTORE_VALUE_FOREACH(valueIdx2, pOriRuleStore, cond) {
                         ppSetValIdxes = iHashMap.Get(pAbsRef->pMapUsefulAVs, pAttrIdx2);
                         if (ppSetValIdxes == NULL) {
-                            pSetValIdxes = iHashSet.Create(sizeof(int), IntHashCode, IntEqual);
+                            pSetValIdxes = iIntSet.Create();
                             ppSetValIdxes = &pSetValIdxes;
                             iHashMap.Put(pAbsRef->pMapUsefulAVs, pAttrIdx2, ppSetValIdxes);
                         }
-                        if (!iHashSet.Add(*ppSetValIdxes, pValueIdx2)) {
+                        if (!iIntSet.Add(*ppSetValIdxes, valueIdx2)) {
                             continue;
                         }
 
                         ppSetValIdxes = iHashMap.Get(pMapNewUsefulAVsInc, pAttrIdx2);
                         if (ppSetValIdxes == NULL) {
-                            pSetValIdxes = iHashSet.Create(sizeof(int), IntHashCode, IntEqual);
+                            pSetValIdxes = iIntSet.Create();
                             ppSetValIdxes = &pSetValIdxes;
                             iHashMap.Put(pMapNewUsefulAVsInc, pAttrIdx2, ppSetValIdxes);
                         }
-                        iHashSet.Add(*ppSetValIdxes, pValueIdx2);
+                        iIntSet.Add(*ppSetValIdxes, valueIdx2);
                     }
-                    iHashSet.DeleteIterator(itSetValIdx2);
                 }
-                iHashMap.DeleteIterator(itMap2);
             }
-            iHashSet.DeleteIterator(itSetRuleIdx);
         }
-        iHashSet.DeleteIterator(itSetValIdx);
     }
-    iHashMap.DeleteIterator(itMap);
 
     iHashMap.Finalize(pAbsRef->pMapUsefulAVsInc);
     pAbsRef->pMapUsefulAVsInc = pMapNewUsefulAVsInc;
@@ -240,11 +211,20 @@ static int backwardSearch(AbsRef *pAbsRef) {
 static void cloneRules(AbsRef *pAbsRef) {
     int nRules = iVector.Size(pAbsRef->pOriVecRules);
 
+    // The rules cloned in the previous round are no longer used, release them with their pool
+    if (pVecRules != pAbsRef->pOriVecRules) {
+        iVector.Finalize(pVecRules);
+        iRuleStore.Finalize(pRuleStore);
+    }
+    if (pAbsRef->pRoundPool != NULL) {
+        iPool.Finalize(pAbsRef->pRoundPool);
+    }
+    pAbsRef->pRoundPool = iPool.Create(NULL);
+
     Vector *pVecNewRules = iVector.Create(sizeof(Rule), nRules);
     Rule *pRule, *pNewRule;
     HashNode *node;
-    HashSet *pSet;
-    HashSetIterator *itSet;
+    IntSet *pSet;
     int i;
     for (i = 0; i < nRules; i++) {
         pRule = iVector.GetElement(pAbsRef->pOriVecRules, i);
@@ -252,23 +232,20 @@ static void cloneRules(AbsRef *pAbsRef) {
         pNewRule = iVector.GetElement(pVecNewRules, i);
 
         if (pRule->pmapUserCondValue != NULL) {
-            pNewRule->pmapUserCondValue = iHashMap.Create(sizeof(int), sizeof(HashSet *), IntHashCode, IntEqual);
+            pNewRule->pmapUserCondValue = iHashMap.CreateInPool(pAbsRef->pRoundPool, sizeof(int), sizeof(IntSet *), IntHashCode, IntEqual);
             HashNodeIterator *itMap = iHashMap.NewIterator(pRule->pmapUserCondValue);
             while (itMap->HasNext(itMap)) {
                 node = itMap->GetNext(itMap);
 
-                pSet = iHashSet.Create(sizeof(int), IntHashCode, IntEqual);
-                itSet = iHashSet.NewIterator(*(HashSet **)node->value);
-                while (itSet->HasNext(itSet)) {
-                    iHashSet.Add(pSet, itSet->GetNext(itSet));
-                }
-                iHashSet.DeleteIterator(itSet);
+                pSet = iIntSet.CloneInPool(*(IntSet **)node->value, pAbsRef->pRoundPool);
                 iHashMap.Put(pNewRule->pmapUserCondValue, node->key, &pSet);
             }
             iHashMap.DeleteIterator(itMap);
         }
     }
     pVecRules = pVecNewRules;
+    // The cloned rules have the same conditions as the original ones, and so does their compiled form
+    pRuleStore = iRuleStore.Clone(pAbsRef->pOriRuleStore);
 }
 
 /**
@@ -291,23 +268,20 @@ static AABACInstance *getInstance(AbsRef *pAbsRef) {
     cloneRules(pAbsRef);
 
     AABACInstance *pNewInstance = createAABACInstance();
-    HashSetIterator *itSet = iHashSet.NewIterator(pAbsRef->pSetF);
-    int ruleIdx;
+    IntSet *pSetSelected = iIntSet.Clone(pAbsRef->pSetF);
+    iIntSet.AddAll(pSetSelected, pAbsRef->pSetB);
+    IntSetIterator *itSet = iIntSet.NewIterator(pSetSelected);
     while (itSet->HasNext(itSet)) {
-        ruleIdx = *(int *)itSet->GetNext(itSet);
-        addRule(pNewInstance, ruleIdx);
+        addRule(pNewInstance, *(int *)itSet->GetNext(itSet));
     }
-    iHashSet.DeleteIterator(itSet);
-
-    itSet = iHashSet.NewIterator(pAbsRef->pSetB);
-    while (itSet->HasNext(itSet)) {
-        ruleIdx = *(int *)itSet->GetNext(itSet);
-        addRule(pNewInstance, ruleIdx);
-    }
-    iHashSet.DeleteIterator(itSet);
+    iIntSet.DeleteIterator(itSet);
+    iIntSet.Finalize(pSetSelected);
 
     int queryUserIdx = pAbsRef->pOriInst->queryUserIdx;
-    pNewInstance->pVecUserIndices = pAbsRef->pOriInst->pVecUserIndices;
+    Vector *pVecOriUserIndices = pAbsRef->pOriInst->pVecUserIndices;
+    for (int i = 0; i < iVector.Size(pVecOriUserIndices); i++) {
+        iVector.Add(pNewInstance->pVecUserIndices, iVector.GetElement(pVecOriUserIndices, i));
+    }
 
     HashNodeIterator *itMap = iHashMap.NewIterator(*(HashMap **)iHashMap.Get(pAbsRef->pOriInst->pTableInitState->pRowMap, &queryUserIdx));
     HashNode *node;
@@ -338,7 +312,7 @@ AABACInstance *abstract(AbsRef *pAbsRef) {
 
     double timeSpent = (double)(clock() - startAbstracting) / CLOCKS_PER_SEC * 1000;
     logAABAC(__func__, __LINE__, 0, INFO, "[end] abstracting policy, cost => %.2fms\n", timeSpent);
-    logAABAC(__func__, __LINE__, 0, INFO, "rules => %d/%d\n", iHashSet.Size(newInstance->pSetRuleIdxes), iHashSet.Size(pAbsRef->pOriInst->pSetRuleIdxes));
+    logAABAC(__func__, __LINE__, 0, INFO, "rules => %d/%d\n", iIntSet.Size(newInstance->pSetRuleIdxes), iIntSet.Size(pAbsRef->pOriInst->pSetRuleIdxes));
 
     return newInstance;
 }
@@ -352,7 +326,7 @@ AABACInstance *refine(AbsRef *pAbsRef) {
     if (newInstance != NULL) {
         double timeSpent = (double)(clock() - startRefining) / CLOCKS_PER_SEC * 1000;
         logAABAC(__func__, __LINE__, 0, INFO, "[end] %d-th policy refinement, cost => %.2fms\n", pAbsRef->round, timeSpent);
-        logAABAC(__func__, __LINE__, 0, INFO, "rules => %d/%d\n", iHashSet.Size(newInstance->pSetRuleIdxes), iHashSet.Size(pAbsRef->pOriInst->pSetRuleIdxes));
+        logAABAC(__func__, __LINE__, 0, INFO, "rules => %d/%d\n", iIntSet.Size(newInstance->pSetRuleIdxes), iIntSet.Size(pAbsRef->pOriInst->pSetRuleIdxes));
     }
     pAbsRef->round++;
     return newInstance;
@@ -20,7 +20,7 @@ static BigInteger computeLooseBound(AABACInstance *pInst) {
         if (strcmp(attr, "Admin") == 0) {
             continue;
         }
-        domSize = iHashSet.Size(*(HashSet **)pNode->value);
+        domSize = iIntSet.Size(*(IntSet **)pNode->value);
         tmp = iBigInteger.multiplyByInt(bound, domSize);
         iBigInteger.finalize(bound);
         bound = tmp;
@@ -124,10 +124,10 @@ static BigInteger computeTightBound(AABACInstance *pInst) {
         if (strcmp(attr, "Admin") == 0) {
             continue;
         }
-        domSize = iHashSet.Size(*(HashSet **)node->value);
+        domSize = iIntSet.Size(*(IntSet **)node->value);
         pInitValIdx = (int *)iHashMap.Get(pMapInitAVs, pAttrIdx);
         pQueryValIdx = (int *)iHashMap.Get(pInst->pmapQueryAVs, pAttrIdx);
-        if (iHashBasedTable.Get(pInst->pTableTargetAV2Rule, pAttrIdx, pInitValIdx) == NULL) {
+        if (iPackedTable.Get(pInst->pTableTargetAV2Rule, *pAttrIdx, *pInitValIdx) == NULL) {
             // attr is non restorable, i.e., once the initial value is modified, it cannot be restored
             if (pQueryValIdx == NULL) {
                 // attr is not a target attribute of the query, so it is not already satisfied
@@ -190,6 +190,128 @@ static BigInteger computeTightBound(AABACInstance *pInst) {
     return bound;
 }
 
+/**
+ * Add an attribute value to a map from attributes to value sets (IntSet).
+ * 
+ * @param pMap[in]: The map, whose value sets are destructed with the map
+ * @param attrIdx[in]: The attribute
+ * @param valIdx[in]: The value
+ */
+static void addAV(HashMap *pMap, int attrIdx, int valIdx) {
+    IntSet **ppSetVals = (IntSet **)iHashMap.Get(pMap, &attrIdx);
+    if (ppSetVals == NULL) {
+        IntSet *pSetVals = iIntSet.Create();
+        iHashMap.Put(pMap, &attrIdx, &pSetVals);
+        ppSetVals = (IntSet **)iHashMap.Get(pMap, &attrIdx);
+    }
+    iIntSet.Add(*ppSetVals, valIdx);
+}
+
+/**
+ * Check whether an attribute value is in a map from attributes to value sets (IntSet).
+ * 
+ * @param pMap[in]: The map
+ * @param attrIdx[in]: The attribute
+ * @param valIdx[in]: The value
+ * @return 1 if the value is in the set of the attribute, 0 otherwise
+ */
+static int containsAV(HashMap *pMap, int attrIdx, int valIdx) {
+    IntSet **ppSetVals = (IntSet **)iHashMap.Get(pMap, &attrIdx);
+    return ppSetVals != NULL && iIntSet.Contains(*ppSetVals, valIdx);
+}
+
+int computeQueryDepth(AABACInstance *pInst) {
+    HashMap *pMapInitAVs = iHashBasedTable.GetRow(pInst->pTableInitState, &pInst->queryUserIdx);
+    HashMap *pmapReachableAVs = iHashMap.Create(sizeof(int), sizeof(IntSet *), IntHashCode, IntEqual);
+    iHashMap.SetDestructValue(pmapReachableAVs, iIntSet.DestructPointer);
+    HASHMAP_FOREACH(slot, pMapInitAVs) {
+        addAV(pmapReachableAVs, *(int *)HashMapSlotKey(pMapInitAVs, slot), *(int *)HashMapSlotValue(pMapInitAVs, slot));
+    }
+
+    // Every action changes a single attribute, so each query attribute not initially at its query value takes one step
+    int *pAttrIdx, *pInitValIdx, changes = 0;
+    HASHMAP_FOREACH(slot, pInst->pmapQueryAVs) {
+        pAttrIdx = (int *)HashMapSlotKey(pInst->pmapQueryAVs, slot);
+        pInitValIdx = (int *)iHashMap.Get(pMapInitAVs, pAttrIdx);
+        if (pInitValIdx == NULL || *pInitValIdx != *(int *)HashMapSlotValue(pInst->pmapQueryAVs, slot)) {
+            changes++;
+        }
+    }
+
+    // Layer by layer, fire the rules whose user conditions are met by the values reachable before the layer.
+    // The first layer tries every rule, later layers only the rules that have a precondition reached by the previous layer
+    IntSet *pSetFired = iIntSet.Create();
+    HashMap *pmapIncrement = NULL, *pmapNewIncrement;
+    IntSet **ppSetRuleIdxes;
+    int depth = 0, satisfied = 0;
+    while (1) {
+        satisfied = 1;
+        HASHMAP_FOREACH(slot, pInst->pmapQueryAVs) {
+            if (!containsAV(pmapReachableAVs, *(int *)HashMapSlotKey(pInst->pmapQueryAVs, slot),
+                            *(int *)HashMapSlotValue(pInst->pmapQueryAVs, slot))) {
+                satisfied = 0;
+                break;
+            }
+        }
+        if (satisfied || (pmapIncrement != NULL && iHashMap.Size(pmapIncrement) == 0)) {
+            break;
+        }
+
+        pmapNewIncrement = iHashMap.Create(sizeof(int), sizeof(IntSet *), IntHashCode, IntEqual);
+        iHashMap.SetDestructValue(pmapNewIncrement, iIntSet.DestructPointer);
+        if (pmapIncrement == NULL) {
+            INTSET_FOREACH(candidate, pInst->pSetRuleIdxes) {
+                if (iRuleStore.IsEffective(pRuleStore, candidate, pmapReachableAVs)) {
+                    iIntSet.Add(pSetFired, candidate);
+                    if (!containsAV(pmapReachableAVs, pRuleStore->targetAttrs[candidate], pRuleStore->targetValues[candidate])) {
+                        addAV(pmapNewIncrement, pRuleStore->targetAttrs[candidate], pRuleStore->targetValues[candidate]);
+                    }
+                }
+            }
+        } else {
+            HASHMAP_FOREACH(slot, pmapIncrement) {
+                pAttrIdx = (int *)HashMapSlotKey(pmapIncrement, slot);
+                INTSET_FOREACH(valIdx, *(IntSet **)HashMapSlotValue(pmapIncrement, slot)) {
+                    ppSetRuleIdxes = (IntSet **)iPackedTable.Get(pInst->pTablePrecond2Rule, *pAttrIdx, valIdx);
+                    if (ppSetRuleIdxes == NULL) {
+                        continue;
+                    }
+                    INTSET_FOREACH(candidate, *ppSetRuleIdxes) {
+                        if (iIntSet.Contains(pSetFired, candidate) || !iIntSet.Contains(pInst->pSetRuleIdxes, candidate) ||
+                            !iRuleStore.IsEffective(pRuleStore, candidate, pmapReachableAVs)) {
+                            continue;
+                        }
+                        iIntSet.Add(pSetFired, candidate);
+                        if (!containsAV(pmapReachableAVs, pRuleStore->targetAttrs[candidate], pRuleStore->targetValues[candidate])) {
+                            addAV(pmapNewIncrement, pRuleStore->targetAttrs[candidate], pRuleStore->targetValues[candidate]);
+                        }
+                    }
+                }
+            }
+            iHashMap.Finalize(pmapIncrement);
+        }
+
+        // The values reached by this layer only become usable in the next one
+        HASHMAP_FOREACH(slot, pmapNewIncrement) {
+            INTSET_FOREACH(valIdx, *(IntSet **)HashMapSlotValue(pmapNewIncrement, slot)) {
+                addAV(pmapReachableAVs, *(int *)HashMapSlotKey(pmapNewIncrement, slot), valIdx);
+            }
+        }
+        pmapIncrement = pmapNewIncrement;
+        depth++;
+    }
+    if (pmapIncrement != NULL) {
+        iHashMap.Finalize(pmapIncrement);
+    }
+    iIntSet.Finalize(pSetFired);
+    iHashMap.Finalize(pmapReachableAVs);
+
+    if (!satisfied) {
+        return -1;
+    }
+    return depth > changes ? depth : changes;
+}
+
 BigInteger computeBound(AABACInstance *pInst, int tl) {
     switch (tl) {
     case 1:
@@ -0,0 +1,589 @@
+#include <fcntl.h>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "AABACIO.h"
+#include "AABACUtils.h"
+
+/*
+ * Layout of a binary policy image. Every field is a native int unless stated otherwise, so an image
+ * can only be read on a machine with the same int size and byte order (checked by the header).
+ *
+ *   header       : magic "AABACIMG" (8 bytes), version, byte order mark 0x01020304
+ *   users        : string table, see writeStrings
+ *   attributes   : string table
+ *   values       : string table
+ *   attr meta    : nAttrMeta, types[nAttrMeta], defaults[nAttrMeta]
+ *   conditions   : count, then per condition nAtoms and (attribute, value, op) per atom, in id order
+ *   rule store   : the compiled rules, see iRuleStore.Save
+ *   rules        : count, then per rule (adminCondId, userCondId, hasUserCondValue)
+ *   instance     : nUsers, users[nUsers], queryUserIdx, nQueryAVs, (attr, value) per query pair,
+ *                  nUAVs, (user, attr, value) per initial assignment,
+ *                  nDomains, (attr, nValues, values[nValues]) per domain,
+ *                  nRules, ruleIdxes[nRules],
+ *                  TargetAV2Rule and Precond2Rule, each as nCells, (attr, value, nRules, ruleIdxes[nRules]) per cell
+ */
+
+#define IMAGE_MAGIC "AABACIMG"
+#define IMAGE_MAGIC_LEN 8
+#define IMAGE_VERSION 1
+#define IMAGE_BYTE_ORDER 0x01020304
+
+/**
+ * A bounded cursor over the mapped image.
+ */
+typedef struct _ImageCursor {
+    const char *cur;
+    const char *end;
+    int ok; // 0 once a read has run past the end of the image
+} ImageCursor;
+
+static void writeInt(FILE *fp, int value) {
+    fwrite(&value, sizeof(int), 1, fp);
+}
+
+/**
+ * Write a string table: count, the byte length of the character area (padded to a multiple of
+ * sizeof(int)), the offset of every string in the area, then the area of '\0'-terminated strings.
+ */
+static void writeStrings(FILE *fp, strCollection *psc) {
+    int count = (int)istrCollection.Size(psc), i, nBytes = 0;
+    int *offsets = (int *)malloc((count + 1) * sizeof(int));
+    for (i = 0; i < count; i++) {
+        offsets[i] = nBytes;
+        nBytes += strlen(istrCollection.GetElement(psc, i)) + 1;
+    }
+    int padding = (int)((sizeof(int) - nBytes % sizeof(int)) % sizeof(int));
+    writeInt(fp, count);
+    writeInt(fp, nBytes + padding);
+    fwrite(offsets, sizeof(int), count, fp);
+    for (i = 0; i < count; i++) {
+        fputs(istrCollection.GetElement(psc, i), fp);
+        fputc('\0', fp);
+    }
+    for (i = 0; i < padding; i++) {
+        fputc('\0', fp);
+    }
+    free(offsets);
+}
+
+/**
+ * Write a table from attribute-value pairs to sets of rule indices.
+ */
+static void writeAV2RuleTable(FILE *fp, PackedTable *pTable) {
+    HashMap *pCellMap = pTable->pCellMap;
+    unsigned long long key;
+    IntSet *pSetRuleIdxes;
+    writeInt(fp, iHashMap.Size(pCellMap));
+    HASHMAP_FOREACH(slot, pCellMap) {
+        key = *(unsigned long long *)HashMapSlotKey(pCellMap, slot);
+        pSetRuleIdxes = *(IntSet **)HashMapSlotValue(pCellMap, slot);
+        writeInt(fp, PackedTableKeyRow(key));
+        writeInt(fp, PackedTableKeyCol(key));
+        writeInt(fp, iIntSet.Size(pSetRuleIdxes));
+        INTSET_FOREACH(ruleIdx, pSetRuleIdxes) {
+            writeInt(fp, ruleIdx);
+        }
+    }
+}
+
+int writeAABACImage(AABACInstance *pInst, char *filename) {
+    logAABAC(__func__, __LINE__, 0, INFO, "[start] writing AABAC image to file %s\n", filename);
+    if (pRuleStore == NULL) {
+        logAABAC(__func__, __LINE__, 0, ERROR, "the instance must be initialized before its image is written\n");
+        return -1;
+    }
+    FILE *fp = fopen(filename, "wb");
+    if (fp == NULL) {
+        logAABAC(__func__, __LINE__, 0, ERROR, "Failed to open file: %s\n", filename);
+        return -1;
+    }
+
+    fwrite(IMAGE_MAGIC, 1, IMAGE_MAGIC_LEN, fp);
+    writeInt(fp, IMAGE_VERSION);
+    writeInt(fp, IMAGE_BYTE_ORDER);
+
+    // 全局符号表与属性元数据
+    writeStrings(fp, pscUsers);
+    writeStrings(fp, pscAttrs);
+    writeStrings(fp, pscValues);
+    writeInt(fp, nAttrMeta);
+    fwrite(pAttr2Type, sizeof(AttrType), nAttrMeta, fp);
+    fwrite(pAttr2DefVal, sizeof(int), nAttrMeta, fp);
+
+    // 条件表
+    int i, nConds = iCondition.Count();
+    Condition *cond;
+    AtomCondition *pAtomCond;
+    writeInt(fp, nConds);
+    for (i = 0; i < nConds; i++) {
+        cond = iCondition.GetById(i);
+        writeInt(fp, iHashSet.Size(cond->atoms));
+        HASHSET_FOREACH(slot, cond->atoms) {
+            pAtomCond = (AtomCondition *)HashSetSlotElement(cond->atoms, slot);
+            writeInt(fp, pAtomCond->attribute);
+            writeInt(fp, pAtomCond->value);
+            writeInt(fp, pAtomCond->op);
+        }
+    }
+
+    // 规则：编译后的规则存储已包含目标与离散化后的用户条件
+    iRuleStore.Save(pRuleStore, fp);
+    int nRules = iVector.Size(pVecRules);
+    Rule *pRule;
+    writeInt(fp, nRules);
+    for (i = 0; i < nRules; i++) {
+        pRule = (Rule *)iVector.GetElement(pVecRules, i);
+        writeInt(fp, pRule->adminCond->id);
+        writeInt(fp, pRule->userCond->id);
+        writeInt(fp, pRule->pmapUserCondValue != NULL);
+    }
+
+    // 实例
+    int nUsers = iVector.Size(pInst->pVecUserIndices);
+    writeInt(fp, nUsers);
+    for (i = 0; i < nUsers; i++) {
+        writeInt(fp, *(int *)iVector.GetElement(pInst->pVecUserIndices, i));
+    }
+    writeInt(fp, pInst->queryUserIdx);
+    HashMap *pmapQueryAVs = pInst->pmapQueryAVs;
+    writeInt(fp, iHashMap.Size(pmapQueryAVs));
+    HASHMAP_FOREACH(slot, pmapQueryAVs) {
+        writeInt(fp, *(int *)HashMapSlotKey(pmapQueryAVs, slot));
+        writeInt(fp, *(int *)HashMapSlotValue(pmapQueryAVs, slot));
+    }
+
+    HashMap *pRowMap = pInst->pTableInitState->pRowMap, *pmapAVs;
+    int nUAVs = 0;
+    HASHMAP_FOREACH(rowSlot, pRowMap) {
+        nUAVs += iHashMap.Size(*(HashMap **)HashMapSlotValue(pRowMap, rowSlot));
+    }
+    writeInt(fp, nUAVs);
+    HASHMAP_FOREACH(rowSlot, pRowMap) {
+        pmapAVs = *(HashMap **)HashMapSlotValue(pRowMap, rowSlot);
+        HASHMAP_FOREACH(colSlot, pmapAVs) {
+            writeInt(fp, *(int *)HashMapSlotKey(pRowMap, rowSlot));
+            writeInt(fp, *(int *)HashMapSlotKey(pmapAVs, colSlot));
+            writeInt(fp, *(int *)HashMapSlotValue(pmapAVs, colSlot));
+        }
+    }
+
+    HashMap *pMapAttr2Dom = pInst->pMapAttr2Dom;
+    IntSet *pSetDom;
+    writeInt(fp, iHashMap.Size(pMapAttr2Dom));
+    HASHMAP_FOREACH(slot, pMapAttr2Dom) {
+        pSetDom = *(IntSet **)HashMapSlotValue(pMapAttr2Dom, slot);
+        writeInt(fp, *(int *)HashMapSlotKey(pMapAttr2Dom, slot));
+        writeInt(fp, iIntSet.Size(pSetDom));
+        INTSET_FOREACH(valIdx, pSetDom) {
+            writeInt(fp, valIdx);
+        }
+    }
+
+    writeInt(fp, iIntSet.Size(pInst->pSetRuleIdxes));
+    INTSET_FOREACH(ruleIdx, pInst->pSetRuleIdxes) {
+        writeInt(fp, ruleIdx);
+    }
+    writeAV2RuleTable(fp, pInst->pTableTargetAV2Rule);
+    writeAV2RuleTable(fp, pInst->pTablePrecond2Rule);
+
+    int failed = ferror(fp);
+    if (fclose(fp) != 0 || failed) {
+        logAABAC(__func__, __LINE__, 0, ERROR, "Failed to write file: %s\n", filename);
+        return -1;
+    }
+    logAABAC(__func__, __LINE__, 0, INFO, "[end] writing AABAC image to file %s\n", filename);
+    return 0;
+}
+
+/**
+ * Get a pointer to the next @{n} ints of the image and advance the cursor.
+ *
+ * @return The pointer, or NULL (with the cursor marked as failed) if the image is too short
+ */
+static const int *takeInts(ImageCursor *cursor, int n) {
+    if (!cursor->ok || n < 0 || (size_t)(cursor->end - cursor->cur) < (size_t)n * sizeof(int)) {
+        cursor->ok = 0;
+        return NULL;
+    }
+    const int *p = (const int *)cursor->cur;
+    cursor->cur += (size_t)n * sizeof(int);
+    return p;
+}
+
+static int takeInt(ImageCursor *cursor) {
+    const int *p = takeInts(cursor, 1);
+    return p == NULL ? 0 : *p;
+}
+
+/**
+ * Read the number of items of a list whose items take @{width} ints each, and check that the
+ * list fits in the rest of the image, so that a corrupted count cannot cause a huge allocation.
+ *
+ * @return The number of items, or 0 (with the cursor marked as failed) if the count is invalid
+ */
+static int takeCount(ImageCursor *cursor, int width) {
+    int n = takeInt(cursor);
+    if (!cursor->ok || n < 0 || n > INT_MAX / width ||
+        (size_t)(cursor->end - cursor->cur) / sizeof(int) < (size_t)n * width) {
+        cursor->ok = 0;
+        return 0;
+    }
+    return n;
+}
+
+static int validUser(int userIdx) {
+    return userIdx >= 0 && userIdx < (int)istrCollection.Size(pscUsers);
+}
+
+static int validAttr(int attrIdx) {
+    return attrIdx >= 0 && attrIdx < nAttrMeta;
+}
+
+/**
+ * Check that a value index belongs to the domain of the type of an attribute.
+ */
+static int validValue(int attrIdx, int valueIdx) {
+    switch (pAttr2Type[attrIdx]) {
+    case BOOLEAN:
+        return valueIdx == 0 || valueIdx == 1;
+    case STRING:
+        return valueIdx >= 0 && valueIdx < (int)istrCollection.Size(pscValues);
+    default:
+        return 1;
+    }
+}
+
+static int validAV(int attrIdx, int valueIdx) {
+    return validAttr(attrIdx) && validValue(attrIdx, valueIdx);
+}
+
+/**
+ * Read a string table written by @{writeStrings} and intern its strings in order.
+ * The strings are read in place from the mapped image.
+ */
+static void readStrings(ImageCursor *cursor, strCollection *psc, Dictionary *pdict) {
+    int count = takeCount(cursor, 1);
+    int nBytes = takeInt(cursor);
+    const int *offsets = takeInts(cursor, count);
+    const char *area = (const char *)takeInts(cursor, nBytes / (int)sizeof(int));
+    if (!cursor->ok || (nBytes <= 0 && count > 0) || (nBytes > 0 && area[nBytes - 1] != '\0')) {
+        cursor->ok = 0;
+        return;
+    }
+    int i;
+    for (i = 0; i < count; i++) {
+        if (offsets[i] < 0 || offsets[i] >= nBytes) {
+            cursor->ok = 0;
+            return;
+        }
+        // 与读取文本策略时一致：字典中已有的名字（如多个string属性共用的默认值""）保留先出现的下标
+        iDictionary.Insert(pdict, area + offsets[i], &i);
+        istrCollection.Add(psc, area + offsets[i]);
+    }
+}
+
+/**
+ * Read a table from attribute-value pairs to sets of rule indices written by @{writeAV2RuleTable}.
+ * Every index is checked against the attribute metadata and the @{nRules} rules of the image.
+ */
+static void readAV2RuleTable(ImageCursor *cursor, AABACInstance *pInst, PackedTable *pTable, int nRules) {
+    int nCells = takeCount(cursor, 3), i, j, attrIdx, valueIdx, nCellRules;
+    const int *ruleIdxes;
+    IntSet *pSetRuleIdxes;
+    for (i = 0; i < nCells && cursor->ok; i++) {
+        attrIdx = takeInt(cursor);
+        valueIdx = takeInt(cursor);
+        nCellRules = takeCount(cursor, 1);
+        ruleIdxes = takeInts(cursor, nCellRules);
+        if (ruleIdxes == NULL || !validAV(attrIdx, valueIdx)) {
+            cursor->ok = 0;
+            return;
+        }
+        pSetRuleIdxes = iIntSet.CreateInPool(pInst->pool);
+        for (j = 0; j < nCellRules; j++) {
+            if (ruleIdxes[j] < 0 || ruleIdxes[j] >= nRules) {
+                cursor->ok = 0;
+                return;
+            }
+            iIntSet.Add(pSetRuleIdxes, ruleIdxes[j]);
+        }
+        iPackedTable.Put(pTable, attrIdx, valueIdx, &pSetRuleIdxes);
+    }
+}
+
+/**
+ * Check the targets and the discretized user conditions of the rule store against the attribute metadata.
+ * The ranges of the store have already been checked by @{iRuleStore.Load}.
+ */
+static int validRuleStore(RuleStore *store) {
+    int i;
+    for (i = 0; i < store->nRules; i++) {
+        if (!validAV(store->targetAttrs[i], store->targetValues[i])) {
+            return 0;
+        }
+    }
+    for (i = 0; i < store->nConds; i++) {
+        if (!validAttr(store->condAttrs[i])) {
+            return 0;
+        }
+        RULESTORE_VALUE_FOREACH(valIdx, store, i) {
+            if (!validValue(store->condAttrs[i], valIdx)) {
+                return 0;
+            }
+        }
+    }
+    return 1;
+}
+
+/**
+ * Rebuild the discretized user condition of a rule from its entries in the rule store.
+ */
+static HashMap *userCondValueOf(RuleStore *store, int ruleIdx) {
+    HashMap *pmapUserCondValue = iHashMap.Create(sizeof(int), sizeof(IntSet *), IntHashCode, IntEqual);
+    iHashMap.SetDestructValue(pmapUserCondValue, iIntSet.DestructPointer);
+    IntSet *pSetVals;
+    RULESTORE_COND_FOREACH(cond, store, ruleIdx) {
+        pSetVals = iIntSet.Create();
+        RULESTORE_VALUE_FOREACH(valIdx, store, cond) {
+            iIntSet.Add(pSetVals, valIdx);
+        }
+        iHashMap.Put(pmapUserCondValue, &store->condAttrs[cond], &pSetVals);
+    }
+    return pmapUserCondValue;
+}
+
+/**
+ * Read the instance part of the image. Every index is checked before it is used.
+ *
+ * @return 0 if the instance is complete and valid, -1 otherwise
+ */
+static int loadInstance(ImageCursor *cursor, AABACInstance *pInst, int nRules) {
+    int i, j;
+    int nUsers = takeCount(cursor, 1);
+    const int *users = takeInts(cursor, nUsers);
+    for (i = 0; i < nUsers && users != NULL; i++) {
+        if (!validUser(users[i])) {
+            return -1;
+        }
+        iVector.Add(pInst->pVecUserIndices, &users[i]);
+    }
+    pInst->queryUserIdx = takeInt(cursor);
+    if (cursor->ok && !validUser(pInst->queryUserIdx)) {
+        return -1;
+    }
+    int nQueryAVs = takeCount(cursor, 2);
+    const int *queryAVs = takeInts(cursor, nQueryAVs * 2);
+    for (i = 0; i < nQueryAVs && queryAVs != NULL; i++) {
+        if (!validAV(queryAVs[2 * i], queryAVs[2 * i + 1])) {
+            return -1;
+        }
+        iHashMap.Put(pInst->pmapQueryAVs, (void *)&queryAVs[2 * i], (void *)&queryAVs[2 * i + 1]);
+    }
+    int nUAVs = takeCount(cursor, 3);
+    const int *uavs = takeInts(cursor, nUAVs * 3);
+    for (i = 0; i < nUAVs && uavs != NULL; i++) {
+        if (!validUser(uavs[3 * i]) || !validAV(uavs[3 * i + 1], uavs[3 * i + 2])) {
+            return -1;
+        }
+        iHashBasedTable.Put(pInst->pTableInitState, (void *)&uavs[3 * i], (void *)&uavs[3 * i + 1], (void *)&uavs[3 * i + 2]);
+    }
+    int nDomains = takeCount(cursor, 2), attrIdx, nValues;
+    const int *values;
+    for (i = 0; i < nDomains && cursor->ok; i++) {
+        attrIdx = takeInt(cursor);
+        nValues = takeCount(cursor, 1);
+        values = takeInts(cursor, nValues);
+        if (values == NULL || !validAttr(attrIdx)) {
+            return -1;
+        }
+        for (j = 0; j < nValues; j++) {
+            if (!validValue(attrIdx, values[j])) {
+                return -1;
+            }
+            addAVByIdx(pInst, attrIdx, values[j]);
+        }
+    }
+    int nInstRules = takeCount(cursor, 1);
+    const int *ruleIdxes = takeInts(cursor, nInstRules);
+    for (i = 0; i < nInstRules && ruleIdxes != NULL; i++) {
+        if (ruleIdxes[i] < 0 || ruleIdxes[i] >= nRules) {
+            return -1;
+        }
+        iIntSet.Add(pInst->pSetRuleIdxes, ruleIdxes[i]);
+    }
+    readAV2RuleTable(cursor, pInst, pInst->pTableTargetAV2Rule, nRules);
+    readAV2RuleTable(cursor, pInst, pInst->pTablePrecond2Rule, nRules);
+    return cursor->ok ? 0 : -1;
+}
+
+/**
+ * Load the global variables and the instance from the mapped image.
+ * The rules and the rule store are published to @{pVecRules} and @{pRuleStore} only once the
+ * whole image has been read and checked.
+ *
+ * @return 0 if the image is complete and valid, -1 otherwise
+ */
+static int loadImage(ImageCursor *cursor, AABACInstance *pInst) {
+    int i, j;
+
+    // 全局符号表与属性元数据
+    readStrings(cursor, pscUsers, pdictUser2Index);
+    readStrings(cursor, pscAttrs, pdictAttr2Index);
+    readStrings(cursor, pscValues, pdictValue2Index);
+    int nAttrs = takeCount(cursor, 2);
+    const int *types = takeInts(cursor, nAttrs);
+    const int *defVals = takeInts(cursor, nAttrs);
+    if (!cursor->ok) {
+        return -1;
+    }
+    for (i = 0; i < nAttrs; i++) {
+        if (types[i] != BOOLEAN && types[i] != STRING && types[i] != INTEGER) {
+            return -1;
+        }
+        addAttrMeta(i, (AttrType)types[i], defVals[i]);
+        if (!validValue(i, defVals[i])) {
+            return -1;
+        }
+    }
+
+    // 条件表，按编号顺序驻留
+    int nConds = takeCount(cursor, 1), nAtoms;
+    const int *atoms;
+    Condition **conds = (Condition **)calloc(nConds > 0 ? nConds : 1, sizeof(Condition *));
+    HashSet *pSetAtoms;
+    AtomCondition atomCond;
+    for (i = 0; i < nConds && cursor->ok; i++) {
+        nAtoms = takeCount(cursor, 3);
+        atoms = takeInts(cursor, nAtoms * 3);
+        if (atoms == NULL) {
+            break;
+        }
+        pSetAtoms = iHashSet.Create(sizeof(AtomCondition), iAtomCondition.HashCode, iAtomCondition.Equal);
+        for (j = 0; j < nAtoms; j++) {
+            atomCond = (AtomCondition){.attribute = atoms[3 * j], .value = atoms[3 * j + 1], .op = (comparisonOperator)atoms[3 * j + 2]};
+            if (!validAV(atomCond.attribute, atomCond.value) || atoms[3 * j + 2] < EQUAL || atoms[3 * j + 2] > GREATER_THAN_OR_EQUAL) {
+                cursor->ok = 0;
+                break;
+            }
+            iHashSet.Add(pSetAtoms, &atomCond);
+        }
+        if (!cursor->ok) {
+            iHashSet.Finalize(pSetAtoms);
+            break;
+        }
+        conds[i] = iCondition.Intern(pSetAtoms);
+    }
+
+    // 规则，先在局部数组中建立，整个镜像校验通过后再发布
+    size_t consumed = 0;
+    RuleStore *store = cursor->ok ? iRuleStore.Load(cursor->cur, cursor->end - cursor->cur, &consumed) : NULL;
+    if (store == NULL) {
+        free(conds);
+        return -1;
+    }
+    cursor->cur += consumed;
+    int nRules = takeCount(cursor, 3), adminCondId, userCondId;
+    const int *ruleFields = takeInts(cursor, nRules * 3);
+    if (ruleFields == NULL || nRules != store->nRules || !validRuleStore(store)) {
+        free(conds);
+        iRuleStore.Finalize(store);
+        return -1;
+    }
+    Rule *rules = (Rule *)calloc(nRules > 0 ? nRules : 1, sizeof(Rule));
+    int ret = 0;
+    for (i = 0; i < nRules; i++) {
+        adminCondId = ruleFields[3 * i];
+        userCondId = ruleFields[3 * i + 1];
+        if (adminCondId < 0 || adminCondId >= nConds || userCondId < 0 || userCondId >= nConds) {
+            ret = -1;
+            break;
+        }
+        rules[i].adminCond = conds[adminCondId];
+        rules[i].userCond = conds[userCondId];
+        rules[i].targetAttrIdx = store->targetAttrs[i];
+        rules[i].targetValueIdx = store->targetValues[i];
+        rules[i].pmapUserCondValue = ruleFields[3 * i + 2] ? userCondValueOf(store, i) : NULL;
+        iRule.UpdateHashCode(&rules[i]);
+    }
+    free(conds);
+
+    // 实例
+    if (ret == 0) {
+        ret = loadInstance(cursor, pInst, nRules);
+    }
+    if (ret == 0) {
+        for (i = 0; i < nRules; i++) {
+            iVector.Add(pVecRules, &rules[i]);
+        }
+        pRuleStore = store;
+    } else {
+        for (i = 0; i < nRules; i++) {
+            iHashMap.Finalize(rules[i].pmapUserCondValue);
+        }
+        iRuleStore.Finalize(store);
+    }
+    free(rules);
+    return ret;
+}
+
+AABACInstance *readAABACImage(char *filename) {
+    logAABAC(__func__, __LINE__, 0, INFO, "[start] reading AABAC image from file %s\n", filename);
+    clock_t startReading = clock();
+
+    int fd = open(filename, O_RDONLY);
+    if (fd < 0) {
+        logAABAC(__func__, __LINE__, 0, ERROR, "Failed to open file: %s\n", filename);
+        return NULL;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size < IMAGE_MAGIC_LEN + 2 * (off_t)sizeof(int)) {
+        logAABAC(__func__, __LINE__, 0, ERROR, "%s is not an AABAC image\n", filename);
+        close(fd);
+        return NULL;
+    }
+    size_t size = (size_t)st.st_size;
+    const char *data = (const char *)mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) {
+        logAABAC(__func__, __LINE__, 0, ERROR, "Failed to map file: %s\n", filename);
+        return NULL;
+    }
+
+    ImageCursor cursor = {.cur = data + IMAGE_MAGIC_LEN, .end = data + size, .ok = 1};
+    int version = takeInt(&cursor), byteOrder = takeInt(&cursor);
+    if (memcmp(data, IMAGE_MAGIC, IMAGE_MAGIC_LEN) != 0 || version != IMAGE_VERSION || byteOrder != IMAGE_BYTE_ORDER) {
+        logAABAC(__func__, __LINE__, 0, ERROR, "%s is not an AABAC image of version %d for this machine\n", filename, IMAGE_VERSION);
+        munmap((void *)data, size);
+        return NULL;
+    }
+
+    initGlobalVars();
+    AABACInstance *pInst = createAABACInstance();
+    int ret = loadImage(&cursor, pInst);
+    munmap((void *)data, size);
+    if (ret) {
+        logAABAC(__func__, __LINE__, 0, ERROR, "the AABAC image %s is truncated or corrupted\n", filename);
+        finalizeAABACInstance(pInst);
+        // 丢弃已读入的符号表、属性元数据与条件，全局变量回到初始状态
+        finalizeGlobalVars();
+        initGlobalVars();
+        return NULL;
+    }
+
+    // 名称字典此后只读，冻结为完美哈希表
+    freezeSymbolTables();
+    // 镜像跳过了init()，取值记号表需在此建立
+    buildValueTokens(pInst);
+
+    double timeSpent = (double)(clock() - startReading) / CLOCKS_PER_SEC * 1000;
+    logAABAC(__func__, __LINE__, 0, INFO, "[end] reading AABAC image, cost => %.2fms\n", timeSpent);
+    logAABAC(__func__, __LINE__, 0, INFO, "users: %d, attributes: %d, rules: %d\n", iVector.Size(pInst->pVecUserIndices), nAttrMeta, iIntSet.Size(pInst->pSetRuleIdxes));
+    return pInst;
+}
@@ -2,6 +2,8 @@
 #include "AABACUtils.h"
 #include "ccl/ccl_internal.h"
 
+#include <limits.h>
+#include <pthread.h>
 #include <time.h>
 
 strCollection *pscUsers = NULL;
@@ -16,12 +18,54 @@ strCollection *pscValues = NULL;
 
 Dictionary *pdictValue2Index = NULL;
 
-HashMap *pmapAttr2Type = NULL;
+AttrType *pAttr2Type = NULL;
 
-HashMap *pmapAttr2DefVal = NULL;
+int *pAttr2DefVal = NULL;
+
+int nAttrMeta = 0;
+
+// The capacity of @{pAttr2Type} and @{pAttr2DefVal}
+static int attrMetaCapacity = 0;
 
 Vector *pVecRules = NULL;
 
+RuleStore *pRuleStore = NULL;
+
+// Frozen copies of the name dictionaries, NULL until freezeSymbolTables() is called
+static FrozenDict *pfdUser2Index = NULL;
+
+static FrozenDict *pfdAttr2Index = NULL;
+
+static FrozenDict *pfdValue2Index = NULL;
+
+// The maximum length of a rendered integer value, including the sign and the terminating '\0'
+#define INT_TOKEN_LEN 12
+
+// The value token table is only built densely for integers if the span of the integer values is at most this,
+// or at most 4 times the number of integer values
+#define MAX_INT_TOKEN_SPAN (1 << 16)
+
+static ValueToken boolTokens[2] = {{"false", 5}, {"true", 4}};
+
+// The value token table, empty until buildValueTokens() is called
+// String tokens parallel @{pscValues}; integer tokens cover the values from intTokenMin to intTokenMin + nIntTokens - 1
+static ValueToken *pStrTokens = NULL;
+
+static int nStrTokens = 0;
+
+static ValueToken *pIntTokens = NULL;
+
+static char *intTokenChars = NULL;
+
+static int intTokenMin = 0;
+
+static int nIntTokens = 0;
+
+// Tokens of the values not covered by the table, keyed by (datatype, value index) and rendered on first use
+static HashMap *pmapExtraTokens = NULL;
+
+static pthread_mutex_t extraTokensLock = PTHREAD_MUTEX_INITIALIZER;
+
 /**
  * Hash code for a rule index.
  * If two rule indices point to two rules with the same content, they should have the same hash code.
@@ -58,6 +102,23 @@ static int RuleIdxEqual(void *pRuleIdx1, void *pRuleIdx2) {
     return iRule.Equal(pRule1, pRule2);
 }
 
+/**
+ * Release the value token table, including the tokens rendered on demand.
+ */
+static void clearValueTokens() {
+    free(pStrTokens);
+    pStrTokens = NULL;
+    nStrTokens = 0;
+    free(pIntTokens);
+    pIntTokens = NULL;
+    free(intTokenChars);
+    intTokenChars = NULL;
+    intTokenMin = 0;
+    nIntTokens = 0;
+    iHashMap.Finalize(pmapExtraTokens);
+    pmapExtraTokens = NULL;
+}
+
 void initGlobalVars() {
     pscUsers = istrCollection.Create(2);
     pdictUser2Index = iDictionary.Create(sizeof(int), 2);
@@ -65,8 +126,10 @@ void initGlobalVars() {
     pdictAttr2Index = iDictionary.Create(sizeof(int), 0);
     pscValues = istrCollection.Create(0);
     pdictValue2Index = iDictionary.Create(sizeof(int), 0);
-    pmapAttr2Type = iHashMap.Create(sizeof(int), sizeof(int), IntHashCode, IntEqual);
-    pmapAttr2DefVal = iHashMap.Create(sizeof(int), sizeof(int), IntHashCode, IntEqual);
+    pAttr2Type = NULL;
+    pAttr2DefVal = NULL;
+    nAttrMeta = 0;
+    attrMetaCapacity = 0;
     pVecRules = iVector.Create(sizeof(Rule), 0);
 }
 
@@ -77,50 +140,113 @@ void finalizeGlobalVars() {
     iDictionary.Finalize(pdictAttr2Index);
     istrCollection.Finalize(pscValues);
     iDictionary.Finalize(pdictValue2Index);
-    iHashMap.Finalize(pmapAttr2Type);
-    iHashMap.Finalize(pmapAttr2DefVal);
+    iFrozenDict.Finalize(pfdUser2Index);
+    pfdUser2Index = NULL;
+    iFrozenDict.Finalize(pfdAttr2Index);
+    pfdAttr2Index = NULL;
+    iFrozenDict.Finalize(pfdValue2Index);
+    pfdValue2Index = NULL;
+    free(pAttr2Type);
+    pAttr2Type = NULL;
+    free(pAttr2DefVal);
+    pAttr2DefVal = NULL;
+    nAttrMeta = 0;
+    attrMetaCapacity = 0;
     for (int i = 0; i < iVector.Size(pVecRules); i++) {
         Rule *pRule = (Rule *)iVector.GetElement(pVecRules, i);
-        iHashSet.Finalize(pRule->adminCond);
-        iHashSet.Finalize(pRule->userCond);
         iHashMap.Finalize(pRule->pmapUserCondValue);
     }
     iVector.Finalize(pVecRules);
+    iRuleStore.Finalize(pRuleStore);
+    pRuleStore = NULL;
+    clearValueTokens();
+    // 规则的条件由条件表统一持有
+    iCondition.ClearTable();
+}
+
+void freezeSymbolTables() {
+    iFrozenDict.Finalize(pfdUser2Index);
+    pfdUser2Index = iFrozenDict.Create(pdictUser2Index);
+    iFrozenDict.Finalize(pfdAttr2Index);
+    pfdAttr2Index = iFrozenDict.Create(pdictAttr2Index);
+    iFrozenDict.Finalize(pfdValue2Index);
+    pfdValue2Index = iFrozenDict.Create(pdictValue2Index);
+}
+
+/**
+ * Look up a name, first in the frozen table (if any) and then in the dictionary.
+ * The dictionary is only consulted for names that were added after the freeze.
+ *
+ * @param pfd[in] The frozen table, or NULL if the dictionary has not been frozen
+ * @param pdict[in] The dictionary
+ * @param name[in] The name
+ * @return A pointer to the index of the name, or NULL if the name does not exist
+ */
+static int *lookupIndex(FrozenDict *pfd, Dictionary *pdict, char *name) {
+    int *pIdx;
+    if (pfd != NULL && (pIdx = iFrozenDict.Get(pfd, name)) != NULL) {
+        return pIdx;
+    }
+    return (int *)iDictionary.GetElement(pdict, name);
 }
 
 AABACInstance *createAABACInstance() {
-    AABACInstance *pInst = (AABACInstance *)malloc(sizeof(AABACInstance));
+    Pool *pool = iPool.Create(NULL);
+    if (pool == NULL) {
+        logAABAC(__func__, __LINE__, 0, ERROR, "Failed to allocate memory pool for AABACInstance\n");
+        return NULL;
+    }
+    AABACInstance *pInst = (AABACInstance *)iPool.Alloc(pool, sizeof(AABACInstance));
     if (pInst == NULL) {
         logAABAC(__func__, __LINE__, 0, ERROR, "Failed to allocate memory for AABACInstance\n");
+        iPool.Finalize(pool);
         return NULL;
     }
+    pInst->pool = pool;
 
     pInst->pVecUserIndices = iVector.Create(sizeof(int), 2);
 
-    pInst->pMapAttr2Dom = iHashMap.Create(sizeof(int), sizeof(HashSet *), IntHashCode, IntEqual);
-    iHashMap.SetDestructValue(pInst->pMapAttr2Dom, iHashSet.DestructPointer); //0xc72fd0
-    pInst->pTableInitState = iHashBasedTable.Create(sizeof(int), sizeof(int), sizeof(int), IntHashCode, IntEqual, IntHashCode, IntEqual);
+    // 以下成员及其中的IntSet都在实例的内存池中分配，随实例一并释放
+    pInst->pMapAttr2Dom = iHashMap.CreateInPool(pool, sizeof(int), sizeof(IntSet *), IntHashCode, IntEqual);
+    pInst->pTableInitState = iHashBasedTable.CreateInPool(pool, sizeof(int), sizeof(int), sizeof(int), IntHashCode, IntEqual, IntHashCode, IntEqual);
 
-    pInst->pSetRuleIdxes = iHashSet.Create(sizeof(int), RuleIdxHashCode, RuleIdxEqual);
+    pInst->pSetRuleIdxes = iIntSet.CreateInPool(pool);
 
-    pInst->pTableTargetAV2Rule = iHashBasedTable.Create(sizeof(int), sizeof(int), sizeof(HashSet *), IntHashCode, IntEqual, IntHashCode, IntEqual);
-    iHashBasedTable.SetDestructValue(pInst->pTableTargetAV2Rule, iHashSet.DestructPointer);
-    pInst->pTablePrecond2Rule = iHashBasedTable.Create(sizeof(int), sizeof(int), sizeof(HashSet *), IntHashCode, IntEqual, IntHashCode, IntEqual);
-    iHashBasedTable.SetDestructValue(pInst->pTablePrecond2Rule, iHashSet.DestructPointer);
+    pInst->pTableTargetAV2Rule = iPackedTable.CreateInPool(pool, sizeof(IntSet *), 1);
+    pInst->pTablePrecond2Rule = iPackedTable.CreateInPool(pool, sizeof(IntSet *), 0);
 
     pInst->queryUserIdx = -1;
-    pInst->pmapQueryAVs = iHashMap.Create(sizeof(int), sizeof(int), IntHashCode, IntEqual);
+    pInst->pmapQueryAVs = iHashMap.CreateInPool(pool, sizeof(int), sizeof(int), IntHashCode, IntEqual);
     return pInst;
 }
 
 void finalizeAABACInstance(AABACInstance *pInst) {
-    iVector.Finalize(pInst->pVecUserIndices);
-    iHashMap.Finalize(pInst->pMapAttr2Dom);
-    iHashBasedTable.Finalize(pInst->pTableInitState);
-    iHashSet.Finalize(pInst->pSetRuleIdxes);
-    iHashBasedTable.Finalize(pInst->pTableTargetAV2Rule);
-    iHashBasedTable.Finalize(pInst->pTablePrecond2Rule);
-    iHashMap.Finalize(pInst->pmapQueryAVs);
+    if (pInst == NULL) {
+        return;
+    }
+    if (pInst->pVecUserIndices != NULL) {
+        iVector.Finalize(pInst->pVecUserIndices);
+    }
+    // 实例本身也在内存池中，释放内存池后不能再访问pInst
+    iPool.Finalize(pInst->pool);
+}
+
+void copyInitState(AABACInstance *pDst, AABACInstance *pSrc) {
+    HashMap *pRowMap = pSrc->pTableInitState->pRowMap, *pmapAVs;
+    HASHMAP_FOREACH(rowSlot, pRowMap) {
+        pmapAVs = *(HashMap **)HashMapSlotValue(pRowMap, rowSlot);
+        HASHMAP_FOREACH(colSlot, pmapAVs) {
+            iHashBasedTable.Put(pDst->pTableInitState, HashMapSlotKey(pRowMap, rowSlot), HashMapSlotKey(pmapAVs, colSlot), HashMapSlotValue(pmapAVs, colSlot));
+        }
+    }
+}
+
+void copyQuery(AABACInstance *pDst, AABACInstance *pSrc) {
+    pDst->queryUserIdx = pSrc->queryUserIdx;
+    HashMap *pmapQueryAVs = pSrc->pmapQueryAVs;
+    HASHMAP_FOREACH(slot, pmapQueryAVs) {
+        iHashMap.Put(pDst->pmapQueryAVs, HashMapSlotKey(pmapQueryAVs, slot), HashMapSlotValue(pmapQueryAVs, slot));
+    }
 }
 
 /**
@@ -175,15 +301,15 @@ static char *stringValueIdxToString(void *pStrValIdx) {
  * @param valueIdx[in] The index of the value
  */
 static void addAV(AABACInstance *pInst, AttrType attrType, int attrIdx, int valueIdx) {
-    HashSet *pDom, **ppDom = iHashMap.Get(pInst->pMapAttr2Dom, &attrIdx);
+    IntSet *pDom, **ppDom = iHashMap.Get(pInst->pMapAttr2Dom, &attrIdx);
     if (ppDom == NULL) {
-        pDom = iHashSet.Create(sizeof(int), IntHashCode, IntEqual);
+        pDom = iIntSet.CreateInPool(pInst->pool);
         ppDom = &pDom;
-        iHashSet.SetElementToString(*ppDom, attrType == BOOLEAN ? boolValueIdxToString : attrType == INTEGER ? intValueIdxToString
+        iIntSet.SetElementToString(*ppDom, attrType == BOOLEAN ? boolValueIdxToString : attrType == INTEGER ? intValueIdxToString
                                                                                                              : stringValueIdxToString);
         iHashMap.Put(pInst->pMapAttr2Dom, &attrIdx, ppDom);
     }
-    iHashSet.Add(*ppDom, &valueIdx);
+    iIntSet.Add(*ppDom, valueIdx);
 }
 
 int addUAV(AABACInstance *pInst, char *user, char *attr, char *value) {
@@ -208,59 +334,86 @@ int addUAVByIdx(AABACInstance *pInst, int userIdx, int attrIdx, int valueIdx) {
     return 0;
 }
 
+void addAVByIdx(AABACInstance *pInst, int attrIdx, int valueIdx) {
+    addAV(pInst, getAttrTypeByIdx(attrIdx), attrIdx, valueIdx);
+}
+
 int addRule(AABACInstance *pInst, int ruleIdx) {
-    if (iHashSet.Contains(pInst->pSetRuleIdxes, &ruleIdx)) {
+    if (!iIntSet.Add(pInst->pSetRuleIdxes, ruleIdx)) {
         logAABAC(__func__, __LINE__, 0, DEBUG, "Rule exists\n");
         return 0;
     }
-    iHashSet.Add(pInst->pSetRuleIdxes, &ruleIdx);
     Rule *r = (Rule *)iVector.GetElement(pVecRules, ruleIdx);
 
     // 建立从TargetAttr与TargetValue到Rule的映射
-    HashSet *psetRuleIdxes, **ppsetRuleIdxes = iHashBasedTable.Get(pInst->pTableTargetAV2Rule, &r->targetAttrIdx, &r->targetValueIdx);
+    IntSet *psetRuleIdxes, **ppsetRuleIdxes = iPackedTable.Get(pInst->pTableTargetAV2Rule, r->targetAttrIdx, r->targetValueIdx);
     if (ppsetRuleIdxes == NULL) {
-        psetRuleIdxes = iHashSet.Create(sizeof(int), IntHashCode, IntEqual);
+        psetRuleIdxes = iIntSet.CreateInPool(pInst->pool);
         ppsetRuleIdxes = &psetRuleIdxes;
-        iHashBasedTable.Put(pInst->pTableTargetAV2Rule, &r->targetAttrIdx, &r->targetValueIdx, ppsetRuleIdxes);
+        iPackedTable.Put(pInst->pTableTargetAV2Rule, r->targetAttrIdx, r->targetValueIdx, ppsetRuleIdxes);
     }
-    iHashSet.Add(*ppsetRuleIdxes, &ruleIdx);
+    iIntSet.Add(*ppsetRuleIdxes, ruleIdx);
 
     // 建立从用户条件属性到Rule的映射
     if (r->pmapUserCondValue != NULL) {
-        int *pAttrIdx, *pValueIdx;
-        HashNode *nodeUserCondValue;
-        HashSet *psetVals;
-
-        HashSet *psetRulesOfAV, **ppsetRulesOfAV;
-        HashNodeIterator *itUserCondValue = iHashMap.NewIterator(r->pmapUserCondValue);
-        HashSetIterator *itVals;
-        while (itUserCondValue->HasNext(itUserCondValue)) {
-            nodeUserCondValue = (HashNode *)itUserCondValue->GetNext(itUserCondValue);
-            pAttrIdx = (int *)nodeUserCondValue->key;
-            psetVals = *(HashSet **)nodeUserCondValue->value;
-
-            itVals = iHashSet.NewIterator(psetVals);
-            while (itVals->HasNext(itVals)) {
-                pValueIdx = (int *)itVals->GetNext(itVals);
-                ppsetRulesOfAV = iHashBasedTable.Get(pInst->pTablePrecond2Rule, pAttrIdx, pValueIdx);
+        int *pAttrIdx;
+        HashMap *pmapUserCondValue = r->pmapUserCondValue;
+        IntSet *psetRulesOfAV, **ppsetRulesOfAV;
+        HASHMAP_FOREACH(slot, pmapUserCondValue) {
+            pAttrIdx = (int *)HashMapSlotKey(pmapUserCondValue, slot);
+            INTSET_FOREACH(valueIdx, *(IntSet **)HashMapSlotValue(pmapUserCondValue, slot)) {
+                ppsetRulesOfAV = iPackedTable.Get(pInst->pTablePrecond2Rule, *pAttrIdx, valueIdx);
                 if (ppsetRulesOfAV == NULL) {
-                    psetRulesOfAV = iHashSet.Create(sizeof(int), IntHashCode, IntEqual);
+                    psetRulesOfAV = iIntSet.CreateInPool(pInst->pool);
                     ppsetRulesOfAV = &psetRulesOfAV;
-                    iHashBasedTable.Put(pInst->pTablePrecond2Rule, pAttrIdx, pValueIdx, ppsetRulesOfAV);
+                    iPackedTable.Put(pInst->pTablePrecond2Rule, *pAttrIdx, valueIdx, ppsetRulesOfAV);
                 }
-                iHashSet.Add(*ppsetRulesOfAV, &ruleIdx);
+                iIntSet.Add(*ppsetRulesOfAV, ruleIdx);
             }
-            iHashSet.DeleteIterator(itVals);
         }
-        iHashMap.DeleteIterator(itUserCondValue);
     }
     AttrType attrType = getAttrTypeByIdx(r->targetAttrIdx);
     addAV(pInst, attrType, r->targetAttrIdx, r->targetValueIdx);
     return 1;
 }
 
+/**
+ * Replace the rules of the instance with the given rule indices, rebuilding the lookup tables.
+ *
+ * @param pInst[in] The AABAC instance
+ * @param pSetRuleIdxes[in] The rule indices to keep
+ */
+static void resetRules(AABACInstance *pInst, IntSet *pSetRuleIdxes) {
+    iIntSet.Clear(pInst->pSetRuleIdxes);
+    iPackedTable.Clear(pInst->pTableTargetAV2Rule);
+    iPackedTable.Clear(pInst->pTablePrecond2Rule);
+
+    INTSET_FOREACH(ruleIdx, pSetRuleIdxes) {
+        addRule(pInst, ruleIdx);
+    }
+}
+
+int dedupRules(AABACInstance *pInst) {
+    int nOldRules = iIntSet.Size(pInst->pSetRuleIdxes);
+    HashSet *pSetUnique = iHashSet.CreateWithCapacity(sizeof(int), RuleIdxHashCode, RuleIdxEqual, nOldRules);
+    IntSet *pSetKept = iIntSet.Create();
+    INTSET_FOREACH(ruleIdx, pInst->pSetRuleIdxes) {
+        if (iHashSet.Add(pSetUnique, &ruleIdx)) {
+            iIntSet.Add(pSetKept, ruleIdx);
+        }
+    }
+    iHashSet.Finalize(pSetUnique);
+
+    int nRemoved = nOldRules - iIntSet.Size(pSetKept);
+    if (nRemoved > 0) {
+        resetRules(pInst, pSetKept);
+    }
+    iIntSet.Finalize(pSetKept);
+    return nRemoved;
+}
+
 int getUserIndex(char *user) {
-    int *i = (int *)iDictionary.GetElement(pdictUser2Index, user);
+    int *i = lookupIndex(pfdUser2Index, pdictUser2Index, user);
     if (i == NULL) {
         logAABAC(__func__, __LINE__, 0, ERROR, "cannot find user %s, please check the policy again\n", user);
         return -1;
@@ -269,7 +422,7 @@ int getUserIndex(char *user) {
 }
 
 int getAttrIndex(char *attr) {
-    int *i = (int *)iDictionary.GetElement(pdictAttr2Index, attr);
+    int *i = lookupIndex(pfdAttr2Index, pdictAttr2Index, attr);
     if (i == NULL) {
         logAABAC(__func__, __LINE__, 0, ERROR, "cannot find attribute %s, please check the policy again\n", attr);
         return -1;
@@ -277,7 +430,7 @@ int getAttrIndex(char *attr) {
     return *i;
 }
 
-int getValueIndex(AttrType attrType, char *value, int *pValueIdx) {
+int findValueIndex(AttrType attrType, char *value, int *pValueIdx) {
     int valueIdx, *pValueIdxLocal;
     char *pEnd;
     switch (attrType) {
@@ -285,15 +438,11 @@ int getValueIndex(AttrType attrType, char *value, int *pValueIdx) {
         *pValueIdx = (strcmp(value, "false") == 0) ? 0 : 1;
         return 0;
     case STRING:
-        pValueIdxLocal = iDictionary.GetElement(pdictValue2Index, value);
-        if (pValueIdxLocal != NULL) {
-            *pValueIdx = *pValueIdxLocal;
-            return 0;
+        pValueIdxLocal = lookupIndex(pfdValue2Index, pdictValue2Index, value);
+        if (pValueIdxLocal == NULL) {
+            return 1;
         }
-        valueIdx = istrCollection.Size(pscValues);
-        iDictionary.Insert(pdictValue2Index, value, &valueIdx);
-        istrCollection.Add(pscValues, value);
-        *pValueIdx = valueIdx;
+        *pValueIdx = *pValueIdxLocal;
         return 0;
     case INTEGER:
         valueIdx = (int)strtod(value, &pEnd);
@@ -309,44 +458,223 @@ int getValueIndex(AttrType attrType, char *value, int *pValueIdx) {
     }
 }
 
+int getValueIndex(AttrType attrType, char *value, int *pValueIdx) {
+    int ret = findValueIndex(attrType, value, pValueIdx);
+    if (ret != 1) {
+        return ret;
+    }
+    // 新的字符串取值，加入全局字符串列表
+    int valueIdx = istrCollection.Size(pscValues);
+    iDictionary.Insert(pdictValue2Index, value, &valueIdx);
+    istrCollection.Add(pscValues, value);
+    *pValueIdx = valueIdx;
+    return 0;
+}
+
 AttrType getAttrType(char *attr) {
     return getAttrTypeByIdx(getAttrIndex(attr));
 }
 
 AttrType getAttrTypeByIdx(int attrIdx) {
-    int *pAttrTypeIdx = (int *)iHashMap.Get(pmapAttr2Type, &attrIdx);
-    if (pAttrTypeIdx == NULL) {
+    if (attrIdx < 0 || attrIdx >= nAttrMeta) {
         fprintf(stderr, "error: cannot find attribute index %d, please check the policy again\n", attrIdx);
         exit(-1);
     }
-    return *pAttrTypeIdx;
+    return pAttr2Type[attrIdx];
 }
 
-char *getValueByIndex(AttrType attrType, int valueIdx) {
+void addAttrMeta(int attrIdx, AttrType attrType, int defValIdx) {
+    if (attrIdx != nAttrMeta) {
+        logAABAC(__func__, __LINE__, 0, ERROR, "attribute index %d is not the next attribute index %d\n", attrIdx, nAttrMeta);
+        exit(-1);
+    }
+    if (nAttrMeta == attrMetaCapacity) {
+        attrMetaCapacity = attrMetaCapacity == 0 ? 16 : attrMetaCapacity * 2;
+        pAttr2Type = (AttrType *)realloc(pAttr2Type, attrMetaCapacity * sizeof(AttrType));
+        pAttr2DefVal = (int *)realloc(pAttr2DefVal, attrMetaCapacity * sizeof(int));
+        if (pAttr2Type == NULL || pAttr2DefVal == NULL) {
+            logAABAC(__func__, __LINE__, 0, ERROR, "Failed to allocate memory for attribute metadata\n");
+            exit(-1);
+        }
+    }
+    pAttr2Type[attrIdx] = attrType;
+    pAttr2DefVal[attrIdx] = defValIdx;
+    nAttrMeta++;
+}
+
+void setAttrDefVal(int attrIdx, int defValIdx) {
+    if (attrIdx < 0 || attrIdx >= nAttrMeta) {
+        logAABAC(__func__, __LINE__, 0, ERROR, "cannot find attribute index %d\n", attrIdx);
+        exit(-1);
+    }
+    pAttr2DefVal[attrIdx] = defValIdx;
+}
+
+int getAttrDefVal(int attrIdx) {
+    if (attrIdx < 0 || attrIdx >= nAttrMeta) {
+        logAABAC(__func__, __LINE__, 0, ERROR, "cannot find attribute index %d in the default value array\n", attrIdx);
+        exit(-1);
+    }
+    return pAttr2DefVal[attrIdx];
+}
+
+/**
+ * Hash code for the key (datatype, value index) of an extra value token.
+ * 
+ * @param pKey[in] A pointer to the key, i.e. two ints
+ * @return The hash code
+ */
+static unsigned int ExtraTokenKeyHashCode(void *pKey) {
+    int *key = (int *)pKey;
+    return (unsigned int)key[0] * 31u + (unsigned int)key[1];
+}
+
+static int ExtraTokenKeyEqual(void *pKey1, void *pKey2) {
+    return memcmp(pKey1, pKey2, 2 * sizeof(int)) == 0;
+}
+
+static void DestructExtraToken(void *ppToken) {
+    free(*(ValueToken **)ppToken);
+}
+
+/**
+ * Render a value that is not covered by the value token table, or return its token if it has been rendered before.
+ * 
+ * @param attrType[in] The datatype of the attribute
+ * @param valueIdx[in] The index of the value
+ * @return The token of the value
+ */
+static const ValueToken *getExtraValueToken(AttrType attrType, int valueIdx) {
+    int key[2] = {attrType, valueIdx};
+    ValueToken **ppToken, *pToken;
+    char intStr[INT_TOKEN_LEN];
+    char *str;
+    pthread_mutex_lock(&extraTokensLock);
+    if (pmapExtraTokens == NULL) {
+        pmapExtraTokens = iHashMap.Create(sizeof(key), sizeof(ValueToken *), ExtraTokenKeyHashCode, ExtraTokenKeyEqual);
+        iHashMap.SetDestructValue(pmapExtraTokens, DestructExtraToken);
+    }
+    ppToken = (ValueToken **)iHashMap.Get(pmapExtraTokens, key);
+    if (ppToken != NULL) {
+        pToken = *ppToken;
+        pthread_mutex_unlock(&extraTokensLock);
+        return pToken;
+    }
+    if (attrType == STRING) {
+        str = istrCollection.GetElement(pscValues, valueIdx);
+        if (str == NULL) {
+            logAABAC(__func__, __LINE__, 0, ERROR, "cannot find string value index %d\n", valueIdx);
+            exit(-1);
+        }
+    } else {
+        snprintf(intStr, sizeof(intStr), "%d", valueIdx);
+        str = intStr;
+    }
+    int len = strlen(str);
+    // 记号与字符串一次分配，字符串紧跟在记号之后
+    pToken = (ValueToken *)malloc(sizeof(ValueToken) + len + 1);
+    if (pToken == NULL) {
+        logAABAC(__func__, __LINE__, 0, ERROR, "Failed to allocate memory for a value token\n");
+        exit(-1);
+    }
+    pToken->str = (char *)(pToken + 1);
+    pToken->len = len;
+    memcpy(pToken->str, str, len + 1);
+    iHashMap.Put(pmapExtraTokens, key, &pToken);
+    pthread_mutex_unlock(&extraTokensLock);
+    return pToken;
+}
+
+void buildValueTokens(AABACInstance *pInst) {
+    clearValueTokens();
+
+    nStrTokens = istrCollection.Size(pscValues);
+    pStrTokens = (ValueToken *)malloc((nStrTokens + 1) * sizeof(ValueToken));
+    if (pStrTokens == NULL) {
+        logAABAC(__func__, __LINE__, 0, ERROR, "Failed to allocate memory for the value token table\n");
+        exit(-1);
+    }
+    for (int i = 0; i < nStrTokens; i++) {
+        pStrTokens[i].str = istrCollection.GetElement(pscValues, i);
+        pStrTokens[i].len = strlen(pStrTokens[i].str);
+    }
+
+    // 整数取值来自各整数属性的值域与默认值
+    long long minValue = LLONG_MAX, maxValue = LLONG_MIN;
+    int nValues = 0;
+    HashMap *pMapAttr2Dom = pInst->pMapAttr2Dom;
+    int attrIdx;
+    HASHMAP_FOREACH(slot, pMapAttr2Dom) {
+        attrIdx = *(int *)HashMapSlotKey(pMapAttr2Dom, slot);
+        if (pAttr2Type[attrIdx] != INTEGER) {
+            continue;
+        }
+        INTSET_FOREACH(valueIdx, *(IntSet **)HashMapSlotValue(pMapAttr2Dom, slot)) {
+            minValue = valueIdx < minValue ? valueIdx : minValue;
+            maxValue = valueIdx > maxValue ? valueIdx : maxValue;
+            nValues++;
+        }
+    }
+    for (attrIdx = 0; attrIdx < nAttrMeta; attrIdx++) {
+        if (pAttr2Type[attrIdx] == INTEGER) {
+            minValue = pAttr2DefVal[attrIdx] < minValue ? pAttr2DefVal[attrIdx] : minValue;
+            maxValue = pAttr2DefVal[attrIdx] > maxValue ? pAttr2DefVal[attrIdx] : maxValue;
+            nValues++;
+        }
+    }
+    long long span = maxValue - minValue + 1;
+    if (nValues == 0 || (span > MAX_INT_TOKEN_SPAN && span > 4LL * nValues)) {
+        // 取值过于稀疏时不建稠密表，按需渲染
+        return;
+    }
+    intTokenMin = (int)minValue;
+    nIntTokens = (int)span;
+    pIntTokens = (ValueToken *)malloc(nIntTokens * sizeof(ValueToken));
+    intTokenChars = (char *)malloc((size_t)nIntTokens * INT_TOKEN_LEN);
+    if (pIntTokens == NULL || intTokenChars == NULL) {
+        logAABAC(__func__, __LINE__, 0, ERROR, "Failed to allocate memory for the value token table\n");
+        exit(-1);
+    }
+    for (int i = 0; i < nIntTokens; i++) {
+        pIntTokens[i].str = intTokenChars + (size_t)i * INT_TOKEN_LEN;
+        pIntTokens[i].len = snprintf(pIntTokens[i].str, INT_TOKEN_LEN, "%d", intTokenMin + i);
+    }
+}
+
+const ValueToken *getValueToken(AttrType attrType, int valueIdx) {
     switch (attrType) {
     case BOOLEAN:
-        return valueIdx == 0 ? strdup("false") : strdup("true");
+        return &boolTokens[valueIdx != 0];
     case STRING:
-        return strdup(istrCollection.GetElement(pscValues, valueIdx));
+        if (valueIdx >= 0 && valueIdx < nStrTokens) {
+            return &pStrTokens[valueIdx];
+        }
+        return getExtraValueToken(attrType, valueIdx);
     case INTEGER:
-        return intValueIdxToString(&valueIdx);
+        if ((long long)valueIdx - intTokenMin >= 0 && (long long)valueIdx - intTokenMin < nIntTokens) {
+            return &pIntTokens[valueIdx - intTokenMin];
+        }
+        return getExtraValueToken(attrType, valueIdx);
     default:
         logAABAC(__func__, __LINE__, 0, ERROR, "The attribute datatype should be %d(boolean), %d(string), or %d(integer)\n", BOOLEAN, STRING, INTEGER);
         exit(-1);
     }
 }
 
+char *getValueByIndex(AttrType attrType, int valueIdx) {
+    return getValueToken(attrType, valueIdx)->str;
+}
+
 int getInitValue(AABACInstance *pInst, int userIdx, int attrIdx) {
     int *pValueIdx = (int *)iHashBasedTable.Get(pInst->pTableInitState, &userIdx, &attrIdx);
     if (pValueIdx != NULL) {
         return *pValueIdx;
     }
-    int *pDefValIdx = (int *)iHashMap.Get(pmapAttr2DefVal, &attrIdx);
-    if (pDefValIdx == NULL) {
-        logAABAC(__func__, __LINE__, 0, ERROR, "cannot find attribute %s in the default value map\n", istrCollection.GetElement(pscAttrs, attrIdx));
+    if (attrIdx < 0 || attrIdx >= nAttrMeta) {
+        logAABAC(__func__, __LINE__, 0, ERROR, "cannot find attribute index %d in the default value array\n", attrIdx);
         exit(-1);
     }
-    return *pDefValIdx;
+    return pAttr2DefVal[attrIdx];
 }
 
 /**
@@ -366,21 +694,21 @@ static char *solution(Rule *r) {
     HashNode *node;
     int *pAttrIdx;
     AttrType attrType;
-    HashSet *psetVals;
+    IntSet *psetVals;
     while (it->HasNext(it)) {
         node = it->GetNext(it);
         pAttrIdx = (int *)node->key;
-        psetVals = *(HashSet **)node->value;
+        psetVals = *(IntSet **)node->value;
         attrType = getAttrTypeByIdx(*pAttrIdx);
         switch (attrType) {
         case BOOLEAN:
-            iHashSet.SetElementToString(psetVals, boolValueIdxToString);
+            iIntSet.SetElementToString(psetVals, boolValueIdxToString);
             break;
         case INTEGER:
-            iHashSet.SetElementToString(psetVals, intValueIdxToString);
+            iIntSet.SetElementToString(psetVals, intValueIdxToString);
             break;
         case STRING:
-            iHashSet.SetElementToString(psetVals, stringValueIdxToString);
+            iIntSet.SetElementToString(psetVals, stringValueIdxToString);
             break;
         default:
             logAABAC(__func__, __LINE__, 0, ERROR, "The attribute datatype should be %d(boolean), %d(string), or %d(integer)\n", BOOLEAN, STRING, INTEGER);
@@ -388,7 +716,7 @@ static char *solution(Rule *r) {
         }
     }
     iHashMap.DeleteIterator(it);
-    return mapToString(r->pmapUserCondValue, attrIdxToString, iHashSet.ToString);
+    return mapToString(r->pmapUserCondValue, attrIdxToString, iIntSet.ToString);
 }
 
 /**
@@ -450,7 +778,6 @@ static char *conditionToString(HashSet *condition) {
             cur += strlen(opStr);
             memcpy(atomCondStr + cur, value, strlen(value));
             cur += strlen(value);
-            free(value);
         }
         atomCondStr[cur++] = '\0';
         iHashSet.DeleteIterator(it);
@@ -467,8 +794,8 @@ static char *conditionToString(HashSet *condition) {
 char *RuleToString(void *ppRule) {
     Rule *r = *(Rule **)ppRule;
 
-    char *adminCondStr = conditionToString(r->adminCond);
-    char *userCondStr = conditionToString(r->userCond);
+    char *adminCondStr = conditionToString(r->adminCond->atoms);
+    char *userCondStr = conditionToString(r->userCond->atoms);
     char *targetAttr = istrCollection.GetElement(pscAttrs, r->targetAttrIdx);
     AttrType attrType = getAttrTypeByIdx(r->targetAttrIdx);
     char *targetValue = getValueByIndex(attrType, r->targetValueIdx);
@@ -512,7 +839,6 @@ char *RuleToString(void *ppRule) {
     free(adminCondStr);
     free(userCondStr);
     free(solutionStr);
-    free(targetValue);
     return ret;
 }
 
@@ -556,65 +882,60 @@ void init(AABACInstance *pInst) {
         iHashMap.DeleteIterator(itInitstate);
     }
 
-    HashNodeIterator *itAttr2DefVal = iHashMap.NewIterator(pmapAttr2DefVal);
-    HashNode *nodeAttr2DefVal;
-    int *pDefValIdx;
-    HashSet *pDom, **ppDom;
+    IntSet *pDom, **ppDom;
     AttrType attrType;
-    while (itAttr2DefVal->HasNext(itAttr2DefVal)) {
-        nodeAttr2DefVal = (HashNode *)itAttr2DefVal->GetNext(itAttr2DefVal);
-        pAttrIdx = (int *)nodeAttr2DefVal->key;
-        attrType = getAttrTypeByIdx(*pAttrIdx);
-        pFlag = iHashMap.Get(map, pAttrIdx);
+    int attrIdx;
+    for (attrIdx = 0; attrIdx < nAttrMeta; attrIdx++) {
+        attrType = pAttr2Type[attrIdx];
+        pFlag = iHashMap.Get(map, &attrIdx);
         if (pFlag == NULL || *pFlag != userNum) {
-            pDefValIdx = (int *)nodeAttr2DefVal->value;
-            ppDom = iHashMap.Get(pInst->pMapAttr2Dom, pAttrIdx);
+            ppDom = iHashMap.Get(pInst->pMapAttr2Dom, &attrIdx);
             if (ppDom == NULL) {
-                pDom = iHashSet.Create(sizeof(int), IntHashCode, IntEqual);
+                pDom = iIntSet.CreateInPool(pInst->pool);
                 ppDom = &pDom;
-                iHashMap.Put(pInst->pMapAttr2Dom, pAttrIdx, ppDom);
-                iHashSet.SetElementToString(*ppDom, attrType == BOOLEAN ? boolValueIdxToString : attrType == INTEGER ? intValueIdxToString
+                iHashMap.Put(pInst->pMapAttr2Dom, &attrIdx, ppDom);
+                iIntSet.SetElementToString(*ppDom, attrType == BOOLEAN ? boolValueIdxToString : attrType == INTEGER ? intValueIdxToString
                                                                                                                      : stringValueIdxToString);
             }
-            iHashSet.Add(*ppDom, pDefValIdx);
+            iIntSet.Add(*ppDom, pAttr2DefVal[attrIdx]);
         }
     }
-    iHashMap.DeleteIterator(itAttr2DefVal);
     iHashMap.Finalize(map);
 
-    HashSet *pSetNewRules = iHashSet.Create(sizeof(int), RuleIdxHashCode, RuleIdxEqual);
+    // 离散化条件后按内容去重，每组相同的规则只保留下标最小的一条
+    int nOldRules = iIntSet.Size(pInst->pSetRuleIdxes);
+    HashSet *pSetUnique = iHashSet.CreateWithCapacity(sizeof(int), RuleIdxHashCode, RuleIdxEqual, nOldRules);
+    IntSet *pSetNewRules = iIntSet.Create();
     int ruleIdx;
     Rule *r;
     char *rStr;
-    HashSetIterator *itRules = iHashSet.NewIterator(pInst->pSetRuleIdxes);
+    IntSetIterator *itRules = iIntSet.NewIterator(pInst->pSetRuleIdxes);
     while (itRules->HasNext(itRules)) {
         ruleIdx = *(int *)itRules->GetNext(itRules);
         r = (Rule *)iVector.GetElement(pVecRules, ruleIdx);
         if (iRule.DiscreteCond(r, pInst->pMapAttr2Dom) != -1) {
-            iHashSet.Add(pSetNewRules, &ruleIdx);
+            if (iHashSet.Add(pSetUnique, &ruleIdx)) {
+                iIntSet.Add(pSetNewRules, ruleIdx);
+            }
         } else {
             rStr = RuleToString(&r);
             logAABAC(__func__, __LINE__, 0, DEBUG, "The user condition cannot be satisfied: %s\n", rStr);
             free(rStr);
         }
     }
-    iHashSet.DeleteIterator(itRules);
+    iIntSet.DeleteIterator(itRules);
+    iHashSet.Finalize(pSetUnique);
 
-    int nOldRules = iHashSet.Size(pInst->pSetRuleIdxes);
+    resetRules(pInst, pSetNewRules);
+    iIntSet.Finalize(pSetNewRules);
 
-    iHashSet.Clear(pInst->pSetRuleIdxes);
-    iHashBasedTable.Clear(pInst->pTableTargetAV2Rule);
-    iHashBasedTable.Clear(pInst->pTablePrecond2Rule);
+    // 条件离散化完成后编译规则存储
+    iRuleStore.Finalize(pRuleStore);
+    pRuleStore = iRuleStore.Create(pVecRules);
 
-    itRules = iHashSet.NewIterator(pSetNewRules);
-    while (itRules->HasNext(itRules)) {
-        ruleIdx = *(int *)itRules->GetNext(itRules);
-        addRule(pInst, ruleIdx);
-    }
-    iHashSet.DeleteIterator(itRules);
-    iHashSet.Finalize(pSetNewRules);
+    int nNewRules = iIntSet.Size(pInst->pSetRuleIdxes);
 
-    int nNewRules = iHashSet.Size(pInst->pSetRuleIdxes);
+    buildValueTokens(pInst);
 
     clock_t initEndTime = clock();
     double time_spent = (double)(initEndTime - initStartTime) / CLOCKS_PER_SEC * 1000;
@@ -201,8 +201,7 @@ static AABACInstance *generate(GenParam *genParam) {
     // The first attribute is Admin, a boolean attribute with default value "false"
     istrCollection.Add(pscAttrs, "Admin");
     iDictionary.Insert(pdictAttr2Index, "Admin", &attrIdx);
-    iHashMap.Put(pmapAttr2Type, &attrIdx, &attrType);
-    iHashMap.Put(pmapAttr2DefVal, &attrIdx, &defValIdx);
+    addAttrMeta(attrIdx, attrType, defValIdx);
     genParam->domSize[attrIdx] = 2;
     attrIdx++;
 
@@ -220,16 +219,15 @@ static AABACInstance *generate(GenParam *genParam) {
 
             istrCollection.Add(pscAttrs, attrName);
             iDictionary.Insert(pdictAttr2Index, attrName, &attrIdx);
-            iHashMap.Put(pmapAttr2Type, &attrIdx, &attrType);
 
             if (attrType == STRING) {
                 sprintf(attrVal, "%s_0", attrName);
                 istrCollection.Add(pscValues, attrVal);
                 iDictionary.Insert(pdictValue2Index, attrVal, &stringValCnt);
-                iHashMap.Put(pmapAttr2DefVal, &attrIdx, &stringValCnt);
+                addAttrMeta(attrIdx, attrType, stringValCnt);
                 stringValCnt++;
             } else {
-                iHashMap.Put(pmapAttr2DefVal, &attrIdx, &defValIdx);
+                addAttrMeta(attrIdx, attrType, defValIdx);
             }
 
             genParam->domSize[attrIdx] = attrType == BOOLEAN ? 2 : rand() % genParam->maxDomSize + 1;
@@ -262,6 +260,7 @@ static AABACInstance *generate(GenParam *genParam) {
         free(r);
         addRule(pInst, i);
     }
+    dedupRules(pInst);
 
     // Set the last user as the query user
     pInst->queryUserIdx = genParam->nUsers - 1;
@@ -14,66 +14,52 @@
  *      1：存在满足条件的用户，0：不存在满足条件的用户
  ***************************************************************************************************/
 static int isEffective(AABACInstance *pInst, HashSet *pCond) {
-    int attrIdx, *pValueIdx;
-    HashMap *pmapAVs;
-    HashSetIterator *itCond;
+    int attrIdx, valueIdx, *pValueIdx;
+    HashMap *pmapAVs, *pRowMap = pInst->pTableInitState->pRowMap;
     AtomCondition *pAtomCond;
     int effective = 0;
 
     // 遍历所有显式指定了部分属性初始值的用户
-    HashNodeIterator *it = iHashMap.NewIterator(pInst->pTableInitState->pRowMap);
-    while (it->HasNext(it)) {
+    HASHMAP_FOREACH(slot, pRowMap) {
         // 获得用户初始状态下的属性键值对
-        pmapAVs = *(HashMap **)((HashNode *)it->GetNext(it))->value;
+        pmapAVs = *(HashMap **)HashMapSlotValue(pRowMap, slot);
 
         effective = 1;
         // 遍历pCond中的每个原子条件
-        itCond = iHashSet.NewIterator(pCond);
-        while (itCond->HasNext(itCond)) {
-            pAtomCond = (AtomCondition *)itCond->GetNext(itCond);
+        HASHSET_FOREACH(condSlot, pCond) {
+            pAtomCond = (AtomCondition *)HashSetSlotElement(pCond, condSlot);
             attrIdx = pAtomCond->attribute;
             // 获取用户初始状态下的属性值
             pValueIdx = (int *)iHashMap.Get(pmapAVs, &attrIdx);
-            if (pValueIdx == NULL) {
-                // 没有显式给出属性初始值，使用默认值
-                pValueIdx = (int *)iHashMap.Get(pmapAttr2DefVal, &attrIdx);
-            }
+            // 没有显式给出属性初始值时使用默认值
+            valueIdx = pValueIdx != NULL ? *pValueIdx : pAttr2DefVal[attrIdx];
             // 判断原子条件是否成立
-            if (!iAtomCondition.Evaluate(pAtomCond, *pValueIdx)) {
+            if (!iAtomCondition.Evaluate(pAtomCond, valueIdx)) {
                 // 该用户的初始状态下的属性值无法满足该原子条件，终止当前循环并继续判断下一个用户
                 effective = 0;
                 break;
             }
         }
-        iHashSet.DeleteIterator(itCond);
 
         if (effective) {
             // 找到了一个满足条件的用户，返回1
-            iHashMap.DeleteIterator(it);
             return 1;
         }
     }
-    iHashMap.DeleteIterator(it);
 
     // 所有显式指定了部分属性初始值的用户都无法满足条件
     // 继续判断未显式指定初始值的用户，这些用户在初始状态下的的所有属性值都为默认值
-    effective = 1;
     // 遍历pCond中的每个原子条件
-    itCond = iHashSet.NewIterator(pCond);
-    while (itCond->HasNext(itCond)) {
-        pAtomCond = (AtomCondition *)itCond->GetNext(itCond);
+    HASHSET_FOREACH(condSlot, pCond) {
+        pAtomCond = (AtomCondition *)HashSetSlotElement(pCond, condSlot);
         attrIdx = pAtomCond->attribute;
-        // 获取属性的属性值
-        pValueIdx = (int *)iHashMap.Get(pmapAttr2DefVal, &attrIdx);
-        // 判断原子条件是否成立
-        if (!iAtomCondition.Evaluate(pAtomCond, *pValueIdx)) {
-            // 存在无法被满足的原子条件，终止循环
-            effective = 0;
-            break;
+        // 判断属性的默认值能否满足原子条件
+        if (!iAtomCondition.Evaluate(pAtomCond, pAttr2DefVal[attrIdx])) {
+            // 存在无法被满足的原子条件
+            return 0;
         }
     }
-    iHashSet.DeleteIterator(itCond);
-    return effective;
+    return 1;
 }
 
 /****************************************************************************************************
@@ -90,69 +76,46 @@ AABACInstance *userCleaning(AABACInstance *pInst) {
     AABACInstance *pNewInst = createAABACInstance();
 
     // 1.删除所有管理条件无法满足的规则，并将剩余规则的管理条件修改为true
-    // 为了提高效率，用一个Map存储已经判断过的AdminCond，避免重复判断
-    HashMap *pmapAdminCond2Bool = iHashMap.Create(sizeof(HashSet *), sizeof(int), iHashSet.HashCode, iHashSet.Equal);
-    iHashMap.SetDestructKey(pmapAdminCond2Bool, iHashSet.DestructPointer);
-    HashSetIterator *itRuleIdxes = iHashSet.NewIterator(pInst->pSetRuleIdxes);
-    int effective, *pEffective, ruleIdx;
-    HashSet *psetAdminCond;
-    while (itRuleIdxes->HasNext(itRuleIdxes)) {
-        ruleIdx = *(int *)itRuleIdxes->GetNext(itRuleIdxes);
+    // 条件已驻留，相同的AdminCond只有一个编号；按编号记录判断结果，避免重复判断（0：未判断，1：可满足，-1：不可满足）
+    Condition *pTrueCond = iCondition.True();
+    signed char *pCondEffective = (signed char *)calloc(iCondition.Count(), sizeof(signed char));
+    int condId;
+    INTSET_FOREACH(ruleIdx, pInst->pSetRuleIdxes) {
         Rule *pRule = (Rule *)iVector.GetElement(pVecRules, ruleIdx);
-        psetAdminCond = pRule->adminCond;
-        pEffective = iHashMap.Get(pmapAdminCond2Bool, &psetAdminCond);
-        if (pEffective != NULL && *pEffective) {
-            // pRule->adminCond = iHashSet.Create(sizeof(AtomCondition), iAtomCondition.HashCode, iAtomCondition.Equal);
-            iHashSet.Clear(pRule->adminCond);
+        condId = pRule->adminCond->id;
+        if (pCondEffective[condId] == 0) {
+            pCondEffective[condId] = isEffective(pInst, pRule->adminCond->atoms) ? 1 : -1;
+        }
+        if (pCondEffective[condId] == 1) {
+            pRule->adminCond = pTrueCond;
+            iRule.UpdateHashCode(pRule);
             addRule(pNewInst, ruleIdx);
-        } else {
-            effective = isEffective(pInst, psetAdminCond);
-            iHashMap.Put(pmapAdminCond2Bool, &psetAdminCond, &effective);
-            if (effective) {
-                pRule->adminCond = iHashSet.Create(sizeof(AtomCondition), iAtomCondition.HashCode, iAtomCondition.Equal);
-                addRule(pNewInst, ruleIdx);
-            }
         }
     }
-    iHashSet.DeleteIterator(itRuleIdxes);
-    iHashMap.Finalize(pmapAdminCond2Bool);
-
-    iHashMap.Finalize(pInst->pMapAttr2Dom);
-    iHashSet.Finalize(pInst->pSetRuleIdxes);
-    iHashBasedTable.Finalize(pInst->pTableTargetAV2Rule);
-    iHashBasedTable.Finalize(pInst->pTablePrecond2Rule);
+    free(pCondEffective);
+    // 管理条件改为true后，原本不同的规则可能变得相同
+    dedupRules(pNewInst);
 
     // 2.只保留目标用户
     int queryUserIdx = pInst->queryUserIdx;
     iVector.Add(pNewInst->pVecUserIndices, &queryUserIdx);
-    iVector.Finalize(pInst->pVecUserIndices);
 
     // 3. 只保留目标用户的初始状态，并将状态中未列举的属性值用默认值替代
     HashMap **ppmapInitStateOfQueryUser = iHashMap.Get(pInst->pTableInitState->pRowMap, &queryUserIdx);
-    HashNodeIterator *itAttr2DefVal = iHashMap.NewIterator(pmapAttr2DefVal);
-    HashNode *node;
-    int *pAttrIdx, *pDefValIdx;
-    while (itAttr2DefVal->HasNext(itAttr2DefVal)) {
-        node = itAttr2DefVal->GetNext(itAttr2DefVal);
-        pAttrIdx = (int *)node->key;
-        pDefValIdx = (int *)node->value;
-        if (ppmapInitStateOfQueryUser == NULL || (pDefValIdx = (int *)iHashMap.Get(*ppmapInitStateOfQueryUser, pAttrIdx)) == NULL) {
+    int attrIdx, *pValIdx;
+    for (attrIdx = 0; attrIdx < nAttrMeta; attrIdx++) {
+        if (ppmapInitStateOfQueryUser == NULL || (pValIdx = (int *)iHashMap.Get(*ppmapInitStateOfQueryUser, &attrIdx)) == NULL) {
             // 该属性在目标用户的初始状态中没有列举，使用默认值
-            pDefValIdx = (int *)node->value;
+            pValIdx = &pAttr2DefVal[attrIdx];
         }
-        addUAVByIdx(pNewInst, queryUserIdx, *pAttrIdx, *pDefValIdx);
+        addUAVByIdx(pNewInst, queryUserIdx, attrIdx, *pValIdx);
     }
-    iHashMap.DeleteIterator(itAttr2DefVal);
-    iHashBasedTable.Finalize(pInst->pTableInitState);
 
     // 4. 查询不变
-    pNewInst->queryUserIdx = queryUserIdx;
-
-    iHashMap.Finalize(pNewInst->pmapQueryAVs);
-    pNewInst->pmapQueryAVs = pInst->pmapQueryAVs;
+    copyQuery(pNewInst, pInst);
 
     // 释放pInst
-    free(pInst);
+    finalizeAABACInstance(pInst);
 
     double timeSpent = (double)(clock() - startUserCleaning) / CLOCKS_PER_SEC * 1000;
     logAABAC(__func__, __LINE__, 0, INFO, "[end] user cleaning, cost => %.2fms\n", timeSpent);
@@ -191,54 +154,54 @@ AABACInstance *ruleCleaning(AABACInstance *pInst, int *ruleCleaningCnt, int *pMo
         node = itQueryAVs->GetNext(itQueryAVs);
         pQueryAttrIdx = (int *)node->key;
         pQueryValueIdx = (int *)node->value;
-        HashSet **ppSetDom = iHashMap.Get(pmapAttrDom, pQueryAttrIdx);
+        IntSet **ppSetDom = iHashMap.Get(pmapAttrDom, pQueryAttrIdx);
 
         // 查询属性的值域为空，或者值域中不包含被查询值时，查询不可能成立
-        if (ppSetDom == NULL || !iHashSet.Contains(*ppSetDom, pQueryValueIdx)) {
+        if (ppSetDom == NULL || !iIntSet.Contains(*ppSetDom, *pQueryValueIdx)) {
             char *queryAttr = istrCollection.GetElement(pscAttrs, *pQueryAttrIdx);
             char *queryVal = getValueByIndex(getAttrTypeByIdx(*pQueryAttrIdx), *pQueryValueIdx);
-            logAABAC(__func__, __LINE__, 0, INFO, "unreachable, because: the query value %s is not in the domain of the query attribute %s\n", queryAttr, queryAttr);
-            free(queryVal);
+            logAABAC(__func__, __LINE__, 0, INFO, "unreachable, because: the query value %s is not in the domain of the query attribute %s\n", queryVal, queryAttr);
             iHashMap.DeleteIterator(itQueryAVs);
             result->code = AABAC_RESULT_UNREACHABLE;
+            finalizeAABACInstance(pInst);
             return pNewInst;
         }
 
         // 当查询属性的值域包含被查询值且大小为1时，该属性项将永远成立，不用参与最终查询
-        if (iHashSet.Size(*ppSetDom) == 1) {
+        if (iIntSet.Size(*ppSetDom) == 1) {
             *pModification = 1;
         } else {
             iHashMap.Put(pNewInst->pmapQueryAVs, pQueryAttrIdx, pQueryValueIdx);
         }
     }
     iHashMap.DeleteIterator(itQueryAVs);
-    iHashMap.Finalize(pInst->pmapQueryAVs);
     // 如果查询属性值域为空，表示查询条件永远成立
     if (iHashMap.Size(pNewInst->pmapQueryAVs) == 0) {
         logAABAC(__func__, __LINE__, 0, INFO, "reachable, because: the query is always satisfied\n");
         result->code = AABAC_RESULT_REACHABLE;
         result->pVecActions = iVector.Create(sizeof(AdminstrativeAction), 0);
+        finalizeAABACInstance(pInst);
         return pNewInst;
     }
 
     HashSet *pSetToBeRemoved = iHashSet.Create(sizeof(int), IntHashCode, IntEqual);
     HashNodeIterator *itAttrDom = iHashMap.NewIterator(pmapAttrDom);
-    HashSet *pSetDom;
+    IntSet *pSetDom;
     int *pAttrIdx;
     while (itAttrDom->HasNext(itAttrDom)) {
         node = itAttrDom->GetNext(itAttrDom);
         pAttrIdx = (int *)node->key;
-        pSetDom = *(HashSet **)node->value;
-        if (iHashSet.Size(pSetDom) == 1) {
+        pSetDom = *(IntSet **)node->value;
+        if (iIntSet.Size(pSetDom) == 1) {
             iHashSet.Add(pSetToBeRemoved, pAttrIdx);
         }
     }
     iHashMap.DeleteIterator(itAttrDom);
 
     /*2.根据值域清洗规则，同时根据Set的无重复性删除重复规则*/
-    int discreteResult, nOldRules = iHashSet.Size(pInst->pSetRuleIdxes);
+    int discreteResult, nOldRules = iIntSet.Size(pInst->pSetRuleIdxes);
     Rule *pRule;
-    HashSetIterator *itRuleIdxes = iHashSet.NewIterator(pInst->pSetRuleIdxes);
+    IntSetIterator *itRuleIdxes = iIntSet.NewIterator(pInst->pSetRuleIdxes);
     int ruleIdx;
     char *ruleStr;
     while (itRuleIdxes->HasNext(itRuleIdxes)) {
@@ -262,13 +225,17 @@ AABACInstance *ruleCleaning(AABACInstance *pInst, int *ruleCleaningCnt, int *pMo
             free(ruleStr);
             continue;
         }
+        iRuleStore.Update(pRuleStore, ruleIdx, pRule);
         addRule(pNewInst, ruleIdx);
     }
-    iHashSet.DeleteIterator(itRuleIdxes);
+    iIntSet.DeleteIterator(itRuleIdxes);
+    // 条件离散化后，原本不同的规则可能变得相同
+    dedupRules(pNewInst);
 
     /*3.用户不需要清理*/
     iVector.Finalize(pNewInst->pVecUserIndices);
     pNewInst->pVecUserIndices = pInst->pVecUserIndices;
+    pInst->pVecUserIndices = NULL;
 
     /*4.清理初始属性值*/
     HashNodeIterator *itInitState = iHashMap.NewIterator(iHashBasedTable.GetRow(pInst->pTableInitState, &queryUserIdx));
@@ -284,15 +251,10 @@ AABACInstance *ruleCleaning(AABACInstance *pInst, int *ruleCleaningCnt, int *pMo
     iHashSet.Finalize(pSetToBeRemoved);
 
     iHashMap.DeleteIterator(itInitState);
-    iHashBasedTable.Finalize(pInst->pTableInitState);
 
-    iHashMap.Finalize(pInst->pMapAttr2Dom);
-    iHashSet.Finalize(pInst->pSetRuleIdxes);
-    iHashBasedTable.Finalize(pInst->pTableTargetAV2Rule);
-    iHashBasedTable.Finalize(pInst->pTablePrecond2Rule);
-    free(pInst);
+    finalizeAABACInstance(pInst);
 
-    int nNewRules = iHashSet.Size(pNewInst->pSetRuleIdxes);
+    int nNewRules = iIntSet.Size(pNewInst->pSetRuleIdxes);
     double timeSpent = (double)(clock() - startRuleCleaning) / CLOCKS_PER_SEC * 1000;
     logAABAC(__func__, __LINE__, 0, INFO, "[end] rule cleaning %d, cost => %.2fms\n", (*ruleCleaningCnt)++, timeSpent);
     logAABAC(__func__, __LINE__, 0, INFO, "modification ==> %d, rules: %d==>%d, difference: %d\n", *pModification, nOldRules, nNewRules, nOldRules - nNewRules);
@@ -324,132 +286,121 @@ static AABACInstance *forwardSlice(AABACInstance *pInst, int *forwardSlicingCnt,
     logAABAC(__func__, __LINE__, 0, INFO, "[start] forward slicing %d\n", *forwardSlicingCnt);
     clock_t startForwardSlicing = clock();
     *pModification = 0;
-    int nOldRules = iHashSet.Size(pInst->pSetRuleIdxes);
+    int nOldRules = iIntSet.Size(pInst->pSetRuleIdxes);
 
     // 创建新实例
     AABACInstance *pNewInst = createAABACInstance();
 
     // 1.根据queryUser的初始属性值， 初始化可达属性值
     int queryUserIdx = pInst->queryUserIdx;
-    HashMap *pmapReachableAVs = iHashMap.Create(sizeof(int), sizeof(HashSet *), IntHashCode, IntEqual);
-    iHashMap.SetDestructValue(pmapReachableAVs, iHashSet.DestructPointer);
+    // 可达属性值最终成为新实例的值域，因此在新实例的内存池中分配
+    HashMap *pmapReachableAVs = iHashMap.CreateInPool(pNewInst->pool, sizeof(int), sizeof(IntSet *), IntHashCode, IntEqual);
 
     HashNodeIterator *itInitState = iHashMap.NewIterator(iHashBasedTable.GetRow(pInst->pTableInitState, &queryUserIdx));
     HashNode *node;
     int *pAttrIdx, *pValIdx;
-    HashSet *pSetVals;
+    IntSet *pSetVals;
     while (itInitState->HasNext(itInitState)) {
         node = itInitState->GetNext(itInitState);
         pAttrIdx = (int *)node->key;
         pValIdx = (int *)node->value;
-        pSetVals = iHashSet.Create(sizeof(int), IntHashCode, IntEqual);
-        iHashSet.Add(pSetVals, pValIdx);
+        pSetVals = iIntSet.CreateInPool(pNewInst->pool);
+        iIntSet.Add(pSetVals, *pValIdx);
         iHashMap.Put(pmapReachableAVs, pAttrIdx, &pSetVals);
     }
     iHashMap.DeleteIterator(itInitState);
 
     // 用于存储增量可达属性值
-    HashMap *pmapReachableAVsIncs = iHashMap.Create(sizeof(int), sizeof(HashSet *), IntHashCode, IntEqual);
-    iHashMap.SetDestructValue(pmapReachableAVsIncs, iHashSet.DestructPointer);
+    HashMap *pmapReachableAVsIncs = iHashMap.Create(sizeof(int), sizeof(IntSet *), IntHashCode, IntEqual);
+    iHashMap.SetDestructValue(pmapReachableAVsIncs, iIntSet.DestructPointer);
 
     // 第一轮检查规则是否可达
-    HashSetIterator *itRuleIdxes = iHashSet.NewIterator(pInst->pSetRuleIdxes);
+    IntSetIterator itRuleIdxes;
+    iIntSet.InitIterator(pInst->pSetRuleIdxes, &itRuleIdxes);
     Rule *pRule;
-    HashSet **ppSetVals;
+    IntSet **ppSetVals;
     int targetAttrIdx, targetValIdx, ruleIdx;
-    while (itRuleIdxes->HasNext(itRuleIdxes)) {
-        ruleIdx = *(int *)itRuleIdxes->GetNext(itRuleIdxes);
-        pRule = (Rule *)iVector.GetElement(pVecRules, ruleIdx);
-        if (iRule.IsEffective(pRule, pmapReachableAVs)) {
-            targetAttrIdx = pRule->targetAttrIdx;
-            targetValIdx = pRule->targetValueIdx;
+    while (itRuleIdxes.HasNext(&itRuleIdxes)) {
+        ruleIdx = *(int *)itRuleIdxes.GetNext(&itRuleIdxes);
+        if (iRuleStore.IsEffective(pRuleStore, ruleIdx, pmapReachableAVs)) {
+            targetAttrIdx = pRuleStore->targetAttrs[ruleIdx];
+            targetValIdx = pRuleStore->targetValues[ruleIdx];
             addRule(pNewInst, ruleIdx);
 
             // 更新可达属性值
-            ppSetVals = (HashSet **)iHashMap.Get(pmapReachableAVs, &targetAttrIdx);
+            ppSetVals = (IntSet **)iHashMap.Get(pmapReachableAVs, &targetAttrIdx);
             if (ppSetVals == NULL) {
-                pSetVals = iHashSet.Create(sizeof(int), IntHashCode, IntEqual);
+                pSetVals = iIntSet.CreateInPool(pNewInst->pool);
                 ppSetVals = &pSetVals;
                 iHashMap.Put(pmapReachableAVs, &targetAttrIdx, ppSetVals);
             }
-            iHashSet.Add(*ppSetVals, &targetValIdx);
+            iIntSet.Add(*ppSetVals, targetValIdx);
 
             // 更新增量可达属性值
-            ppSetVals = (HashSet **)iHashMap.Get(pmapReachableAVsIncs, &targetAttrIdx);
+            ppSetVals = (IntSet **)iHashMap.Get(pmapReachableAVsIncs, &targetAttrIdx);
             if (ppSetVals == NULL) {
-                pSetVals = iHashSet.Create(sizeof(int), IntHashCode, IntEqual);
+                pSetVals = iIntSet.Create();
                 ppSetVals = &pSetVals;
                 iHashMap.Put(pmapReachableAVsIncs, &targetAttrIdx, ppSetVals);
             }
-            iHashSet.Add(*ppSetVals, &targetValIdx);
+            iIntSet.Add(*ppSetVals, targetValIdx);
 
             // 从剩余规则集中移除
-            itRuleIdxes->Remove(itRuleIdxes);
+            itRuleIdxes.Remove(&itRuleIdxes);
         }
     }
-    iHashSet.DeleteIterator(itRuleIdxes);
 
     // 迭代处理增量可达属性值
     HashMap *pmapNewIncrement;
-    HashNodeIterator *itReachableAVsIncs;
-    HashSetIterator *itVals;
-    HashSet **ppSetRuleIdxes;
-    int *pRuleIdx;
+    IntSet **ppSetRuleIdxes;
     while (iHashMap.Size(pmapReachableAVsIncs) > 0) {
-        pmapNewIncrement = iHashMap.Create(sizeof(int), sizeof(HashSet *), IntHashCode, IntEqual);
-        iHashMap.SetDestructValue(pmapNewIncrement, iHashSet.DestructPointer);
-
-        itReachableAVsIncs = iHashMap.NewIterator(pmapReachableAVsIncs);
-        while (itReachableAVsIncs->HasNext(itReachableAVsIncs)) {
-            node = itReachableAVsIncs->GetNext(itReachableAVsIncs);
-            pAttrIdx = (int *)node->key;
-            itVals = iHashSet.NewIterator(*(HashSet **)node->value);
-            while (itVals->HasNext(itVals)) {
-                pValIdx = (int *)itVals->GetNext(itVals);
+        pmapNewIncrement = iHashMap.Create(sizeof(int), sizeof(IntSet *), IntHashCode, IntEqual);
+        iHashMap.SetDestructValue(pmapNewIncrement, iIntSet.DestructPointer);
+
+        HASHMAP_FOREACH(slot, pmapReachableAVsIncs) {
+            pAttrIdx = (int *)HashMapSlotKey(pmapReachableAVsIncs, slot);
+            INTSET_FOREACH(valIdx, *(IntSet **)HashMapSlotValue(pmapReachableAVsIncs, slot)) {
                 // 找出所有可能因增量可达属性值而可达的规则，即以该属性值为前置条件的规则
-                ppSetRuleIdxes = (HashSet **)iHashBasedTable.Get(pInst->pTablePrecond2Rule, pAttrIdx, pValIdx);
+                ppSetRuleIdxes = (IntSet **)iPackedTable.Get(pInst->pTablePrecond2Rule, *pAttrIdx, valIdx);
                 if (ppSetRuleIdxes == NULL) {
                     continue;
                 }
-                itRuleIdxes = iHashSet.NewIterator(*ppSetRuleIdxes);
-                while (itRuleIdxes->HasNext(itRuleIdxes)) {
-                    pRuleIdx = (int *)itRuleIdxes->GetNext(itRuleIdxes);
-                    pRule = (Rule *)iVector.GetElement(pVecRules, *pRuleIdx);
+                INTSET_FOREACH(incRuleIdx, *ppSetRuleIdxes) {
                     // 检查规则是否在剩余规则集中且可达
-                    if (!iHashSet.Contains(pInst->pSetRuleIdxes, pRuleIdx) || !iRule.IsEffective(pRule, pmapReachableAVs)) {
+                    if (!iIntSet.Contains(pInst->pSetRuleIdxes, incRuleIdx)) {
+                        continue;
+                    }
+                    if (!iRuleStore.IsEffective(pRuleStore, incRuleIdx, pmapReachableAVs)) {
                         continue;
                     }
                     // 将该规则添加到新实例中
-                    addRule(pNewInst, *pRuleIdx);
-                    targetAttrIdx = pRule->targetAttrIdx;
-                    targetValIdx = pRule->targetValueIdx;
-                    ppSetVals = (HashSet **)iHashMap.Get(pmapReachableAVs, &targetAttrIdx);
-                    if (ppSetVals != NULL && iHashSet.Contains(*ppSetVals, &targetValIdx)) {
+                    addRule(pNewInst, incRuleIdx);
+                    targetAttrIdx = pRuleStore->targetAttrs[incRuleIdx];
+                    targetValIdx = pRuleStore->targetValues[incRuleIdx];
+                    ppSetVals = (IntSet **)iHashMap.Get(pmapReachableAVs, &targetAttrIdx);
+                    if (ppSetVals != NULL && iIntSet.Contains(*ppSetVals, targetValIdx)) {
                         continue;
                     }
                     // 更新可达属性值
                     if (ppSetVals == NULL) {
-                        pSetVals = iHashSet.Create(sizeof(int), IntHashCode, IntEqual);
+                        pSetVals = iIntSet.CreateInPool(pNewInst->pool);
                         ppSetVals = &pSetVals;
                         iHashMap.Put(pmapReachableAVs, &targetAttrIdx, ppSetVals);
                     }
-                    iHashSet.Add(*ppSetVals, &targetValIdx);
+                    iIntSet.Add(*ppSetVals, targetValIdx);
                     // 更新新增量
-                    ppSetVals = (HashSet **)iHashMap.Get(pmapNewIncrement, &targetAttrIdx);
+                    ppSetVals = (IntSet **)iHashMap.Get(pmapNewIncrement, &targetAttrIdx);
                     if (ppSetVals == NULL) {
-                        pSetVals = iHashSet.Create(sizeof(int), IntHashCode, IntEqual);
+                        pSetVals = iIntSet.Create();
                         ppSetVals = &pSetVals;
                         iHashMap.Put(pmapNewIncrement, &targetAttrIdx, ppSetVals);
                     }
-                    iHashSet.Add(*ppSetVals, &targetValIdx);
+                    iIntSet.Add(*ppSetVals, targetValIdx);
                     // 从剩余规则集中移除
-                    iHashSet.Remove(pInst->pSetRuleIdxes, pRuleIdx);
+                    iIntSet.Remove(pInst->pSetRuleIdxes, incRuleIdx);
                 }
-                iHashSet.DeleteIterator(itRuleIdxes);
             }
-            iHashSet.DeleteIterator(itVals);
         }
-        iHashMap.DeleteIterator(itReachableAVsIncs);
         // 清理旧的增量集
         iHashMap.Finalize(pmapReachableAVsIncs);
         pmapReachableAVsIncs = pmapNewIncrement;
@@ -457,39 +408,27 @@ static AABACInstance *forwardSlice(AABACInstance *pInst, int *forwardSlicingCnt,
     iHashMap.Finalize(pmapReachableAVsIncs);
 
     // 检查是否发生修改
-    if (iHashSet.Size(pNewInst->pSetRuleIdxes) != nOldRules) {
+    if (iIntSet.Size(pNewInst->pSetRuleIdxes) != nOldRules) {
         *pModification = 1;
-        itRuleIdxes = iHashSet.NewIterator(pInst->pSetRuleIdxes);
-        while (itRuleIdxes->HasNext(itRuleIdxes)) {
-            ruleIdx = *(int *)itRuleIdxes->GetNext(itRuleIdxes);
-            pRule = (Rule *)iVector.GetElement(pVecRules, ruleIdx);
+        INTSET_FOREACH(unreachableRuleIdx, pInst->pSetRuleIdxes) {
+            pRule = (Rule *)iVector.GetElement(pVecRules, unreachableRuleIdx);
             logAABAC(__func__, __LINE__, 0, DEBUG, "user condition can never be satisfied: %s", RuleToString(&pRule));
         }
-        iHashMap.DeleteIterator(itRuleIdxes);
     }
 
     // 设置新实例的其他属性
-    iHashMap.Finalize(pNewInst->pMapAttr2Dom);
     pNewInst->pMapAttr2Dom = pmapReachableAVs;
     
     iVector.Finalize(pNewInst->pVecUserIndices);
     pNewInst->pVecUserIndices = pInst->pVecUserIndices;
+    pInst->pVecUserIndices = NULL;
 
-    iHashBasedTable.Finalize(pNewInst->pTableInitState);
-    pNewInst->pTableInitState = pInst->pTableInitState;
-
-    pNewInst->queryUserIdx = pInst->queryUserIdx;
-
-    iHashMap.Finalize(pNewInst->pmapQueryAVs);
-    pNewInst->pmapQueryAVs = pInst->pmapQueryAVs;
+    copyInitState(pNewInst, pInst);
+    copyQuery(pNewInst, pInst);
 
-    iHashMap.Finalize(pInst->pMapAttr2Dom);
-    iHashSet.Finalize(pInst->pSetRuleIdxes);
-    iHashBasedTable.Finalize(pInst->pTablePrecond2Rule);
-    iHashBasedTable.Finalize(pInst->pTableTargetAV2Rule);
-    free(pInst);
+    finalizeAABACInstance(pInst);
 
-    int nNewRules = iHashSet.Size(pNewInst->pSetRuleIdxes);
+    int nNewRules = iIntSet.Size(pNewInst->pSetRuleIdxes);
 
     double timeSpent = (double)(clock() - startForwardSlicing) / CLOCKS_PER_SEC * 1000;
     logAABAC(__func__, __LINE__, 0, INFO, "[end] forward slicing %d, cost => %.2fms\n", (*forwardSlicingCnt)++, timeSpent);
@@ -538,61 +477,49 @@ AABACInstance *backwardSlice(AABACInstance *pInst, int *backwardSlicingCnt, int
     }
     iHashMap.DeleteIterator(itQueryAVs);
 
-    HashMap *pmapReachableAVs = iHashMap.Create(sizeof(int), sizeof(HashSet *), IntHashCode, IntEqual);
-    iHashMap.SetDestructValue(pmapReachableAVs, iHashSet.DestructPointer);
+    HashMap *pmapReachableAVs = iHashMap.CreateInPool(pNewInst->pool, sizeof(int), sizeof(IntSet *), IntHashCode, IntEqual);
 
     AVP avp, avp2;
     Rule *pRule;
-    int ruleIdx;
     char *ruleStr, *val;
-    HashNodeIterator *itUserCondValue;
-    HashSet **ppSetRuleIdxes, *pSetVals, **ppSetVals;
-    HashSetIterator *itRuleIdxes, *itVals;
+    IntSet **ppSetRuleIdxes;
+    IntSet *pSetVals, **ppSetVals;
     while (iList.Size(pListStack) > 0) {
         iList.PopFront(pListStack, &avp);
-        ppSetRuleIdxes = iHashBasedTable.Get(pInst->pTableTargetAV2Rule, &avp.attrIdx, &avp.valIdx);
+        ppSetRuleIdxes = iPackedTable.Get(pInst->pTableTargetAV2Rule, avp.attrIdx, avp.valIdx);
         if (ppSetRuleIdxes == NULL) {
             continue;
         }
 
-        ppSetVals = (HashSet **)iHashMap.Get(pmapReachableAVs, &avp.attrIdx);
+        ppSetVals = (IntSet **)iHashMap.Get(pmapReachableAVs, &avp.attrIdx);
         if (ppSetVals == NULL) {
-            pSetVals = iHashSet.Create(sizeof(int), IntHashCode, IntEqual);
+            pSetVals = iIntSet.CreateInPool(pNewInst->pool);
             ppSetVals = &pSetVals;
             iHashMap.Put(pmapReachableAVs, &avp.attrIdx, ppSetVals);
         }
-        iHashSet.Add(*ppSetVals, &avp.valIdx);
+        iIntSet.Add(*ppSetVals, avp.valIdx);
 
-        itRuleIdxes = iHashSet.NewIterator(*ppSetRuleIdxes);
-        while (itRuleIdxes->HasNext(itRuleIdxes)) {
-            ruleIdx = *(int *)itRuleIdxes->GetNext(itRuleIdxes);
+        INTSET_FOREACH(ruleIdx, *ppSetRuleIdxes) {
             pRule = (Rule *)iVector.GetElement(pVecRules, ruleIdx);
             addRule(pNewInst, ruleIdx);
             ruleStr = RuleToString(&pRule);
             val = getValueByIndex(getAttrTypeByIdx(avp.attrIdx), avp.valIdx);
             logAABAC(__func__, __LINE__, 0, DEBUG, "rule %s is associated with (%s, %s)", ruleStr, istrCollection.GetElement(pscAttrs, avp.attrIdx), val);
             free(ruleStr);
-            free(val);
-            itUserCondValue = iHashMap.NewIterator(pRule->pmapUserCondValue);
-            while (itUserCondValue->HasNext(itUserCondValue)) {
-                node = itUserCondValue->GetNext(itUserCondValue);
-                itVals = iHashSet.NewIterator(*(HashSet **)node->value);
-                while (itVals->HasNext(itVals)) {
-                    avp2 = (AVP){.attrIdx = *(int *)node->key, .valIdx = *(int *)itVals->GetNext(itVals)};
+            RULESTORE_COND_FOREACH(cond, pRuleStore, ruleIdx) {
+                RULESTORE_VALUE_FOREACH(valIdx, pRuleStore, cond) {
+                    avp2 = (AVP){.attrIdx = pRuleStore->condAttrs[cond], .valIdx = valIdx};
                     if (iHashSet.Add(pSetVisited, &avp2)) {
                         iList.PushFront(pListStack, &avp2);
                     }
                 }
-                iHashSet.DeleteIterator(itVals);
             }
-            iHashMap.DeleteIterator(itUserCondValue);
         }
-        iHashSet.DeleteIterator(itRuleIdxes);
     }
     iList.Finalize(pListStack);
     iHashSet.Finalize(pSetVisited);
 
-    if (iHashSet.Size(pNewInst->pSetRuleIdxes) != iHashSet.Size(pInst->pSetRuleIdxes)) {
+    if (iIntSet.Size(pNewInst->pSetRuleIdxes) != iIntSet.Size(pInst->pSetRuleIdxes)) {
         *pModification = 1;
     }
 
@@ -601,39 +528,30 @@ AABACInstance *backwardSlice(AABACInstance *pInst, int *backwardSlicingCnt, int
     while (itInitState->HasNext(itInitState)) {
         node = itInitState->GetNext(itInitState);
         pAttrIdx = (int *)node->key;
-        ppSetVals = (HashSet **)iHashMap.Get(pmapReachableAVs, pAttrIdx);
+        ppSetVals = (IntSet **)iHashMap.Get(pmapReachableAVs, pAttrIdx);
         if (ppSetVals == NULL) {
-            pSetVals = iHashSet.Create(sizeof(int), IntHashCode, IntEqual);
+            pSetVals = iIntSet.CreateInPool(pNewInst->pool);
             ppSetVals = &pSetVals;
             iHashMap.Put(pmapReachableAVs, pAttrIdx, ppSetVals);
         }
-        iHashSet.Add(*ppSetVals, node->value);
+        iIntSet.Add(*ppSetVals, *(int *)node->value);
     }
     iHashMap.DeleteIterator(itInitState);
 
-    int nOldRules = iHashSet.Size(pInst->pSetRuleIdxes);
+    int nOldRules = iIntSet.Size(pInst->pSetRuleIdxes);
 
-    iHashMap.Finalize(pNewInst->pMapAttr2Dom);
     pNewInst->pMapAttr2Dom = pmapReachableAVs;
 
     iVector.Finalize(pNewInst->pVecUserIndices);
     pNewInst->pVecUserIndices = pInst->pVecUserIndices;
+    pInst->pVecUserIndices = NULL;
 
-    iHashBasedTable.Finalize(pNewInst->pTableInitState);
-    pNewInst->pTableInitState = pInst->pTableInitState;
-
-    pNewInst->queryUserIdx = pInst->queryUserIdx;
-
-    iHashMap.Finalize(pNewInst->pmapQueryAVs);
-    pNewInst->pmapQueryAVs = pInst->pmapQueryAVs;
+    copyInitState(pNewInst, pInst);
+    copyQuery(pNewInst, pInst);
 
-    iHashMap.Finalize(pInst->pMapAttr2Dom);
-    iHashSet.Finalize(pInst->pSetRuleIdxes);
-    iHashBasedTable.Finalize(pInst->pTablePrecond2Rule);
-    iHashBasedTable.Finalize(pInst->pTableTargetAV2Rule);
-    free(pInst);
+    finalizeAABACInstance(pInst);
 
-    int nNewRules = iHashSet.Size(pNewInst->pSetRuleIdxes);
+    int nNewRules = iIntSet.Size(pNewInst->pSetRuleIdxes);
     
     double timeSpent = (double)(clock() - startBackwardSlicing) / CLOCKS_PER_SEC * 1000;
     logAABAC(__func__, __LINE__, 0, INFO, "[end] backward slicing %d, cost => %.2fms\n", (*backwardSlicingCnt)++, timeSpent);
@@ -645,7 +563,7 @@ AABACInstance *backwardSlice(AABACInstance *pInst, int *backwardSlicingCnt, int
 AABACInstance *slice(AABACInstance *pInst, AABACResult *pResult) {
     logAABAC(__func__, __LINE__, 0, INFO, "[start] slicing instance\n");
     clock_t startSlicing = clock();
-    int nOldRules = iHashSet.Size(pInst->pSetRuleIdxes);
+    int nOldRules = iIntSet.Size(pInst->pSetRuleIdxes);
 
     pResult->code = AABAC_RESULT_UNKNOWN;
     int rcMod, rcCnt = 1;
@@ -671,7 +589,7 @@ AABACInstance *slice(AABACInstance *pInst, AABACResult *pResult) {
             break;
         }
     }
-    int nNewRules = iHashSet.Size(pInst->pSetRuleIdxes);
+    int nNewRules = iIntSet.Size(pInst->pSetRuleIdxes);
     double timeSpent = (double)(clock() - startSlicing) / CLOCKS_PER_SEC * 1000;
     logAABAC(__func__, __LINE__, 0, INFO, "[end] slicing instance, cost => %.2fms\n", timeSpent);
     logAABAC(__func__, __LINE__, 0, INFO, "rules: %d==>%d, difference: %d\n", nOldRules, nNewRules, nOldRules - nNewRules);
@@ -1,7 +1,11 @@
 #include <ctype.h>
+#include <pthread.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
 #include "AABACIO.h"
 #include "AABACUtils.h"
@@ -58,7 +62,7 @@ static int handleAttributes(char *line) {
         return 0;
     }
 
-    char *token = NULL, *type = NULL;
+    char *type = NULL;
     int start = 0, cur = 0;
     int attrStrTrimmed = 0;
     AttrType attrType;
@@ -66,15 +70,14 @@ static int handleAttributes(char *line) {
 
     while (1) {
         if (line[cur] == ':') {
-            if (token != NULL) {
-                logAABAC(__func__, __LINE__, 0, ERROR, "type already set to %s, line: %s\n", token, line);
+            if (type != NULL) {
+                logAABAC(__func__, __LINE__, 0, ERROR, "type already set to %s, line: %s\n", type, line);
                 return -1;
             }
-            token = (char *)malloc((cur - start + 1) * sizeof(char));
-            strncpy(token, line, cur - start);
-            token[cur - start] = '\0';
+            // 类型名在行内原地截断
+            line[cur] = '\0';
             cur++;
-            type = strtrim(token);
+            type = strtrim(line + start);
             if (strcmp(type, "boolean") == 0) {
                 attrType = BOOLEAN;
             } else if (strcmp(type, "string") == 0) {
@@ -110,8 +113,7 @@ static int handleAttributes(char *line) {
                 iDictionary.Insert(pdictAttr2Index, line + start, &attrNum);
                 istrCollection.Add(pscAttrs, line + start);
                 // iVector.Add(pInst->pVecAttrIdxes, &attrNum);
-                iHashMap.Put(pmapAttr2Type, &attrNum, &attrType);
-                iHashMap.Put(pmapAttr2DefVal, &attrNum, &defValIdx);
+                addAttrMeta(attrNum, attrType, defValIdx);
                 // logAABAC(__func__, __LINE__, 0, DEBUG, "Add attribute: %s, index: %d\n", line + start, attrNum);
                 attrNum++;
             }
@@ -122,9 +124,6 @@ static int handleAttributes(char *line) {
         }
         cur++;
     }
-    if (token != NULL) {
-        free(token);
-    }
     return 0;
 }
 
@@ -153,7 +152,7 @@ static int handleDefaultValues(char *line) {
         logAABAC(__func__, __LINE__, 0, ERROR, "Failed to add default value: %s, %s\n", attr, value);
         exit(ret);
     }
-    iHashMap.Put(pmapAttr2DefVal, &attrIdx, &valueIdx);
+    setAttrDefVal(attrIdx, valueIdx);
     return 0;
 }
 
@@ -211,7 +210,71 @@ static int handleUAV(AABACInstance *pInst, char *line) {
     return 0;
 }
 
-static AtomCondition *handleAtomCondition(char *atomCondStr) {
+/*
+ * 规则行的解析结果。解析只读取名称字典、不修改任何全局状态，因此规则节可以切分成若干块由多个线程并行解析；
+ * 原子条件存放在各解析线程自己的缓冲区中，合并时才按行的顺序构造条件集合、驻留并加入pVecRules。
+ */
+typedef struct _ParsedAtom {
+    int attribute;
+    int value;               // 取值下标，valueStr非NULL时无效
+    comparisonOperator op;
+    char *valueStr;          // 尚未出现在字典中的字符串取值（指向行内），合并时再按出现顺序加入字典
+} ParsedAtom;
+
+typedef struct _ParsedRule {
+    int adminBegin;          // 管理员条件的原子条件为atoms[adminBegin, userBegin)
+    int userBegin;           // 用户条件的原子条件为atoms[userBegin, atomEnd)
+    int atomEnd;
+    int attrIdx;             // 目标属性
+    int valueIdx;            // 目标值下标，valueStr非NULL时无效
+    char *valueStr;          // 尚未出现在字典中的字符串目标值
+} ParsedRule;
+
+typedef struct _RuleBuffer {
+    ParsedAtom *atoms;
+    int nAtoms;
+    int atomCapacity;
+    ParsedRule *rules;
+    int nRules;
+    int ruleCapacity;
+} RuleBuffer;
+
+// 每个解析线程至少分到的规则行数，行数较少时线程的开销超过收益
+#define MIN_RULE_LINES_PER_THREAD 2048
+#define MAX_RULE_PARSER_THREADS 64
+
+static void freeRuleBuffer(RuleBuffer *buf) {
+    free(buf->atoms);
+    free(buf->rules);
+}
+
+/****************************************************************************************************
+ * 功能：解析一个取值，字典中尚不存在的字符串取值只记录其位置，不修改字典。
+ * 参数：
+ *      @attrType[in]: 属性的数据类型
+ *      @value[in]: 取值
+ *      @pValueIdx[out]: 取值下标
+ *      @pValueStr[out]: 字典中尚不存在的字符串取值，其他情况为NULL
+ * 返回值：
+ *      0表示成功，其他值表示取值不合法
+ ***************************************************************************************************/
+static int parseValue(AttrType attrType, char *value, int *pValueIdx, char **pValueStr) {
+    int ret = findValueIndex(attrType, value, pValueIdx);
+    *pValueStr = (ret == 1) ? value : NULL;
+    return ret == 1 ? 0 : ret;
+}
+
+/****************************************************************************************************
+ * 功能：取出字典中尚不存在的取值的下标，此时才将其加入字典，只能在合并阶段单线程调用。
+ ***************************************************************************************************/
+static int resolveValue(int valueIdx, char *valueStr) {
+    if (valueStr != NULL) {
+        getValueIndex(STRING, valueStr, &valueIdx);
+    }
+    return valueIdx;
+}
+
+static void parseAtomCondition(RuleBuffer *buf, char *atomCondStr) {
     char *attr = NULL, *value = NULL;
     comparisonOperator op;
     char *p = atomCondStr;
@@ -283,38 +346,45 @@ static AtomCondition *handleAtomCondition(char *atomCondStr) {
     attr = strtrim(attr);
     value = strtrim(value);
 
-    AtomCondition *atomCond = (AtomCondition *)malloc(sizeof(AtomCondition));
-    atomCond->attribute = getAttrIndex(attr);
-    int ret = getValueIndex(getAttrType(attr), value, &atomCond->value);
+    if (buf->nAtoms == buf->atomCapacity) {
+        buf->atomCapacity = buf->atomCapacity == 0 ? 64 : buf->atomCapacity * 2;
+        buf->atoms = (ParsedAtom *)realloc(buf->atoms, buf->atomCapacity * sizeof(ParsedAtom));
+    }
+    ParsedAtom *atom = &buf->atoms[buf->nAtoms];
+    atom->attribute = getAttrIndex(attr);
+    int ret = parseValue(getAttrTypeByIdx(atom->attribute), value, &atom->value, &atom->valueStr);
     if (ret) {
         logAABAC(__func__, __LINE__, 0, ERROR, "Failed to handle atom condition: %s\n", atomCondStr);
         exit(ret);
     }
-    atomCond->op = op;
-    return atomCond;
+    atom->op = op;
+    buf->nAtoms++;
 }
 
-static HashSet *handleCondition(char *condStr) {
-    HashSet *condition = iHashSet.Create(sizeof(AtomCondition), iAtomCondition.HashCode, iAtomCondition.Equal);
+static void parseCondition(RuleBuffer *buf, char *condStr) {
     if (strcmp("TRUE", condStr) == 0) {
-        return condition;
+        return;
     }
 
-    char *atomCondStr = strtok(condStr, "&");
-    AtomCondition *pAtomCond;
+    char *savePtr = NULL;
+    char *atomCondStr = strtok_r(condStr, "&", &savePtr);
     while (atomCondStr != NULL) {
-        atomCondStr = strtrim(atomCondStr);
-        pAtomCond = handleAtomCondition(atomCondStr);
-        iHashSet.Add(condition, pAtomCond);
-        free(pAtomCond);
-        atomCondStr = strtok(NULL, "&");
+        parseAtomCondition(buf, strtrim(atomCondStr));
+        atomCondStr = strtok_r(NULL, "&", &savePtr);
     }
-    return condition;
 }
 
-static int handleRule(AABACInstance *pInst, char *line) {
+/****************************************************************************************************
+ * 功能：在行内切分一行规则的四个部分，不解析其中的内容。
+ * 参数：
+ *      @line[in]: 规则行，格式为"(admincond, usercond, attr, val)"，切分时会被原地修改
+ *      @pAdminCondStr[out], @pUserCondStr[out], @pAttr[out], @pValue[out]: 去除首尾空白后的各部分
+ * 返回值：
+ *      0表示成功，1表示该行为空规则";"，-1表示失败
+ ***************************************************************************************************/
+static int splitRule(char *line, char **pAdminCondStr, char **pUserCondStr, char **pAttr, char **pValue) {
     if (strcmp(";", line) == 0) {
-        return 0;
+        return 1;
     }
 
     char *adminCondStr = NULL, *userCondStr = NULL, *attr = NULL, *value = NULL;
@@ -359,28 +429,328 @@ static int handleRule(AABACInstance *pInst, char *line) {
         return -1;
     }
 
-    adminCondStr = strtrim(adminCondStr + 1);
-    userCondStr = strtrim(userCondStr);
-    attr = strtrim(attr);
-    value = strtrim(value);
+    *pAdminCondStr = strtrim(adminCondStr + 1);
+    *pUserCondStr = strtrim(userCondStr);
+    *pAttr = strtrim(attr);
+    *pValue = strtrim(value);
+    return 0;
+}
 
-    int attrIdx = getAttrIndex(attr);
-    int valueIdx;
-    int ret = getValueIndex(getAttrType(attr), value, &valueIdx);
+/****************************************************************************************************
+ * 功能：解析规则的两个条件，与已解析的目标一起追加到缓冲区中。
+ ***************************************************************************************************/
+static void parseRuleConditions(RuleBuffer *buf, char *adminCondStr, char *userCondStr, ParsedRule rule) {
+    rule.adminBegin = buf->nAtoms;
+    parseCondition(buf, adminCondStr);
+    rule.userBegin = buf->nAtoms;
+    parseCondition(buf, userCondStr);
+    rule.atomEnd = buf->nAtoms;
+
+    if (buf->nRules == buf->ruleCapacity) {
+        buf->ruleCapacity = buf->ruleCapacity == 0 ? 16 : buf->ruleCapacity * 2;
+        buf->rules = (ParsedRule *)realloc(buf->rules, buf->ruleCapacity * sizeof(ParsedRule));
+    }
+    buf->rules[buf->nRules++] = rule;
+}
+
+/****************************************************************************************************
+ * 功能：解析一行规则，结果追加到缓冲区中。只读取全局字典，可在多个线程中并行调用。
+ * 参数：
+ *      @buf[in,out]: 解析线程的缓冲区
+ *      @line[in]: 规则行，格式为"(admincond, usercond, attr, val)"，解析过程中会被原地修改
+ * 返回值：
+ *      0表示成功，-1表示失败
+ ***************************************************************************************************/
+static int parseRule(RuleBuffer *buf, char *line) {
+    char *adminCondStr, *userCondStr, *attr, *value;
+    int ret = splitRule(line, &adminCondStr, &userCondStr, &attr, &value);
+    if (ret) {
+        return ret == 1 ? 0 : -1;
+    }
+
+    ParsedRule rule;
+    rule.attrIdx = getAttrIndex(attr);
+    ret = parseValue(getAttrTypeByIdx(rule.attrIdx), value, &rule.valueIdx, &rule.valueStr);
     if (ret) {
         logAABAC(__func__, __LINE__, 0, ERROR, "Failed to handle rule: (%s, %s, %s, %s)\n", adminCondStr, userCondStr, attr, value);
         exit(ret);
     }
-    HashSet *adminCond = handleCondition(adminCondStr);
-    HashSet *userCond = handleCondition(userCondStr);
-    Rule *r = iRule.Create(adminCond, userCond, attrIdx, valueIdx);
-    iVector.Add(pVecRules, r);
-    free(r);
-    int ruleIdx = iVector.Size(pVecRules) - 1;
-    addRule(pInst, ruleIdx);
+    parseRuleConditions(buf, adminCondStr, userCondStr, rule);
     return 0;
 }
 
+static HashSet *buildCondition(RuleBuffer *buf, int begin, int end) {
+    HashSet *condition = iHashSet.Create(sizeof(AtomCondition), iAtomCondition.HashCode, iAtomCondition.Equal);
+    AtomCondition atomCond;
+    int i;
+    for (i = begin; i < end; i++) {
+        atomCond.attribute = buf->atoms[i].attribute;
+        atomCond.value = resolveValue(buf->atoms[i].value, buf->atoms[i].valueStr);
+        atomCond.op = buf->atoms[i].op;
+        iHashSet.Add(condition, &atomCond);
+    }
+    return condition;
+}
+
+/****************************************************************************************************
+ * 功能：将缓冲区中解析好的规则按顺序加入pVecRules和实例，只能单线程调用。
+ *      新的字符串取值按它们在文件中出现的顺序加入字典，因此取值下标与逐行解析时相同。
+ ***************************************************************************************************/
+static void commitRules(AABACInstance *pInst, RuleBuffer *buf) {
+    ParsedRule *pr;
+    Rule *r;
+    int i, valueIdx;
+    for (i = 0; i < buf->nRules; i++) {
+        pr = &buf->rules[i];
+        valueIdx = resolveValue(pr->valueIdx, pr->valueStr);
+        HashSet *adminCond = buildCondition(buf, pr->adminBegin, pr->userBegin);
+        HashSet *userCond = buildCondition(buf, pr->userBegin, pr->atomEnd);
+        r = iRule.Create(adminCond, userCond, pr->attrIdx, valueIdx);
+        iVector.Add(pVecRules, r);
+        free(r);
+        addRule(pInst, iVector.Size(pVecRules) - 1);
+    }
+}
+
+static int handleRule(AABACInstance *pInst, char *line) {
+    RuleBuffer buf = {0};
+    int ret = parseRule(&buf, line);
+    commitRules(pInst, &buf);
+    freeRuleBuffer(&buf);
+    return ret;
+}
+
+typedef struct _RuleChunk {
+    char **lines;
+    int nLines;
+    RuleBuffer buf;
+} RuleChunk;
+
+static void *parseRuleChunk(void *arg) {
+    RuleChunk *chunk = (RuleChunk *)arg;
+    int i;
+    for (i = 0; i < chunk->nLines; i++) {
+        parseRule(&chunk->buf, chunk->lines[i]);
+    }
+    return NULL;
+}
+
+/****************************************************************************************************
+ * 功能：并行解析规则节。规则行被切分成连续的若干块，每块由一个线程解析到自己的缓冲区，
+ *      全部完成后按块的顺序合并，结果与逐行调用handleRule相同。
+ * 参数：
+ *      @lines[in]: 规则节中已去除首尾空白的非空行
+ *      @nLines[in]: 行数
+ ***************************************************************************************************/
+static void handleRules(AABACInstance *pInst, char **lines, int nLines) {
+    long nCpus = sysconf(_SC_NPROCESSORS_ONLN);
+    int nThreads = nLines / MIN_RULE_LINES_PER_THREAD, i;
+    if (nThreads > nCpus) {
+        nThreads = (int)nCpus;
+    }
+    if (nThreads > MAX_RULE_PARSER_THREADS) {
+        nThreads = MAX_RULE_PARSER_THREADS;
+    }
+    if (nThreads < 1) {
+        nThreads = 1;
+    }
+
+    RuleChunk *chunks = (RuleChunk *)calloc(nThreads, sizeof(RuleChunk));
+    pthread_t *threads = (pthread_t *)malloc(nThreads * sizeof(pthread_t));
+    int *started = (int *)calloc(nThreads, sizeof(int));
+    for (i = 0; i < nThreads; i++) {
+        chunks[i].lines = lines + (long)nLines * i / nThreads;
+        chunks[i].nLines = (int)((long)nLines * (i + 1) / nThreads - (long)nLines * i / nThreads);
+    }
+    logAABAC(__func__, __LINE__, 0, DEBUG, "parsing %d rule lines with %d threads\n", nLines, nThreads);
+    // 第一块由当前线程解析，线程创建失败的块也在当前线程中解析
+    for (i = 1; i < nThreads; i++) {
+        started[i] = pthread_create(&threads[i], NULL, parseRuleChunk, &chunks[i]) == 0;
+    }
+    parseRuleChunk(&chunks[0]);
+    for (i = 1; i < nThreads; i++) {
+        if (started[i]) {
+            pthread_join(threads[i], NULL);
+        } else {
+            parseRuleChunk(&chunks[i]);
+        }
+    }
+    for (i = 0; i < nThreads; i++) {
+        commitRules(pInst, &chunks[i].buf);
+        freeRuleBuffer(&chunks[i].buf);
+    }
+    free(started);
+    free(threads);
+    free(chunks);
+}
+
+/*
+ * 按需加载规则时的规则索引。第一遍只切分规则行并解析目标，条件留在行内不解析；
+ * 读完Spec后从查询的属性值出发反向遍历，只解析并加载可能用于到达查询的规则（见loadQueryCone）。
+ */
+typedef struct _LazyRule {
+    char *adminCondStr;      // 行内的管理员条件
+    char *userCondStr;       // 行内的用户条件
+    int attrIdx;             // 目标属性
+    int valueIdx;            // 目标值下标
+    int parsedIdx;           // 在解析缓冲区中的下标，尚未解析时为-1
+} LazyRule;
+
+typedef struct _LazyRuleIndex {
+    LazyRule *rules;         // 按文件中的顺序
+    int nRules;
+    int capacity;
+    PackedTable *pTableTarget2Rules; // 目标属性值 -> 以其为目标的规则（rules中的下标，IntSet），启用行视图
+} LazyRuleIndex;
+
+static void initLazyRuleIndex(LazyRuleIndex *index) {
+    index->rules = NULL;
+    index->nRules = 0;
+    index->capacity = 0;
+    index->pTableTarget2Rules = iPackedTable.Create(sizeof(IntSet *), 1);
+    iPackedTable.SetDestructValue(index->pTableTarget2Rules, iIntSet.DestructPointer);
+}
+
+static void finalizeLazyRuleIndex(LazyRuleIndex *index) {
+    free(index->rules);
+    iPackedTable.Finalize(index->pTableTarget2Rules);
+}
+
+/****************************************************************************************************
+ * 功能：按需加载的第一遍，切分规则行并按目标属性值建立索引，目标值在此时加入字典。
+ * 参数：
+ *      @lines[in]: 规则节中已去除首尾空白的非空行
+ *      @nLines[in]: 行数
+ ***************************************************************************************************/
+static void indexRules(LazyRuleIndex *index, char **lines, int nLines) {
+    char *adminCondStr, *userCondStr, *attr, *value;
+    LazyRule *pRule;
+    IntSet *pSetRules, **ppSetRules;
+    int i, ret;
+    for (i = 0; i < nLines; i++) {
+        if (splitRule(lines[i], &adminCondStr, &userCondStr, &attr, &value)) {
+            continue;
+        }
+        if (index->nRules == index->capacity) {
+            index->capacity = index->capacity == 0 ? 1024 : index->capacity * 2;
+            index->rules = (LazyRule *)realloc(index->rules, index->capacity * sizeof(LazyRule));
+        }
+        pRule = &index->rules[index->nRules];
+        pRule->adminCondStr = adminCondStr;
+        pRule->userCondStr = userCondStr;
+        pRule->attrIdx = getAttrIndex(attr);
+        pRule->parsedIdx = -1;
+        ret = getValueIndex(getAttrTypeByIdx(pRule->attrIdx), value, &pRule->valueIdx);
+        if (ret) {
+            logAABAC(__func__, __LINE__, 0, ERROR, "Failed to handle rule: (%s, %s, %s, %s)\n", adminCondStr, userCondStr, attr, value);
+            exit(ret);
+        }
+        ppSetRules = (IntSet **)iPackedTable.Get(index->pTableTarget2Rules, pRule->attrIdx, pRule->valueIdx);
+        if (ppSetRules == NULL) {
+            pSetRules = iIntSet.Create();
+            iPackedTable.Put(index->pTableTarget2Rules, pRule->attrIdx, pRule->valueIdx, &pSetRules);
+        } else {
+            pSetRules = *ppSetRules;
+        }
+        iIntSet.Add(pSetRules, index->nRules);
+        index->nRules++;
+    }
+}
+
+/*
+ * 反向遍历中待处理的需求：属性attrIdx取值valueIdx，或allValues非0时属性attrIdx的任意取值
+ */
+typedef struct _ConeDemand {
+    int attrIdx;
+    int valueIdx;
+    int allValues;
+} ConeDemand;
+
+static void pushDemand(ConeDemand **pStack, int *pSize, int *pCapacity, int attrIdx, int valueIdx, int allValues) {
+    if (*pSize == *pCapacity) {
+        *pCapacity = *pCapacity == 0 ? 256 : *pCapacity * 2;
+        *pStack = (ConeDemand *)realloc(*pStack, *pCapacity * sizeof(ConeDemand));
+    }
+    (*pStack)[(*pSize)++] = (ConeDemand){.attrIdx = attrIdx, .valueIdx = valueIdx, .allValues = allValues};
+}
+
+/****************************************************************************************************
+ * 功能：按需加载的第二遍。从查询的属性值出发反向遍历：以需要的属性值为目标的规则被解析，
+ *      其管理员条件与用户条件中的原子条件又产生新的需要——等值条件需要该取值，其他比较需要该属性的任意取值。
+ *      得到的规则集合包含backwardSlice在完整实例上保留的所有规则（且不忽略管理员条件），
+ *      其余规则的条件从不解析。加载的规则按它们在文件中的顺序加入pVecRules。
+ ***************************************************************************************************/
+static void loadQueryCone(AABACInstance *pInst, LazyRuleIndex *index) {
+    RuleBuffer buf = {0};
+    IntSet *pSetAllValueAttrs = iIntSet.Create();
+    ConeDemand *stack = NULL, demand;
+    int nStack = 0, stackCapacity = 0, i;
+    IntSet **ppSetRules, *pSetVals;
+    LazyRule *pRule;
+    ParsedRule parsed;
+    ParsedAtom *atom;
+
+
+    HASHMAP_FOREACH(slot, pInst->pmapQueryAVs) {
+        pushDemand(&stack, &nStack, &stackCapacity, *(int *)HashMapSlotKey(pInst->pmapQueryAVs, slot), *(int *)HashMapSlotValue(pInst->pmapQueryAVs, slot), 0);
+    }
+    while (nStack > 0) {
+        demand = stack[--nStack];
+        if (demand.allValues) {
+            if (!iIntSet.Add(pSetAllValueAttrs, demand.attrIdx)) {
+                continue;
+            }
+            pSetVals = iPackedTable.GetRow(index->pTableTarget2Rules, demand.attrIdx);
+            if (pSetVals != NULL) {
+                INTSET_FOREACH(valIdx, pSetVals) {
+                    pushDemand(&stack, &nStack, &stackCapacity, demand.attrIdx, valIdx, 0);
+                }
+            }
+            continue;
+        }
+        ppSetRules = (IntSet **)iPackedTable.Get(index->pTableTarget2Rules, demand.attrIdx, demand.valueIdx);
+        if (ppSetRules == NULL) {
+            continue;
+        }
+        INTSET_FOREACH(lazyIdx, *ppSetRules) {
+            pRule = &index->rules[lazyIdx];
+            if (pRule->parsedIdx >= 0) {
+                continue;
+            }
+            pRule->parsedIdx = buf.nRules;
+            parsed.attrIdx = pRule->attrIdx;
+            parsed.valueIdx = pRule->valueIdx;
+            parsed.valueStr = NULL;
+            parseRuleConditions(&buf, pRule->adminCondStr, pRule->userCondStr, parsed);
+            for (i = buf.rules[pRule->parsedIdx].adminBegin; i < buf.rules[pRule->parsedIdx].atomEnd; i++) {
+                atom = &buf.atoms[i];
+                if (atom->op != EQUAL) {
+                    pushDemand(&stack, &nStack, &stackCapacity, atom->attribute, 0, 1);
+                } else if (atom->valueStr == NULL) {
+                    // 尚未出现在字典中的字符串取值不是任何规则的目标，不产生需要
+                    pushDemand(&stack, &nStack, &stackCapacity, atom->attribute, atom->value, 0);
+                }
+            }
+        }
+    }
+    free(stack);
+    iIntSet.Finalize(pSetAllValueAttrs);
+
+    // 按文件中的顺序重排解析结果后加载
+    ParsedRule *ordered = (ParsedRule *)malloc((buf.nRules > 0 ? buf.nRules : 1) * sizeof(ParsedRule));
+    int nOrdered = 0;
+    for (i = 0; i < index->nRules; i++) {
+        if (index->rules[i].parsedIdx >= 0) {
+            ordered[nOrdered++] = buf.rules[index->rules[i].parsedIdx];
+        }
+    }
+    free(buf.rules);
+    buf.rules = ordered;
+    commitRules(pInst, &buf);
+    freeRuleBuffer(&buf);
+    logAABAC(__func__, __LINE__, 0, INFO, "loaded %d of %d rules reachable backwards from the query\n", nOrdered, index->nRules);
+}
+
 static int handleSpec(AABACInstance *pInst, char *line) {
     if (*line != '(') {
         logAABAC(__func__, __LINE__, 0, ERROR, "spec should starts with (, but it is %s\n", line);
@@ -414,7 +784,7 @@ static int handleSpec(AABACInstance *pInst, char *line) {
                     return -1;
                 }
                 attr = strtrim(attr);
-                value = strdup(strtrim(value));
+                value = strtrim(value);
                 attrIdx = getAttrIndex(attr);
                 int ret = getValueIndex(getAttrType(attr), value, &valueIdx);
                 if (ret) {
@@ -423,7 +793,6 @@ static int handleSpec(AABACInstance *pInst, char *line) {
                 }
                 iHashMap.Put(pInst->pmapQueryAVs, &attrIdx, &valueIdx);
                 logAABAC(__func__, __LINE__, 0, INFO, "add query attribute: %s, value: %s\n", attr, value);
-                free(value);
             }
             if (toBreak) {
                 break;
@@ -483,30 +852,154 @@ static int handleLine(AABACInstance *pInst, int stage, char *line) {
     return 0;
 }
 
-AABACInstance *readAABACInstance(char *aabacFilePath) {
-    logAABAC(__func__, __LINE__, 0, INFO, "[start] reading AABAC instance from file %s\n", aabacFilePath);
+/****************************************************************************************************
+ * 功能：判断一行是否为节标题。
+ * 参数：
+ *      @line[in]: 已去除首尾空白的一行
+ * 返回值：
+ *      节标题对应的阶段（见processLine），不是节标题时返回0
+ ***************************************************************************************************/
+static int sectionStage(char *line) {
+    if (strcmp(line, USERS) == 0) {
+        return 1;
+    } else if (strcmp(line, ATTRIBUTES) == 0) {
+        return 2;
+    } else if (strcmp(line, DEFAULT_VALUE) == 0) {
+        return 3;
+    } else if (strcmp(line, UAV) == 0) {
+        return 4;
+    } else if (strcmp(line, RULES) == 0) {
+        return 5;
+    } else if (strcmp(line, SPEC) == 0) {
+        return 6;
+    }
+    return 0;
+}
 
-    FILE *file = fopen(aabacFilePath, "r");
-    if (file == NULL) {
-        printf("Error opening file: %s\n", aabacFilePath);
-        return NULL;
+/****************************************************************************************************
+ * 功能：处理一行数据。节标题行切换阶段，其余非空行交给handleLine处理。
+ * 参数：
+ *      @pStage[in,out]: 当前所处的阶段，0: initial, 1: users, 2: attributes, 3: default value, 4: UAV, 5: rules, 6: spec
+ *      @line[in]: 以'\0'结尾的一行，处理过程中会被原地修改
+ * 返回值：
+ *      0表示成功，-1表示失败
+ ***************************************************************************************************/
+static int processLine(AABACInstance *pInst, int *pStage, char *line) {
+    char *trimmed_line = strtrim(line);
+    // Check if the line is empty after trimming
+    if (*trimmed_line == '\0') {
+        return 0;
     }
 
-    // 初始化全局变量
-    initGlobalVars();
-    AABACInstance *pInst = createAABACInstance();
+    int stage = sectionStage(trimmed_line);
+    if (stage) {
+        *pStage = stage;
+    } else {
+        return handleLine(pInst, *pStage, trimmed_line);
+    }
+    return 0;
+}
+
+/****************************************************************************************************
+ * 功能：通过私有内存映射读取文件，并在映射区中原地切分各行，不再把文件内容复制到行缓冲区。
+ *      行边界用memchr查找（glibc中为向量化实现）；每行的换行符被原地改写为'\0'，
+ *      之后的分词同样在映射区中原地进行，因此用户名、属性名和值都直接以映射区中的字符串交给字典驻留。
+ *      规则节的各行收集后由handleRules并行解析；按需加载时只建立索引，读完文件后由loadQueryCone加载。
+ *      映射为MAP_PRIVATE，写入只影响本进程的副本，不会修改文件。
+ * 参数：
+ *      @fd[in]: 已打开的文件描述符
+ *      @size[in]: 文件大小
+ *      @lazy[in]: 非0时只加载可能用于到达查询的规则
+ * 返回值：
+ *      0表示成功，-1表示解析失败，1表示无法映射（调用者改用标准IO读取）
+ ***************************************************************************************************/
+static int readMapped(AABACInstance *pInst, int fd, size_t size, int lazy) {
+    char *data = (char *)mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    if (data == MAP_FAILED) {
+        return 1;
+    }
+    madvise(data, size, MADV_SEQUENTIAL);
+
+    int stage = 0, ret = 0;
+    char *line = data, *end = data + size, *newline, *next, *lastLine = NULL, *trimmed;
+    size_t pageSize = (size_t)sysconf(_SC_PAGESIZE);
+    // 规则节的各行先收集起来，到节末尾时交给handleRules并行解析
+    char **ruleLines = NULL;
+    int nRuleLines = 0, ruleLineCapacity = 0;
+    LazyRuleIndex lazyIndex;
+    if (lazy) {
+        initLazyRuleIndex(&lazyIndex);
+    }
+    while (line < end) {
+        newline = (char *)memchr(line, '\n', end - line);
+        if (newline != NULL) {
+            *newline = '\0';
+            next = newline + 1;
+        } else if (size % pageSize != 0) {
+            // 最后一行没有换行符，映射的最后一页中文件末尾之后的部分全为0，可直接作为结束符
+            next = end;
+        } else {
+            // 文件大小恰为页大小的整数倍，文件末尾之后没有可访问的字节，只能复制最后一行
+            lastLine = (char *)malloc(end - line + 1);
+            memcpy(lastLine, line, end - line);
+            lastLine[end - line] = '\0';
+            line = lastLine;
+            next = end;
+        }
+        trimmed = strtrim(line);
+        if (stage == 5 && *trimmed != '\0' && sectionStage(trimmed) == 0) {
+            if (nRuleLines == ruleLineCapacity) {
+                ruleLineCapacity = ruleLineCapacity == 0 ? 1024 : ruleLineCapacity * 2;
+                ruleLines = (char **)realloc(ruleLines, ruleLineCapacity * sizeof(char *));
+            }
+            ruleLines[nRuleLines++] = trimmed;
+        } else {
+            if (nRuleLines > 0 && *trimmed != '\0') {
+                if (lazy) {
+                    indexRules(&lazyIndex, ruleLines, nRuleLines);
+                } else {
+                    handleRules(pInst, ruleLines, nRuleLines);
+                }
+                nRuleLines = 0;
+            }
+            ret = processLine(pInst, &stage, trimmed);
+        }
+        line = next;
+        if (ret) {
+            break;
+        }
+    }
+    if (ret == 0 && lazy) {
+        indexRules(&lazyIndex, ruleLines, nRuleLines);
+        loadQueryCone(pInst, &lazyIndex);
+    } else if (ret == 0 && nRuleLines > 0) {
+        handleRules(pInst, ruleLines, nRuleLines);
+    }
+    if (lazy) {
+        finalizeLazyRuleIndex(&lazyIndex);
+    }
+    free(ruleLines);
+    free(lastLine);
+    munmap(data, size);
+    return ret ? -1 : 0;
+}
 
-    // 0: initial, 1: users, 2: attributes, 3: default value, 4: UAV, 5: rules, 6: spec
+/****************************************************************************************************
+ * 功能：通过标准IO逐行读取文件，用于无法映射的输入（如管道）。
+ * 参数：
+ *      @file[in]: 已打开的文件
+ * 返回值：
+ *      0表示成功，-1表示失败
+ ***************************************************************************************************/
+static int readStream(AABACInstance *pInst, FILE *file) {
     int stage = 0;
-    int line_count = 0;
 
     // 动态分配初始缓冲区
     size_t buffer_size = 1024;
     char *line = (char *)malloc(buffer_size);
     if (line == NULL) {
         logAABAC(__func__, __LINE__, 0, ERROR, "Failed to allocate memory for line buffer\n");
-        fclose(file);
-        return NULL;
+        return -1;
     }
 
     while (1) {
@@ -516,8 +1009,6 @@ AABACInstance *readAABACInstance(char *aabacFilePath) {
             break;
         }
 
-        line_count++;
-
         // 检查是否需要扩展缓冲区
         size_t line_len = strlen(line);
         if (line_len > 0 && line[line_len - 1] != '\n' && !feof(file)) {
@@ -527,8 +1018,7 @@ AABACInstance *readAABACInstance(char *aabacFilePath) {
             if (new_line == NULL) {
                 logAABAC(__func__, __LINE__, 0, ERROR, "Failed to reallocate memory for line buffer\n");
                 free(line);
-                fclose(file);
-                return NULL;
+                return -1;
             }
             line = new_line;
             buffer_size = new_size;
@@ -548,8 +1038,7 @@ AABACInstance *readAABACInstance(char *aabacFilePath) {
                 if (new_line == NULL) {
                     logAABAC(__func__, __LINE__, 0, ERROR, "Failed to reallocate memory for line buffer\n");
                     free(line);
-                    fclose(file);
-                    return NULL;
+                    return -1;
                 }
                 line = new_line;
                 buffer_size = new_size;
@@ -557,39 +1046,65 @@ AABACInstance *readAABACInstance(char *aabacFilePath) {
         }
 
         // 处理完整的行
-        char *trimmed_line = strtrim(line);
-        // Check if the line is empty after trimming
-        if (strlen(trimmed_line) == 0) {
-            continue;
-        }
-
-        // Process the line
-        if (strcmp(trimmed_line, USERS) == 0) {
-            stage = 1;
-        } else if (strcmp(trimmed_line, ATTRIBUTES) == 0) {
-            stage = 2;
-        } else if (strcmp(trimmed_line, DEFAULT_VALUE) == 0) {
-            stage = 3;
-        } else if (strcmp(trimmed_line, UAV) == 0) {
-            stage = 4;
-        } else if (strcmp(trimmed_line, RULES) == 0) {
-            stage = 5;
-        } else if (strcmp(trimmed_line, SPEC) == 0) {
-            stage = 6;
-        } else {
-            if (handleLine(pInst, stage, trimmed_line)) {
-                // Error in processing the line
-                free(line);
-                fclose(file);
-                return NULL;
-            }
+        if (processLine(pInst, &stage, line)) {
+            // Error in processing the line
+            free(line);
+            return -1;
         }
     }
 
     // 释放动态分配的内存
     free(line);
+    return 0;
+}
+
+/****************************************************************************************************
+ * 功能：读取AABAC策略文件。
+ * 参数：
+ *      @aabacFilePath[in]: 文件路径
+ *      @lazy[in]: 非0时只加载可能用于到达查询的规则，仅对普通文件有效
+ ***************************************************************************************************/
+static AABACInstance *readInstance(char *aabacFilePath, int lazy) {
+    logAABAC(__func__, __LINE__, 0, INFO, "[start] reading AABAC instance from file %s\n", aabacFilePath);
+
+    FILE *file = fopen(aabacFilePath, "r");
+    if (file == NULL) {
+        printf("Error opening file: %s\n", aabacFilePath);
+        return NULL;
+    }
+
+    // 初始化全局变量
+    initGlobalVars();
+    AABACInstance *pInst = createAABACInstance();
+
+    // 普通文件通过内存映射原地解析，其他输入（或映射失败时）逐行读取
+    int ret = 1;
+    struct stat st;
+    if (fstat(fileno(file), &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0) {
+        ret = readMapped(pInst, fileno(file), (size_t)st.st_size, lazy);
+    }
+    if (ret == 1) {
+        if (lazy) {
+            logAABAC(__func__, __LINE__, 0, INFO, "%s is not a regular file, all rules are loaded\n", aabacFilePath);
+        }
+        ret = readStream(pInst, file);
+    }
     fclose(file);
+    if (ret) {
+        return NULL;
+    }
+
+    // 名称字典此后只读，冻结为完美哈希表
+    freezeSymbolTables();
 
     logAABAC(__func__, __LINE__, 0, INFO, "[end] reading AABAC instance from file %s\n", aabacFilePath);
     return pInst;
+}
+
+AABACInstance *readAABACInstance(char *aabacFilePath) {
+    return readInstance(aabacFilePath, 0);
+}
+
+AABACInstance *readAABACInstanceForQuery(char *aabacFilePath) {
+    return readInstance(aabacFilePath, 1);
 }
\ No newline at end of file
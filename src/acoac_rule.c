@@ -3,6 +3,7 @@
 #include "AABACRule.h"
 #include "AABACUtils.h"
 #include "hashSet.h"
+#include "intSet.h"
 
 static int Evaluate(AtomCondition *atomCond, int valIdx) {
     int valIdxInCond = atomCond->value;
@@ -37,28 +38,24 @@ static int Evaluate(AtomCondition *atomCond, int valIdx) {
  * @param domain 查找范围
  * @return domain中满足该条件的值构成的集合
  */
-static void FindEffectiveValues(AtomCondition *atomdCond, HashSet *domain, HashSet *effectiveValues) {
-    HashSetIterator *it = iHashSet.NewIterator(domain);
-    int valIdx;
-    while (it->HasNext(it)) {
-        valIdx = *(int *)it->GetNext(it);
+static void FindEffectiveValues(AtomCondition *atomdCond, IntSet *domain, IntSet *effectiveValues) {
+    INTSET_FOREACH(valIdx, domain) {
         if (Evaluate(atomdCond, valIdx)) {
-            iHashSet.Add(effectiveValues, &valIdx);
+            iIntSet.Add(effectiveValues, valIdx);
         }
     }
-    iHashSet.DeleteIterator(it);
 }
 
-static void RetainEffectiveValues(AtomCondition *atomdCond, HashSet *effectiveValues) {
-    HashSetIterator *it = iHashSet.NewIterator(effectiveValues);
+static void RetainEffectiveValues(AtomCondition *atomdCond, IntSet *effectiveValues) {
+    IntSetIterator it;
+    iIntSet.InitIterator(effectiveValues, &it);
     int valIdx;
-    while (it->HasNext(it)) {
-        valIdx = *(int *)it->GetNext(it);
+    while (it.HasNext(&it)) {
+        valIdx = *(int *)it.GetNext(&it);
         if (!Evaluate(atomdCond, valIdx)) {
-            it->Remove(it);
+            it.Remove(&it);
         }
     }
-    iHashSet.DeleteIterator(it);
 }
 
 static unsigned int AtomCondHashCode(void *obj) {
@@ -85,28 +82,90 @@ static int AtomCondEqual(void *obj1, void *obj2) {
     return 1;
 }
 
-static unsigned int RuleHashCode(void *pRule) {
-    if (pRule == NULL) {
-        printf("[Error] RuleHashCode: rule is NULL\n");
-        abort();
+// The global condition table: atom set (HashSet *) -> condition id, and condition id -> Condition *
+static HashMap *pMapAtoms2CondId = NULL;
+static Vector *pVecConds = NULL;
+
+static Condition *GetById(int id) {
+    return *(Condition **)iVector.GetElement(pVecConds, id);
+}
+
+/**
+ * Intern a condition. If a condition with the same atoms is already in the table, the given set is freed
+ * and the existing condition is returned; otherwise a new condition with the next id takes over the set.
+ *
+ * @param atoms[in] A set of atomic conditions, owned by the condition table afterwards
+ * @return The shared condition
+ */
+static Condition *Intern(HashSet *atoms) {
+    if (pMapAtoms2CondId == NULL) {
+        pMapAtoms2CondId = iHashMap.Create(sizeof(HashSet *), sizeof(int), iHashSet.HashCode, iHashSet.Equal);
+        pVecConds = iVector.Create(sizeof(Condition *), 0);
+    }
+    int *pId = iHashMap.Get(pMapAtoms2CondId, &atoms);
+    if (pId != NULL) {
+        iHashSet.Finalize(atoms);
+        return GetById(*pId);
     }
+    Condition *cond = (Condition *)malloc(sizeof(Condition));
+    if (cond == NULL) {
+        logAABAC(__func__, __LINE__, 0, ERROR, "Failed to allocate memory for condition\n");
+        exit(-1);
+    }
+    cond->atoms = atoms;
+    cond->hashCode = iHashSet.HashCode(&atoms);
+    cond->id = (int)iVector.Size(pVecConds);
+    iVector.Add(pVecConds, &cond);
+    iHashMap.Put(pMapAtoms2CondId, &atoms, &cond->id);
+    return cond;
+}
+
+static Condition *True(void) {
+    return Intern(iHashSet.Create(sizeof(AtomCondition), AtomCondHashCode, AtomCondEqual));
+}
+
+static int Count(void) {
+    return pVecConds == NULL ? 0 : (int)iVector.Size(pVecConds);
+}
+
+static void ClearTable(void) {
+    if (pMapAtoms2CondId == NULL) {
+        return;
+    }
+    Condition *cond;
+    for (int i = 0; i < iVector.Size(pVecConds); i++) {
+        cond = GetById(i);
+        iHashSet.Finalize(cond->atoms);
+        free(cond);
+    }
+    iVector.Finalize(pVecConds);
+    pVecConds = NULL;
+    iHashMap.Finalize(pMapAtoms2CondId);
+    pMapAtoms2CondId = NULL;
+}
+
+/**
+ * Compute the content hash of a rule from its conditions and target.
+ * The result is cached in @{hashCode} and must be recomputed whenever the conditions change.
+ *
+ * @param r[in] The rule
+ * @return The content hash of the rule
+ */
+static unsigned int computeRuleHash(Rule *r) {
     int hash = 1;
-    Rule *r = (Rule *)pRule;
 
-    hash = 31 * hash + iHashSet.HashCode(&r->adminCond);
+    hash = 31 * hash + r->adminCond->hashCode;
 
     if (r->pmapUserCondValue == NULL) {
-        hash = 31 * hash + iHashSet.HashCode(&r->userCond);
+        hash = 31 * hash + r->userCond->hashCode;
     } else {
-        int hash2 = 1;
-        HashNodeIterator *it = iHashMap.NewIterator(r->pmapUserCondValue);
-        HashNode *node;
-        while (it->HasNext(it)) {
-            node = (HashNode *)it->GetNext(it);
-            hash2 = 31 * hash2 + IntHashCode(node->key);
-            hash2 = 31 * hash2 + iHashSet.HashCode(node->value);
+        // 与遍历顺序无关：各键值对哈希值之和
+        // 不用 key ^ value，否则属性下标恰好等于取值之和时该键值对的哈希值为0，与没有该条件的规则冲突
+        int hash2 = 0;
+        HashMap *pmapUserCondValue = r->pmapUserCondValue;
+        HASHMAP_FOREACH(slot, pmapUserCondValue) {
+            hash2 += 31 * (IntHashCode(HashMapSlotKey(pmapUserCondValue, slot)) + 1) + iIntSet.HashCode(HashMapSlotValue(pmapUserCondValue, slot));
         }
-        iHashMap.DeleteIterator(it);
         hash = 31 * hash + hash2;
     }
 
@@ -115,6 +174,18 @@ static unsigned int RuleHashCode(void *pRule) {
     return hash;
 }
 
+static unsigned int RuleHashCode(void *pRule) {
+    if (pRule == NULL) {
+        printf("[Error] RuleHashCode: rule is NULL\n");
+        abort();
+    }
+    return ((Rule *)pRule)->hashCode;
+}
+
+static void UpdateHashCode(Rule *r) {
+    r->hashCode = computeRuleHash(r);
+}
+
 static int RuleEqual(void *pRule1, void *pRule2) {
     if (pRule1 == NULL || pRule2 == NULL) {
         printf("[Error] RuleEqual: rule is NULL\n");
@@ -128,27 +199,28 @@ static int RuleEqual(void *pRule1, void *pRule2) {
     if (r1->targetValueIdx != r2->targetValueIdx) {
         return 0;
     }
-    if (iHashSet.Equal(&r1->adminCond, &r2->adminCond) == 0) {
+    if (r1->hashCode != r2->hashCode) {
+        return 0;
+    }
+    // 条件已驻留，内容相同当且仅当是同一个对象
+    if (r1->adminCond != r2->adminCond) {
         return 0;
     }
     if (r1->pmapUserCondValue == NULL || r2->pmapUserCondValue == NULL) {
-        return iHashSet.Equal(&r1->userCond, &r2->userCond);
+        return r1->userCond == r2->userCond;
+    } else if (iHashMap.Size(r1->pmapUserCondValue) != iHashMap.Size(r2->pmapUserCondValue)) {
+        return 0;
     } else {
-        int ret = 1;
-        HashNodeIterator *it = iHashMap.NewIterator(r1->pmapUserCondValue);
-        HashNode *node;
-        HashSet **psetCondValues1, **psetCondValues2;
-        while (it->HasNext(it)) {
-            node = (HashNode *)it->GetNext(it);
-            psetCondValues1 = (HashSet **)node->value;
-            psetCondValues2 = iHashMap.Get(r2->pmapUserCondValue, node->key);
-            if (psetCondValues2 == NULL || iHashSet.Equal(psetCondValues1, psetCondValues2) == 0) {
-                ret = 0;
-                break;
+        HashMap *pmapUserCondValue1 = r1->pmapUserCondValue;
+        IntSet **psetCondValues1, **psetCondValues2;
+        HASHMAP_FOREACH(slot, pmapUserCondValue1) {
+            psetCondValues1 = (IntSet **)HashMapSlotValue(pmapUserCondValue1, slot);
+            psetCondValues2 = iHashMap.Get(r2->pmapUserCondValue, HashMapSlotKey(pmapUserCondValue1, slot));
+            if (psetCondValues2 == NULL || iIntSet.Equal(psetCondValues1, psetCondValues2) == 0) {
+                return 0;
             }
         }
-        iHashMap.DeleteIterator(it);
-        return ret;
+        return 1;
     }
 }
 
@@ -158,11 +230,12 @@ static Rule *Create(HashSet *adminCond, HashSet *userCond, int targetAttrIdx, in
         logAABAC(__func__, __LINE__, 0, ERROR, "Failed to allocate memory for rule\n");
         return NULL;
     }
-    r->adminCond = adminCond;
-    r->userCond = userCond;
+    r->adminCond = Intern(adminCond);
+    r->userCond = Intern(userCond);
     r->targetAttrIdx = targetAttrIdx;
     r->targetValueIdx = targetValueIdx;
     r->pmapUserCondValue = NULL;
+    r->hashCode = computeRuleHash(r);
     return r;
 }
 
@@ -181,24 +254,24 @@ static int DiscreteCond(Rule *r, HashMap *reachableAVs) {
     int ret = 0;
     // logAABAC(__func__, __LINE__, 0, 1, "%s\n", mapToString(reachableAVs, iHashSet.ToString));
     int *pAttrIdx;
-    HashSet *effectiveVals, **pEffectiveVals, *reachableValues, **pReachableVals;
+    IntSet *effectiveVals, **pEffectiveVals, *reachableValues, **pReachableVals;
     HashNode *node;
     HashMap *pmapUserCondValue = r->pmapUserCondValue;
     if (pmapUserCondValue == NULL) {
-        pmapUserCondValue = iHashMap.Create(sizeof(int), sizeof(HashSet *), IntHashCode, IntEqual);
-        iHashMap.SetDestructValue(pmapUserCondValue, iHashSet.DestructPointer);
+        pmapUserCondValue = iHashMap.Create(sizeof(int), sizeof(IntSet *), IntHashCode, IntEqual);
+        iHashMap.SetDestructValue(pmapUserCondValue, iIntSet.DestructPointer);
         
         r->pmapUserCondValue = pmapUserCondValue;
-        HashSetIterator *it = iHashSet.NewIterator(r->userCond);
         AtomCondition *atomCond;
         int attrIdx;
-        while (it->HasNext(it)) {
-            atomCond = it->GetNext(it); //*(atomCondition **)it->GetNext(it);
+        HashSet *psetUserAtoms = r->userCond->atoms;
+        HASHSET_FOREACH(slot, psetUserAtoms) {
+            atomCond = HashSetSlotElement(psetUserAtoms, slot);
             attrIdx = atomCond->attribute;
 
             pEffectiveVals = iHashMap.Get(pmapUserCondValue, &attrIdx);
             if (pEffectiveVals == NULL) {
-                effectiveVals = iHashSet.Create(sizeof(int), IntHashCode, IntEqual);
+                effectiveVals = iIntSet.Create();
                 pReachableVals = iHashMap.Get(reachableAVs, &attrIdx);
                 if (pReachableVals != NULL) {
                     FindEffectiveValues(atomCond, *pReachableVals, effectiveVals);
@@ -208,50 +281,47 @@ static int DiscreteCond(Rule *r, HashMap *reachableAVs) {
                 RetainEffectiveValues(atomCond, *pEffectiveVals);
             }
         }
-        iHashSet.DeleteIterator(it);
         ret = 1;
     } else {
         int before;
-        HashNodeIterator *it = iHashMap.NewIterator(pmapUserCondValue);
-        while (it->HasNext(it)) {
-            node = it->GetNext(it);
-            pAttrIdx = (int *)node->key;
-            reachableValues = *(HashSet **)node->value;
-            before = iHashSet.Size(reachableValues);
+        HASHMAP_FOREACH(slot, pmapUserCondValue) {
+            pAttrIdx = (int *)HashMapSlotKey(pmapUserCondValue, slot);
+            reachableValues = *(IntSet **)HashMapSlotValue(pmapUserCondValue, slot);
+            before = iIntSet.Size(reachableValues);
             pReachableVals = iHashMap.Get(reachableAVs, pAttrIdx);
             if (pReachableVals == NULL) {
-                iHashSet.Clear(reachableValues);
+                iIntSet.Clear(reachableValues);
             } else {
-                iHashSet.RetainAll(reachableValues, *pReachableVals);
+                iIntSet.RetainAll(reachableValues, *pReachableVals);
             }
-            ret = (iHashSet.Size(reachableValues) != before);
+            ret = (iIntSet.Size(reachableValues) != before);
         }
-        iHashMap.DeleteIterator(it);
     }
 
-    HashSet **pSet, **pTargetAttrDom = iHashMap.Get(pmapUserCondValue, &r->targetAttrIdx);
+    IntSet **pSet, **pTargetAttrDom = iHashMap.Get(pmapUserCondValue, &r->targetAttrIdx);
     if (pTargetAttrDom != NULL) {
-        iHashSet.Add(*pTargetAttrDom, &r->targetValueIdx);
+        iIntSet.Add(*pTargetAttrDom, r->targetValueIdx);
         pSet = iHashMap.Get(reachableAVs, &r->targetAttrIdx);
-        if (pSet != NULL && iHashSet.Equal(pTargetAttrDom, pSet)) {
+        if (pSet != NULL && iIntSet.Equal(pTargetAttrDom, pSet)) {
             iHashMap.Remove(pmapUserCondValue, &r->targetAttrIdx);
         } else {
-            iHashSet.Remove(*pTargetAttrDom, &r->targetValueIdx);
+            iIntSet.Remove(*pTargetAttrDom, r->targetValueIdx);
         }
     }
 
-    HashNodeIterator *it = iHashMap.NewIterator(pmapUserCondValue);
-    while (it->HasNext(it)) {
-        node = it->GetNext(it);
+    HashNodeIterator it;
+    iHashMap.InitIterator(pmapUserCondValue, &it);
+    while (it.HasNext(&it)) {
+        node = it.GetNext(&it);
         pAttrIdx = (int *)node->key;
-        reachableValues = *(HashSet **)node->value;
-        if (iHashSet.Size(reachableValues) == 0) {
+        reachableValues = *(IntSet **)node->value;
+        if (iIntSet.Size(reachableValues) == 0) {
             ret = -1;
             break;
         }
         pSet = iHashMap.Get(reachableAVs, pAttrIdx);
-        if (pSet != NULL && iHashSet.Equal(&reachableValues, pSet)) {
-            it->Remove(it);
+        if (pSet != NULL && iIntSet.Equal(&reachableValues, pSet)) {
+            it.Remove(&it);
             // free(node->key);
             // iHashSet.Finalize(reachableValues);
             // free(node->value);
@@ -259,59 +329,36 @@ static int DiscreteCond(Rule *r, HashMap *reachableAVs) {
             // iHashMap.Remove(pmapUserCondValue, pAttrIdx);
         }
     }
-    iHashMap.DeleteIterator(it);
+    r->hashCode = computeRuleHash(r);
     return ret;
 }
 
 static int CanBeManaged(Rule *r, HashMap *userState) {
-    int ret = 1;
-    HashNodeIterator *it = iHashMap.NewIterator(r->pmapUserCondValue);
+    HashMap *pmapUserCondValue = r->pmapUserCondValue;
     int *pAttrIdx, *pUserAttrVal;
-    HashNode *node;
-    HashSet *condValues;
-    while (it->HasNext(it)) {
-        node = it->GetNext(it);
-        pAttrIdx = (int *)node->key;
-        condValues = *(HashSet **)node->value;
+    IntSet *condValues;
+    HASHMAP_FOREACH(slot, pmapUserCondValue) {
+        pAttrIdx = (int *)HashMapSlotKey(pmapUserCondValue, slot);
+        condValues = *(IntSet **)HashMapSlotValue(pmapUserCondValue, slot);
         pUserAttrVal = iHashMap.Get(userState, pAttrIdx);
-        if (pUserAttrVal == NULL || !iHashSet.Contains(condValues, pUserAttrVal)) {
-            ret = 0;
-            break;
+        if (pUserAttrVal == NULL || !iIntSet.Contains(condValues, *pUserAttrVal)) {
+            return 0;
         }
     }
-    iHashMap.DeleteIterator(it);
-    return ret;
+    return 1;
 }
 
 static int IsEffective(Rule *r, HashMap *reachableAVs) {
-    int ret = 1;
-    HashNodeIterator *it = iHashMap.NewIterator(r->pmapUserCondValue);
-    int flag, *pAttrIdx, *pVal;
-    HashNode *node;
-    HashSet *condValues, **pReachableValues;
-    HashSetIterator *itCondValues;
-    while (it->HasNext(it)) {
-        node = it->GetNext(it);
-        pAttrIdx = (int *)node->key;
-        condValues = *(HashSet **)node->value;
-        flag = 0;
-        itCondValues = iHashSet.NewIterator(condValues);
-        while (itCondValues->HasNext(itCondValues)) {
-            pVal = (int *)itCondValues->GetNext(itCondValues);
-            pReachableValues = iHashMap.Get(reachableAVs, pAttrIdx);
-            if (pReachableValues != NULL && iHashSet.Contains(*pReachableValues, pVal)) {
-                flag = 1;
-                break;
-            }
-        }
-        iHashSet.DeleteIterator(itCondValues);
-        if (!flag) {
-            ret = 0;
-            break;
+    HashMap *pmapUserCondValue = r->pmapUserCondValue;
+    IntSet **pReachableValues;
+    HASHMAP_FOREACH(slot, pmapUserCondValue) {
+        // 每个条件属性至少有一个取值可达
+        pReachableValues = iHashMap.Get(reachableAVs, HashMapSlotKey(pmapUserCondValue, slot));
+        if (pReachableValues == NULL || !iIntSet.Intersects(*(IntSet **)HashMapSlotValue(pmapUserCondValue, slot), *pReachableValues)) {
+            return 0;
         }
     }
-    iHashMap.DeleteIterator(it);
-    return ret;
+    return 1;
 }
 
 AtomConditionInterface iAtomCondition = {
@@ -321,6 +368,14 @@ AtomConditionInterface iAtomCondition = {
     .Equal = AtomCondEqual,
 };
 
+ConditionInterface iCondition = {
+    .Intern = Intern,
+    .True = True,
+    .GetById = GetById,
+    .Count = Count,
+    .ClearTable = ClearTable,
+};
+
 RuleInterface iRule = {
     .Create = Create,
     .DiscreteCond = DiscreteCond,
@@ -328,4 +383,5 @@ RuleInterface iRule = {
     .IsEffective = IsEffective,
     .HashCode = RuleHashCode,
     .Equal = RuleEqual,
-};
\ No newline at end of file
+    .UpdateHashCode = UpdateHashCode,
+};
\ No newline at end of file
@@ -1,220 +1,362 @@
 #include "AABACTranslator.h"
 #include "AABACUtils.h"
 #include <assert.h>
+#include <string.h>
 #include <time.h>
 
+// 输出缓冲区大小，缓冲区满时整块写入文件
+#define SMV_BUFFER_SIZE (1 << 20)
+
+// 单个字符串写入缓冲区的最大长度，更长的字符串直接写入文件
+#define SMV_MAX_INLINE_LEN 4096
+
+// NuSMV模型的缓冲输出器
+typedef struct {
+    FILE *fp;
+    char *buf;
+    size_t len;
+    int failed;             // 写入文件是否失败
+    int ruleComments;       // 是否在每个case分支前写入对应规则的注释
+    int invarSpec;          // 是否将查询写为INVARSPEC不变式，否则写为LTLSPEC
+    ValueToken *attrTokens; // 属性下标 -> 属性名
+} SmvEmitter;
+
 static void computeAttrDom(AABACInstance *pInst) {
-    HashSetIterator *itSet1 = iHashSet.NewIterator(pInst->pSetRuleIdxes), *itSet2;
-    int ruleIdx, *pAttrIdx;
-    Rule *pRule;
-    HashNodeIterator *itMap;
-    HashNode *node;
-    HashSet **ppSetValIdxes;
-    while (itSet1->HasNext(itSet1)) {
-        ruleIdx = *(int *)itSet1->GetNext(itSet1);
-        pRule = iVector.GetElement(pVecRules, ruleIdx);
-        itMap = iHashMap.NewIterator(pRule->pmapUserCondValue);
-        while (itMap->HasNext(itMap)) {
-            node = itMap->GetNext(itMap);
-            pAttrIdx = (int *)node->key;
-            ppSetValIdxes = iHashMap.Get(pInst->pMapAttr2Dom, pAttrIdx);
+    int *pAttrIdx;
+    HashMap *pmapQueryAVs = pInst->pmapQueryAVs;
+    IntSet **ppSetValIdxes;
+    INTSET_FOREACH(ruleIdx, pInst->pSetRuleIdxes) {
+        RULESTORE_COND_FOREACH(cond, pRuleStore, ruleIdx) {
+            ppSetValIdxes = iHashMap.Get(pInst->pMapAttr2Dom, &pRuleStore->condAttrs[cond]);
             assert(ppSetValIdxes != NULL);
-            itSet2 = iHashSet.NewIterator(*(HashSet **)node->value);
-            while (itSet2->HasNext(itSet2)) {
-                iHashSet.Add(*ppSetValIdxes, itSet2->GetNext(itSet2));
+            RULESTORE_VALUE_FOREACH(valIdx, pRuleStore, cond) {
+                iIntSet.Add(*ppSetValIdxes, valIdx);
             }
-            iHashSet.DeleteIterator(itSet2);
         }
-        iHashMap.DeleteIterator(itMap);
     }
-    iHashMap.DeleteIterator(itSet1);
 
-    itMap = iHashMap.NewIterator(pInst->pmapQueryAVs);
-    while (itMap->HasNext(itMap)) {
-        node = itMap->GetNext(itMap);
-        pAttrIdx = (int *)node->key;
+    HASHMAP_FOREACH(slot, pmapQueryAVs) {
+        pAttrIdx = (int *)HashMapSlotKey(pmapQueryAVs, slot);
         ppSetValIdxes = iHashMap.Get(pInst->pMapAttr2Dom, pAttrIdx);
         assert(ppSetValIdxes != NULL);
         // if (ppSetValIdxes == NULL) {
-        //     pSetValIdxes = iHashSet.Create(sizeof(int), IntHashCode, IntEqual);
+        //     pSetValIdxes = iIntSet.Create();
         //     ppSetValIdxes = &pSetValIdxes;
         //     iHashMap.Put(pInst->pmapAttr2Dom, pAttrIdx, ppSetValIdxes);
         // }
-        iHashSet.Add(*ppSetValIdxes, node->value);
+        iIntSet.Add(*ppSetValIdxes, *(int *)HashMapSlotValue(pmapQueryAVs, slot));
+    }
+}
+
+/**
+ * 将缓冲区中的内容写入文件
+ * @param e[in]: 输出器
+ */
+static void emitFlush(SmvEmitter *e) {
+    if (e->len > 0 && !e->failed && fwrite(e->buf, 1, e->len, e->fp) != e->len) {
+        e->failed = 1;
+    }
+    e->len = 0;
+}
+
+/**
+ * 写入长度为n的字节串
+ * @param e[in]: 输出器
+ * @param s[in]: 字节串
+ * @param n[in]: 长度
+ */
+static inline void emitBytes(SmvEmitter *e, const char *s, size_t n) {
+    if (e->len + n > SMV_BUFFER_SIZE) {
+        emitFlush(e);
+        if (n > SMV_MAX_INLINE_LEN) {
+            if (!e->failed && fwrite(s, 1, n, e->fp) != n) {
+                e->failed = 1;
+            }
+            return;
+        }
+    }
+    memcpy(e->buf + e->len, s, n);
+    e->len += n;
+}
+
+static inline void emitStr(SmvEmitter *e, const char *s) {
+    emitBytes(e, s, strlen(s));
+}
+
+static inline void emitToken(SmvEmitter *e, const ValueToken *token) {
+    emitBytes(e, token->str, token->len);
+}
+
+static inline void emitChar(SmvEmitter *e, char c) {
+    if (e->len == SMV_BUFFER_SIZE) {
+        emitFlush(e);
+    }
+    e->buf[e->len++] = c;
+}
+
+/**
+ * 写入一个取值，取值来自预先渲染的取值记号表
+ * @param e[in]: 输出器
+ * @param attrType[in]: 属性的数据类型
+ * @param valIdx[in]: 取值下标
+ */
+static inline void emitValue(SmvEmitter *e, AttrType attrType, int valIdx) {
+    emitToken(e, getValueToken(attrType, valIdx));
+}
+
+/**
+ * 写入条件的字符串表示，格式与RuleToString相同
+ * @param e[in]: 输出器
+ * @param cond[in]: 条件
+ */
+static void emitCondition(SmvEmitter *e, Condition *cond) {
+    static const char *opStrs[] = {"=", "!=", "<", ">", "<=", ">="};
+    AtomCondition *pAtomCond;
+    int first = 1;
+    if (iHashSet.Size(cond->atoms) == 0) {
+        emitBytes(e, "TRUE", 4);
+        return;
+    }
+    HASHSET_FOREACH(slot, cond->atoms) {
+        pAtomCond = (AtomCondition *)HashSetSlotElement(cond->atoms, slot);
+        if (!first) {
+            emitBytes(e, " & ", 3);
+        }
+        first = 0;
+        emitToken(e, &e->attrTokens[pAtomCond->attribute]);
+        emitStr(e, opStrs[pAtomCond->op]);
+        emitValue(e, pAttr2Type[pAtomCond->attribute], pAtomCond->value);
+    }
+}
+
+/**
+ * 写入规则的注释，内容与RuleToString相同，但直接写入缓冲区
+ * @param e[in]: 输出器
+ * @param pRule[in]: 规则
+ */
+static void emitRuleComment(SmvEmitter *e, Rule *pRule) {
+    AttrType attrType;
+    int firstAttr = 1, firstVal;
+    emitBytes(e, "-- (", 4);
+    emitCondition(e, pRule->adminCond);
+    emitBytes(e, ", ", 2);
+    emitCondition(e, pRule->userCond);
+    emitBytes(e, ", ", 2);
+    emitToken(e, &e->attrTokens[pRule->targetAttrIdx]);
+    emitBytes(e, ", ", 2);
+    emitValue(e, pAttr2Type[pRule->targetAttrIdx], pRule->targetValueIdx);
+    emitBytes(e, ")\t/*", 4);
+    if (pRule->pmapUserCondValue == NULL) {
+        emitStr(e, "not defined");
+    } else if (iHashMap.Size(pRule->pmapUserCondValue) == 0) {
+        emitStr(e, "none");
+    } else {
+        emitChar(e, '{');
+        HASHMAP_FOREACH(slot, pRule->pmapUserCondValue) {
+            int attrIdx = *(int *)HashMapSlotKey(pRule->pmapUserCondValue, slot);
+            if (!firstAttr) {
+                emitBytes(e, ", ", 2);
+            }
+            firstAttr = 0;
+            emitToken(e, &e->attrTokens[attrIdx]);
+            emitBytes(e, "=[", 2);
+            attrType = pAttr2Type[attrIdx];
+            firstVal = 1;
+            INTSET_FOREACH(valIdx, *(IntSet **)HashMapSlotValue(pRule->pmapUserCondValue, slot)) {
+                if (!firstVal) {
+                    emitBytes(e, ", ", 2);
+                }
+                firstVal = 0;
+                emitValue(e, attrType, valIdx);
+            }
+            emitChar(e, ']');
+        }
+        emitChar(e, '}');
     }
-    iHashMap.DeleteIterator(itMap);
+    emitBytes(e, "*/\n", 3);
 }
 
 /**
  * 写入状态变量
  * @param instance[in]: 待翻译的AABAC实例
- * @param fp[in]: 输出文件
+ * @param e[in]: 输出器
  */
-static void translateVars(AABACInstance *pInst, FILE *fp) {
-    fprintf(fp, "VAR\n");
+static void translateVars(AABACInstance *pInst, SmvEmitter *e) {
+    emitStr(e, "VAR\n");
 
     // 定义变量
     HashSet *pSetVals = iHashSet.Create(sizeof(char *), StringHashCode, StringEqual);
 
-    HashNodeIterator *itMap = iHashMap.NewIterator(pInst->pMapAttr2Dom);
+    HashMap *pMapAttr2Dom = pInst->pMapAttr2Dom;
     int *pAttrIdx;
-    char *attr, *val;
+    char *val;
+    const ValueToken *pValToken;
     AttrType attrType;
-    HashNode *node;
-    HashSetIterator *itSet;
     int first;
-    while (itMap->HasNext(itMap)) {
-        node = itMap->GetNext(itMap);
-        pAttrIdx = (int *)node->key;
-        attr = istrCollection.GetElement(pscAttrs, *pAttrIdx);
-        attrType = *(AttrType *)iHashMap.Get(pmapAttr2Type, pAttrIdx);
-        fprintf(fp, "%s : {", attr);
+    HASHMAP_FOREACH(slot, pMapAttr2Dom) {
+        pAttrIdx = (int *)HashMapSlotKey(pMapAttr2Dom, slot);
+        attrType = pAttr2Type[*pAttrIdx];
+        emitToken(e, &e->attrTokens[*pAttrIdx]);
+        emitBytes(e, " : {", 4);
 
         first = 1;
-        itSet = iHashSet.NewIterator(*(HashSet **)node->value);
-        while (itSet->HasNext(itSet)) {
-            val = getValueByIndex(attrType, *(int *)itSet->GetNext(itSet));
-            fprintf(fp, "%s%s", first ? "" : ",", val);
+        INTSET_FOREACH(valIdx, *(IntSet **)HashMapSlotValue(pMapAttr2Dom, slot)) {
+            if (!first) {
+                emitChar(e, ',');
+            }
             first = 0;
+            pValToken = getValueToken(attrType, valIdx);
+            emitToken(e, pValToken);
+            val = pValToken->str;
             iHashSet.Add(pSetVals, &val);
         }
-        iHashSet.DeleteIterator(itSet);
-        fprintf(fp, "};\n");
+        emitStr(e, "};\n");
     }
-    iHashMap.DeleteIterator(itMap);
 
-    fprintf(fp, "attr : {");
-    itMap = iHashMap.NewIterator(pInst->pMapAttr2Dom);
+    emitStr(e, "attr : {");
     first = 1;
-    while (itMap->HasNext(itMap)) {
-        node = itMap->GetNext(itMap);
-        attr = istrCollection.GetElement(pscAttrs, *(int *)node->key);
-        fprintf(fp, "%s%s%s", first ? "" : ",", attr, ALIAS_SUFFIX);
+    HASHMAP_FOREACH(slot, pMapAttr2Dom) {
+        if (!first) {
+            emitChar(e, ',');
+        }
         first = 0;
+        emitToken(e, &e->attrTokens[*(int *)HashMapSlotKey(pMapAttr2Dom, slot)]);
+        emitBytes(e, ALIAS_SUFFIX, ALIAS_SUFFIX_LEN);
     }
-    iHashMap.DeleteIterator(itMap);
-    fprintf(fp, "};\n");
+    emitStr(e, "};\n");
 
-    fprintf(fp, "val : {");
-    itSet = iHashSet.NewIterator(pSetVals);
+    emitStr(e, "val : {");
     first = 1;
-    while (itSet->HasNext(itSet)) {
-        fprintf(fp, "%s%s", first ? "" : ",", *(char **)itSet->GetNext(itSet));
+    HASHSET_FOREACH(slot, pSetVals) {
+        if (!first) {
+            emitChar(e, ',');
+        }
         first = 0;
+        emitStr(e, *(char **)HashSetSlotElement(pSetVals, slot));
     }
-    iHashSet.DeleteIterator(itSet);
-    fprintf(fp, "};\n\n");
+    emitStr(e, "};\n\n");
+
+    iHashSet.Finalize(pSetVals);
 }
 
 /**
  * 写入初始状态
  * @param instance[in]: 待翻译的AABAC实例
- * @param fp[in]: 输出文件
+ * @param e[in]: 输出器
  */
-static void translateInitState(AABACInstance *pInst, FILE *fp) {
-    fprintf(fp, "ASSIGN\n");
+static void translateInitState(AABACInstance *pInst, SmvEmitter *e) {
+    emitStr(e, "ASSIGN\n");
 
     HashMap *avsOfUser = iHashBasedTable.GetRow(pInst->pTableInitState, &pInst->queryUserIdx);
+    HashMap *pMapAttr2Dom = pInst->pMapAttr2Dom;
     int *pAttrIdx, valIdx;
-    AttrType attrType;
-    HashNode *node;
-    HashNodeIterator *itMap = iHashMap.NewIterator(pInst->pMapAttr2Dom);
-    while (itMap->HasNext(itMap)) {
-        node = itMap->GetNext(itMap);
-        if (iHashSet.Size(*(HashSet **)node->value) <= 1) {
+    HASHMAP_FOREACH(slot, pMapAttr2Dom) {
+        if (iIntSet.Size(*(IntSet **)HashMapSlotValue(pMapAttr2Dom, slot)) <= 1) {
             continue;
         }
-        pAttrIdx = (int *)node->key;
+        pAttrIdx = (int *)HashMapSlotKey(pMapAttr2Dom, slot);
         valIdx = *(int *)iHashMap.Get(avsOfUser, pAttrIdx);
-        attrType = *(AttrType *)iHashMap.Get(pmapAttr2Type, pAttrIdx);
-        fprintf(fp, "init(%s) := %s;\n", istrCollection.GetElement(pscAttrs, *pAttrIdx), getValueByIndex(attrType, valIdx));
+        emitBytes(e, "init(", 5);
+        emitToken(e, &e->attrTokens[*pAttrIdx]);
+        emitBytes(e, ") := ", 5);
+        emitValue(e, pAttr2Type[*pAttrIdx], valIdx);
+        emitBytes(e, ";\n", 2);
     }
-    iHashMap.DeleteIterator(itMap);
 
-    fprintf(fp, "\n");
+    emitChar(e, '\n');
 }
 
-static void translateCanSetRules(AABACInstance *pInst, FILE *fp) {
+/**
+ * 写入条件中某个属性的一个取值。属性只有一个取值时写为"& attr=val"，否则写为"& (attr=val1 | attr=val2 ...)"，
+ * 其中的右括号由调用者在写完所有取值后写入
+ * @param e[in]: 输出器
+ * @param condAttrIdx[in]: 条件属性
+ * @param valIdx[in]: 取值下标
+ * @param nValues[in]: 该属性的取值个数
+ * @param first[in]: 是否为第一个取值
+ */
+static void translateCondValue(SmvEmitter *e, int condAttrIdx, int valIdx, int nValues, int first) {
+    if (nValues == 1) {
+        emitBytes(e, " & ", 3);
+    } else {
+        emitBytes(e, first ? " & (" : " | ", first ? 4 : 3);
+    }
+    emitToken(e, &e->attrTokens[condAttrIdx]);
+    emitChar(e, '=');
+    emitValue(e, pAttr2Type[condAttrIdx], valIdx);
+}
+
+/**
+ * 统计值域中满足原子条件的取值个数
+ * @param pAtomCond[in]: 原子条件
+ * @param pSetAttrDom[in]: 条件属性的值域
+ * @return 满足条件的取值个数
+ */
+static int countEffectiveValues(AtomCondition *pAtomCond, IntSet *pSetAttrDom) {
+    int count = 0;
+    INTSET_FOREACH(valIdx, pSetAttrDom) {
+        count += iAtomCondition.Evaluate(pAtomCond, valIdx) != 0;
+    }
+    return count;
+}
+
+static void translateCanSetRules(AABACInstance *pInst, SmvEmitter *e) {
     int *pTargetAttrIdx, condAttrIdx;
-    char *targetAttr, *targetVal, *condAttr;
-    AttrType attrType, condAttrType;
+    ValueToken *targetAttr;
+    AttrType attrType;
     Rule *pRule;
-    char *ruleStr;
-    int isEffectiveRule, first, isAtLeastOneEffectiveRule;
-    HashSet *pSetAttrDom, *pSetEffectiveValues;
-    HashSetIterator *itSetRules, *itSetAtomConds, *itSetEffectiveValues;
+    int isEffectiveRule, first, nValues, isAtLeastOneEffectiveRule;
+    IntSet *pSetAttrDom, **ppSetAttrDom, *pSetTargetVals;
     AtomCondition *pAtomCond;
-    HashMap *pMapValToRules, *pMapAdminCondValue;
-    HashNode *node;
-    HashNodeIterator *itMapAttr2Dom = iHashMap.NewIterator(pInst->pMapAttr2Dom), *itMapValToRules, *itMapCondValue;
-    while (itMapAttr2Dom->HasNext(itMapAttr2Dom)) {
-        node = itMapAttr2Dom->GetNext(itMapAttr2Dom);
-        pTargetAttrIdx = (int *)node->key;
-        pSetAttrDom = *(HashSet **)node->value;
-        if (iHashSet.Size(pSetAttrDom) <= 1) {
+    HashMap *pMapAttr2Dom = pInst->pMapAttr2Dom;
+    HASHMAP_FOREACH(attrSlot, pMapAttr2Dom) {
+        pTargetAttrIdx = (int *)HashMapSlotKey(pMapAttr2Dom, attrSlot);
+        pSetAttrDom = *(IntSet **)HashMapSlotValue(pMapAttr2Dom, attrSlot);
+        if (iIntSet.Size(pSetAttrDom) <= 1) {
             continue;
         }
-        targetAttr = istrCollection.GetElement(pscAttrs, *pTargetAttrIdx);
+        targetAttr = &e->attrTokens[*pTargetAttrIdx];
 
-        pMapValToRules = iHashBasedTable.GetRow(pInst->pTableTargetAV2Rule, pTargetAttrIdx);
-        if (pMapValToRules == NULL) {
+        pSetTargetVals = iPackedTable.GetRow(pInst->pTableTargetAV2Rule, *pTargetAttrIdx);
+        if (pSetTargetVals == NULL) {
             // 如果没有以attr为目标属性的规则，那么该属性的值将永远不会变化
             // 即next(attr) := attr
-            fprintf(fp, "next(%s) := %s;\n\n", targetAttr, targetAttr);
+            emitBytes(e, "next(", 5);
+            emitToken(e, targetAttr);
+            emitBytes(e, ") := ", 5);
+            emitToken(e, targetAttr);
+            emitBytes(e, ";\n\n", 3);
             continue;
         }
 
-        attrType = *(AttrType *)iHashMap.Get(pmapAttr2Type, pTargetAttrIdx);
+        attrType = pAttr2Type[*pTargetAttrIdx];
         isAtLeastOneEffectiveRule = 0;
 
         // 遍历规则，列出next(attr[i])的所有可能变化
-        itMapValToRules = iHashMap.NewIterator(pMapValToRules);
-        while (itMapValToRules->HasNext(itMapValToRules)) {
-            node = itMapValToRules->GetNext(itMapValToRules);
-            itSetRules = iHashSet.NewIterator(*(HashSet **)node->value);
-
-            while (itSetRules->HasNext(itSetRules)) {
-                pRule = (Rule *)iVector.GetElement(pVecRules, *(int *)itSetRules->GetNext(itSetRules));
+        INTSET_FOREACH(targetValIdx, pSetTargetVals) {
+            INTSET_FOREACH(ruleIdx, *(IntSet **)iPackedTable.Get(pInst->pTableTargetAV2Rule, *pTargetAttrIdx, targetValIdx)) {
+                pRule = (Rule *)iVector.GetElement(pVecRules, ruleIdx);
 
-                // 检查该规则是否有效
+                // 检查该规则是否有效：管理员条件的每个原子条件在条件属性的值域中都至少有一个满足的取值
                 isEffectiveRule = 1;
-                pMapAdminCondValue = iHashMap.Create(sizeof(int), sizeof(HashSet *), IntHashCode, IntEqual);
-                iHashMap.SetDestructValue(pMapAdminCondValue, iHashSet.DestructPointer);
-
-                itSetAtomConds = iHashSet.NewIterator(pRule->adminCond);
-                while (itSetAtomConds->HasNext(itSetAtomConds)) {
-                    pAtomCond = (AtomCondition *)itSetAtomConds->GetNext(itSetAtomConds);
-                    condAttrIdx = pAtomCond->attribute;
-
-                    // 在condAttr的值域中寻找所有满足条件adminAtomCond的值effectiveValues
-                    pSetAttrDom = iHashMap.Get(pInst->pMapAttr2Dom, &condAttrIdx);
-                    pSetEffectiveValues = iHashSet.Create(sizeof(int), IntHashCode, IntEqual);
-                    iAtomCondition.FindEffectiveValues(pAtomCond, pSetAttrDom, pSetEffectiveValues);
-
-                    // 如果effectiveValues为空集，则设置标志位isEffectiveRule = false，然后break
-                    if (iHashSet.Size(pSetEffectiveValues) == 0) {
+                HASHSET_FOREACH(condSlot, pRule->adminCond->atoms) {
+                    pAtomCond = (AtomCondition *)HashSetSlotElement(pRule->adminCond->atoms, condSlot);
+                    ppSetAttrDom = iHashMap.Get(pMapAttr2Dom, &pAtomCond->attribute);
+                    if (ppSetAttrDom == NULL || countEffectiveValues(pAtomCond, *ppSetAttrDom) == 0) {
                         isEffectiveRule = 0;
-                        iHashSet.Finalize(pSetEffectiveValues);
                         break;
                     }
-
-                    // 如果effectiveValues等于condAttr的值域，则不用添加后续条件，直接continue就行
-                    if (iHashSet.Equal(&pSetAttrDom, &pSetEffectiveValues)) {
-                        iHashSet.Finalize(pSetEffectiveValues);
-                        continue;
-                    }
-                    iHashMap.Put(pMapAdminCondValue, &condAttrIdx, &pSetEffectiveValues);
                 }
-                // 如果isEffectiveRule = 0，那么continue，跳过该规则
                 if (!isEffectiveRule) {
-                    iHashMap.Finalize(pMapAdminCondValue);
                     continue;
                 }
 
                 // 规则有效，需写入文件
                 // 如果还没有写入过next(attr) := case的语句，则写入
                 if (!isAtLeastOneEffectiveRule) {
-                    fprintf(fp, "next(%s) :=\ncase\n", targetAttr);
+                    emitBytes(e, "next(", 5);
+                    emitToken(e, targetAttr);
+                    emitBytes(e, ") :=\ncase\n", 10);
                     isAtLeastOneEffectiveRule = 1;
                 }
 
@@ -223,82 +365,108 @@ static void translateCanSetRules(AABACInstance *pInst, FILE *fp) {
                 // 2.管理值为规则的目标值，即val = targetVal
                 // 3.被管理为i，即user = i
                 // 4.管理员与被管理者分别满足adminCondition与userCondition
-                targetVal = getValueByIndex(attrType, pRule->targetValueIdx);
-                ruleStr = RuleToString(&pRule);
-                fprintf(fp, "-- %s\nattr=%s%s & val=%s", ruleStr, targetAttr, ALIAS_SUFFIX, targetVal);
-                free(ruleStr);
-
-                HashMap *condValues[2] = {pMapAdminCondValue, pRule->pmapUserCondValue};
-                int i;
-                for (i = 0; i < 2; i++) {
-                    itMapCondValue = iHashMap.NewIterator(condValues[i]);
-                    while (itMapCondValue->HasNext(itMapCondValue)) {
-                        node = itMapCondValue->GetNext(itMapCondValue);
-                        condAttrIdx = *(int *)node->key;
-                        condAttr = istrCollection.GetElement(pscAttrs, condAttrIdx);
-                        condAttrType = *(AttrType *)iHashMap.Get(pmapAttr2Type, &condAttrIdx);
-                        pSetEffectiveValues = *(HashSet **)node->value;
-                        itSetEffectiveValues = iHashSet.NewIterator(pSetEffectiveValues);
-                        if (iHashSet.Size(pSetEffectiveValues) == 1) {
-                            while (itSetEffectiveValues->HasNext(itSetEffectiveValues)) {
-                                fprintf(fp, " & %s=%s", condAttr, getValueByIndex(condAttrType, *(int *)itSetEffectiveValues->GetNext(itSetEffectiveValues)));
-                            }
-                        } else {
-                            first = 1;
-                            while (itSetEffectiveValues->HasNext(itSetEffectiveValues)) {
-                                fprintf(fp, first ? " & (%s=%s" : " | %s=%s", condAttr, getValueByIndex(condAttrType, *(int *)itSetEffectiveValues->GetNext(itSetEffectiveValues)));
-                                first = 0;
-                            }
-                            fprintf(fp, ")");
+                if (e->ruleComments) {
+                    emitRuleComment(e, pRule);
+                }
+                emitBytes(e, "attr=", 5);
+                emitToken(e, targetAttr);
+                emitBytes(e, ALIAS_SUFFIX " & val=", ALIAS_SUFFIX_LEN + 7);
+                emitValue(e, attrType, pRule->targetValueIdx);
+
+                // 管理员条件直接按原子条件写入，取值为条件属性值域中满足该原子条件的值；
+                // 值域中的所有值都满足时该原子条件恒为真，不用写入
+                HASHSET_FOREACH(condSlot, pRule->adminCond->atoms) {
+                    pAtomCond = (AtomCondition *)HashSetSlotElement(pRule->adminCond->atoms, condSlot);
+                    condAttrIdx = pAtomCond->attribute;
+                    pSetAttrDom = *(IntSet **)iHashMap.Get(pMapAttr2Dom, &condAttrIdx);
+                    nValues = countEffectiveValues(pAtomCond, pSetAttrDom);
+                    if (nValues == iIntSet.Size(pSetAttrDom)) {
+                        continue;
+                    }
+                    first = 1;
+                    INTSET_FOREACH(valIdx, pSetAttrDom) {
+                        if (iAtomCondition.Evaluate(pAtomCond, valIdx)) {
+                            translateCondValue(e, condAttrIdx, valIdx, nValues, first);
+                            first = 0;
                         }
-                        iHashSet.DeleteIterator(itSetEffectiveValues);
                     }
-                    iHashMap.DeleteIterator(itMapCondValue);
+                    if (nValues > 1) {
+                        emitChar(e, ')');
+                    }
                 }
-                fprintf(fp, " : %s;\n", targetVal);
-
-                iHashMap.Finalize(pMapAdminCondValue);
+                // 用户条件取自编译后的规则存储
+                RULESTORE_COND_FOREACH(cond, pRuleStore, ruleIdx) {
+                    condAttrIdx = pRuleStore->condAttrs[cond];
+                    nValues = iRuleStore.CountValues(pRuleStore, cond);
+                    first = 1;
+                    RULESTORE_VALUE_FOREACH(valIdx, pRuleStore, cond) {
+                        translateCondValue(e, condAttrIdx, valIdx, nValues, first);
+                        first = 0;
+                    }
+                    if (nValues > 1) {
+                        emitChar(e, ')');
+                    }
+                }
+                emitBytes(e, " : ", 3);
+                emitValue(e, attrType, pRule->targetValueIdx);
+                emitBytes(e, ";\n", 2);
             }
-            iHashSet.DeleteIterator(itSetRules);
         }
-        iHashMap.DeleteIterator(itMapValToRules);
 
         if (!isAtLeastOneEffectiveRule) {
-            fprintf(fp, "next(%s) := %s;\n\n", targetAttr, targetAttr);
+            emitBytes(e, "next(", 5);
+            emitToken(e, targetAttr);
+            emitBytes(e, ") := ", 5);
+            emitToken(e, targetAttr);
+            emitBytes(e, ";\n\n", 3);
             continue;
         }
 
-        fprintf(fp, "-- default\nTRUE : %s;\nesac;\n\n", targetAttr);
+        emitStr(e, "-- default\nTRUE : ");
+        emitToken(e, targetAttr);
+        emitStr(e, ";\nesac;\n\n");
     }
-    iHashMap.DeleteIterator(itMapAttr2Dom);
 }
 
 /**
- * 写入查询目标
+ * 写入查询目标。查询是安全性质，既可以写为LTLSPEC G (...)，也可以写为不变式INVARSPEC (...)
  * @param instance[in]: 待翻译的AABAC实例
- * @param fp[in]: 输出文件
+ * @param e[in]: 输出器
  */
-static void translateQuery(AABACInstance *pInst, FILE *fp) {
-    fprintf(fp, "LTLSPEC\n");
+static void translateQuery(AABACInstance *pInst, SmvEmitter *e) {
+    emitStr(e, e->invarSpec ? "INVARSPEC\n" : "LTLSPEC\n");
 
+    HashMap *pmapQueryAVs = pInst->pmapQueryAVs;
     int *pAttrIdx, first = 1;
-    char *attr, *val;
-    AttrType attrType;
-    HashNode *node;
-    HashNodeIterator *itMap = iHashMap.NewIterator(pInst->pmapQueryAVs);
-    while (itMap->HasNext(itMap)) {
-        node = itMap->GetNext(itMap);
-        pAttrIdx = (int *)node->key;
-        attr = istrCollection.GetElement(pscAttrs, *pAttrIdx);
-        attrType = *(AttrType *)iHashMap.Get(pmapAttr2Type, pAttrIdx);
-        val = getValueByIndex(attrType, *(int *)node->value);
-        fprintf(fp, first ? "G (%s!=%s" : " | %s!=%s", attr, val);
+    HASHMAP_FOREACH(slot, pmapQueryAVs) {
+        pAttrIdx = (int *)HashMapSlotKey(pmapQueryAVs, slot);
+        emitStr(e, first ? (e->invarSpec ? "(" : "G (") : " | ");
+        emitToken(e, &e->attrTokens[*pAttrIdx]);
+        emitBytes(e, "!=", 2);
+        emitValue(e, pAttr2Type[*pAttrIdx], *(int *)HashMapSlotValue(pmapQueryAVs, slot));
         first = 0;
     }
-    fprintf(fp, ")");
+    emitChar(e, ')');
 }
 
-int translate(AABACInstance *instance, char *nusmvFilePath, int sliced) {
+/**
+ * 为所有属性名预先计算长度，翻译过程中直接按长度复制
+ * @param e[in]: 输出器
+ */
+static void buildAttrTokens(SmvEmitter *e) {
+    int nAttrs = (int)istrCollection.Size(pscAttrs);
+    e->attrTokens = (ValueToken *)malloc((nAttrs + 1) * sizeof(ValueToken));
+    if (e->attrTokens == NULL) {
+        logAABAC(__func__, __LINE__, 0, ERROR, "Failed to allocate memory for the attribute tokens\n");
+        exit(-1);
+    }
+    for (int i = 0; i < nAttrs; i++) {
+        e->attrTokens[i].str = istrCollection.GetElement(pscAttrs, i);
+        e->attrTokens[i].len = strlen(e->attrTokens[i].str);
+    }
+}
+
+int translate(AABACInstance *instance, char *nusmvFilePath, int sliced, int ruleComments, int invarSpec) {
     logAABAC(__func__, __LINE__, 0, INFO, "[begin] translating aabac instance into nusmv file %s\n", nusmvFilePath);
     clock_t startTranslating = clock();
 
@@ -312,17 +480,31 @@ int translate(AABACInstance *instance, char *nusmvFilePath, int sliced) {
         computeAttrDom(instance);
     }
 
-    fprintf(fp, "-- This NuSMV specification was automatically generated by aabac policy verifier\n\n");
-    fprintf(fp, "MODULE main\n\n");
+    SmvEmitter emitter = {.fp = fp, .ruleComments = ruleComments, .invarSpec = invarSpec};
+    emitter.buf = (char *)malloc(SMV_BUFFER_SIZE);
+    if (emitter.buf == NULL) {
+        logAABAC(__func__, __LINE__, 0, ERROR, "Failed to allocate the output buffer\n");
+        exit(-1);
+    }
+    buildAttrTokens(&emitter);
 
-    translateVars(instance, fp);
-    translateInitState(instance, fp);
-    translateCanSetRules(instance, fp);
-    translateQuery(instance, fp);
+    emitStr(&emitter, "-- This NuSMV specification was automatically generated by aabac policy verifier\n\n");
+    emitStr(&emitter, "MODULE main\n\n");
 
-    fclose(fp);
+    translateVars(instance, &emitter);
+    translateInitState(instance, &emitter);
+    translateCanSetRules(instance, &emitter);
+    translateQuery(instance, &emitter);
+
+    emitFlush(&emitter);
+    free(emitter.buf);
+    free(emitter.attrTokens);
+    if (fclose(fp) != 0 || emitter.failed) {
+        logAABAC(__func__, __LINE__, 0, ERROR, "Failed to write file: %s\n", nusmvFilePath);
+        return -1;
+    }
 
     double timeSpent = (double)(clock() - startTranslating) / CLOCKS_PER_SEC * 1000;
     logAABAC(__func__, __LINE__, 0, INFO, "[end] translating aabac instance into nusmv file, cost => %.2fms\n", timeSpent);
     return 0;
-}
\ No newline at end of file
+}
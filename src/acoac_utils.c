@@ -34,13 +34,18 @@ void logAABAC(const char *func, int line, int logType, LogLevel logLevel, const
     va_start(arg, format);
     time_t time_log;
     if (logType == 0) {
+        // 日志可能来自后台写线程，加锁保证前缀与消息写在同一行
+        struct tm tmBuf, *tm_log;
         time_log = time(NULL);
-        struct tm *tm_log = localtime(&time_log);
+        tm_log = localtime_r(&time_log, &tmBuf);
         /*printf("%04d-%02d-%02d %02d:%02d:%02d INFO [%s](%d):  ", tm_log->tm_year + 1900, tm_log->tm_mon + 1, tm_log->tm_mday,
             tm_log->tm_hour, tm_log->tm_min, tm_log->tm_sec, func, line);*/
+        flockfile(stdout);
         printf("\033[47;31m%02d/%02d/%02d %02d:%02d:%02d [%s][%s(%d)]: \033[0m", tm_log->tm_year - 100, tm_log->tm_mon + 1, tm_log->tm_mday,
                tm_log->tm_hour, tm_log->tm_min, tm_log->tm_sec, logLevelStr, func, line);
         vprintf(format, arg);
+        funlockfile(stdout);
+        va_end(arg);
         return;
     }
     FILE *p = fopen("E:\\projects\\c_projects\\CoAChecker\\log\\log.txt", "a+");
@@ -50,7 +55,7 @@ void logAABAC(const char *func, int line, int logType, LogLevel logLevel, const
     time_log = time(NULL);
     struct tm *tm_log = localtime(&time_log);
     fprintf(p, "%04d-%02d-%02d %02d:%02d:%02d %s [%s](%d):", tm_log->tm_year + 1900, tm_log->tm_mon + 1, tm_log->tm_mday,
-            tm_log->tm_hour, tm_log->tm_min, tm_log->tm_sec, func, line);
+            tm_log->tm_hour, tm_log->tm_min, tm_log->tm_sec, logLevelStr, func, line);
     vfprintf(p, format, arg);
     va_end(arg);
     fflush(p);
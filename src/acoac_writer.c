@@ -1,6 +1,8 @@
 #include "AABACIO.h"
 #include "AABACUtils.h"
 
+#include <pthread.h>
+
 #define USERS "Users"
 #define ATTRIBUTES "Attributes"
 #define DEFAULT_VALUE "Default Value"
@@ -116,7 +118,7 @@ static int writeAttrsAndDefaultValues(FILE *fp, AABACInstance *pInst) {
         itHashSet = iHashSet.NewIterator(attrs[i]);
         while (itHashSet->HasNext(itHashSet)) {
             pAttrIdx = (int *)itHashSet->GetNext(itHashSet);
-            defaultValueIdx = *(int *)iHashMap.Get(pmapAttr2DefVal, pAttrIdx);
+            defaultValueIdx = getAttrDefVal(*pAttrIdx);
             if (defaultValueIdx) {
                 fprintf(fp, "\n%s: %s", istrCollection.GetElement(pscAttrs, *pAttrIdx), getValueByIndex(getAttrTypeByIdx(*pAttrIdx), defaultValueIdx));
                 f = 1;
@@ -208,17 +210,18 @@ static int writeUAVs(FILE *fp, AABACInstance *pInst) {
  * 
  * @param fp[in]: The file pointer
  * @param pInst[in]: The AABAC instance
+ * @param pVecRuleList[in]: The list of rules that the rule indices of the instance refer to
  * @return 0 if write successfully, -1 if failed
  */
-static int writeRules(FILE *fp, AABACInstance *pInst) {
+static int writeRules(FILE *fp, AABACInstance *pInst, Vector *pVecRuleList) {
     logAABAC(__func__, __LINE__, 0, DEBUG, "[Writing] Writing rules\n");
-    if (pVecRules == NULL || pInst->pSetRuleIdxes == NULL) {
+    if (pVecRuleList == NULL || pInst->pSetRuleIdxes == NULL) {
         logAABAC(__func__, __LINE__, 0, ERROR, "[Writing] The set of rules is a NULL pointer\n");
         return -1;
     }
 
     fprintf(fp, RULES);;
-    if (iHashSet.Size(pInst->pSetRuleIdxes) == 0) {
+    if (iIntSet.Size(pInst->pSetRuleIdxes) == 0) {
         fprintf(fp, "\n;\n\n");
         return 0;
     }
@@ -226,15 +229,15 @@ static int writeRules(FILE *fp, AABACInstance *pInst) {
     int ruleIdx;
     char *rStr;
     Rule *pRule;
-    HashSetIterator *itRules = iHashSet.NewIterator(pInst->pSetRuleIdxes);
+    IntSetIterator *itRules = iIntSet.NewIterator(pInst->pSetRuleIdxes);
     while (itRules->HasNext(itRules)) {
         ruleIdx = *(int *)itRules->GetNext(itRules);
-        pRule = (Rule *)iVector.GetElement(pVecRules, ruleIdx);
+        pRule = (Rule *)iVector.GetElement(pVecRuleList, ruleIdx);
         rStr = RuleToString(&pRule);
         fprintf(fp, "\n%s", rStr);
         free(rStr);
     }
-    iHashSet.DeleteIterator(itRules);
+    iIntSet.DeleteIterator(itRules);
     fprintf(fp, ";\n\n");
     return 0;
 }
@@ -282,7 +285,15 @@ static int writeSpec(FILE *fp, AABACInstance *pInst) {
     return 0;
 }
 
-int writeAABACInstance(AABACInstance *pInst, char *filename) {
+/**
+ * Write an AABAC instance whose rule indices refer to a given list of rules to a file.
+ * 
+ * @param pInst[in]: The AABAC instance to write
+ * @param pVecRuleList[in]: The list of rules that the rule indices of the instance refer to
+ * @param filename[in]: The path of the file to write
+ * @return 0 if write successfully, error code if failed
+ */
+static int writeInstance(AABACInstance *pInst, Vector *pVecRuleList, char *filename) {
     logAABAC(__func__, __LINE__, 0, DEBUG, "[Writing] writing AABAC instance into file %s\n", filename);
     if (pInst == NULL) {
         logAABAC(__func__, __LINE__, 0, ERROR, "[Writing] Writing failed, the given AABAC instance is a NULL pointer\n");
@@ -292,18 +303,9 @@ int writeAABACInstance(AABACInstance *pInst, char *filename) {
         logAABAC(__func__, __LINE__, 0, ERROR, "[Writing] Writing failed, the given filename is a NULL pointer\n");
         return -1;
     }
-    // 检查文件是否存在，如果存在则删除
-    FILE *fp = fopen(filename, "r");
-    if (fp != NULL) {
-        fclose(fp);
-        if (remove(filename) != 0) {
-            logAABAC(__func__, __LINE__, 0, ERROR, "[Writing] File %s exists but failed to delete\n", filename);
-            return -1;
-        }
-    }
 
-    // 创建文件，如果文件所在目录不存在，则创建目录
-    fp = fopen(filename, "w");
+    // 以"w"模式打开时已存在的文件会被截断，无需先删除
+    FILE *fp = fopen(filename, "w");
     if (fp == NULL) {
         logAABAC(__func__, __LINE__, 0, ERROR, "[Writing] Failed to create file %s\n", filename);
         return -1;
@@ -325,7 +327,7 @@ int writeAABACInstance(AABACInstance *pInst, char *filename) {
         fclose(fp);
         return ret;
     }
-    if ((ret = writeRules(fp, pInst)) != 0) {
+    if ((ret = writeRules(fp, pInst, pVecRuleList)) != 0) {
         logAABAC(__func__, __LINE__, 0, ERROR, "[Writing] Failed to write rules\n");
         fclose(fp);
         return ret;
@@ -339,3 +341,170 @@ int writeAABACInstance(AABACInstance *pInst, char *filename) {
     logAABAC(__func__, __LINE__, 0, INFO, "[Writing] Successfully wrote AABAC instance into file %s\n", filename);
     return 0;
 }
+
+int writeAABACInstance(AABACInstance *pInst, char *filename) {
+    return writeInstance(pInst, pVecRules, filename);
+}
+
+/* An instance waiting to be written by the writer thread */
+typedef struct _WriteJob {
+    // A copy of the instance, whose rule indices refer to @{pVecRuleList}
+    AABACInstance *pInst;
+    // Copies of the rules of the instance; the i-th rule of the instance has index i
+    Vector *pVecRuleList;
+    char *filename;
+    struct _WriteJob *next;
+} WriteJob;
+
+// The queue of the writer thread, protected by @{writeQueueLock}
+static WriteJob *pWriteQueueHead = NULL, *pWriteQueueTail = NULL;
+static pthread_mutex_t writeQueueLock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t writeQueueCond = PTHREAD_COND_INITIALIZER;
+static pthread_t writerThread;
+static int writerRunning = 0;
+static int writerClosing = 0;
+static int nFailedWrites = 0;
+
+/**
+ * Copy an AABAC instance, together with the rules it uses, so that the copy can be written while the original
+ * instance and the global rule list @{pVecRules} are modified or released.
+ * The conditions of the rules are interned and never modified, so they are shared rather than copied.
+ * 
+ * @param pInst[in]: The AABAC instance to copy
+ * @return The write job holding the copy, without a file name
+ */
+static WriteJob *snapshotInstance(AABACInstance *pInst) {
+    WriteJob *pJob = (WriteJob *)calloc(1, sizeof(WriteJob));
+    AABACInstance *pCopy = createAABACInstance();
+    if (pJob == NULL || pCopy == NULL) {
+        logAABAC(__func__, __LINE__, 0, ERROR, "[Writing] Failed to allocate memory for the snapshot\n");
+        exit(-1);
+    }
+
+    for (int i = 0; i < iVector.Size(pInst->pVecUserIndices); i++) {
+        iVector.Add(pCopy->pVecUserIndices, iVector.GetElement(pInst->pVecUserIndices, i));
+    }
+    IntSet *pSetDom;
+    HASHMAP_FOREACH(slot, pInst->pMapAttr2Dom) {
+        pSetDom = iIntSet.CloneInPool(*(IntSet **)HashMapSlotValue(pInst->pMapAttr2Dom, slot), pCopy->pool);
+        iHashMap.Put(pCopy->pMapAttr2Dom, HashMapSlotKey(pInst->pMapAttr2Dom, slot), &pSetDom);
+    }
+    copyInitState(pCopy, pInst);
+    copyQuery(pCopy, pInst);
+
+    // 规则的用户条件取值会被切片修改，且每轮抽象精化后旧的规则副本即被释放，因此复制到快照的内存池中
+    Vector *pVecRuleList = iVector.Create(sizeof(Rule), iIntSet.Size(pInst->pSetRuleIdxes));
+    HashMap *pmapUserCondValue;
+    IntSet *pSetVals;
+    Rule rule;
+    INTSET_FOREACH(ruleIdx, pInst->pSetRuleIdxes) {
+        rule = *(Rule *)iVector.GetElement(pVecRules, ruleIdx);
+        pmapUserCondValue = rule.pmapUserCondValue;
+        if (pmapUserCondValue != NULL) {
+            rule.pmapUserCondValue = iHashMap.CreateInPool(pCopy->pool, sizeof(int), sizeof(IntSet *), IntHashCode, IntEqual);
+            HASHMAP_FOREACH(slot, pmapUserCondValue) {
+                pSetVals = iIntSet.CloneInPool(*(IntSet **)HashMapSlotValue(pmapUserCondValue, slot), pCopy->pool);
+                iHashMap.Put(rule.pmapUserCondValue, HashMapSlotKey(pmapUserCondValue, slot), &pSetVals);
+            }
+        }
+        iIntSet.Add(pCopy->pSetRuleIdxes, iVector.Size(pVecRuleList));
+        iVector.Add(pVecRuleList, &rule);
+    }
+
+    pJob->pInst = pCopy;
+    pJob->pVecRuleList = pVecRuleList;
+    return pJob;
+}
+
+/**
+ * The writer thread. It writes the queued instances in order until @{waitAABACWrites} closes the queue.
+ * 
+ * @param arg[in]: Unused
+ * @return NULL
+ */
+static void *writerMain(void *arg) {
+    WriteJob *pJob;
+    (void)arg;
+    while (1) {
+        pthread_mutex_lock(&writeQueueLock);
+        while (pWriteQueueHead == NULL && !writerClosing) {
+            pthread_cond_wait(&writeQueueCond, &writeQueueLock);
+        }
+        pJob = pWriteQueueHead;
+        if (pJob == NULL) {
+            pthread_mutex_unlock(&writeQueueLock);
+            break;
+        }
+        pWriteQueueHead = pJob->next;
+        if (pWriteQueueHead == NULL) {
+            pWriteQueueTail = NULL;
+        }
+        pthread_mutex_unlock(&writeQueueLock);
+
+        if (writeInstance(pJob->pInst, pJob->pVecRuleList, pJob->filename) != 0) {
+            pthread_mutex_lock(&writeQueueLock);
+            nFailedWrites++;
+            pthread_mutex_unlock(&writeQueueLock);
+        }
+        iVector.Finalize(pJob->pVecRuleList);
+        finalizeAABACInstance(pJob->pInst);
+        free(pJob->filename);
+        free(pJob);
+    }
+    return NULL;
+}
+
+int writeAABACInstanceAsync(AABACInstance *pInst, char *filename) {
+    if (pInst == NULL || filename == NULL) {
+        logAABAC(__func__, __LINE__, 0, ERROR, "[Writing] Writing failed, the given AABAC instance or filename is a NULL pointer\n");
+        return -1;
+    }
+    WriteJob *pJob = snapshotInstance(pInst);
+    pJob->filename = strdup(filename);
+
+    pthread_mutex_lock(&writeQueueLock);
+    if (!writerRunning) {
+        writerClosing = 0;
+        if (pthread_create(&writerThread, NULL, writerMain, NULL) != 0) {
+            pthread_mutex_unlock(&writeQueueLock);
+            // 无法启动写线程时退化为同步写入
+            logAABAC(__func__, __LINE__, 0, WARNING, "[Writing] Failed to start the writer thread, writing %s synchronously\n", filename);
+            int ret = writeInstance(pJob->pInst, pJob->pVecRuleList, pJob->filename);
+            iVector.Finalize(pJob->pVecRuleList);
+            finalizeAABACInstance(pJob->pInst);
+            free(pJob->filename);
+            free(pJob);
+            return ret;
+        }
+        writerRunning = 1;
+    }
+    if (pWriteQueueTail == NULL) {
+        pWriteQueueHead = pJob;
+    } else {
+        pWriteQueueTail->next = pJob;
+    }
+    pWriteQueueTail = pJob;
+    pthread_cond_signal(&writeQueueCond);
+    pthread_mutex_unlock(&writeQueueLock);
+    return 0;
+}
+
+int waitAABACWrites() {
+    pthread_mutex_lock(&writeQueueLock);
+    if (!writerRunning) {
+        pthread_mutex_unlock(&writeQueueLock);
+        return 0;
+    }
+    writerClosing = 1;
+    pthread_cond_signal(&writeQueueCond);
+    pthread_mutex_unlock(&writeQueueLock);
+
+    pthread_join(writerThread, NULL);
+
+    pthread_mutex_lock(&writeQueueLock);
+    writerRunning = 0;
+    int ret = nFailedWrites;
+    nFailedWrites = 0;
+    pthread_mutex_unlock(&writeQueueLock);
+    return ret;
+}
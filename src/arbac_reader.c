@@ -1,159 +1,208 @@
+#include <ctype.h>
+
 #include "AABACIO.h"
 #include "AABACUtils.h"
-#include <regex.h>
 
 #define ROLES "Roles"
-#define ROLES_LEN 5
-
 #define USERS "Users"
-#define USERS_LEN 5
-
 #define UA "UA"
-#define UA_LEN 2
-
 #define CR "CR"
-#define CR_LEN 2
-
 #define CA "CA"
-#define CA_LEN 2
-
 #define ADMIN "ADMIN"
-#define ADMIN_LEN 5
-
 #define SPEC "SPEC"
-#define SPEC_LEN 4
+
+// 文件读取缓冲区的大小
+#define ARBAC_READ_BUFFER_SIZE (1 << 16)
 
 /**
- * 解析角色列表，将角色添加到AABACInstance中
- * @param line 格式为：role1 role2 role3 ... roleN;
+ * ARBAC（Mohawk）格式的流式词法分析器。
+ * 文件按块读入固定大小的缓冲区，逐字符切分出三类词：
+ * 以空白、分号或'<'结尾的单词，'<'与'>'之间的元组内容，以及分号。
+ * 元组可以每行一个，也可以多个写在同一行；内存只与最长的词有关，而与行长和文件大小无关。
  */
-static void handleRoles(AABACInstance *pInst, char *line) {
-    if (strcmp(line, ";") == 0) {
-        return;
-    }
+typedef struct _ARBACLexer {
+    FILE *file;
+    char buffer[ARBAC_READ_BUFFER_SIZE];
+    size_t pos;             // 缓冲区中下一个字符的位置
+    size_t len;             // 缓冲区中有效字符数
+    char *token;            // 当前词（以'\0'结尾），元组不含两侧的尖括号
+    size_t tokenLen;
+    size_t tokenCapacity;
+    int atLineStart;        // 自上一个词以来是否读到过换行（文件开头视为行首）
+    int firstOnLine;        // 当前词是否为所在行的第一个词
+} ARBACLexer;
+
+typedef enum {
+    ARBAC_TOKEN_END,        // 文件结束
+    ARBAC_TOKEN_WORD,       // 单词：节标题、角色名或用户名
+    ARBAC_TOKEN_TUPLE,      // 元组：<...>中的内容
+    ARBAC_TOKEN_SEMICOLON   // 分号
+} ARBACTokenType;
 
-    AttrType attrType = BOOLEAN;
-    int defValIdx = 0;
-    int roleNum = 0;
+/**
+ * 查看下一个字符但不消耗它
+ * @return 下一个字符，文件结束时返回EOF
+ */
+static int peekChar(ARBACLexer *lex) {
+    if (lex->pos == lex->len) {
+        lex->len = fread(lex->buffer, 1, ARBAC_READ_BUFFER_SIZE, lex->file);
+        lex->pos = 0;
+        if (lex->len == 0) {
+            return EOF;
+        }
+    }
+    return (unsigned char)lex->buffer[lex->pos];
+}
 
-    char *role;
-    int roleLen = 0;
+static void appendTokenChar(ARBACLexer *lex, char c) {
+    if (lex->tokenLen + 1 >= lex->tokenCapacity) {
+        lex->tokenCapacity *= 2;
+        lex->token = (char *)realloc(lex->token, lex->tokenCapacity);
+    }
+    lex->token[lex->tokenLen++] = c;
+}
 
-    char *token = strtok(line, " "), *nextToken = NULL;
-    while (token != NULL) {
-        role = strtrim(token);
-        roleLen = strlen(role);
-        nextToken = strtok(NULL, " ");
-        if (nextToken == NULL) {
-            if (roleLen > 0 && role[roleLen - 1] == ';') {
-                role[roleLen - 1] = '\0';
-                roleLen--;
-            }
+/**
+ * 读取下一个词，词的内容存放在lex->token中，lex->firstOnLine表示该词是否为所在行的第一个词
+ * @return 词的类型
+ */
+static ARBACTokenType nextToken(ARBACLexer *lex) {
+    int c;
+    while ((c = peekChar(lex)) != EOF && isspace(c)) {
+        if (c == '\n') {
+            lex->atLineStart = 1;
         }
-
-        if (roleLen > 0 && !iDictionary.Contains(pdictAttr2Index, role)) {
-            roleNum = istrCollection.Size(pscAttrs);
-            iDictionary.Insert(pdictAttr2Index, role, &roleNum);
-            istrCollection.Add(pscAttrs, role);
-            iHashMap.Put(pmapAttr2Type, &roleNum, &attrType);
-            iHashMap.Put(pmapAttr2DefVal, &roleNum, &defValIdx);
-            logAABAC(__func__, __LINE__, 0, DEBUG, "Add attribute: %s, index: %d\n", role, roleNum);
-            roleNum++;
+        lex->pos++;
+    }
+    lex->firstOnLine = lex->atLineStart;
+    lex->atLineStart = 0;
+    lex->tokenLen = 0;
+    if (c == EOF) {
+        lex->token[0] = '\0';
+        return ARBAC_TOKEN_END;
+    }
+    lex->pos++;
+    if (c == ';') {
+        lex->token[0] = '\0';
+        return ARBAC_TOKEN_SEMICOLON;
+    }
+    if (c == '<') {
+        while ((c = peekChar(lex)) != EOF && c != '>') {
+            appendTokenChar(lex, (char)c);
+            lex->pos++;
+        }
+        if (c == EOF) {
+            lex->token[lex->tokenLen] = '\0';
+            logAABAC(__func__, __LINE__, 0, ERROR, "missing '>' after <%s\n", lex->token);
+            exit(1);
         }
-        token = nextToken;
+        lex->pos++;
+        lex->token[lex->tokenLen] = '\0';
+        return ARBAC_TOKEN_TUPLE;
+    }
+    appendTokenChar(lex, (char)c);
+    while ((c = peekChar(lex)) != EOF && !isspace(c) && c != ';' && c != '<') {
+        appendTokenChar(lex, (char)c);
+        lex->pos++;
     }
+    lex->token[lex->tokenLen] = '\0';
+    return ARBAC_TOKEN_WORD;
 }
 
 /**
- * 解析用户列表，将用户添加到AABACInstance中
- * @param line 格式为：user1 user2 user3 ... userN;
+ * 判断一个行首单词是否为节标题
+ * @return 节标题对应的阶段（见readARBACInstance），不是节标题时返回0
  */
-static void handleUsers(AABACInstance *pInst, char *line) {
-    char *user;
-    int userLen = 0;
-
-    char *token = strtok(line, " ");
-    char *nextToken = NULL;
-    int userNum = 0;
+static int sectionStage(char *word) {
+    if (strcmp(word, ROLES) == 0) {
+        return 1;
+    } else if (strcmp(word, USERS) == 0) {
+        return 2;
+    } else if (strcmp(word, UA) == 0) {
+        return 3;
+    } else if (strcmp(word, CR) == 0) {
+        return 4;
+    } else if (strcmp(word, CA) == 0) {
+        return 5;
+    } else if (strcmp(word, ADMIN) == 0) {
+        return 6;
+    } else if (strcmp(word, SPEC) == 0) {
+        return 7;
+    }
+    return 0;
+}
 
-    while (token != NULL) {
-        user = strtrim(token);
-        userLen = strlen(user);
-        nextToken = strtok(NULL, " ");
-        if (nextToken == NULL) {
-            if (userLen > 0 && user[userLen - 1] == ';') {
-                // Remove trailing semicolon
-                user[userLen - 1] = '\0';
-                userLen--;
-            }
+/**
+ * 在元组内容中原地按逗号切分出各个字段，并去除每个字段首尾的空白
+ * @param tuple 元组内容，例如"role0,role1&-role2,role3"
+ * @param fields 切分出的字段
+ * @param maxFields 最多的字段数
+ * @return 字段数，超过maxFields时返回maxFields + 1
+ */
+static int splitTuple(char *tuple, char **fields, int maxFields) {
+    int nFields = 0;
+    char *p = tuple, *comma;
+    while (1) {
+        if (nFields == maxFields) {
+            return maxFields + 1;
         }
-
-        if (userLen > 0 && iDictionary.Insert(pdictUser2Index, user, &userNum)) {
-            istrCollection.Add(pscUsers, user);
-            iVector.Add(pInst->pVecUserIndices, &userNum);
-            userNum++;
-            logAABAC(__func__, __LINE__, 0, DEBUG, "Add %d user: %s\n", userNum, user);
+        comma = strchr(p, ',');
+        if (comma != NULL) {
+            *comma = '\0';
         }
-        token = nextToken;
+        fields[nFields++] = strtrim(p);
+        if (comma == NULL) {
+            return nFields;
+        }
+        p = comma + 1;
     }
 }
 
-/*能够匹配出<>中的内容，例如<1,2,3>，<1,2,3,4>，<1,2,3,4,5>，会匹配出1,2,3，1,2,3,4，1,2,3,4,5*/
-#define PATTERN_STR "<(.*?)>"
-regex_t pattern;
-int compiled = 0;
-
 /**
- * 解析用户初始属性值列表，将用户初始属性值添加到AABACInstance中
- * 如果line为分号，不做任何处理。
- * 如果line不为分号，判断line是否是形如<user, role>的字符串，可能最后会带一个分号。
- * 如果是，将user, attr, value分别加入到instance的userAttrValueSet中。
- * 如果不是，抛出异常。
- * @param line 格式为：<user, role> <user, role> ... <user, role>;
+ * 将角色作为布尔属性添加到全局属性列表中，默认值为false
  */
-static void handleUA(AABACInstance *pInst, char *line) {
-    if (!compiled) {
-        regcomp(&pattern, PATTERN_STR, REG_EXTENDED);
-        compiled = 1;
+static void handleRole(char *role) {
+    int roleNum = istrCollection.Size(pscAttrs);
+    if (iDictionary.Insert(pdictAttr2Index, role, &roleNum) > 0) {
+        istrCollection.Add(pscAttrs, role);
+        addAttrMeta(roleNum, BOOLEAN, 0);
     }
+}
 
-    regmatch_t pmatch[2];
-    int rc, addUAVRet;
-    char *uaStr, *user, *role;
-    while (line != NULL) {
-        rc = regexec(&pattern, line, 2, pmatch, 0);
-        if (rc != 0) {
-            break;
-        }
-        uaStr = line + pmatch[1].rm_so;
-        if (line[pmatch[1].rm_eo] == '\0') {
-            line = NULL;
-        } else {
-            line[pmatch[1].rm_eo] = '\0';
-            line = line + pmatch[1].rm_eo + 1;
-        }
-        user = strtok(uaStr, ",");
-        role = strtok(NULL, ",");
+/**
+ * 将用户添加到AABACInstance中
+ */
+static void handleUser(AABACInstance *pInst, char *user) {
+    int userNum = istrCollection.Size(pscUsers);
+    if (iDictionary.Insert(pdictUser2Index, user, &userNum) > 0) {
+        istrCollection.Add(pscUsers, user);
+        iVector.Add(pInst->pVecUserIndices, &userNum);
+    }
+}
 
-        if (user == NULL || role == NULL || strtok(NULL, ",") != NULL) {
-            logAABAC(__func__, __LINE__, 0, ERROR, "UA should be form of <user, role>\n");
-            exit(1);
-        }
+/**
+ * 解析用户-角色关系<user, role>，将用户的初始角色添加到AABACInstance中
+ * @param tuple 元组内容
+ */
+static void handleUA(AABACInstance *pInst, char *tuple) {
+    char *fields[2];
+    if (splitTuple(tuple, fields, 2) != 2 || *fields[0] == '\0' || *fields[1] == '\0') {
+        logAABAC(__func__, __LINE__, 0, ERROR, "UA should be form of <user, role>\n");
+        exit(1);
+    }
 
-        addUAVRet = addUAV(pInst, strtrim(user), strtrim(role), "true");
-        if (addUAVRet) {
-            logAABAC(__func__, __LINE__, 0, ERROR, "Failed to handle UA: <%s, %s>\n", user, role);
-            exit(addUAVRet);
-        }
+    int addUAVRet = addUAV(pInst, fields[0], fields[1], "true");
+    if (addUAVRet) {
+        logAABAC(__func__, __LINE__, 0, ERROR, "Failed to handle UA: <%s, %s>\n", fields[0], fields[1]);
+        exit(addUAVRet);
     }
 }
 
 /**
- * 判断condStr是否是一个合法的条件，如果是，返回Condition对象，否则抛出异常。
+ * 判断condStr是否是一个合法的条件，如果是，返回原子条件集合，否则抛出异常。
  * 合法的条件格式为：TRUE或role1 & role2 & ... & roleN，其中每个角色前可以有一个-号，表示取反
- * 如果condStr为TRUE，返回一个Condition对象，其中的atomConds为空集合
- * 如果condStr不为TRUE，将condStr按照&符号分割，得到role1, role2, ..., roleN
- * 对于每个role，判断其是否以-开头，然后添加到Condition对象的atomConds中
+ * 如果condStr为TRUE，返回空集合
+ * 如果condStr不为TRUE，将condStr按照&符号原地分割，对于每个role，判断其是否以-开头，然后添加到集合中
  * @param condStr
  * @return
  */
@@ -163,340 +212,181 @@ static HashSet *handleCondition(char *condStr) {
         return pSetCondition;
     }
 
-    int roleIdx;
-    char *role, *token = strtok(condStr, "&");
+    char *p = condStr, *amp, *role;
     AtomCondition atomCond;
-    while (token != NULL) {
-        role = strtrim(token);
-        if (strlen(role) > 0 && role[0] == '-') {
-            role = role + 1;
-            roleIdx = getAttrIndex(role);
-            atomCond = (AtomCondition){
-                .attribute = roleIdx,
-                .value = 0,
-                .op = EQUAL};
-        } else {
-            roleIdx = getAttrIndex(role);
-            atomCond = (AtomCondition){
-                .attribute = roleIdx,
-                .value = 1,
-                .op = EQUAL};
+    while (1) {
+        amp = strchr(p, '&');
+        if (amp != NULL) {
+            *amp = '\0';
+        }
+        role = strtrim(p);
+        if (*role != '\0') {
+            atomCond.op = EQUAL;
+            atomCond.value = 1;
+            if (*role == '-') {
+                role++;
+                atomCond.value = 0;
+            }
+            atomCond.attribute = getAttrIndex(role);
+            iHashSet.Add(pSetCondition, &atomCond);
         }
-        iHashSet.Add(pSetCondition, &atomCond);
-        token = strtok(NULL, "&");
+        if (amp == NULL) {
+            break;
+        }
+        p = amp + 1;
     }
-
     return pSetCondition;
 }
 
 /**
- * 解析CA规则，将CA规则添加到AABACInstance中
- * 规则的格式为：<adminCond, usercond, targetRole> <adminCond, userCond, targetRole> ... <adminCond, userCond, targetRole>;
- * @param line
+ * 将规则添加到全局规则列表与AABACInstance中
  */
-static void handleCA(AABACInstance *pInst, char *line) {
-    if (!compiled) {
-        regcomp(&pattern, PATTERN_STR, REG_EXTENDED);
-        compiled = 1;
-    }
-
-    regmatch_t pmatch[2];
-    int rc;
-    char *caStr, *adminCondStr, *userCondStr, *targetRole;
-    int roleIdx;
-    HashSet *adminCond, *userCond;
-    Rule *r;
-    while (line != NULL) {
-        rc = regexec(&pattern, line, 2, pmatch, 0);
-        if (rc != 0) {
-            break;
-        }
-        caStr = line + pmatch[1].rm_so;
-        if (line[pmatch[1].rm_eo] == '\0') {
-            line = NULL;
-        } else {
-            line[pmatch[1].rm_eo] = '\0';
-            line = line + pmatch[1].rm_eo + 1;
-        }
-
-        adminCondStr = strtok(caStr, ",");
-        userCondStr = strtok(NULL, ",");
-        targetRole = strtok(NULL, ",");
-
-        if (adminCondStr == NULL || userCondStr == NULL || targetRole == NULL || strtok(NULL, ",") != NULL) {
-            logAABAC(__func__, __LINE__, 0, ERROR, "CA should be form of <adminCond, userCond, targetRole>\n");
-            exit(1);
-        }
-
-        roleIdx = getAttrIndex(strtrim(targetRole));
-
-        adminCond = handleCondition(strtrim(adminCondStr));
-        userCond = handleCondition(strtrim(userCondStr));
-        r = iRule.Create(adminCond, userCond, roleIdx, 1);
-        iVector.Add(pVecRules, r);
-        free(r);
-        int ruleIdx = iVector.Size(pVecRules) - 1;
-        addRule(pInst, ruleIdx);
-    }
+static void addARBACRule(AABACInstance *pInst, HashSet *adminCond, HashSet *userCond, int roleIdx, int valueIdx) {
+    Rule *r = iRule.Create(adminCond, userCond, roleIdx, valueIdx);
+    iVector.Add(pVecRules, r);
+    free(r);
+    addRule(pInst, iVector.Size(pVecRules) - 1);
 }
 
 /**
- * 解析CR规则，将CR规则添加到AABACInstance中
- * 规则的格式为：<adminCond, targetRole> <adminCond, targetRole> ... <adminCond, targetRole>;
- * @param line
+ * 解析CA规则<adminCond, userCond, targetRole>，转换为将目标角色置为true的规则
+ * @param tuple 元组内容
  */
-static void handleCR(AABACInstance *pInst, char *line) {
-    if (!compiled) {
-        regcomp(&pattern, PATTERN_STR, REG_EXTENDED);
-        compiled = 1;
+static void handleCA(AABACInstance *pInst, char *tuple) {
+    char *fields[3];
+    if (splitTuple(tuple, fields, 3) != 3 || *fields[0] == '\0' || *fields[1] == '\0' || *fields[2] == '\0') {
+        logAABAC(__func__, __LINE__, 0, ERROR, "CA should be form of <adminCond, userCond, targetRole>\n");
+        exit(1);
     }
 
-    regmatch_t pmatch[2];
-    int rc;
-    char *crStr, *adminCondStr, *targetRole;
-    int roleIdx;
-    HashSet *adminCond, *userCond;
-    Rule *r;
-    while (line != NULL) {
-        rc = regexec(&pattern, line, 2, pmatch, 0);
-        if (rc != 0) {
-            break;
-        }
-        crStr = line + pmatch[1].rm_so;
-        if (line[pmatch[1].rm_eo] == '\0') {
-            line = NULL;
-        } else {
-            line[pmatch[1].rm_eo] = '\0';
-            line = line + pmatch[1].rm_eo + 1;
-        }
-
-        adminCondStr = strtok(crStr, ",");
-        targetRole = strtok(NULL, ",");
-
-        if (adminCondStr == NULL || targetRole == NULL || strtok(NULL, ",") != NULL) {
-            logAABAC(__func__, __LINE__, 0, ERROR, "CR should be form of <adminCond, targetRole>\n");
-            exit(1);
-        }
-
-        roleIdx = getAttrIndex(strtrim(targetRole));
-
-        adminCond = handleCondition(strtrim(adminCondStr));
-        userCond = iHashSet.Create(sizeof(AtomCondition), iAtomCondition.HashCode, iAtomCondition.Equal);
-        r = iRule.Create(adminCond, userCond, roleIdx, 0);
-        iVector.Add(pVecRules, r);
-        free(r);
-        int ruleIdx = iVector.Size(pVecRules) - 1;
-        addRule(pInst, ruleIdx);
-    }
+    int roleIdx = getAttrIndex(fields[2]);
+    HashSet *adminCond = handleCondition(fields[0]);
+    HashSet *userCond = handleCondition(fields[1]);
+    addARBACRule(pInst, adminCond, userCond, roleIdx, 1);
 }
 
 /**
- * 解析查询语句，将查询语句添加到AABACInstance中
- * 查询语句的格式为：user role;
- * @param line
+ * 解析CR规则<adminCond, targetRole>，转换为将目标角色置为false的规则
+ * @param tuple 元组内容
  */
-static void handleSpec(AABACInstance *pInst, char *line) {
-    if (strcmp(";", line) == 0) {
-        return;
-    }
-
-    char *queryUser = strtok(line, " ");
-    char *role = strtok(NULL, " ");
-    if (queryUser == NULL || role == NULL || strtok(NULL, " ") != NULL) {
-        logAABAC(__func__, __LINE__, 0, ERROR, "spec should be form of user, role\n");
+static void handleCR(AABACInstance *pInst, char *tuple) {
+    char *fields[2];
+    if (splitTuple(tuple, fields, 2) != 2 || *fields[0] == '\0' || *fields[1] == '\0') {
+        logAABAC(__func__, __LINE__, 0, ERROR, "CR should be form of <adminCond, targetRole>\n");
         exit(1);
     }
 
-    pInst->queryUserIdx = getUserIndex(strtrim(queryUser));
-    role = strtrim(role);
-
-    if (role[strlen(role) - 1] == ';') {
-        role[strlen(role) - 1] = '\0';
-    }
-    int roleIdx = getAttrIndex(role);
-    int valueIdx = 1;
-
-    iHashMap.Put(pInst->pmapQueryAVs, &roleIdx, &valueIdx);
-    logAABAC(__func__, __LINE__, 0, INFO, "query user: %s\n", queryUser);
+    int roleIdx = getAttrIndex(fields[1]);
+    HashSet *adminCond = handleCondition(fields[0]);
+    HashSet *userCond = iHashSet.Create(sizeof(AtomCondition), iAtomCondition.HashCode, iAtomCondition.Equal);
+    addARBACRule(pInst, adminCond, userCond, roleIdx, 0);
 }
 
 /**
- * 处理一行数据。根据stage的值，调用不同的处理方法。
- * stage=1时，表示当前行为角色列表，调用handleRoles方法处理；
- * stage=2时，表示当前行为用户列表，调用handleUsers方法处理；
- * stage=3时，表示当前行为用户-角色关系，调用handleUA方法处理；
- * stage=4时，表示当前行为角色-角色关系，调用handleCR方法处理；
- * stage=5时，表示当前行为角色-属性关系，调用handleCA方法处理；
- * stage=6时，表示当前行为管理员列表，不用做任何处理；
- * stage=7时，表示当前行为查询列表，调用handleSpec方法处理；
- * @param stage 当前行所处的阶段
- * @param line 当前行的内容
+ * 解析查询语句中的一个单词。查询语句的格式为：user role;
+ * @param word 单词
+ * @param nWords 查询语句中已读取的单词数
  */
-static int handleLine(AABACInstance *pInst, int stage, char *line) {
-    switch (stage) {
-    case 1:
-        handleRoles(pInst, line);
-        break;
-    case 2:
-        handleUsers(pInst, line);
-        break;
-    case 3:
-        handleUA(pInst, line);
-        break;
-    case 4:
-        handleCR(pInst, line);
-        break;
-    case 5:
-        handleCA(pInst, line);
-        break;
-    case 6:
-        break;
-    case 7:
-        handleSpec(pInst, line);
-        break;
-    default:
-        logAABAC(__func__, __LINE__, 0, ERROR, "unexpect line: %s\n", line);
-        return -1;
+static void handleSpec(AABACInstance *pInst, char *word, int nWords) {
+    if (nWords == 0) {
+        pInst->queryUserIdx = getUserIndex(word);
+        logAABAC(__func__, __LINE__, 0, INFO, "query user: %s\n", word);
+    } else if (nWords == 1) {
+        int roleIdx = getAttrIndex(word);
+        int valueIdx = 1;
+        iHashMap.Put(pInst->pmapQueryAVs, &roleIdx, &valueIdx);
+    } else {
+        logAABAC(__func__, __LINE__, 0, ERROR, "spec should be form of user, role\n");
+        exit(1);
     }
-    return 0;
 }
 
 AABACInstance *readARBACInstance(char *arbacFilePath) {
     logAABAC(__func__, __LINE__, 0, INFO, "[start] reading ARBAC instance from file %s\n", arbacFilePath);
 
-    FILE *file = fopen(arbacFilePath, "r");
-    if (file == NULL) {
+    ARBACLexer *lex = (ARBACLexer *)malloc(sizeof(ARBACLexer));
+    if (lex == NULL) {
+        logAABAC(__func__, __LINE__, 0, ERROR, "Failed to allocate memory for the lexer\n");
+        return NULL;
+    }
+    lex->file = fopen(arbacFilePath, "r");
+    if (lex->file == NULL) {
         printf("Error opening file: %s\n", arbacFilePath);
+        free(lex);
         return NULL;
     }
+    lex->pos = lex->len = 0;
+    lex->atLineStart = 1;
+    lex->tokenLen = 0;
+    lex->tokenCapacity = 256;
+    lex->token = (char *)malloc(lex->tokenCapacity);
 
     // 初始化全局变量
     initGlobalVars();
     AABACInstance *pInst = createAABACInstance();
 
-    // 0: initial, 1: users, 2: attributes, 3: default value, 4: UAV, 5: rules, 6: spec
-    int stage = 0;
-    int line_count = 0;
-
-    // 动态分配初始缓冲区
-    size_t buffer_size = 1024;
-    char *line = (char *)malloc(buffer_size);
-    if (line == NULL) {
-        logAABAC(__func__, __LINE__, 0, ERROR, "Failed to allocate memory for line buffer\n");
-        fclose(file);
-        return NULL;
-    }
-
-    while (1) {
-        // 尝试读取一行
-        if (fgets(line, buffer_size, file) == NULL) {
-            // 文件结束或读取错误
-            break;
-        }
-
-        line_count++;
-
-        // 检查是否需要扩展缓冲区
-        size_t line_len = strlen(line);
-        if (line_len > 0 && line[line_len - 1] != '\n' && !feof(file)) {
-            // 行被截断，需要扩展缓冲区
-            size_t new_size = buffer_size * 2;
-            char *new_line = (char *)realloc(line, new_size);
-            if (new_line == NULL) {
-                logAABAC(__func__, __LINE__, 0, ERROR, "Failed to reallocate memory for line buffer\n");
-                free(line);
-                fclose(file);
-                return NULL;
-            }
-            line = new_line;
-            buffer_size = new_size;
-
-            // 继续读取同一行的剩余部分
-            while (fgets(line + line_len, buffer_size - line_len, file) != NULL) {
-                line_len = strlen(line);
-                if (line_len > 0 && line[line_len - 1] == '\n') {
-                    break; // 行已完整读取
-                }
-                if (feof(file)) {
-                    break; // 文件结束
-                }
-                // 再次扩展缓冲区
-                new_size = buffer_size * 2;
-                new_line = (char *)realloc(line, new_size);
-                if (new_line == NULL) {
-                    logAABAC(__func__, __LINE__, 0, ERROR, "Failed to reallocate memory for line buffer\n");
-                    free(line);
-                    fclose(file);
-                    return NULL;
-                }
-                line = new_line;
-                buffer_size = new_size;
-            }
+    // 0: initial, 1: roles, 2: users, 3: UA, 4: CR, 5: CA, 6: ADMIN, 7: SPEC
+    int stage = 0, nextStage, nSpecWords = 0;
+    ARBACTokenType type;
+    while ((type = nextToken(lex)) != ARBAC_TOKEN_END) {
+        if (type == ARBAC_TOKEN_SEMICOLON) {
+            continue;
         }
-
-        // 处理完整的行
-        char *trimmed_line = strtrim(line);
-        if (strlen(trimmed_line) == 0) {
+        // 只有位于行首的单词才可能是节标题，行中的同名单词按所在节的内容处理
+        if (type == ARBAC_TOKEN_WORD && lex->firstOnLine && (nextStage = sectionStage(lex->token)) != 0) {
+            stage = nextStage;
             continue;
         }
-
-        if (strncmp(trimmed_line, ROLES, ROLES_LEN) == 0) {
-            stage = 1;
-            trimmed_line += ROLES_LEN;
-            trimmed_line = strtrim(trimmed_line);
-            if (strlen(trimmed_line) > 0) {
-                handleLine(pInst, stage, trimmed_line);
-            }
-        } else if (strncmp(trimmed_line, USERS, USERS_LEN) == 0) {
-            stage = 2;
-            trimmed_line += USERS_LEN;
-            trimmed_line = strtrim(trimmed_line);
-            if (strlen(trimmed_line) > 0) {
-                handleLine(pInst, stage, trimmed_line);
+        switch (stage) {
+        case 1:
+            if (type == ARBAC_TOKEN_WORD) {
+                handleRole(lex->token);
+                continue;
             }
-        } else if (strncmp(trimmed_line, UA, UA_LEN) == 0) {
-            stage = 3;
-            trimmed_line += UA_LEN;
-            trimmed_line = strtrim(trimmed_line);
-            if (strlen(trimmed_line) > 0) {
-                handleLine(pInst, stage, trimmed_line);
+            break;
+        case 2:
+            if (type == ARBAC_TOKEN_WORD) {
+                handleUser(pInst, lex->token);
+                continue;
             }
-        } else if (strncmp(trimmed_line, CR, CR_LEN) == 0) {
-            stage = 4;
-            trimmed_line += CR_LEN;
-            trimmed_line = strtrim(trimmed_line);
-            if (strlen(trimmed_line) > 0) {
-                handleLine(pInst, stage, trimmed_line);
+            break;
+        case 3:
+            if (type == ARBAC_TOKEN_TUPLE) {
+                handleUA(pInst, lex->token);
+                continue;
             }
-        } else if (strncmp(trimmed_line, CA, CA_LEN) == 0) {
-            stage = 5;
-            trimmed_line += CA_LEN;
-            trimmed_line = strtrim(trimmed_line);
-            if (strlen(trimmed_line) > 0) {
-                handleLine(pInst, stage, trimmed_line);
+            break;
+        case 4:
+            if (type == ARBAC_TOKEN_TUPLE) {
+                handleCR(pInst, lex->token);
+                continue;
             }
-        } else if (strncmp(trimmed_line, ADMIN, ADMIN_LEN) == 0) {
-            stage = 6;
-            trimmed_line += ADMIN_LEN;
-            trimmed_line = strtrim(trimmed_line);
-            if (strlen(trimmed_line) > 0) {
-                handleLine(pInst, stage, trimmed_line);
+            break;
+        case 5:
+            if (type == ARBAC_TOKEN_TUPLE) {
+                handleCA(pInst, lex->token);
+                continue;
             }
-        } else if (strncmp(trimmed_line, SPEC, SPEC_LEN) == 0) {
-            stage = 7;
-            trimmed_line += SPEC_LEN;
-            trimmed_line = strtrim(trimmed_line);
-            if (strlen(trimmed_line) > 0) {
-                handleLine(pInst, stage, trimmed_line);
+            break;
+        case 6:
+            // 管理员列表不用做任何处理
+            continue;
+        case 7:
+            if (type == ARBAC_TOKEN_WORD) {
+                handleSpec(pInst, lex->token, nSpecWords++);
+                continue;
             }
-        } else {
-            handleLine(pInst, stage, trimmed_line);
+            break;
         }
+        logAABAC(__func__, __LINE__, 0, ERROR, "unexpected %s in section %d: %s\n", type == ARBAC_TOKEN_TUPLE ? "tuple" : "word", stage, lex->token);
     }
 
-    // 释放动态分配的内存
-    free(line);
-    fclose(file);
+    fclose(lex->file);
+    free(lex->token);
+    free(lex);
+
+    // 名称字典此后只读，冻结为完美哈希表
+    freezeSymbolTables();
 
     logAABAC(__func__, __LINE__, 0, INFO, "[end] reading ARBAC instance from file %s\n", arbacFilePath);
     return pInst;
@@ -2,6 +2,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <time.h>
+#include <unistd.h>
 
 #include "AABACAbsRef.h"
 #include "AABACBoundCalculator.h"
@@ -17,6 +18,8 @@
 
 #define AABAC_SUFFIX ".aabac"
 #define AABAC_SUFFIX_LEN 6
+#define AABACB_SUFFIX ".aabacb"
+#define AABACB_SUFFIX_LEN 7
 #define ARBAC_SUFFIX ".arbac"
 #define ARBAC_SUFFIX_LEN 6
 #define MOHAWK_SUFFIX ".mohawk"
@@ -39,15 +42,57 @@
 #define RESULT_SUFFIX ".txt"
 #define RESULT_SUFFIX_LEN 4
 
+#define BMC_PROGRESS_FILE_NAME "bmcProgress.txt"
+#define BMC_PROGRESS_FILE_NAME_LEN 15
+
+// Which sub-policies and NuSMV models are written to the log directory during verification
+#define DUMP_NONE 0  // none
+#define DUMP_FINAL 1 // the globally sliced policy, and the sub-policy and model whose model-checking result is returned
+#define DUMP_ROUND 2 // the globally sliced policy, and the sub-policies and models of every round
+
+/**
+ * Build the path of the NuSMV model of a round in the log directory, <logDir>/lastSmvInstance<roundStr>.smv.
+ * 
+ * @param logDir[in]: The log directory
+ * @param roundStr[in]: The round
+ * @return The path, which the caller frees
+ */
+static char *nusmvLogPath(char *logDir, char *roundStr) {
+    char *path = (char *)malloc(strlen(logDir) + NUSMV_FILE_NAME_LEN + strlen(roundStr) + SMV_SUFFIX_LEN + 2);
+    sprintf(path, "%s/%s%s%s", logDir, NUSMV_FILE_NAME, roundStr, SMV_SUFFIX);
+    return path;
+}
+
+/**
+ * Queue a sub-policy to be written to <logDir>/<name><roundStr>.aabac by the background writer.
+ * 
+ * @param pInst[in]: The sub-policy, which may be modified or finalized as soon as the function returns
+ * @param logDir[in]: The log directory
+ * @param name[in]: The file name without the round and suffix
+ * @param roundStr[in]: The round, or an empty string
+ */
+static void dumpInstance(AABACInstance *pInst, char *logDir, char *name, char *roundStr) {
+    char *writePath = (char *)malloc(strlen(logDir) + strlen(name) + strlen(roundStr) + AABAC_SUFFIX_LEN + 2);
+    sprintf(writePath, "%s/%s%s%s", logDir, name, roundStr, AABAC_SUFFIX);
+    writeAABACInstanceAsync(pInst, writePath);
+    free(writePath);
+}
+
 static AABACResult verify(char *modelCheckerPath, char *instFilePath, char *logDir, int doPrechecking,
-                          int doSlicing, int enableAbstractRefine, int useBMC, int tl, int showRules, long timeout) {
+                          int doSlicing, int enableAbstractRefine, int engine, int invarSpec, int tl, int showRules, double timeout, char *dumpImagePath, int lazyRules, int ruleComments, int dumpLevel, MCSession *session, int portfolio, double cpuBudget, double deepenFactor, double deepenBudget) {
     AABACInstance *pInst = NULL;
+    int initialized = 0;
 
     // read the instance file
     int instFilePathLen = strlen(instFilePath);
-    if (instFilePathLen >= AABAC_SUFFIX_LEN && strcmp(instFilePath + instFilePathLen - AABAC_SUFFIX_LEN, AABAC_SUFFIX) == 0) {
+    if (instFilePathLen >= AABACB_SUFFIX_LEN && strcmp(instFilePath + instFilePathLen - AABACB_SUFFIX_LEN, AABACB_SUFFIX) == 0) {
+        // the image is taken after initialization, so init() must not run again
+        logAABAC(__func__, __LINE__, 0, INFO, "[start] loading aabac image file\n");
+        pInst = readAABACImage(instFilePath);
+        initialized = 1;
+    } else if (instFilePathLen >= AABAC_SUFFIX_LEN && strcmp(instFilePath + instFilePathLen - AABAC_SUFFIX_LEN, AABAC_SUFFIX) == 0) {
         logAABAC(__func__, __LINE__, 0, INFO, "[start] parsing aabac instance file\n");
-        pInst = readAABACInstance(instFilePath);
+        pInst = lazyRules ? readAABACInstanceForQuery(instFilePath) : readAABACInstance(instFilePath);
     } else if ((instFilePathLen >= ARBAC_SUFFIX_LEN && strcmp(instFilePath + instFilePathLen - ARBAC_SUFFIX_LEN, ARBAC_SUFFIX) == 0) ||
                (instFilePathLen >= MOHAWK_SUFFIX_LEN && strcmp(instFilePath + instFilePathLen - MOHAWK_SUFFIX_LEN, MOHAWK_SUFFIX) == 0)) {
         logAABAC(__func__, __LINE__, 0, INFO, "[start] translating arbac instance file\n");
@@ -61,7 +106,12 @@ static AABACResult verify(char *modelCheckerPath, char *instFilePath, char *logD
     }
 
     // initialize the instance
-    init(pInst);
+    if (!initialized) {
+        init(pInst);
+    }
+    if (dumpImagePath != NULL && writeAABACImage(pInst, dumpImagePath) != 0) {
+        return (AABACResult){.code = AABAC_RESULT_ERROR};
+    }
 
     // pre-checking
     if (doPrechecking) {
@@ -80,7 +130,6 @@ static AABACResult verify(char *modelCheckerPath, char *instFilePath, char *logD
     }
     
     pInst = userCleaning(pInst);
-    char *writePath;
 
     AABACResult result = {.code = AABAC_RESULT_UNKNOWN};
     if (doSlicing) {
@@ -91,17 +140,17 @@ static AABACResult verify(char *modelCheckerPath, char *instFilePath, char *logD
             return result;
         }
 
-        writePath = (char *)malloc(strlen(logDir) + SLICING_RESULT_FILE_NAME_LEN + AABAC_SUFFIX_LEN + 2);
-        sprintf(writePath, "%s/%s%s", logDir, SLICING_RESULT_FILE_NAME, AABAC_SUFFIX);
-        writeAABACInstance(pInst, writePath);
-        free(writePath);
+        if (dumpLevel != DUMP_NONE) {
+            dumpInstance(pInst, logDir, SLICING_RESULT_FILE_NAME, "");
+        }
     }
 
     AbsRef *pAbsRef;
     AABACInstance *next;
     char roundStr[10];
     char boundStr[15];
-    char *nusmvFilePath, *resultFilePath, *nusmvOutput;
+    char *nusmvFilePath, *resultFilePath;
+    int modelFd;
 
     if (enableAbstractRefine) {
         // Generate an abstract sub-policy
@@ -118,10 +167,9 @@ static AABACResult verify(char *modelCheckerPath, char *instFilePath, char *logD
 
         if (enableAbstractRefine) {
             // Save the abstract sub-policy in the log directory
-            writePath = (char *)malloc(strlen(logDir) + ABSTRACTION_REFINEMENT_RESULT_FILE_NAME_LEN + strlen(roundStr) + AABAC_SUFFIX_LEN + 2);
-            sprintf(writePath, "%s/%s%s%s", logDir, ABSTRACTION_REFINEMENT_RESULT_FILE_NAME, roundStr, AABAC_SUFFIX);
-            writeAABACInstance(next, writePath);
-            free(writePath);
+            if (dumpLevel == DUMP_ROUND) {
+                dumpInstance(next, logDir, ABSTRACTION_REFINEMENT_RESULT_FILE_NAME, roundStr);
+            }
 
             if (doSlicing) {
                 // Local pruning
@@ -136,20 +184,21 @@ static AABACResult verify(char *modelCheckerPath, char *instFilePath, char *logD
                 if (result.code == AABAC_RESULT_UNREACHABLE) {
                     // Abstraction refinement is enabled and the sub-policy is determined to be "safe", need refinement and re-verification
                     printResult(result, showRules);
+                    finalizeAABACInstance(next);
                     next = refine(pAbsRef);
                     continue;
                 }
 
                 // Save the pruned sub-policy in the log directory
-                writePath = (char *)malloc(strlen(logDir) + SLICING_RESULT_FILE_NAME_LEN + strlen(roundStr) + AABAC_SUFFIX_LEN + 2);
-                sprintf(writePath, "%s/%s%s%s", logDir, SLICING_RESULT_FILE_NAME, roundStr, AABAC_SUFFIX);
-                writeAABACInstance(next, writePath);
-                free(writePath);
+                if (dumpLevel == DUMP_ROUND) {
+                    dumpInstance(next, logDir, SLICING_RESULT_FILE_NAME, roundStr);
+                }
             }
         }
 
         int tooLarge = 0;
-        if (useBMC) {
+        int useBound = engine == MC_ENGINE_BMC || engine == MC_ENGINE_KIND;
+        if (useBound) {
             // Bound estimation, if the bound exceeds the range of int, use INT_MAX as the bound
             BigInteger bound = computeBound(next, tl);
             if (bound.magLen > 1 || (bound.magLen == 1 && (bound.mag[0] >> 31) != 0)) {
@@ -161,12 +210,25 @@ static AABACResult verify(char *modelCheckerPath, char *instFilePath, char *logD
             }
             iBigInteger.finalize(bound);
         }
+        int startLength = 0;
+        if (deepenFactor > 0) {
+            // Iterative deepening starts from the forward reachability depth of the query
+            startLength = computeQueryDepth(next);
+            logAABAC(__func__, __LINE__, 0, INFO, "estimated counterexample length => %d\n", startLength);
+        }
 
-        // Translate the instance to a NuSMV file
-        nusmvFilePath = (char *)malloc(strlen(logDir) + NUSMV_FILE_NAME_LEN + strlen(roundStr) + SMV_SUFFIX_LEN + 2);
-        sprintf(nusmvFilePath, "%s/%s%s%s", logDir, NUSMV_FILE_NAME, roundStr, SMV_SUFFIX);
-        if (translate(next, nusmvFilePath, doSlicing) != 0) {
+        // Translate the instance to a NuSMV file. Unless every round is dumped, the model is handed to the model checker
+        // through an in-memory file and never goes through the log directory
+        modelFd = dumpLevel == DUMP_ROUND ? -1 : createModelMemFile(NUSMV_FILE_NAME, &nusmvFilePath);
+        if (modelFd < 0) {
+            nusmvFilePath = nusmvLogPath(logDir, roundStr);
+        }
+        if (translate(next, nusmvFilePath, doSlicing, ruleComments, invarSpec) != 0) {
             logAABAC(__func__, __LINE__, 0, ERROR, "failed to translate instance to nusmv file\n");
+            free(nusmvFilePath);
+            if (modelFd >= 0) {
+                close(modelFd);
+            }
             result.code = AABAC_RESULT_ERROR;
             printResult(result, showRules);
             return result;
@@ -175,17 +237,31 @@ static AABACResult verify(char *modelCheckerPath, char *instFilePath, char *logD
         // Call the model checker to verify the instance and save the result in the log directory
         resultFilePath = (char *)malloc(strlen(logDir) + RESULT_FILE_NAME_LEN + strlen(roundStr) + RESULT_SUFFIX_LEN + 2);
         sprintf(resultFilePath, "%s/%s%s%s", logDir, RESULT_FILE_NAME, roundStr, RESULT_SUFFIX);
-        nusmvOutput = runModelChecker(modelCheckerPath, nusmvFilePath, resultFilePath, timeout, useBMC ? boundStr : NULL);
-
-        // Analyze the result of the model checker
-        result = analyzeModelCheckerOutput(nusmvOutput, next, useBMC ? boundStr : NULL, showRules);
-        free(nusmvOutput);
+        if (portfolio > 0) {
+            // Race the engines instead of running BMC and then SMC; an "unreachable" from BMC only counts if the bound is exact
+            result = runModelCheckerPortfolio(modelCheckerPath, nusmvFilePath, resultFilePath, timeout, useBound ? boundStr : NULL, !tooLarge,
+                                              invarSpec, portfolio, cpuBudget, next, showRules);
+        } else if (deepenFactor > 0) {
+            // Deepening falls back to SMC by itself when the bound is not conclusive
+            result = runModelCheckerDeepening(modelCheckerPath, session, nusmvFilePath, resultFilePath, timeout, invarSpec, boundStr,
+                                              !tooLarge, startLength, deepenFactor, deepenBudget, next, showRules);
+        } else if (session != NULL) {
+            result = runModelCheckerSession(session, nusmvFilePath, resultFilePath, timeout, engine, invarSpec,
+                                            useBound ? boundStr : NULL, next, showRules);
+        } else {
+            result = runModelChecker(modelCheckerPath, nusmvFilePath, resultFilePath, timeout, engine, invarSpec,
+                                     useBound ? boundStr : NULL, next, showRules);
+        }
 
-        if (tooLarge && result.code == AABAC_RESULT_UNREACHABLE) {
+        if (portfolio == 0 && deepenFactor == 0 && engine == MC_ENGINE_BMC && tooLarge && result.code == AABAC_RESULT_UNREACHABLE) {
             // The bound exceeds the range of int and the model checker result is "unreachable", need re-verification in SMC mode
-            nusmvOutput = runModelChecker(modelCheckerPath, nusmvFilePath, resultFilePath, timeout, NULL);
-            result = analyzeModelCheckerOutput(nusmvOutput, next, NULL, showRules);
-            free(nusmvOutput);
+            if (session != NULL) {
+                result = runModelCheckerSession(session, nusmvFilePath, resultFilePath, timeout, MC_ENGINE_BDD, invarSpec, NULL, next,
+                                                showRules);
+            } else {
+                result = runModelChecker(modelCheckerPath, nusmvFilePath, resultFilePath, timeout, MC_ENGINE_BDD, invarSpec, NULL, next,
+                                         showRules);
+            }
         }
         free(nusmvFilePath);
         free(resultFilePath);
@@ -195,11 +271,28 @@ static AABACResult verify(char *modelCheckerPath, char *instFilePath, char *logD
 
         // If abstraction refinement is disabled or the sub-policy is not determined to be "unsafe", output the result
         if (!enableAbstractRefine || result.code != AABAC_RESULT_UNREACHABLE) {
+            if (dumpLevel == DUMP_FINAL && enableAbstractRefine) {
+                // Save the sub-policy of the returned result under the name it has in every-round dumps
+                dumpInstance(next, logDir, doSlicing ? SLICING_RESULT_FILE_NAME : ABSTRACTION_REFINEMENT_RESULT_FILE_NAME, roundStr);
+            }
+            if (dumpLevel == DUMP_FINAL && modelFd >= 0) {
+                // Also persist the model the returned result comes from
+                nusmvFilePath = nusmvLogPath(logDir, roundStr);
+                saveModelMemFile(modelFd, nusmvFilePath);
+                free(nusmvFilePath);
+            }
+            if (modelFd >= 0) {
+                close(modelFd);
+            }
             logAABAC(__func__, __LINE__, 0, INFO, "round => %s\n", roundStr);
             return result;
         }
 
         // Abstraction refinement is enabled and the sub-policy is determined to be "unsafe", need refinement and re-verification
+        if (modelFd >= 0) {
+            close(modelFd);
+        }
+        finalizeAABACInstance(next);
         next = refine(pAbsRef);
     }
     logAABAC(__func__, __LINE__, 0, INFO, "round => %s\n", roundStr);
@@ -213,29 +306,57 @@ int main(int argc, char *argv[]) {
     int doPrechecking = 1;
     int doSlicing = 1;
     int enableAbstractRefine = 1;
-    int useBMC = 1;
+    int engine = MC_ENGINE_BMC;
+    int invarSpec = 0;
     int showRules = 1;
 
     int tl = 2;
     char *modelCheckerPath = NULL;
     char *inputFilePath = NULL;
     char *logDir = NULL;
-    long timeout = 60;
+    char *dumpImagePath = NULL;
+    int lazyRules = 0;
+    int ruleComments = 1;
+    int dumpLevel = DUMP_ROUND;
+    int useSession = 0;
+    int portfolio = 0;
+    double cpuBudget = 0;
+    double deepenFactor = 0;
+    double deepenBudget = 0.5;
+    char *resumeFilePath = NULL;
+    double timeout = 60;
 
     int unrecognized = 0;
 
     char *helpMessage = "Usage: aabac-verifier\
         \n-tl <arg>                   tight level, either 1 (loose) or 2 (tight)\
         \n-h                          print this help text\
-        \n-input <arg>                acoac file path\
+        \n-input <arg>                acoac file path (.aabac, .arbac, .mohawk, or an .aabacb image)\
         \n-model_checker <arg>        nusmv file path\
         \n-log_dir <arg>              directory for storing logs\
         \n-no_absref                  no abstraction refinement\
         \n-no_precheck                no precheck\
         \n-no_slicing                 no slicing\
         \n-no_rules                   do not show the rules associated with the actions in the result\
-        \n-smc                        on smc mode\
-        \n-timeout <arg>              timeout in seconds\n";
+        \n-no_rule_comments           do not annotate the generated nusmv model with the rule of each transition\
+        \n-dump_level <arg>           sub-policies and nusmv models written to the log directory: none, final (the sliced policy,\
+        \n                            and the sub-policy and model of the returned result), or round (every round, default);\
+        \n                            unless round, models reach the model checker through an in-memory file\
+        \n-session                    keep one model checker running in interactive mode (-int) for all the rounds\
+        \n-portfolio <arg>            race bmc, smc, ic3 and (with -spec invar) kind on each model, at most <arg> engines\
+        \n                            (1 to 4) at a time\
+        \n-cpu_budget <arg>           cpu seconds shared evenly by the portfolio engines of a round, 0 for no limit\
+        \n-deepen <arg>               run bmc at geometrically growing lengths, starting from the estimated counterexample\
+        \n                            length and multiplied by <arg> (greater than 1), before the full bound\
+        \n-deepen_budget <arg>        fraction of the timeout the deepening may spend before falling back to smc (default 0.5)\
+        \n-resume <arg>               continue bmc from the lengths recorded in a bmcProgress.txt file of an earlier run\
+        \n                            (bmc records them in <log_dir>/bmcProgress.txt when it times out, unless -dump_level none)\
+        \n-spec <arg>                 the query as an ltl property (ltl, default) or an invariant (invar, INVARSPEC)\
+        \n-engine <arg>               bmc (default), smc, ic3, or kind (k-induction, needs -spec invar)\
+        \n-smc                        on smc mode, same as -engine smc\
+        \n-timeout <arg>              timeout in seconds, may be fractional\
+        \n-lazy_rules                 only load the rules that may lead to the query (.aabac files)\
+        \n-dump_image <arg>           write the initialized instance to a binary image (.aabacb) for faster reloading\n";
 
     static struct option long_options[] = {
         {"help", no_argument, 0, 'h'},
@@ -245,17 +366,29 @@ int main(int argc, char *argv[]) {
         {"smc", no_argument, 0, 'n'},
         {"tl", required_argument, 0, 'b'},
         {"no_rules", no_argument, 0, 'r'},
+        {"no_rule_comments", no_argument, 0, 'c'},
         {"model_checker", required_argument, 0, 'm'},
         {"input", required_argument, 0, 'i'},
         {"log_dir", required_argument, 0, 'l'},
         {"timeout", required_argument, 0, 't'},
+        {"dump_image", required_argument, 0, 'd'},
+        {"lazy_rules", no_argument, 0, 'z'},
+        {"dump_level", required_argument, 0, 'w'},
+        {"session", no_argument, 0, 'e'},
+        {"portfolio", required_argument, 0, 'f'},
+        {"cpu_budget", required_argument, 0, 'u'},
+        {"deepen", required_argument, 0, 'g'},
+        {"deepen_budget", required_argument, 0, 'j'},
+        {"resume", required_argument, 0, 'k'},
+        {"spec", required_argument, 0, 'v'},
+        {"engine", required_argument, 0, 'x'},
         {0, 0, 0, 0}};
 
     int c;
     while (1) {
         int option_index = 0;
 
-        c = getopt_long_only(argc, argv, "hpsanb:rm:i:l:t:", long_options, &option_index);
+        c = getopt_long_only(argc, argv, "hpsanb:rcm:i:l:t:d:zw:ef:u:g:j:k:v:x:", long_options, &option_index);
 
         if (c == -1)
             break;
@@ -274,11 +407,14 @@ int main(int argc, char *argv[]) {
             enableAbstractRefine = 0;
             break;
         case 'n':
-            useBMC = 0;
+            engine = MC_ENGINE_BDD;
             break;
         case 'r':
             showRules = 0;
             break;
+        case 'c':
+            ruleComments = 0;
+            break;
         case 'b':
             tl = atoi(optarg);
             if (tl != 1 && tl != 2) {
@@ -299,7 +435,81 @@ int main(int argc, char *argv[]) {
             strcpy(logDir, optarg);
             break;
         case 't':
-            timeout = atol(optarg);
+            timeout = atof(optarg);
+            break;
+        case 'z':
+            lazyRules = 1;
+            break;
+        case 'w':
+            if (strcmp(optarg, "none") == 0) {
+                dumpLevel = DUMP_NONE;
+            } else if (strcmp(optarg, "final") == 0) {
+                dumpLevel = DUMP_FINAL;
+            } else if (strcmp(optarg, "round") == 0) {
+                dumpLevel = DUMP_ROUND;
+            } else {
+                printf("dump level should be none, final, or round\n");
+                return 0;
+            }
+            break;
+        case 'e':
+            useSession = 1;
+            break;
+        case 'f':
+            portfolio = atoi(optarg);
+            if (portfolio < 1 || portfolio > 4) {
+                printf("portfolio should be between 1 and 4\n");
+                return 0;
+            }
+            break;
+        case 'u':
+            cpuBudget = atof(optarg);
+            break;
+        case 'g':
+            deepenFactor = atof(optarg);
+            if (deepenFactor <= 1) {
+                printf("deepen factor should be greater than 1\n");
+                return 0;
+            }
+            break;
+        case 'j':
+            deepenBudget = atof(optarg);
+            if (deepenBudget <= 0 || deepenBudget > 1) {
+                printf("deepen budget should be greater than 0 and at most 1\n");
+                return 0;
+            }
+            break;
+        case 'k':
+            resumeFilePath = (char *)malloc(strlen(optarg) + 1);
+            strcpy(resumeFilePath, optarg);
+            break;
+        case 'v':
+            if (strcmp(optarg, "ltl") == 0) {
+                invarSpec = 0;
+            } else if (strcmp(optarg, "invar") == 0) {
+                invarSpec = 1;
+            } else {
+                printf("spec should be ltl or invar\n");
+                return 0;
+            }
+            break;
+        case 'x':
+            if (strcmp(optarg, "bmc") == 0) {
+                engine = MC_ENGINE_BMC;
+            } else if (strcmp(optarg, "smc") == 0) {
+                engine = MC_ENGINE_BDD;
+            } else if (strcmp(optarg, "ic3") == 0) {
+                engine = MC_ENGINE_IC3;
+            } else if (strcmp(optarg, "kind") == 0) {
+                engine = MC_ENGINE_KIND;
+            } else {
+                printf("engine should be bmc, smc, ic3, or kind\n");
+                return 0;
+            }
+            break;
+        case 'd':
+            dumpImagePath = (char *)malloc(strlen(optarg) + 1);
+            strcpy(dumpImagePath, optarg);
             break;
         default:
             unrecognized = 1;
@@ -319,12 +529,34 @@ int main(int argc, char *argv[]) {
         printf("please input the directory for storing logs\n%s", helpMessage);
     } else if (timeout <= 0) {
         printf("timeout must be greater than 0\n%s", helpMessage);
+    } else if (useSession && portfolio > 0) {
+        printf("-session and -portfolio cannot be used together\n%s", helpMessage);
+    } else if (engine == MC_ENGINE_KIND && !invarSpec) {
+        printf("-engine kind needs -spec invar\n%s", helpMessage);
+    } else if (deepenFactor > 0 && (engine != MC_ENGINE_BMC || portfolio > 0)) {
+        printf("-deepen needs -engine bmc and cannot be used with -portfolio\n%s", helpMessage);
     } else {
         clock_t start = clock();
-        verify(modelCheckerPath, inputFilePath, logDir, doPrechecking, doSlicing, enableAbstractRefine, useBMC, tl, showRules, timeout);
+        // BMC records how deep it got when it times out, so that a later run can continue with -resume. Nothing is
+        // written to the log directory when dumping is disabled
+        char *progressFilePath = NULL;
+        if (dumpLevel != DUMP_NONE) {
+            progressFilePath = (char *)malloc(strlen(logDir) + BMC_PROGRESS_FILE_NAME_LEN + 2);
+            sprintf(progressFilePath, "%s/%s", logDir, BMC_PROGRESS_FILE_NAME);
+        }
+        setBMCProgressFiles(progressFilePath, resumeFilePath);
+        MCSession *session = useSession ? createModelCheckerSession(modelCheckerPath) : NULL;
+        verify(modelCheckerPath, inputFilePath, logDir, doPrechecking, doSlicing, enableAbstractRefine, engine, invarSpec, tl, showRules, timeout, dumpImagePath, lazyRules, ruleComments, dumpLevel, session, portfolio, cpuBudget, deepenFactor, deepenBudget);
+        if (session != NULL) {
+            destroyModelCheckerSession(session);
+        }
+        // the sub-policy dumps may still be being written
+        waitAABACWrites();
         clock_t end = clock();
         double time_spent = (double)(end - start) / CLOCKS_PER_SEC * 1000;
         logAABAC(__func__, __LINE__, 0, INFO, "end verification, cost => %.2fms\n", time_spent);
+        setBMCProgressFiles(NULL, NULL);
+        free(progressFilePath);
     }
     return 0;
 }
\ No newline at end of file
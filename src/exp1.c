@@ -41,7 +41,7 @@ void computePR(char *instFile, char *resultFile) {
     init(pInst);
 
     // 记录global pruning前的规则数
-    int nRulesBeforeGP = iHashSet.Size(pInst->pSetRuleIdxes);
+    int nRulesBeforeGP = iIntSet.Size(pInst->pSetRuleIdxes);
 
     // 进行global pruning
     pInst = userCleaning(pInst);
@@ -61,7 +61,7 @@ void computePR(char *instFile, char *resultFile) {
     }
 
     // 记录剪枝后的规则数
-    int nRulesAfterGP = iHashSet.Size(pInst->pSetRuleIdxes);
+    int nRulesAfterGP = iIntSet.Size(pInst->pSetRuleIdxes);
     double gpr = (nRulesBeforeGP - nRulesAfterGP) * 100.0 / nRulesBeforeGP;
 
     // 进行local pruning
@@ -78,7 +78,7 @@ void computePR(char *instFile, char *resultFile) {
             nRulesBeforeLP = (int *)realloc(nRulesBeforeLP, capacity * sizeof(int));
             nRulesAfterLP = (int *)realloc(nRulesAfterLP, capacity * sizeof(int));
         }
-        nRulesBeforeLP[cnt] = iHashSet.Size(next->pSetRuleIdxes);
+        nRulesBeforeLP[cnt] = iIntSet.Size(next->pSetRuleIdxes);
         result = (AABACResult){.code = AABAC_RESULT_UNKNOWN};
         next = slice(next, &result);
 
@@ -89,15 +89,16 @@ void computePR(char *instFile, char *resultFile) {
         } else if (result.code == AABAC_RESULT_UNREACHABLE) {
             nRulesAfterLP[cnt] = 0;
         } else {
-            nRulesAfterLP[cnt] = iHashSet.Size(next->pSetRuleIdxes);
+            nRulesAfterLP[cnt] = iIntSet.Size(next->pSetRuleIdxes);
         }
 
         if (result.code != AABAC_RESULT_REACHABLE && result.code != AABAC_RESULT_UNREACHABLE) {
-            nRulesAfterLP[cnt] = iHashSet.Size(next->pSetRuleIdxes);
+            nRulesAfterLP[cnt] = iIntSet.Size(next->pSetRuleIdxes);
         } else {
             nRulesAfterLP[cnt] = 0;
         }
         cnt++;
+        finalizeAABACInstance(next);
         next = refine(pAbsRef);
     }
 
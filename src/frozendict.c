@@ -0,0 +1,223 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "AABACUtils.h"
+#include "frozenDict.h"
+
+#define KEYS_PER_BUCKET 2     // Average number of keys per bucket
+#define SEEDS_PER_TABLE_SIZE 16 // Number of seeds tried before the table is enlarged
+
+/**
+ * 64-bit FNV-1a hash of a string followed by a murmur3 finalizer, so that both halves of the
+ * result are well mixed. The high half selects the bucket and the low half the base slot.
+ */
+static unsigned long long hashString(const char *str, unsigned long long seed) {
+    unsigned long long h = 0xcbf29ce484222325ULL ^ seed;
+    while (*str) {
+        h ^= (unsigned char)*str++;
+        h *= 0x100000001b3ULL;
+    }
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ULL;
+    h ^= h >> 33;
+    return h;
+}
+
+static int bucketOf(FrozenDict *frozenDict, unsigned long long h) {
+    return (int)((unsigned int)(h >> 32) % (unsigned int)frozenDict->nBuckets);
+}
+
+static int baseSlotOf(FrozenDict *frozenDict, unsigned long long h) {
+    return (int)((unsigned int)h % (unsigned int)frozenDict->nSlots);
+}
+
+/**
+ * Tries to place every key with the current seed and table size. Buckets are processed from the
+ * largest to the smallest; the keys of a bucket are moved together by the smallest displacement
+ * that puts all of them into free slots.
+ *
+ * @param hashes[in] The hash of each key under the current seed
+ * @param order[out] Scratch array of nKeys ints
+ * @param bucketStart[out] Scratch array of nBuckets + 1 ints
+ * @param keySlots[out] The slot of each key
+ * @return 1 if all keys have been placed, 0 otherwise
+ */
+static int tryPlace(FrozenDict *frozenDict, unsigned long long *hashes, int nKeys, int *order, int *bucketStart, int *keySlots) {
+    int nBuckets = frozenDict->nBuckets, nSlots = frozenDict->nSlots;
+    int i, j, b;
+
+    // Group the keys by bucket (counting sort)
+    memset(bucketStart, 0, (nBuckets + 1) * sizeof(int));
+    for (i = 0; i < nKeys; i++) {
+        bucketStart[bucketOf(frozenDict, hashes[i]) + 1]++;
+    }
+    for (b = 0; b < nBuckets; b++) {
+        bucketStart[b + 1] += bucketStart[b];
+    }
+    int *fill = (int *)malloc(nBuckets * sizeof(int));
+    memcpy(fill, bucketStart, nBuckets * sizeof(int));
+    for (i = 0; i < nKeys; i++) {
+        b = bucketOf(frozenDict, hashes[i]);
+        order[fill[b]++] = i;
+    }
+    free(fill);
+
+    // Sort the buckets by decreasing size (counting sort on the size)
+    int maxBucketSize = 0;
+    for (b = 0; b < nBuckets; b++) {
+        if (bucketStart[b + 1] - bucketStart[b] > maxBucketSize) {
+            maxBucketSize = bucketStart[b + 1] - bucketStart[b];
+        }
+    }
+    int *bucketsBySize = (int *)malloc(nBuckets * sizeof(int));
+    int nSorted = 0, size;
+    for (size = maxBucketSize; size > 0; size--) {
+        for (b = 0; b < nBuckets; b++) {
+            if (bucketStart[b + 1] - bucketStart[b] == size) {
+                bucketsBySize[nSorted++] = b;
+            }
+        }
+    }
+
+    char *occupied = (char *)calloc(nSlots, 1);
+    int placed = 1, d, slot, fits;
+    for (i = 0; i < nSorted && placed; i++) {
+        b = bucketsBySize[i];
+        placed = 0;
+        for (d = 0; d < nSlots && !placed; d++) {
+            fits = 1;
+            for (j = bucketStart[b]; j < bucketStart[b + 1]; j++) {
+                slot = baseSlotOf(frozenDict, hashes[order[j]]) + d;
+                slot = slot >= nSlots ? slot - nSlots : slot;
+                if (occupied[slot]) {
+                    fits = 0;
+                    break;
+                }
+                // Reserve the slot now so that two keys of the bucket cannot share it
+                occupied[slot] = 1;
+                keySlots[order[j]] = slot;
+            }
+            if (fits) {
+                frozenDict->disps[b] = d;
+                placed = 1;
+            } else {
+                // Release the slots reserved by this attempt
+                while (--j >= bucketStart[b]) {
+                    occupied[keySlots[order[j]]] = 0;
+                }
+            }
+        }
+    }
+    free(occupied);
+    free(bucketsBySize);
+    return placed;
+}
+
+static FrozenDict *Create(Dictionary *dict) {
+    FrozenDict *frozenDict = (FrozenDict *)calloc(1, sizeof(FrozenDict));
+    if (frozenDict == NULL) {
+        logAABAC(__func__, __LINE__, 0, ERROR, "Failed to allocate memory for frozen dictionary\n");
+        return NULL;
+    }
+    strCollection *keys = iDictionary.GetKeys(dict);
+    int nKeys = (int)istrCollection.Size(keys);
+    frozenDict->size = nKeys;
+    if (nKeys == 0) {
+        istrCollection.Finalize(keys);
+        return frozenDict;
+    }
+
+    // Copy the keys into the arena
+    int i, *arenaOffsets = (int *)malloc(nKeys * sizeof(int));
+    size_t arenaSize = 0;
+    for (i = 0; i < nKeys; i++) {
+        arenaOffsets[i] = (int)arenaSize;
+        arenaSize += strlen(istrCollection.GetElement(keys, i)) + 1;
+    }
+    frozenDict->arena = (char *)malloc(arenaSize);
+    for (i = 0; i < nKeys; i++) {
+        strcpy(frozenDict->arena + arenaOffsets[i], istrCollection.GetElement(keys, i));
+    }
+
+    // Search for a seed that yields a perfect hash, enlarging the table if the minimal one keeps failing
+    unsigned long long *hashes = (unsigned long long *)malloc(nKeys * sizeof(unsigned long long));
+    int *order = (int *)malloc(nKeys * sizeof(int));
+    int *keySlots = (int *)malloc(nKeys * sizeof(int));
+    int *bucketStart = NULL;
+    int attempt = 0, placed = 0;
+    frozenDict->nSlots = nKeys;
+    frozenDict->nBuckets = nKeys / KEYS_PER_BUCKET + 1;
+    while (!placed) {
+        if (attempt > 0 && attempt % SEEDS_PER_TABLE_SIZE == 0) {
+            frozenDict->nSlots += frozenDict->nSlots / 8 + 1;
+        }
+        frozenDict->seed = 0x9E3779B97F4A7C15ULL * (attempt + 1);
+        free(frozenDict->disps);
+        free(bucketStart);
+        frozenDict->disps = (unsigned int *)calloc(frozenDict->nBuckets, sizeof(unsigned int));
+        bucketStart = (int *)malloc((frozenDict->nBuckets + 1) * sizeof(int));
+        for (i = 0; i < nKeys; i++) {
+            hashes[i] = hashString(frozenDict->arena + arenaOffsets[i], frozenDict->seed);
+        }
+        placed = tryPlace(frozenDict, hashes, nKeys, order, bucketStart, keySlots);
+        attempt++;
+    }
+
+    frozenDict->keyOffsets = (int *)malloc(frozenDict->nSlots * sizeof(int));
+    frozenDict->values = (int *)calloc(frozenDict->nSlots, sizeof(int));
+    for (i = 0; i < frozenDict->nSlots; i++) {
+        frozenDict->keyOffsets[i] = -1;
+    }
+    for (i = 0; i < nKeys; i++) {
+        frozenDict->keyOffsets[keySlots[i]] = arenaOffsets[i];
+        frozenDict->values[keySlots[i]] = *(int *)iDictionary.GetElement(dict, frozenDict->arena + arenaOffsets[i]);
+    }
+    logAABAC(__func__, __LINE__, 0, DEBUG, "froze %d keys into %d slots after %d attempt(s)\n", nKeys, frozenDict->nSlots, attempt);
+
+    free(hashes);
+    free(order);
+    free(keySlots);
+    free(bucketStart);
+    free(arenaOffsets);
+    istrCollection.Finalize(keys);
+    return frozenDict;
+}
+
+static int *Get(FrozenDict *frozenDict, const char *key) {
+    if (frozenDict->size == 0) {
+        return NULL;
+    }
+    unsigned long long h = hashString(key, frozenDict->seed);
+    int slot = baseSlotOf(frozenDict, h) + (int)frozenDict->disps[bucketOf(frozenDict, h)];
+    slot = slot >= frozenDict->nSlots ? slot - frozenDict->nSlots : slot;
+    int offset = frozenDict->keyOffsets[slot];
+    if (offset < 0 || strcmp(frozenDict->arena + offset, key) != 0) {
+        return NULL;
+    }
+    return &frozenDict->values[slot];
+}
+
+static int Size(FrozenDict *frozenDict) {
+    return frozenDict->size;
+}
+
+static void Finalize(FrozenDict *frozenDict) {
+    if (frozenDict == NULL) {
+        return;
+    }
+    free(frozenDict->arena);
+    free(frozenDict->keyOffsets);
+    free(frozenDict->values);
+    free(frozenDict->disps);
+    free(frozenDict);
+}
+
+FrozenDictInterface iFrozenDict = {
+    .Create = Create,
+    .Get = Get,
+    .Size = Size,
+    .Finalize = Finalize,
+};
@@ -3,9 +3,9 @@
 
 #include "hashBasedTable.h"
 
-static HashBasedTable *Create(int rowKeySize, int colKeySize, int valueSize, Hashcode rowHashCode, KeyEqual rowKeyEqual, Hashcode colHashCode, KeyEqual colKeyEqual) {
-    HashBasedTable *hashTable = (HashBasedTable *)malloc(sizeof(HashBasedTable));
-    hashTable->pRowMap = iHashMap.Create(rowKeySize, sizeof(HashMap *), rowHashCode, rowKeyEqual);
+static HashBasedTable *CreateInPool(Pool *pool, int rowKeySize, int colKeySize, int valueSize, Hashcode rowHashCode, KeyEqual rowKeyEqual, Hashcode colHashCode, KeyEqual colKeyEqual) {
+    HashBasedTable *hashTable = (HashBasedTable *)(pool != NULL ? iPool.Alloc(pool, sizeof(HashBasedTable)) : malloc(sizeof(HashBasedTable)));
+    hashTable->pRowMap = iHashMap.CreateInPool(pool, rowKeySize, sizeof(HashMap *), rowHashCode, rowKeyEqual);
     iHashMap.SetDestructValue(hashTable->pRowMap, iHashMap.DestructPointer);
 
     hashTable->colKeySize = colKeySize;
@@ -14,13 +14,18 @@ static HashBasedTable *Create(int rowKeySize, int colKeySize, int valueSize, Has
     hashTable->colKeyEqual = colKeyEqual;
     hashTable->destructCol = NULL;
     hashTable->destructValue = NULL;
+    hashTable->pool = pool;
     return hashTable;
 }
 
+static HashBasedTable *Create(int rowKeySize, int colKeySize, int valueSize, Hashcode rowHashCode, KeyEqual rowKeyEqual, Hashcode colHashCode, KeyEqual colKeyEqual) {
+    return CreateInPool(NULL, rowKeySize, colKeySize, valueSize, rowHashCode, rowKeyEqual, colHashCode, colKeyEqual);
+}
+
 static int Put(HashBasedTable *hashTable, void *rowKey, void *colKey, void *value) {
     HashMap *pColMap, **ppColMap = iHashMap.Get(hashTable->pRowMap, rowKey);
     if (ppColMap == NULL) {
-        pColMap = iHashMap.Create(hashTable->colKeySize, hashTable->valueSize, hashTable->colHashCode, hashTable->colKeyEqual);
+        pColMap = iHashMap.CreateInPool(hashTable->pool, hashTable->colKeySize, hashTable->valueSize, hashTable->colHashCode, hashTable->colKeyEqual);
         if (hashTable->destructValue != NULL) {
             iHashMap.SetDestructValue(pColMap, hashTable->destructValue);
         }
@@ -65,12 +70,16 @@ static void Clear(HashBasedTable *hashTable) {
 }
 
 static void Finalize(HashBasedTable *hashTable) {
+    if (hashTable->pool != NULL) {
+        return;
+    }
     iHashMap.Finalize(hashTable->pRowMap);
     free(hashTable);
 }
 
 HashBasedTableInterface iHashBasedTable = {
     .Create = Create,
+    .CreateInPool = CreateInPool,
     .Put = Put,
     .Get = Get,
     .GetRow = GetRow,
@@ -4,43 +4,18 @@
 #include <string.h>
 
 #define MAXIMUM_CAPACITY 0x40000000
-#define DEFAULT_LOAD_FACTOR 0.75
-#define DEFAULT_INITIAL_CAPACITY 16
-#define TREEIFY_THRESHOLD 8
+#define DEFAULT_INITIAL_CAPACITY 8
 #define MAX_INTEGER 0x7FFFFFFF
 
-// static int numberOfLeadingZeros(int i) {
-//     // HD, Count leading 0's
-//     if (i <= 0)
-//         return i == 0 ? 32 : 0;
-//     int n = 31;
-//     if (i >= 1 << 16) {
-//         n -= 16;
-//         i = (unsigned int)i >> 16;
-//     }
-//     if (i >= 1 << 8) {
-//         n -= 8;
-//         i = (unsigned int)i >> 8;
-//     }
-//     if (i >= 1 << 4) {
-//         n -= 4;
-//         i = (unsigned int)i >> 4;
-//     }
-//     if (i >= 1 << 2) {
-//         n -= 2;
-//         i = (unsigned int)i >> 2;
-//     }
-//     return n - ((unsigned int)i >> 1);
-// }
-
-// /**
-//  * Returns a power of two size for the given target capacity.
-//  */
-// static int tableSizeFor(int cap) {
-//     int n = -1 >> numberOfLeadingZeros(cap - 1);
-//     return (n < 0) ? 1 : (n >= MAXIMUM_CAPACITY) ? MAXIMUM_CAPACITY
-//                                                  : n + 1;
-// }
+// Control bytes. A full slot stores 0x80 | (the top 7 bits of the spread hash).
+#define CTRL_EMPTY 0x00
+#define CTRL_DELETED 0x01
+#define CTRL_FULL 0x80
+
+#define SLOT(hashMap, i) ((hashMap)->slots + (size_t)(i) * (hashMap)->slotSize)
+#define SLOT_HASH(hashMap, i) (*(unsigned int *)SLOT(hashMap, i))
+#define SLOT_KEY(hashMap, i) (SLOT(hashMap, i) + (hashMap)->keyOffset)
+#define SLOT_VALUE(hashMap, i) (SLOT(hashMap, i) + (hashMap)->valueOffset)
 
 /**
  * Default hash function. Calculates the hash code of the adress of the given key.
@@ -92,355 +67,383 @@ int Size(HashMap *hashMap) {
     return hashMap->size;
 }
 
-static HashNode *newNode(unsigned int hash, void *key, int keySize, void *value, int valueSize, HashNode *next) {
-    HashNode *node = (HashNode *)malloc(sizeof(HashNode));
-    node->hash = hash;
-    char *keyCopy = (char *)malloc(keySize);
-    memcpy(keyCopy, key, keySize);
-    node->key = keyCopy;
+/**
+ * Spreads the bits of a hash code. Many keys in this project are small dense integers whose
+ * hash code is the integer itself, so the low bits (used for the slot index) and the high
+ * bits (used for the control byte tag) must both depend on the whole hash code.
+ */
+static unsigned int spread(unsigned int hash) {
+    hash *= 0x9E3779B1u;
+    return hash ^ (hash >> 15);
+}
 
-    char *valueCopy = (char *)malloc(valueSize);
-    memcpy(valueCopy, value, valueSize);
-    node->value = valueCopy;
+static unsigned char tagOf(unsigned int spreadHash) {
+    return CTRL_FULL | (spreadHash >> 25);
+}
 
-    node->next = next;
-    return node;
+/**
+ * Returns the alignment required by an inline field of the given size,
+ * i.e. the largest power of two dividing the size, capped at 8.
+ */
+static int alignmentOf(int size) {
+    int align = size & -size;
+    return (align == 0 || align > 8) ? 8 : align;
+}
+
+static int alignUp(int n, int align) {
+    return (n + align - 1) & -align;
 }
 
 /**
- * Initializes or doubles table size.  If null, allocates in
- * accord with initial capacity target held in field threshold.
- * Otherwise, because we are using power-of-two expansion, the
- * elements from each bin must either stay at same index, or move
- * with a power of two offset in the new table.
- *
- * @return The new table.
+ * Returns the smallest power-of-two table length that can hold the given number of
+ * entries without exceeding the 3/4 load factor.
  */
-static HashNode **resize(HashMap *hashMap) {
-    HashNode **oldTab = hashMap->table;
-    int oldCap = (oldTab == NULL) ? 0 : hashMap->tableLen;
-    int oldThr = hashMap->threshold;
-    int newCap, newThr = 0;
-    if (oldCap > 0) {
-        if (oldCap >= MAXIMUM_CAPACITY) {
-            hashMap->threshold = MAX_INTEGER;
-            return oldTab;
-        } else if ((newCap = oldCap << 1) < MAXIMUM_CAPACITY &&
-                   oldCap >= DEFAULT_INITIAL_CAPACITY) {
-            // double threshold
-            newThr = oldThr << 1;
-        }
-    } else if (oldThr > 0) {
-        // initial capacity was placed in threshold
-        newCap = oldThr;
-    } else {
-        // zero initial threshold signifies using defaults
-        newCap = DEFAULT_INITIAL_CAPACITY;
-        newThr = (int)(DEFAULT_LOAD_FACTOR * DEFAULT_INITIAL_CAPACITY);
+static int tableSizeFor(int entries) {
+    int cap = DEFAULT_INITIAL_CAPACITY;
+    while (cap < MAXIMUM_CAPACITY && cap - (cap >> 2) <= entries) {
+        cap <<= 1;
     }
-    if (newThr == 0) {
-        float ft = (float)newCap * hashMap->loadFactor;
-        newThr = (newCap < MAXIMUM_CAPACITY && ft < (float)MAXIMUM_CAPACITY ? (int)ft : MAX_INTEGER);
+    return cap;
+}
+
+/**
+ * Allocates memory for the hash map, from its pool if it has one.
+ */
+static void *allocMem(HashMap *hashMap, size_t size) {
+    return hashMap->pool != NULL ? iPool.Alloc(hashMap->pool, size) : malloc(size);
+}
+
+/**
+ * Frees memory of the hash map. Memory taken from a pool is only released with the pool.
+ */
+static void freeMem(HashMap *hashMap, void *ptr) {
+    if (hashMap->pool == NULL) {
+        free(ptr);
     }
-    hashMap->threshold = newThr;
-    HashNode **newTab = (HashNode **)malloc(newCap * sizeof(HashNode *));
-    memset(newTab, 0, newCap * sizeof(HashNode *));
-    hashMap->table = newTab;
-    hashMap->tableLen = newCap;
-    if (oldTab != NULL) {
-        int j;
-        for (j = 0; j < oldCap; ++j) {
-            HashNode *e;
-            if ((e = oldTab[j]) != NULL) {
-                oldTab[j] = NULL;
-                if (e->next == NULL)
-                    newTab[e->hash & (newCap - 1)] = e;
-                else { // preserve order
-                    HashNode *loHead = NULL, *loTail = NULL;
-                    HashNode *hiHead = NULL, *hiTail = NULL;
-                    HashNode *next;
-                    do {
-                        next = e->next;
-                        if ((e->hash & oldCap) == 0) {
-                            if (loTail == NULL)
-                                loHead = e;
-                            else
-                                loTail->next = e;
-                            loTail = e;
-                        } else {
-                            if (hiTail == NULL)
-                                hiHead = e;
-                            else
-                                hiTail->next = e;
-                            hiTail = e;
-                        }
-                    } while ((e = next) != NULL);
-                    if (loTail != NULL) {
-                        loTail->next = NULL;
-                        newTab[j] = loHead;
-                    }
-                    if (hiTail != NULL) {
-                        hiTail->next = NULL;
-                        newTab[j + oldCap] = hiHead;
-                    }
-                }
-            }
-        }
-        free(oldTab);
+}
+
+/**
+ * Allocates a table with the given number of slots. The control bytes and the slots share one
+ * allocation; the slot array starts right after the control bytes, which keeps it 8-byte aligned
+ * because the table length is a power of two not less than 8.
+ *
+ * @return 0 if the table is allocated, -1 otherwise
+ */
+static int allocTable(HashMap *hashMap, int cap) {
+    unsigned char *block = (unsigned char *)allocMem(hashMap, (size_t)cap + (size_t)cap * hashMap->slotSize);
+    if (block == NULL) {
+        return -1;
     }
-    return newTab;
+    memset(block, CTRL_EMPTY, cap);
+    hashMap->ctrl = block;
+    hashMap->slots = (char *)(block + cap);
+    hashMap->tableLen = cap;
+    hashMap->tombstones = 0;
+    hashMap->threshold = (cap >= MAXIMUM_CAPACITY) ? MAX_INTEGER : cap - (cap >> 2);
+    return 0;
 }
 
-static int putVal(HashMap *hashMap, unsigned int hash, void *key, void *value, int onlyIfAbsent, int evict) {
-    HashNode **tab;
-    HashNode *p;
-    int n, i;
-    if ((tab = hashMap->table) == NULL || (n = hashMap->tableLen) == 0) {
-        tab = resize(hashMap);
-        n = hashMap->tableLen;
+/**
+ * Moves every entry into a new table of the given length. Deleted slots are dropped.
+ *
+ * @return 0 if the table is rebuilt, -1 otherwise
+ */
+static int rehash(HashMap *hashMap, int newCap) {
+    unsigned char *oldCtrl = hashMap->ctrl;
+    char *oldSlots = hashMap->slots;
+    int oldCap = hashMap->tableLen;
+    if (allocTable(hashMap, newCap) != 0) {
+        return -1;
     }
-    if ((p = tab[i = (n - 1) & hash]) == NULL)
-        tab[i] = newNode(hash, key, hashMap->keySize, value, hashMap->valueSize, NULL);
-    else {
-        HashNode *e;
-        void *k;
-        if (p->hash == hash &&
-            ((k = p->key) == key || (key != NULL && hashMap->equal(key, k))))
-            e = p;
-        else {
-            int binCount;
-            for (binCount = 0;; ++binCount) {
-                if ((e = p->next) == NULL) {
-                    p->next = newNode(hash, key, hashMap->keySize, value, hashMap->valueSize, NULL);
-                    /*if (binCount >= TREEIFY_THRESHOLD - 1)
-                        //change the link list to a red-black tree
-                        treeifyBin(tab, hash);*/
-                    break;
-                }
-                if (e->hash == hash &&
-                    ((k = e->key) == key || (key != NULL && hashMap->equal(key, k))))
-                    break;
-                p = e;
-            }
+    int mask = newCap - 1;
+    int i, j;
+    unsigned int h;
+    for (i = 0; i < oldCap; i++) {
+        if (!(oldCtrl[i] & CTRL_FULL)) {
+            continue;
         }
-        if (e != NULL) {
-            // existing mapping for key
-            void *oldValue = e->value;
-            if (!onlyIfAbsent || oldValue == NULL) {
-                memcpy(e->value, value, hashMap->valueSize);
-                return 1;
-            }
-            // afterNodeAccess(e);
-            return 0;
+        char *oldSlot = oldSlots + (size_t)i * hashMap->slotSize;
+        h = spread(*(unsigned int *)oldSlot);
+        j = h & mask;
+        while (hashMap->ctrl[j] != CTRL_EMPTY) {
+            j = (j + 1) & mask;
         }
+        hashMap->ctrl[j] = oldCtrl[i];
+        memcpy(SLOT(hashMap, j), oldSlot, hashMap->slotSize);
     }
-    //++modCount;
-    if (++hashMap->size > hashMap->threshold)
-        resize(hashMap);
-    // afterNodeInsertion(evict);
+    freeMem(hashMap, oldCtrl);
     return 0;
 }
 
-static HashNode *getNode(HashMap *hashMap, void *key) {
-    HashNode **tab;
-    HashNode *first, *e;
-    int n, hash;
+/**
+ * Finds the slot holding the given key.
+ *
+ * @return The index of the slot, or -1 if the key is absent.
+ */
+static int findSlot(HashMap *hashMap, unsigned int hash, void *key) {
+    if (hashMap->size == 0) {
+        return -1;
+    }
+    unsigned int h = spread(hash);
+    unsigned char tag = tagOf(h);
+    int mask = hashMap->tableLen - 1;
+    int i = h & mask;
+    unsigned char c;
     void *k;
-    if ((tab = hashMap->table) != NULL && (n = hashMap->tableLen) > 0 &&
-        (first = tab[(n - 1) & (hash = hashMap->hashcode(key))]) != NULL) {
-        if (first->hash == hash &&
-            ((k = first->key) == key || (key != NULL && hashMap->equal(key, k))))
-            return first;
-        if ((e = first->next) != NULL) {
-            do {
-                if (e->hash == hash &&
-                    ((k = e->key) == key || (key != NULL && hashMap->equal(key, k))))
-                    return e;
-            } while ((e = e->next) != NULL);
+    while ((c = hashMap->ctrl[i]) != CTRL_EMPTY) {
+        if (c == tag && SLOT_HASH(hashMap, i) == hash &&
+            ((k = SLOT_KEY(hashMap, i)) == key || (key != NULL && hashMap->equal(key, k)))) {
+            return i;
         }
+        i = (i + 1) & mask;
     }
-    return NULL;
-}
-
-/****************************************************************************************************
- * 功能：删除节点
- * 参数：
- *      @hashMap[in]: 哈希表
- *      @hash[in]: 哈希值
- *      @key[in]: 键
- *      @value[in]: 值
- *      @matchValue[in]: 是否匹配值
- *      @movable[in]: 是否可移动
- * 返回值：
- *      1表示删除成功，0表示删除失败
- ***************************************************************************************************/
-static int removeNode(HashMap *hashMap, unsigned int hash, void *key, void *value, int matchValue, int movable) {
-    HashNode **tab;
-    HashNode *p;
-    int n, index;
-    if ((tab = hashMap->table) != NULL && (n = hashMap->tableLen) > 0 &&
-        (p = tab[index = (n - 1) & hash]) != NULL) {
-        HashNode *node = NULL, *e;
-        void *k, *v;
-        if (p->hash == hash &&
-            ((k = p->key) == key || (key != NULL && hashMap->equal(key, k))))
-            node = p;
-        else if ((e = p->next) != NULL) {
-            do {
-                if (e->hash == hash &&
-                    ((k = e->key) == key ||
-                     (key != NULL && hashMap->equal(key, k)))) {
-                    node = e;
-                    break;
-                }
-                p = e;
-            } while ((e = e->next) != NULL);
-        }
-        // 如果key与value的类型不一样，判断是否相等的方式不一样，那么可能存在bug，因为hashMap->equal函数是用来判断key是否相等的
-        if (node != NULL && (!matchValue || (v = node->value) == value ||
-                             (value != NULL && hashMap->equal(value, v)))) {
-            if (node == p)
-                tab[index] = node->next;
-            else
-                p->next = node->next;
-            //++modCount;
-            --hashMap->size;
-            // afterNodeRemoval(node);
-            if (hashMap->destructKey != NULL) {
-                hashMap->destructKey(node->key);
-            }
-            free(node->key);
-            if (hashMap->destructValue != NULL) {
-                hashMap->destructValue(node->value);
-            }
-            free(node->value);
-            free(node);
+    return -1;
+}
+
+static int putVal(HashMap *hashMap, unsigned int hash, void *key, void *value) {
+    if (hashMap->ctrl == NULL && allocTable(hashMap, DEFAULT_INITIAL_CAPACITY) != 0) {
+        fprintf(stderr, "Failed to allocate memory for hash map\n");
+        abort();
+    }
+    unsigned int h = spread(hash);
+    unsigned char tag = tagOf(h);
+    int mask = hashMap->tableLen - 1;
+    int i = h & mask, firstDeleted = -1;
+    unsigned char c;
+    void *k;
+    while ((c = hashMap->ctrl[i]) != CTRL_EMPTY) {
+        if (c == tag && SLOT_HASH(hashMap, i) == hash &&
+            ((k = SLOT_KEY(hashMap, i)) == key || (key != NULL && hashMap->equal(key, k)))) {
+            // existing mapping for key
+            memcpy(SLOT_VALUE(hashMap, i), value, hashMap->valueSize);
             return 1;
         }
+        if (c == CTRL_DELETED && firstDeleted < 0) {
+            firstDeleted = i;
+        }
+        i = (i + 1) & mask;
     }
+
+    if (firstDeleted >= 0) {
+        // reuse a deleted slot, the number of occupied slots does not change
+        i = firstDeleted;
+        hashMap->tombstones--;
+    } else if (hashMap->size + hashMap->tombstones >= hashMap->threshold) {
+        // grow the table, or only drop the deleted slots if they take up most of the room
+        int newCap = (hashMap->size + 1 > (hashMap->threshold >> 1)) ? hashMap->tableLen << 1 : hashMap->tableLen;
+        if (rehash(hashMap, newCap) != 0) {
+            fprintf(stderr, "Failed to allocate memory for hash map\n");
+            abort();
+        }
+        mask = hashMap->tableLen - 1;
+        i = h & mask;
+        while (hashMap->ctrl[i] != CTRL_EMPTY) {
+            i = (i + 1) & mask;
+        }
+    }
+    hashMap->ctrl[i] = tag;
+    SLOT_HASH(hashMap, i) = hash;
+    memcpy(SLOT_KEY(hashMap, i), key, hashMap->keySize);
+    memcpy(SLOT_VALUE(hashMap, i), value, hashMap->valueSize);
+    hashMap->size++;
     return 0;
 }
 
-static HashMap *Create(int keySize, int valueSize, Hashcode hashcode, KeyEqual keyEqual) {
-    HashMap *hashMap = (HashMap *)malloc(sizeof(HashMap));
+/**
+ * Destructs the entry stored in a slot and marks the slot as deleted. When the next slot is
+ * empty, no probe sequence passes through this slot, so it can be marked as empty directly.
+ */
+static void removeSlot(HashMap *hashMap, int i) {
+    if (hashMap->destructKey != NULL) {
+        hashMap->destructKey(SLOT_KEY(hashMap, i));
+    }
+    if (hashMap->destructValue != NULL) {
+        hashMap->destructValue(SLOT_VALUE(hashMap, i));
+    }
+    if (hashMap->ctrl[(i + 1) & (hashMap->tableLen - 1)] == CTRL_EMPTY) {
+        hashMap->ctrl[i] = CTRL_EMPTY;
+    } else {
+        hashMap->ctrl[i] = CTRL_DELETED;
+        hashMap->tombstones++;
+    }
+    hashMap->size--;
+}
+
+static HashMap *CreateInPool(Pool *pool, int keySize, int valueSize, Hashcode hashcode, KeyEqual keyEqual) {
+    HashMap *hashMap = (HashMap *)(pool != NULL ? iPool.Alloc(pool, sizeof(HashMap)) : malloc(sizeof(HashMap)));
+    int keyAlign = alignmentOf(keySize), valueAlign = alignmentOf(valueSize);
+    int slotAlign = keyAlign > valueAlign ? keyAlign : valueAlign;
+    hashMap->ctrl = NULL;
+    hashMap->slots = NULL;
+    hashMap->tableLen = 0;
     hashMap->size = 0;
+    hashMap->tombstones = 0;
+    hashMap->threshold = 0;
     hashMap->keySize = keySize;
     hashMap->valueSize = valueSize;
-    hashMap->threshold = 0;
-    hashMap->loadFactor = DEFAULT_LOAD_FACTOR;
-    hashMap->table = NULL;
+    hashMap->keyOffset = alignUp(sizeof(unsigned int), keyAlign);
+    hashMap->valueOffset = alignUp(hashMap->keyOffset + keySize, valueAlign);
+    hashMap->slotSize = alignUp(hashMap->valueOffset + valueSize, slotAlign < 4 ? 4 : slotAlign);
     hashMap->hashcode = hashcode ? hashcode : DefualtHashCode;
     hashMap->equal = keyEqual ? keyEqual : DefaultEqual;
     hashMap->keyToString = DefaultElementToString;
     hashMap->valueToString = DefaultElementToString;
     hashMap->destructKey = NULL;
     hashMap->destructValue = NULL;
+    hashMap->pool = pool;
+    return hashMap;
+}
+
+static HashMap *Create(int keySize, int valueSize, Hashcode hashcode, KeyEqual keyEqual) {
+    return CreateInPool(NULL, keySize, valueSize, hashcode, keyEqual);
+}
+
+/**
+ * Makes sure the hash map can hold the given number of entries without rebuilding its table.
+ *
+ * @param hashMap The hash map.
+ * @param capacity The number of entries.
+ * @return 0 if the room is reserved, -1 if the memory cannot be allocated.
+ */
+static int Reserve(HashMap *hashMap, int capacity) {
+    if (capacity <= 0 || (hashMap->ctrl != NULL && capacity < hashMap->threshold - hashMap->tombstones)) {
+        return 0;
+    }
+    int newCap = tableSizeFor(capacity);
+    if (hashMap->ctrl == NULL) {
+        return allocTable(hashMap, newCap);
+    }
+    return rehash(hashMap, newCap < hashMap->tableLen ? hashMap->tableLen : newCap);
+}
+
+static HashMap *CreateWithCapacity(int keySize, int valueSize, Hashcode hashcode, KeyEqual keyEqual, int capacity) {
+    HashMap *hashMap = Create(keySize, valueSize, hashcode, keyEqual);
+    Reserve(hashMap, capacity);
     return hashMap;
 }
 
 static int Put(HashMap *hashMap, void *key, void *value) {
-    return putVal(hashMap, hashMap->hashcode(key), key, value, 0, 0);
+    return putVal(hashMap, hashMap->hashcode(key), key, value);
 }
 
 static int ContainsKey(HashMap *hashMap, void *key) {
-    return getNode(hashMap, key) != NULL;
+    return hashMap->size > 0 && findSlot(hashMap, hashMap->hashcode(key), key) >= 0;
 }
 
 static void *Get(HashMap *hashMap, void *key) {
-    HashNode *e;
-    return (e = getNode(hashMap, key)) == NULL ? NULL : e->value;
+    int i;
+    if (hashMap->size == 0 || (i = findSlot(hashMap, hashMap->hashcode(key), key)) < 0) {
+        return NULL;
+    }
+    return SLOT_VALUE(hashMap, i);
 }
 
 static void *GetOrDefault(HashMap *hashMap, void *key, void *defaultValue) {
-    HashNode *e;
-    return (e = getNode(hashMap, key)) == NULL ? defaultValue : e->value;
+    void *value = Get(hashMap, key);
+    return value == NULL ? defaultValue : value;
 }
 
 static int RemoveKey(HashMap *hashMap, void *key) {
-    return removeNode(hashMap, hashMap->hashcode(key), key, NULL, 0, 1);
+    int i;
+    if (hashMap->size == 0 || (i = findSlot(hashMap, hashMap->hashcode(key), key)) < 0) {
+        return 0;
+    }
+    removeSlot(hashMap, i);
+    return 1;
 }
 
 static void Clear(HashMap *hashMap) {
-    int i = 0;
-    HashNode **tab = hashMap->table, *e, *next;
-    if (tab != NULL && hashMap->size > 0) {
-        hashMap->size = 0;
+    int i;
+    if (hashMap->ctrl == NULL) {
+        return;
+    }
+    if (hashMap->size > 0 && (hashMap->destructKey != NULL || hashMap->destructValue != NULL)) {
         for (i = 0; i < hashMap->tableLen; ++i) {
-            e = tab[i];
-            if (e != NULL) {
-                do {
-                    next = e->next;
-                    if (hashMap->destructKey != NULL) {
-                        hashMap->destructKey(e->key);
-                    }
-                    free(e->key);
-                    if (hashMap->destructValue != NULL) {
-                        hashMap->destructValue(e->value);
-                    }
-                    free(e->value);
-                    free(e);
-                    e = next;
-                } while (e != NULL);
-                tab[i] = NULL;
+            if (hashMap->ctrl[i] & CTRL_FULL) {
+                if (hashMap->destructKey != NULL) {
+                    hashMap->destructKey(SLOT_KEY(hashMap, i));
+                }
+                if (hashMap->destructValue != NULL) {
+                    hashMap->destructValue(SLOT_VALUE(hashMap, i));
+                }
             }
         }
     }
+    memset(hashMap->ctrl, CTRL_EMPTY, hashMap->tableLen);
+    hashMap->size = 0;
+    hashMap->tombstones = 0;
 }
 
 static void Finalize(HashMap *hashMap) {
-    if (hashMap == NULL) {
+    // 池中的哈希表及其值随池一并释放
+    if (hashMap == NULL || hashMap->pool != NULL) {
         return;
     }
     Clear(hashMap);
-    free(hashMap->table);
-    hashMap->table = NULL;
+    free(hashMap->ctrl);
+    hashMap->ctrl = NULL;
+    hashMap->slots = NULL;
     free(hashMap);
 }
 
+/**
+ * Moves the iterator to the first full slot at or after its index.
+ */
+static void skipEmptySlots(HashNodeIterator *it) {
+    HashMap *hashMap = it->hashMap;
+    while (it->index < hashMap->tableLen && !(hashMap->ctrl[it->index] & CTRL_FULL)) {
+        it->index++;
+    }
+}
+
 static int HasNext(HashNodeIterator *it) {
-    return it->next != NULL;
+    return it->index < it->hashMap->tableLen;
 }
 
 static void *GetNext(HashNodeIterator *it) {
-    HashNode **t;
-    HashNode *e = it->next;
-    if (e == NULL) {
+    HashMap *hashMap = it->hashMap;
+    int i = it->index;
+    if (i >= hashMap->tableLen) {
         printf("No next element\n");
         abort();
         return NULL;
     }
-    int tableLen = it->hashMap->tableLen;
-    if ((it->next = (it->current = e)->next) == NULL && (t = it->hashMap->table) != NULL) {
-        do {
-        } while (it->index < tableLen && (it->next = t[it->index++]) == NULL);
-    }
-    return e;
+    it->current = i;
+    it->node.hash = SLOT_HASH(hashMap, i);
+    it->node.key = SLOT_KEY(hashMap, i);
+    it->node.value = SLOT_VALUE(hashMap, i);
+    it->index++;
+    skipEmptySlots(it);
+    return &it->node;
 }
 
 static void RemoveCurrent(HashNodeIterator *it) {
-    HashNode *p = it->current;
-    if (p == NULL) {
+    if (it->current < 0) {
         fprintf(stderr, "Illegal state exception\n");
         abort();
     }
-    it->current = NULL;
-    removeNode(it->hashMap, p->hash, p->key, NULL, 0, 0);
+    // Removing only rewrites the control byte of the current slot, the remaining slots are not moved
+    removeSlot(it->hashMap, it->current);
+    it->current = -1;
 }
 
-static HashNodeIterator *NewIterator(HashMap *hashMap) {
-    HashNode **t = hashMap->table;
-    HashNodeIterator *it = (HashNodeIterator *)malloc(sizeof(HashNodeIterator));
+static void InitIterator(HashMap *hashMap, HashNodeIterator *it) {
     it->hashMap = hashMap;
-    it->current = NULL;
-    it->next = NULL;
+    it->current = -1;
     it->index = 0;
-    if (t != NULL && hashMap->size > 0) {
-        do {
-        } while (it->index < hashMap->tableLen && (it->next = t[it->index++]) == NULL);
+    if (hashMap->size > 0) {
+        skipEmptySlots(it);
+    } else {
+        it->index = hashMap->tableLen;
     }
     it->HasNext = HasNext;
     it->GetNext = GetNext;
     it->Remove = RemoveCurrent;
+}
+
+static HashNodeIterator *NewIterator(HashMap *hashMap) {
+    HashNodeIterator *it = (HashNodeIterator *)malloc(sizeof(HashNodeIterator));
+    InitIterator(hashMap, it);
     return it;
 }
 
@@ -481,28 +484,20 @@ static void DestructHashMapPointer(void *pHashMap) {
 }
 
 static int HashMapHashCode(HashMap *hashMap) {
-    // int hash = 1;
-    // HashNodeIterator *it = NewIterator(hashMap);
-    // HashNode *node;
-    // while (it->HasNext(it))
-    // {
-    //     node = (HashNode *)it->GetNext(it);
-    //     hash = 31 * hash + node->hash;
-    // }
-    // DeleteIterator(it);
-    // return hash;
     printf("HashMapHashCode has not been implemented\n");
     abort();
 }
 
 static int HashMapEqual(HashMap *hashMap, HashMap *hashMap2) {
-    // return hashMap->equal(hashMap, hashMap2);
     printf("HashMapEqual has not been implemented\n");
     abort();
 }
 
 HashMapInterface iHashMap = {
     .Create = Create,
+    .CreateWithCapacity = CreateWithCapacity,
+    .CreateInPool = CreateInPool,
+    .Reserve = Reserve,
     .Put = Put,
     .ContainsKey = ContainsKey,
     .Get = Get,
@@ -519,4 +514,5 @@ HashMapInterface iHashMap = {
     .SetDestructValue = SetDestructValue,
     .DestructPointer = DestructHashMapPointer,
     .NewIterator = NewIterator,
-    .DeleteIterator = DeleteIterator};
\ No newline at end of file
+    .DeleteIterator = DeleteIterator,
+    .InitIterator = InitIterator};
\ No newline at end of file
@@ -5,8 +5,19 @@
 
 static char *defaultValue = "0";
 
+/*
+ * Elements are stored as keys of a hash map whose values take no room in the slots.
+ */
 static HashSet *Create(int valueSize, Hashcode hashCode, KeyEqual keyEqual) {
-    return iHashMap.Create(valueSize, sizeof(char), hashCode, keyEqual);
+    return iHashMap.Create(valueSize, 0, hashCode, keyEqual);
+}
+
+static HashSet *CreateWithCapacity(int valueSize, Hashcode hashCode, KeyEqual keyEqual, int capacity) {
+    return iHashMap.CreateWithCapacity(valueSize, 0, hashCode, keyEqual, capacity);
+}
+
+static int Reserve(HashSet *hashSet, int capacity) {
+    return iHashMap.Reserve(hashSet, capacity);
 }
 
 static int Add(HashSet *hashSet, void *newval) {
@@ -17,20 +28,24 @@ static int Size(HashSet *hashSet) {
     return iHashMap.Size(hashSet);
 }
 
+/*
+ * Elements are the keys of the slots. The iterator advances over the slots itself and keeps no state
+ * outside the iterator, so that sets may be iterated concurrently.
+ */
 static void *GetNext(HashNodeIterator *it) {
-    HashNode **t;
-    HashNode *e = it->next;
-    if (e == NULL) {
+    HashMap *hashMap = it->hashMap;
+    int i = it->index;
+    if (i >= hashMap->tableLen) {
         printf("No next element\n");
         abort();
         return NULL;
     }
-    int tableLen = it->hashMap->tableLen;
-    if ((it->next = (it->current = e)->next) == NULL && (t = it->hashMap->table) != NULL) {
-        do {
-        } while (it->index < tableLen && (it->next = t[it->index++]) == NULL);
+    it->current = i;
+    it->node.key = hashMap->slots + (size_t)i * hashMap->slotSize + hashMap->keyOffset;
+    for (i++; i < hashMap->tableLen && !(hashMap->ctrl[i] & 0x80); i++) {
     }
-    return e->key;
+    it->index = i;
+    return it->node.key;
 }
 
 static HashSetIterator *NewIterator(HashSet *hashSet) {
@@ -39,6 +54,11 @@ static HashSetIterator *NewIterator(HashSet *hashSet) {
     return it;
 }
 
+static void InitIterator(HashSet *hashSet, HashSetIterator *it) {
+    iHashMap.InitIterator(hashSet, it);
+    it->GetNext = GetNext;
+}
+
 static HashSetIterator *DeleteIterator(HashSetIterator *it) {
     return iHashMap.DeleteIterator(it);
 }
@@ -80,26 +100,24 @@ static void Clear(HashSet *hashSet) {
 }
 
 static int containsAll(HashSet *hashSet1, HashSet *hashSet2) {
-    int ret = 1;
-    HashSetIterator *it = NewIterator(hashSet2);
-    while (it->HasNext(it)) {
-        if (!Contains(hashSet1, it->GetNext(it))) {
-            ret = 0;
-            break;
+    HASHSET_FOREACH(slot, hashSet2) {
+        if (!Contains(hashSet1, HashSetSlotElement(hashSet2, slot))) {
+            return 0;
         }
     }
-    iHashMap.DeleteIterator(it);
-    return ret;
+    return 1;
 }
 
+/**
+ * The hash code of a set is the sum of the hash codes of its elements, so that equal sets
+ * have the same hash code whatever order their elements are stored in.
+ */
 static unsigned int HashSetHashCode(void *hashSet) {
     HashSet *hs = *(HashSet **)hashSet;
-    int hash = 1;
-    HashSetIterator *it = NewIterator(hs);
-    while (it->HasNext(it)) {
-        hash = 31 * hash + hs->hashcode(it->GetNext(it));
+    unsigned int hash = 0;
+    HASHSET_FOREACH(slot, hs) {
+        hash += hs->hashcode(HashSetSlotElement(hs, slot));
     }
-    iHashMap.DeleteIterator(it);
     return hash;
 }
 
@@ -167,6 +185,8 @@ static void DestructHashSetPointer(void *pHashSet) {
 
 HashSetInterface iHashSet = {
     .Create = Create,
+    .CreateWithCapacity = CreateWithCapacity,
+    .Reserve = Reserve,
     .Add = Add,
     .Contains = Contains,
     .containsAll = containsAll,
@@ -184,4 +204,5 @@ HashSetInterface iHashSet = {
     .DestructPointer = DestructHashSetPointer,
     .NewIterator = NewIterator,
     .DeleteIterator = DeleteIterator,
+    .InitIterator = InitIterator,
 };
\ No newline at end of file
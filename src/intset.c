@@ -0,0 +1,587 @@
+#include "intSet.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define WORD_BITS INTSET_WORD_BITS
+
+/**
+ * Returns the index of the bitmap word holding the given value, rounding towards negative infinity.
+ */
+static int wordOf(int value) {
+    return value >= 0 ? value / WORD_BITS : -1 - (-(value + 1)) / WORD_BITS;
+}
+
+static int bitOf(int value) {
+    return value - wordOf(value) * WORD_BITS;
+}
+
+/**
+ * A bitmap pays off once it takes no more room than the sorted array, i.e. when every
+ * 64-bit word covers at least two elements on average. Sets that fit inline stay arrays.
+ */
+static int preferBitmap(int size, int nWords) {
+    return size > INTSET_INLINE_CAPACITY && nWords * 2 <= size;
+}
+
+static void resetStorage(IntSet *intSet) {
+    intSet->size = 0;
+    intSet->capacity = INTSET_INLINE_CAPACITY;
+    intSet->elements = intSet->inlineElements;
+    intSet->words = NULL;
+    intSet->firstWord = 0;
+    intSet->nWords = 0;
+}
+
+/**
+ * Allocates memory for the set, from its pool if it has one, and aborts if none is left.
+ */
+static void *allocOrDie(IntSet *intSet, size_t size) {
+    void *ptr = intSet->pool != NULL ? iPool.Alloc(intSet->pool, size) : malloc(size);
+    if (ptr == NULL) {
+        fprintf(stderr, "Failed to allocate memory for int set\n");
+        abort();
+    }
+    return ptr;
+}
+
+static void *callocOrDie(IntSet *intSet, size_t n, size_t size) {
+    void *ptr = allocOrDie(intSet, n * size);
+    memset(ptr, 0, n * size);
+    return ptr;
+}
+
+/**
+ * Frees memory of the set. Memory taken from a pool is only released with the pool.
+ */
+static void freeMem(IntSet *intSet, void *ptr) {
+    if (intSet->pool == NULL) {
+        free(ptr);
+    }
+}
+
+static void freeStorage(IntSet *intSet) {
+    if (intSet->elements != NULL && intSet->elements != intSet->inlineElements) {
+        freeMem(intSet, intSet->elements);
+    }
+    freeMem(intSet, intSet->words);
+}
+
+static int countBits(IntSet *intSet) {
+    int i, n = 0;
+    for (i = 0; i < intSet->nWords; i++) {
+        n += __builtin_popcountll(intSet->words[i]);
+    }
+    return n;
+}
+
+/**
+ * Returns the word of the bitmap with the given absolute word index, or 0 if it lies outside the bitmap.
+ */
+static unsigned long long wordAt(IntSet *intSet, int word) {
+    int i = word - intSet->firstWord;
+    return (i >= 0 && i < intSet->nWords) ? intSet->words[i] : 0;
+}
+
+/**
+ * Returns the position of the first element not less than the value in the sorted array.
+ */
+static int lowerBound(IntSet *intSet, int value) {
+    int lo = 0, hi = intSet->size, mid;
+    while (lo < hi) {
+        mid = (lo + hi) >> 1;
+        if (intSet->elements[mid] < value) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+/**
+ * Converts the sorted array into a bitmap covering the words [firstWord, firstWord + nWords).
+ */
+static void toBitmap(IntSet *intSet, int firstWord, int nWords) {
+    unsigned long long *words = (unsigned long long *)callocOrDie(intSet, nWords, sizeof(unsigned long long));
+    int i, value;
+    for (i = 0; i < intSet->size; i++) {
+        value = intSet->elements[i];
+        words[wordOf(value) - firstWord] |= 1ULL << bitOf(value);
+    }
+    if (intSet->elements != intSet->inlineElements) {
+        freeMem(intSet, intSet->elements);
+    }
+    intSet->elements = NULL;
+    intSet->capacity = 0;
+    intSet->words = words;
+    intSet->firstWord = firstWord;
+    intSet->nWords = nWords;
+}
+
+/**
+ * Converts the bitmap back into a sorted array.
+ */
+static void toArray(IntSet *intSet) {
+    int size = intSet->size, capacity = INTSET_INLINE_CAPACITY;
+    int *elements = intSet->inlineElements;
+    if (size > capacity) {
+        capacity = size * 2;
+        elements = (int *)allocOrDie(intSet, sizeof(int) * capacity);
+    }
+    int pos = 0, n = 0, value;
+    while (IntSetNextElement(intSet, &pos, &value)) {
+        elements[n++] = value;
+    }
+    freeMem(intSet, intSet->words);
+    intSet->words = NULL;
+    intSet->firstWord = 0;
+    intSet->nWords = 0;
+    intSet->elements = elements;
+    intSet->capacity = capacity;
+}
+
+/**
+ * Widens the bitmap so that it covers the words [firstWord, firstWord + nWords).
+ */
+static void growBitmap(IntSet *intSet, int firstWord, int nWords) {
+    unsigned long long *words = (unsigned long long *)callocOrDie(intSet, nWords, sizeof(unsigned long long));
+    memcpy(words + (intSet->firstWord - firstWord), intSet->words, sizeof(unsigned long long) * intSet->nWords);
+    freeMem(intSet, intSet->words);
+    intSet->words = words;
+    intSet->firstWord = firstWord;
+    intSet->nWords = nWords;
+}
+
+static IntSet *CreateInPool(Pool *pool) {
+    IntSet *intSet = (IntSet *)(pool != NULL ? iPool.Alloc(pool, sizeof(IntSet)) : malloc(sizeof(IntSet)));
+    if (intSet == NULL) {
+        fprintf(stderr, "Failed to allocate memory for int set\n");
+        abort();
+    }
+    resetStorage(intSet);
+    intSet->elementToString = NULL;
+    intSet->pool = pool;
+    return intSet;
+}
+
+static IntSet *Create(void) {
+    return CreateInPool(NULL);
+}
+
+static IntSet *CloneInPool(IntSet *intSet, Pool *pool) {
+    IntSet *clone = CreateInPool(pool);
+    memcpy(clone, intSet, sizeof(IntSet));
+    clone->pool = pool;
+    if (intSet->words != NULL) {
+        clone->words = (unsigned long long *)allocOrDie(clone, sizeof(unsigned long long) * intSet->nWords);
+        memcpy(clone->words, intSet->words, sizeof(unsigned long long) * intSet->nWords);
+    } else if (intSet->elements == intSet->inlineElements) {
+        clone->elements = clone->inlineElements;
+    } else {
+        clone->elements = (int *)allocOrDie(clone, sizeof(int) * intSet->capacity);
+        memcpy(clone->elements, intSet->elements, sizeof(int) * intSet->size);
+    }
+    return clone;
+}
+
+static IntSet *Clone(IntSet *intSet) {
+    return CloneInPool(intSet, NULL);
+}
+
+static int Contains(IntSet *intSet, int value) {
+    if (intSet->words != NULL) {
+        return (wordAt(intSet, wordOf(value)) >> bitOf(value)) & 1;
+    }
+    int pos = lowerBound(intSet, value);
+    return pos < intSet->size && intSet->elements[pos] == value;
+}
+
+static int Add(IntSet *intSet, int value) {
+    int w = wordOf(value);
+    if (intSet->words != NULL) {
+        int lastWord = intSet->firstWord + intSet->nWords - 1;
+        if (w < intSet->firstWord || w > lastWord) {
+            int firstWord = w < intSet->firstWord ? w : intSet->firstWord;
+            int nWords = (w > lastWord ? w : lastWord) - firstWord + 1;
+            if (!preferBitmap(intSet->size + 1, nWords)) {
+                toArray(intSet);
+                return Add(intSet, value);
+            }
+            growBitmap(intSet, firstWord, nWords);
+        }
+        unsigned long long *word = &intSet->words[w - intSet->firstWord];
+        unsigned long long mask = 1ULL << bitOf(value);
+        if (*word & mask) {
+            return 0;
+        }
+        *word |= mask;
+        intSet->size++;
+        return 1;
+    }
+
+    int pos = lowerBound(intSet, value);
+    if (pos < intSet->size && intSet->elements[pos] == value) {
+        return 0;
+    }
+    if (intSet->size == intSet->capacity) {
+        int lo = value < intSet->elements[0] ? value : intSet->elements[0];
+        int hi = value > intSet->elements[intSet->size - 1] ? value : intSet->elements[intSet->size - 1];
+        int firstWord = wordOf(lo), nWords = wordOf(hi) - firstWord + 1;
+        if (preferBitmap(intSet->size + 1, nWords)) {
+            toBitmap(intSet, firstWord, nWords);
+            intSet->words[w - firstWord] |= 1ULL << bitOf(value);
+            intSet->size++;
+            return 1;
+        }
+        int capacity = intSet->capacity * 2;
+        if (intSet->elements == intSet->inlineElements || intSet->pool != NULL) {
+            int *elements = (int *)allocOrDie(intSet, sizeof(int) * capacity);
+            memcpy(elements, intSet->elements, sizeof(int) * intSet->size);
+            intSet->elements = elements;
+        } else {
+            int *elements = (int *)realloc(intSet->elements, sizeof(int) * capacity);
+            if (elements == NULL) {
+                fprintf(stderr, "Failed to allocate memory for int set\n");
+                abort();
+            }
+            intSet->elements = elements;
+        }
+        intSet->capacity = capacity;
+    }
+    memmove(intSet->elements + pos + 1, intSet->elements + pos, sizeof(int) * (intSet->size - pos));
+    intSet->elements[pos] = value;
+    intSet->size++;
+    return 1;
+}
+
+static int Remove(IntSet *intSet, int value) {
+    if (intSet->words != NULL) {
+        int i = wordOf(value) - intSet->firstWord;
+        unsigned long long mask = 1ULL << bitOf(value);
+        if (i < 0 || i >= intSet->nWords || !(intSet->words[i] & mask)) {
+            return 0;
+        }
+        intSet->words[i] &= ~mask;
+        intSet->size--;
+        return 1;
+    }
+    int pos = lowerBound(intSet, value);
+    if (pos >= intSet->size || intSet->elements[pos] != value) {
+        return 0;
+    }
+    memmove(intSet->elements + pos, intSet->elements + pos + 1, sizeof(int) * (intSet->size - pos - 1));
+    intSet->size--;
+    return 1;
+}
+
+static int Size(IntSet *intSet) {
+    return intSet->size;
+}
+
+static void Clear(IntSet *intSet) {
+    freeStorage(intSet);
+    resetStorage(intSet);
+}
+
+static void Finalize(IntSet *intSet) {
+    // 池中的集合随池一并释放
+    if (intSet == NULL || intSet->pool != NULL) {
+        return;
+    }
+    freeStorage(intSet);
+    free(intSet);
+}
+
+static int AddAll(IntSet *intSet1, IntSet *intSet2) {
+    int before = intSet1->size;
+    if (intSet1->words != NULL && intSet2->words != NULL && intSet2->firstWord >= intSet1->firstWord &&
+        intSet2->firstWord + intSet2->nWords <= intSet1->firstWord + intSet1->nWords) {
+        int i, offset = intSet2->firstWord - intSet1->firstWord;
+        for (i = 0; i < intSet2->nWords; i++) {
+            intSet1->words[offset + i] |= intSet2->words[i];
+        }
+        intSet1->size = countBits(intSet1);
+        return intSet1->size != before;
+    }
+    int pos = 0, value;
+    while (IntSetNextElement(intSet2, &pos, &value)) {
+        Add(intSet1, value);
+    }
+    return intSet1->size != before;
+}
+
+/**
+ * Retains only the elements of the first set that are contained in the second set.
+ *
+ * @return 1 if the first set was modified, 0 otherwise
+ */
+static int RetainAll(IntSet *intSet1, IntSet *intSet2) {
+    int before = intSet1->size;
+    int i, j, n;
+    if (intSet1->words == NULL) {
+        n = 0;
+        if (intSet2->words == NULL) {
+            // merge two sorted arrays
+            for (i = 0, j = 0; i < intSet1->size && j < intSet2->size;) {
+                if (intSet1->elements[i] < intSet2->elements[j]) {
+                    i++;
+                } else if (intSet1->elements[i] > intSet2->elements[j]) {
+                    j++;
+                } else {
+                    intSet1->elements[n++] = intSet1->elements[i++];
+                    j++;
+                }
+            }
+        } else {
+            for (i = 0; i < intSet1->size; i++) {
+                if (Contains(intSet2, intSet1->elements[i])) {
+                    intSet1->elements[n++] = intSet1->elements[i];
+                }
+            }
+        }
+        intSet1->size = n;
+        return n != before;
+    }
+
+    if (intSet2->words != NULL) {
+        for (i = 0; i < intSet1->nWords; i++) {
+            intSet1->words[i] &= wordAt(intSet2, intSet1->firstWord + i);
+        }
+    } else {
+        unsigned long long *words = (unsigned long long *)callocOrDie(intSet1, intSet1->nWords, sizeof(unsigned long long));
+        int value;
+        for (i = 0; i < intSet2->size; i++) {
+            value = intSet2->elements[i];
+            if (Contains(intSet1, value)) {
+                words[wordOf(value) - intSet1->firstWord] |= 1ULL << bitOf(value);
+            }
+        }
+        freeMem(intSet1, intSet1->words);
+        intSet1->words = words;
+    }
+    intSet1->size = countBits(intSet1);
+    return intSet1->size != before;
+}
+
+/**
+ * Checks whether every element of the second set is contained in the first set.
+ */
+static int ContainsAll(IntSet *intSet1, IntSet *intSet2) {
+    if (intSet2->size > intSet1->size) {
+        return 0;
+    }
+    int i, j;
+    if (intSet1->words != NULL && intSet2->words != NULL) {
+        for (i = 0; i < intSet2->nWords; i++) {
+            if (intSet2->words[i] & ~wordAt(intSet1, intSet2->firstWord + i)) {
+                return 0;
+            }
+        }
+        return 1;
+    }
+    if (intSet1->words == NULL && intSet2->words == NULL) {
+        for (i = 0, j = 0; j < intSet2->size; j++) {
+            while (i < intSet1->size && intSet1->elements[i] < intSet2->elements[j]) {
+                i++;
+            }
+            if (i == intSet1->size || intSet1->elements[i] != intSet2->elements[j]) {
+                return 0;
+            }
+        }
+        return 1;
+    }
+    int pos = 0, value;
+    while (IntSetNextElement(intSet2, &pos, &value)) {
+        if (!Contains(intSet1, value)) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+/**
+ * Checks whether the two sets have at least one element in common.
+ */
+static int Intersects(IntSet *intSet1, IntSet *intSet2) {
+    int i, j;
+    if (intSet1->words != NULL && intSet2->words != NULL) {
+        for (i = 0; i < intSet1->nWords; i++) {
+            if (intSet1->words[i] & wordAt(intSet2, intSet1->firstWord + i)) {
+                return 1;
+            }
+        }
+        return 0;
+    }
+    if (intSet1->words == NULL && intSet2->words == NULL) {
+        for (i = 0, j = 0; i < intSet1->size && j < intSet2->size;) {
+            if (intSet1->elements[i] < intSet2->elements[j]) {
+                i++;
+            } else if (intSet1->elements[i] > intSet2->elements[j]) {
+                j++;
+            } else {
+                return 1;
+            }
+        }
+        return 0;
+    }
+    IntSet *arraySet = intSet1->words == NULL ? intSet1 : intSet2;
+    IntSet *bitmapSet = arraySet == intSet1 ? intSet2 : intSet1;
+    for (i = 0; i < arraySet->size; i++) {
+        if (Contains(bitmapSet, arraySet->elements[i])) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/**
+ * The hash code of a set is the sum of its elements, which is what a HashSet of int computes.
+ */
+static unsigned int IntSetHashCode(void *pIntSet) {
+    IntSet *intSet = *(IntSet **)pIntSet;
+    unsigned int hash = 0;
+    int pos = 0, value;
+    while (IntSetNextElement(intSet, &pos, &value)) {
+        hash += (unsigned int)value;
+    }
+    return hash;
+}
+
+static int IntSetEqual(void *pIntSet1, void *pIntSet2) {
+    if (pIntSet1 == pIntSet2) {
+        return 1;
+    }
+    IntSet *intSet1 = *(IntSet **)pIntSet1;
+    IntSet *intSet2 = *(IntSet **)pIntSet2;
+    if (intSet1->size != intSet2->size) {
+        return 0;
+    }
+    if (intSet1->words == NULL && intSet2->words == NULL) {
+        return memcmp(intSet1->elements, intSet2->elements, sizeof(int) * intSet1->size) == 0;
+    }
+    return ContainsAll(intSet1, intSet2);
+}
+
+static char *DefaultElementToString(void *pValue) {
+    char *str = (char *)malloc(32);
+    sprintf(str, "%d", *(int *)pValue);
+    return str;
+}
+
+static char *ToString(void *pIntSet) {
+    IntSet *intSet = *(IntSet **)pIntSet;
+    KeyToString elementToString = intSet->elementToString ? intSet->elementToString : DefaultElementToString;
+    char *e;
+    char *ret = (char *)malloc(3);
+    int cur = 0;
+    ret[cur++] = '[';
+    int first = 1;
+    int elementLen;
+    int pos = 0, value;
+    while (IntSetNextElement(intSet, &pos, &value)) {
+        e = elementToString(&value);
+        elementLen = strlen(e);
+        ret = (char *)realloc(ret, cur + elementLen + 4);
+        if (first) {
+            first = 0;
+        } else {
+            ret[cur++] = ',';
+            ret[cur++] = ' ';
+        }
+        memcpy(ret + cur, e, elementLen);
+        free(e);
+        cur += elementLen;
+    }
+    ret[cur++] = ']';
+    ret[cur++] = '\0';
+    return ret;
+}
+
+static KeyToString SetElementToString(IntSet *intSet, KeyToString elementToString) {
+    KeyToString oldElementToString = intSet->elementToString;
+    intSet->elementToString = elementToString;
+    return oldElementToString;
+}
+
+static void DestructIntSetPointer(void *pIntSet) {
+    Finalize(*(IntSet **)pIntSet);
+}
+
+static int HasNext(IntSetIterator *it) {
+    return it->hasNext;
+}
+
+static void *GetNext(IntSetIterator *it) {
+    if (!it->hasNext) {
+        printf("No next element\n");
+        abort();
+        return NULL;
+    }
+    it->value = it->next;
+    it->current = 0;
+    it->hasNext = IntSetNextElement(it->intSet, &it->index, &it->next);
+    return &it->value;
+}
+
+static void RemoveCurrent(IntSetIterator *it) {
+    if (it->current < 0) {
+        fprintf(stderr, "Illegal state exception\n");
+        abort();
+    }
+    if (Remove(it->intSet, it->value) && it->intSet->words == NULL) {
+        // the elements after the removed one have been shifted left
+        it->index--;
+    }
+    it->current = -1;
+}
+
+static void InitIterator(IntSet *intSet, IntSetIterator *it) {
+    it->intSet = intSet;
+    it->index = 0;
+    it->current = -1;
+    it->hasNext = IntSetNextElement(intSet, &it->index, &it->next);
+    it->HasNext = HasNext;
+    it->GetNext = GetNext;
+    it->Remove = RemoveCurrent;
+}
+
+static IntSetIterator *NewIterator(IntSet *intSet) {
+    IntSetIterator *it = (IntSetIterator *)malloc(sizeof(IntSetIterator));
+    if (it == NULL) {
+        fprintf(stderr, "Failed to allocate memory for int set iterator\n");
+        abort();
+    }
+    InitIterator(intSet, it);
+    return it;
+}
+
+static IntSetIterator *DeleteIterator(IntSetIterator *it) {
+    free(it);
+    return NULL;
+}
+
+IntSetInterface iIntSet = {
+    .Create = Create,
+    .Clone = Clone,
+    .CreateInPool = CreateInPool,
+    .CloneInPool = CloneInPool,
+    .Add = Add,
+    .AddAll = AddAll,
+    .Contains = Contains,
+    .ContainsAll = ContainsAll,
+    .Intersects = Intersects,
+    .RetainAll = RetainAll,
+    .Remove = Remove,
+    .Size = Size,
+    .Clear = Clear,
+    .Finalize = Finalize,
+    .HashCode = IntSetHashCode,
+    .Equal = IntSetEqual,
+    .ToString = ToString,
+    .SetElementToString = SetElementToString,
+    .DestructPointer = DestructIntSetPointer,
+    .NewIterator = NewIterator,
+    .DeleteIterator = DeleteIterator,
+    .InitIterator = InitIterator,
+};
\ No newline at end of file
@@ -1,14 +1,19 @@
 // #define _POSIX_C_SOURCE 199309L
+#define _GNU_SOURCE // memfd_create
 
 #include "NuSMVRunner.h"
+#include "AABACTranslator.h"
 #include "AABACUtils.h"
 #include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <poll.h>
 #include <signal.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
-#include <sys/select.h>
-#include <sys/time.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
 #include <sys/wait.h>
 #include <time.h>
 #include <unistd.h>
@@ -18,14 +23,422 @@
 #define MEMORY_OUT_MESSAGE "memory out"
 #define MEMORY_OUT_MESSAGE_LEN 10
 
+#define PROC_FD_PATH_FORMAT "/proc/%d/fd/%d"
+#define PROC_FD_PATH_LEN 36
+
+#define PATTERN_SMC_UNREACHABLE_PREFIX "-- specification "
+#define PATTERN_SMC_UNREACHABLE_PREFIX_LEN 17
+#define PATTERN_INVAR_UNREACHABLE_PREFIX "-- invariant "
+#define PATTERN_INVAR_UNREACHABLE_PREFIX_LEN 13
+#define PATTERN_SMC_UNREACHABLE_SUFFIX " is true"
+#define PATTERN_BMC_UNREACHABLE "-- no counterexample found with bound"
+#define PATTERN_BMC_UNREACHABLE_LEN 37
+#define PATTERN_COMMENT "-- "
+#define PATTERN_COMMENT_LEN 3
+#define PATTERN_LOOP_STARTS "-- Loop starts here"
+#define PATTERN_LOOP_STARTS_LEN 19
+
+#define PROMPT_NUXMV "nuXmv > "
+#define PROMPT_NUSMV "NuSMV > "
+#define PROMPT_LEN 8
+
+#define SESSION_SENTINEL "coachecker_end_of_round_"
+#define SESSION_QUIT_WAIT 1.0
+
+#define PORTFOLIO_MAX_ENGINES 4
+#define ENGINE_COMMANDS_LEN 128
+
+#define READ_BUFFER_SIZE 65536
+
+#define RESUME_MAX_LENGTHS 65536
+
+int findRule(HashMap *state, PackedTable *pTableTargetAV2Rule, AdminstrativeAction action) {
+    int attrIdx = getAttrIndex(action.attr);
+    int valIdx;
+    if(getValueIndex(getAttrType(action.attr), action.val, &valIdx) != 0) {
+        return -2;
+    }
+    IntSet **ppSetCandidateRules = (IntSet **)iPackedTable.Get(pTableTargetAV2Rule, attrIdx, valIdx);
+    if (ppSetCandidateRules != NULL) {
+        int ruleIdx;
+        IntSetIterator *itSet = iIntSet.NewIterator(*ppSetCandidateRules);
+        while (itSet->HasNext(itSet)) {
+            ruleIdx = *(int *)itSet->GetNext(itSet);
+            if (iRuleStore.CanBeManaged(pRuleStore, ruleIdx, state)) {
+                iHashMap.Put(state, &attrIdx, &valIdx);
+                iIntSet.DeleteIterator(itSet);
+                return ruleIdx;
+            }
+        }
+        iIntSet.DeleteIterator(itSet);
+    }
+    return -1;
+}
+
+/* 模型检测器输出的增量解析器，输出到达时逐行识别结论和反例轨迹 */
+typedef struct _OutputParser {
+    char *boundStr;      // 有界模型检测的上界，符号模型检测时为NULL
+    int deepestBound;    // 输出中已检查完且没有反例的最大BMC长度，尚无时为-1
+    int userIdx;         // 查询用户，即管理操作的管理员和被修改的用户
+    int code;            // 已识别出的结论，尚无结论时为AABAC_RESULT_UNKNOWN
+    int done;            // 结论和完整的反例轨迹都已读到，不必继续读取
+    int reachable;       // 是否已遇见反例轨迹中的状态
+    int waitAction;      // 之后的变量赋值行是否属于某个状态
+    int failed;          // 内存不足
+    char *sentinel;      // 会话模式下标志本轮输出结束的行，否则为NULL
+    int sentinelSeen;    // 是否已读到结束标记
+    char *attr;          // 当前状态中attr变量的取值（已去掉别名后缀）
+    char *val;           // 当前状态中val变量的取值
+    char *stepAttr;      // 上一个状态选择的管理操作的属性，该操作在当前状态中生效前为NULL之外的值
+    char *stepVal;       // 上一个状态选择的管理操作的取值
+    Vector *pVecActions; // 反例轨迹对应的管理操作序列
+    char *line;          // 跨越两次读取的不完整行
+    size_t lineLen;      // 不完整行的长度
+    size_t lineCap;      // 不完整行缓冲区的容量
+} OutputParser;
+
+static void initParser(OutputParser *parser, char *boundStr, AABACInstance *pInst) {
+    memset(parser, 0, sizeof(OutputParser));
+    parser->boundStr = boundStr;
+    parser->deepestBound = -1;
+    parser->userIdx = pInst->queryUserIdx;
+    parser->code = AABAC_RESULT_UNKNOWN;
+    parser->pVecActions = iVector.Create(sizeof(AdminstrativeAction), 10);
+}
+
+/**
+ * 判断是否不必再读取输出：单次运行时为已得出结论并读完反例轨迹，会话模式下为已读到本轮的结束标记
+ * @param parser[in]: 解析器
+ * @return 不必再读取返回1，否则返回0
+ */
+static int parserFinished(OutputParser *parser) {
+    return parser->sentinel != NULL ? parser->sentinelSeen : parser->done;
+}
+
+/**
+ * 释放解析器，丢弃已解析出的管理操作
+ * @param parser[in]: 解析器
+ */
+static void discardParser(OutputParser *parser) {
+    free(parser->line);
+    iVector.Finalize(parser->pVecActions);
+}
+
+/**
+ * 判断一行是否匹配"<prefix>.* is true"
+ * @param line[in]: 一行输出
+ * @param prefix[in]: 前缀
+ * @param prefixLen[in]: 前缀长度
+ * @return 匹配返回1，否则返回0
+ */
+static int isPropertyTrue(char *line, char *prefix, int prefixLen) {
+    char *p = line;
+    while ((p = strstr(p, prefix)) != NULL) {
+        p += prefixLen;
+        if (strstr(p, PATTERN_SMC_UNREACHABLE_SUFFIX) != NULL) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/**
+ * 解析模型检测器输出的一行
+ * @param parser[in]: 解析器
+ * @param line[in]: 不含换行符的非空行，解析时可能被修改
+ */
+static void parseLine(OutputParser *parser, char *line) {
+    // 交互模式下，提示符与其后的输出位于同一行
+    while (strncmp(line, PROMPT_NUXMV, PROMPT_LEN) == 0 || strncmp(line, PROMPT_NUSMV, PROMPT_LEN) == 0) {
+        line += PROMPT_LEN;
+    }
+    if (parser->sentinel != NULL && strcmp(strtrim(line), parser->sentinel) == 0) {
+        parser->sentinelSeen = 1;
+        return;
+    }
+    if (parser->done || *line == '\0') {
+        return;
+    }
+
+    if (parser->reachable && strncmp(line, PATTERN_COMMENT, PATTERN_COMMENT_LEN) == 0 &&
+        strncmp(line, PATTERN_LOOP_STARTS, PATTERN_LOOP_STARTS_LEN) != 0) {
+        // 反例轨迹之后的注释行说明轨迹已经结束
+        parser->done = 1;
+        return;
+    }
+
+    if (parser->boundStr != NULL && strncmp(line, PATTERN_BMC_UNREACHABLE, PATTERN_BMC_UNREACHABLE_LEN) == 0) {
+        // 有界模型检测模式下，如果直到上界bound都没有counterexample被找到，那么说明结果为unreacheable
+        char *boundStr = strtrim(line + PATTERN_BMC_UNREACHABLE_LEN), *end;
+        long bound = strtol(boundStr, &end, 10);
+        if (end != boundStr && *end == '\0' && bound > parser->deepestBound && bound <= INT_MAX) {
+            parser->deepestBound = (int)bound;
+        }
+        if (strcmp(boundStr, parser->boundStr) == 0) {
+            parser->code = AABAC_RESULT_UNREACHABLE;
+            parser->done = 1;
+        }
+        return;
+    }
+
+    // 符号模型检测、IC3和k-induction，判断LTLSPEC或INVARSPEC是否被证明，即unreachable
+    if (isPropertyTrue(line, PATTERN_SMC_UNREACHABLE_PREFIX, PATTERN_SMC_UNREACHABLE_PREFIX_LEN) ||
+        isPropertyTrue(line, PATTERN_INVAR_UNREACHABLE_PREFIX, PATTERN_INVAR_UNREACHABLE_PREFIX_LEN)) {
+        parser->code = AABAC_RESULT_UNREACHABLE;
+        parser->done = 1;
+        return;
+    }
+
+    if (strstr(line, "State:")) {
+        // 如果line中包含“State:”，意味者是目标状态是可达的。上一个状态选择的管理操作只有在当前状态中
+        // 确实修改了目标属性时才记录下来：比反例更长的BMC轨迹会用不生效或不改变状态的步骤补齐长度
+        if (parser->reachable) {
+            parser->stepAttr = parser->attr;
+            parser->stepVal = parser->val;
+        }
+        parser->reachable = 1;
+        parser->waitAction = 1;
+        return;
+    }
+
+    if (parser->waitAction) {
+        // 已遇见"State:"，所以当前line是管理操作，需要解析
+        char *p = strchr(line, '=');
+        if (p == NULL) {
+            return;
+        }
+        *(p++) = '\0';
+        char *variable = strtrim(line);
+        if (parser->stepAttr != NULL && strcmp(variable, parser->stepAttr) == 0) {
+            // 轨迹中只列出取值发生变化的变量，目标属性变为操作的取值说明该操作生效
+            if (parser->stepVal != NULL && strcmp(strtrim(p), parser->stepVal) == 0) {
+                AdminstrativeAction action = {parser->userIdx, parser->userIdx, parser->stepAttr, parser->stepVal};
+                iVector.Add(parser->pVecActions, &action);
+            }
+            parser->stepAttr = NULL;
+        } else if (strcmp(variable, "attr") == 0) {
+            parser->attr = strdup(strtrim(p));
+            parser->attr[strlen(parser->attr) - ALIAS_SUFFIX_LEN] = '\0';
+        } else if (strcmp(variable, "val") == 0) {
+            parser->val = strdup(strtrim(p));
+        }
+    }
+}
+
+/**
+ * 将新读到的一段输出交给解析器，完整的行立即解析，末尾不完整的行暂存到下一次
+ * @param parser[in]: 解析器
+ * @param data[in]: 新读到的输出，解析时会被修改
+ * @param len[in]: 输出的长度
+ */
+static void feedParser(OutputParser *parser, char *data, size_t len) {
+    char *end = data + len;
+    while (data < end && !parserFinished(parser) && !parser->failed) {
+        char *newline = (char *)memchr(data, '\n', end - data);
+        size_t segLen = (newline ? newline : end) - data;
+        if (newline != NULL && parser->lineLen == 0) {
+            // 整行都在本次读到的数据中，直接原地解析
+            *newline = '\0';
+            if (segLen > 0) {
+                parseLine(parser, data);
+            }
+        } else {
+            if (parser->lineLen + segLen + 1 > parser->lineCap) {
+                size_t newCap = (parser->lineLen + segLen + 1) * 2;
+                char *newLine = (char *)realloc(parser->line, newCap);
+                if (newLine == NULL) {
+                    parser->failed = 1;
+                    return;
+                }
+                parser->line = newLine;
+                parser->lineCap = newCap;
+            }
+            memcpy(parser->line + parser->lineLen, data, segLen);
+            parser->lineLen += segLen;
+            if (newline != NULL) {
+                parser->line[parser->lineLen] = '\0';
+                parser->lineLen = 0;
+                parseLine(parser, parser->line);
+            }
+        }
+        data += segLen + (newline != NULL);
+    }
+}
+
+/**
+ * 输出结束，解析末尾没有换行符的最后一行，并根据解析出的结论和管理操作序列生成分析结果
+ * @param parser[in]: 解析器，调用后被释放
+ * @param pInst[in]: 被验证的AABAC实例
+ * @param showRules[in]: 是否找出每个管理操作对应的规则
+ * @return 分析结果
+ */
+static AABACResult finishParser(OutputParser *parser, AABACInstance *pInst, int showRules) {
+    if (parser->lineLen > 0 && !parser->done && !parser->failed) {
+        parser->line[parser->lineLen] = '\0';
+        parseLine(parser, parser->line);
+    }
+
+    Vector *pVecActions = parser->pVecActions;
+    if (parser->failed || parser->code == AABAC_RESULT_UNREACHABLE || !parser->reachable) {
+        discardParser(parser);
+        return (AABACResult){parser->code == AABAC_RESULT_UNREACHABLE ? AABAC_RESULT_UNREACHABLE : AABAC_RESULT_ERROR, NULL, NULL};
+    }
+
+    if (showRules) {
+        HashMap *pMapState = iHashMap.Create(sizeof(int), sizeof(int), IntHashCode, IntEqual);
+        HashNode *node;
+        HashNodeIterator *itMap = iHashMap.NewIterator(iHashBasedTable.GetRow(pInst->pTableInitState, &pInst->queryUserIdx));
+        while (itMap->HasNext(itMap)) {
+            node = itMap->GetNext(itMap);
+            iHashMap.Put(pMapState, node->key, node->value);
+        }
+        iHashMap.DeleteIterator(itMap);
+
+        Vector *pVecRules = iVector.Create(sizeof(int), iVector.Size(pVecActions));
+        int i;
+        for (i = 0; i < iVector.Size(pVecActions); i++) {
+            AdminstrativeAction action = *(AdminstrativeAction *)iVector.GetElement(pVecActions, i);
+            int ruleIdx = findRule(pMapState, pInst->pTableTargetAV2Rule, action);
+            if (ruleIdx < 0) {
+                logAABAC(__func__, __LINE__, 0, ERROR, "find no corresponding rule!\n");
+            }
+            iVector.Add(pVecRules, &ruleIdx);
+        }
+        free(parser->line);
+        return (AABACResult){AABAC_RESULT_REACHABLE, pVecActions, pVecRules};
+    }
+    free(parser->line);
+    return (AABACResult){AABAC_RESULT_REACHABLE, pVecActions, NULL};
+}
+
 /**
- * 执行Linux命令，等待命令执行结束，并返回命令执行结果。如果等待至超时时间命令仍未结束，则强制杀死子进程，并返回超时错误信息。
+ * 单调时钟的当前时间
+ * @return 当前时间，单位为秒
+ */
+static double monotonicNow() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/**
+ * 打开用于保存模型检测器原始输出的结果文件
+ * @param resultFilePath[in]: 结果文件路径
+ * @return 结果文件，打开失败时返回NULL
+ */
+static FILE *openResultFile(char *resultFilePath) {
+    FILE *fp = fopen(resultFilePath, "w");
+    if (fp == NULL) {
+        logAABAC(__func__, __LINE__, errno, WARNING, "Failed to open file: %s\n", resultFilePath);
+    }
+    return fp;
+}
+
+/**
+ * 从管道读取一段输出，写入结果文件并交给解析器
+ * @param fd[in]: 输出管道的读端
+ * @param fp[in]: 结果文件，可以为NULL
+ * @param buffer[in]: 大小为READ_BUFFER_SIZE的读缓冲区
+ * @param parser[in]: 解析器
+ * @param pEndsWithNewline[out]: 已写入结果文件的输出是否以换行符结束
+ * @return 读到的字节数，0表示输出结束，-1表示读取失败
+ */
+static ssize_t readChunk(int fd, FILE *fp, char *buffer, OutputParser *parser, int *pEndsWithNewline) {
+    ssize_t bytesRead;
+    do {
+        bytesRead = read(fd, buffer, READ_BUFFER_SIZE);
+    } while (bytesRead == -1 && errno == EINTR);
+    if (bytesRead <= 0) {
+        return bytesRead;
+    }
+    if (fp != NULL) {
+        fwrite(buffer, 1, bytesRead, fp);
+    }
+    *pEndsWithNewline = buffer[bytesRead - 1] == '\n';
+    feedParser(parser, buffer, bytesRead);
+    return bytesRead;
+}
+
+/**
+ * 在结果文件末尾另起一行追加信息，如超时或内存不足
+ * @param fp[in]: 结果文件，可以为NULL
+ * @param endsWithNewline[in]: 已写入的输出是否以换行符结束
+ * @param message[in]: 信息
+ */
+static void appendMessage(FILE *fp, int endsWithNewline, char *message) {
+    if (fp != NULL) {
+        fprintf(fp, "%s%s\n", endsWithNewline ? "" : "\n", message);
+    }
+}
+
+/**
+ * 读取模型检测器的输出并在到达时解析，同时写入结果文件，直到不必再读取、输出结束或超过截止时间。
+ * 超时或内存不足时，在结果文件末尾追加相应的信息。
+ * @param fd[in]: 输出管道的读端
+ * @param fp[in]: 结果文件，可以为NULL
+ * @param deadline[in]: 截止时间，即单调时钟的秒数
+ * @param parser[in]: 解析器
+ * @return 0表示不必再读取或输出已结束，AABAC_RESULT_TIMEOUT表示超时，-1表示内存不足或读取失败
+ */
+static int readOutput(int fd, FILE *fp, double deadline, OutputParser *parser) {
+    char *buffer = (char *)malloc(READ_BUFFER_SIZE);
+    struct pollfd pfd = {fd, POLLIN, 0};
+    int timedOut = 0, readFailed = 0, endsWithNewline = 1;
+    ssize_t bytesRead;
+    if (buffer == NULL) {
+        parser->failed = 1;
+    }
+    while (!parserFinished(parser) && !parser->failed) {
+        double remaining = deadline - monotonicNow();
+        if (remaining <= 0) {
+            timedOut = 1;
+            break;
+        }
+        int ret = poll(&pfd, 1, (int)(remaining * 1000) + 1);
+        if (ret == -1) {
+            if (errno == EINTR) {
+                continue;
+            }
+            logAABAC(__func__, __LINE__, errno, ERROR, "Poll failed\n");
+            readFailed = 1;
+            break;
+        } else if (ret == 0) {
+            continue;
+        }
+        bytesRead = readChunk(fd, fp, buffer, parser, &endsWithNewline);
+        if (bytesRead == -1) {
+            logAABAC(__func__, __LINE__, errno, ERROR, "Failed to read the output of the model checker\n");
+            readFailed = 1;
+            break;
+        } else if (bytesRead == 0) {
+            break;
+        }
+    }
+    free(buffer);
+
+    if (parser->failed) {
+        logAABAC(__func__, __LINE__, 0, ERROR, "Failed to allocate memory\n");
+        appendMessage(fp, endsWithNewline, MEMORY_OUT_MESSAGE);
+        return -1;
+    }
+    if (timedOut) {
+        logAABAC(__func__, __LINE__, 0, WARNING, "Command execution timed out\n");
+        appendMessage(fp, endsWithNewline, TIMEOUT_MESSAGE);
+        return AABAC_RESULT_TIMEOUT;
+    }
+    // 输出不完整，不能当作已结束的输出解析
+    return readFailed ? -1 : 0;
+}
+
+/**
+ * 启动子进程执行命令，子进程的标准输出和标准错误重定向到管道
  * @param cmdPath[in]: 命令路径
  * @param args[in]: 命令参数
- * @param timeout[in]: 超时时间
- * @return 命令执行结果
+ * @param cpuLimit[in]: 子进程可使用的CPU时间，单位为秒，0表示不限制
+ * @param pOutFd[out]: 管道的读端
+ * @return 子进程号，失败时返回-1
  */
-static char *run(char *cmdPath, char *args[], char *resultFilePath, long timeout) {
+static pid_t spawn(char *cmdPath, char *args[], long cpuLimit, int *pOutFd) {
     int i = 1;
     char *cmd = (char *)malloc(strlen(args[0]) + 1);
     strcpy(cmd, args[0]);
@@ -41,7 +454,7 @@ static char *run(char *cmdPath, char *args[], char *resultFilePath, long timeout
     int pipefd[2];
     if (pipe(pipefd) == -1) {
         logAABAC(__func__, __LINE__, errno, ERROR, "Failed to create pipe\n");
-        return NULL;
+        return -1;
     }
 
     pid_t pid = fork();
@@ -49,7 +462,7 @@ static char *run(char *cmdPath, char *args[], char *resultFilePath, long timeout
         logAABAC(__func__, __LINE__, errno, ERROR, "Failed to fork");
         close(pipefd[0]);
         close(pipefd[1]);
-        return NULL;
+        return -1;
     }
 
     if (pid == 0) {                     // Child process
@@ -58,6 +471,10 @@ static char *run(char *cmdPath, char *args[], char *resultFilePath, long timeout
         dup2(pipefd[1], STDERR_FILENO); // Redirect stderr to pipe
         close(pipefd[1]);
 
+        if (cpuLimit > 0) {
+            struct rlimit limit = {(rlim_t)cpuLimit, (rlim_t)cpuLimit};
+            setrlimit(RLIMIT_CPU, &limit);
+        }
         execv(cmdPath, args);
         // If execv returns, it means there was an error
         logAABAC(__func__, __LINE__, errno, ERROR, "Failed to execute command\n");
@@ -66,262 +483,882 @@ static char *run(char *cmdPath, char *args[], char *resultFilePath, long timeout
 
     // Parent process
     close(pipefd[1]); // Close write end
+    fcntl(pipefd[0], F_SETFD, FD_CLOEXEC);
+    *pOutFd = pipefd[0];
+    return pid;
+}
 
-    // Read output with timeout
-    char *output = NULL;
-    size_t output_size = 0;
-    char buffer[4096];
-    ssize_t bytes_read;
-    time_t start_time = time(NULL);
-
-    while ((time(NULL) - start_time) < timeout) {
-        fd_set read_fds;
-        struct timeval tv;
-        FD_ZERO(&read_fds);
-        FD_SET(pipefd[0], &read_fds);
-        tv.tv_sec = 1;
-        tv.tv_usec = 0;
-
-        int ret = select(pipefd[0] + 1, &read_fds, NULL, NULL, &tv);
-        if (ret == -1) {
-            logAABAC(__func__, __LINE__, errno, ERROR, "Select failed\n");
-            break;
-        } else if (ret == 0) {
-            // Timeout in select, check if process is still running
-            if (waitpid(pid, NULL, WNOHANG) != 0) {
-                break; // Process has finished
-            }
-            continue;
-        }
+/**
+ * 执行模型检测器，在输出到达时逐行解析，同时将原始输出写入结果文件。一旦得出结论并读完反例轨迹，立即停止读取并结束子进程；
+ * 如果等待至超时时间仍未得出结论，则强制杀死子进程，并返回超时。
+ * @param cmdPath[in]: 命令路径
+ * @param args[in]: 命令参数
+ * @param resultFilePath[in]: 结果文件路径
+ * @param timeout[in]: 超时时间，单位为秒，可以不是整数
+ * @param parser[in]: 解析器
+ * @return 0表示正常结束，-1表示执行失败，AABAC_RESULT_TIMEOUT表示超时
+ */
+static int run(char *cmdPath, char *args[], char *resultFilePath, double timeout, OutputParser *parser) {
+    double deadline = monotonicNow() + timeout;
+    int outFd;
+    pid_t pid = spawn(cmdPath, args, 0, &outFd);
+    if (pid == -1) {
+        return -1;
+    }
+
+    FILE *fp = openResultFile(resultFilePath);
+    int ret = readOutput(outFd, fp, deadline, parser);
+    close(outFd);
 
-        bytes_read = read(pipefd[0], buffer, sizeof(buffer) - 1);
-        if (bytes_read <= 0) {
+    int status;
+    if (ret != 0) {
+        kill(pid, SIGKILL);
+        waitpid(pid, NULL, 0);
+    } else if (parser->done) {
+        // 结论及其反例路径已经读完，之后的输出不再需要
+        kill(pid, SIGKILL);
+        waitpid(pid, &status, 0);
+        logAABAC(__func__, __LINE__, 0, INFO, "verdict read, model checker stopped\n");
+    } else {
+        // Wait for child process to finish
+        waitpid(pid, &status, 0);
+        logAABAC(__func__, __LINE__, 0, INFO, "exit value: %d\n", status);
+    }
+    if (fp != NULL) {
+        fclose(fp);
+    }
+    return ret;
+}
+
+int createModelMemFile(char *name, char **pPath) {
+    // 模型检测器通过/proc/<pid>/fd/<fd>重新打开同一个内存文件，这对之后创建的子进程和已经在运行的会话进程都有效
+    int fd = memfd_create(name, MFD_CLOEXEC);
+    if (fd == -1) {
+        logAABAC(__func__, __LINE__, errno, WARNING, "Failed to create the in-memory file for the nusmv model\n");
+        return -1;
+    }
+    *pPath = (char *)malloc(PROC_FD_PATH_LEN);
+    sprintf(*pPath, PROC_FD_PATH_FORMAT, (int)getpid(), fd);
+    return fd;
+}
+
+int saveModelMemFile(int fd, char *filePath) {
+    FILE *fp = fopen(filePath, "w");
+    if (fp == NULL) {
+        logAABAC(__func__, __LINE__, errno, ERROR, "Failed to open file: %s\n", filePath);
+        return -1;
+    }
+    char buffer[1 << 16];
+    ssize_t n;
+    off_t offset = 0;
+    int failed = 0;
+    while ((n = pread(fd, buffer, sizeof(buffer), offset)) > 0) {
+        if (fwrite(buffer, 1, n, fp) != (size_t)n) {
+            failed = 1;
             break;
         }
+        offset += n;
+    }
+    if (fclose(fp) != 0 || n < 0 || failed) {
+        logAABAC(__func__, __LINE__, errno, ERROR, "Failed to write file: %s\n", filePath);
+        return -1;
+    }
+    return 0;
+}
 
-        buffer[bytes_read] = '\0';
-        char *new_output = realloc(output, output_size + bytes_read + 1);
-        if (new_output == NULL) {
-            logAABAC(__func__, __LINE__, errno, ERROR, "Failed to allocate memory\n");
-            close(pipefd[0]);
-            kill(pid, SIGKILL);
-            waitpid(pid, NULL, 0);
-            if (output) {
-                free(output);
-            }
-            FILE *fp = fopen(resultFilePath, "w");
-            fprintf(fp, "%s\n", MEMORY_OUT_MESSAGE);
-            fclose(fp);
+/* 一个引擎，即以某种配置运行模型检测器的一个子进程 */
+typedef struct _Engine {
+    char *name;                // 引擎名，也用于区分各引擎的结果文件
+    char *args[6];             // 命令参数
+    char *bound;               // 交给解析器的有界模型检测上界，其他引擎为NULL
+    int unreachableConclusive; // 该引擎给出的"unreachable"是否为最终结论
+    pid_t pid;                 // 子进程号，未运行时为0
+    int fd;                    // 输出管道的读端
+    FILE *fp;                  // 结果文件
+    int endsWithNewline;       // 已写入结果文件的输出是否以换行符结束
+    OutputParser parser;       // 解析器
+    int scriptFd;              // 通过-source执行的命令脚本所在的内存文件，不需要脚本时为-1
+    char *scriptPath;          // 命令脚本的路径
+} Engine;
 
-            output = (char *)malloc(MEMORY_OUT_MESSAGE_LEN + 2);
-            sprintf(output, "%s\n", MEMORY_OUT_MESSAGE);
-            return output;
-        }
-        output = new_output;
-        strcpy(output + output_size, buffer);
-        output_size += bytes_read;
+static char *engineNames[] = {"bmc", "smc", "ic3", "kind", "bmc_length"};
+
+/**
+ * 写入以指定引擎检查已读入模型的交互命令
+ * @param buf[out]: 命令缓冲区，长度至少为ENGINE_COMMANDS_LEN
+ * @param engine[in]: 引擎，MC_ENGINE_*之一
+ * @param invarSpec[in]: 模型中的查询是否为INVARSPEC
+ * @param bound[in]: BMC和k-induction的上界，为NULL时使用模型检测器的默认值
+ */
+static void engineCommands(char *buf, int engine, int invarSpec, char *bound) {
+    char boundOption[24] = "";
+    if (bound != NULL) {
+        sprintf(boundOption, " -k %s", bound);
     }
+    switch (engine) {
+    case MC_ENGINE_BMC:
+        sprintf(buf, invarSpec ? "go_bmc\ncheck_invar_bmc_inc -a falsification%s\n" : "go_bmc\ncheck_ltlspec_bmc%s\n", boundOption);
+        break;
+    case MC_ENGINE_IC3:
+        strcpy(buf, invarSpec ? "go_bmc\ncheck_invar_ic3\n" : "go_bmc\ncheck_ltlspec_ic3\n");
+        break;
+    case MC_ENGINE_KIND:
+        sprintf(buf, "go_bmc\ncheck_invar_bmc -a een-sorensson%s\n", boundOption);
+        break;
+    case MC_ENGINE_BMC_LENGTH:
+        // 不变式没有只检查单一长度的命令，使用增量的falsification
+        sprintf(buf, invarSpec ? "go_bmc\ncheck_invar_bmc_inc -a falsification%s\n" : "go_bmc\ncheck_ltlspec_bmc_onepb -l X%s\n", boundOption);
+        break;
+    default:
+        strcpy(buf, invarSpec ? "go\ncheck_invar\n" : "go\ncheck_ltlspec\n");
+    }
+}
 
-    close(pipefd[0]);
+/* BMC进度文件，每行为"<模型指纹> <已检查完且没有反例的最大长度>" */
+static char *progressRecordPath = NULL; // BMC超时时追加进度的文件，为NULL时不记录
+static char *progressResumePath = NULL; // 恢复BMC时读取进度的文件，为NULL时不恢复
 
-    // Check if we timed out
-    if ((time(NULL) - start_time) >= timeout) {
-        logAABAC(__func__, __LINE__, 0, WARNING, "Command execution timed out\n");
-        kill(pid, SIGKILL);
-        waitpid(pid, NULL, 0);
-        char *newOutput = output ? (char *)malloc(output_size + TIMEOUT_MESSAGE_LEN + 2) : (char *)malloc(TIMEOUT_MESSAGE_LEN + 2);
-        sprintf(newOutput, "%s\n%s", TIMEOUT_MESSAGE, output ? output : "");
-        if (output) {
-            free(output);
+void setBMCProgressFiles(char *recordPath, char *resumePath) {
+    progressRecordPath = recordPath;
+    progressResumePath = resumePath;
+}
+
+/**
+ * 计算模型内容的指纹(64位FNV-1a)，只有内容完全相同的模型才能共享BMC进度
+ * @param nusmvFilePath[in]: NuSMV模型路径
+ * @return 指纹，无法读取模型时返回0
+ */
+static unsigned long long fingerprintModel(char *nusmvFilePath) {
+    FILE *fp = fopen(nusmvFilePath, "rb");
+    if (fp == NULL) {
+        logAABAC(__func__, __LINE__, errno, WARNING, "cannot read %s to fingerprint it\n", nusmvFilePath);
+        return 0;
+    }
+    unsigned long long hash = 14695981039346656037ULL;
+    unsigned char buf[READ_BUFFER_SIZE / 4];
+    size_t n, i;
+    while ((n = fread(buf, 1, sizeof(buf), fp)) > 0) {
+        for (i = 0; i < n; i++) {
+            hash = (hash ^ buf[i]) * 1099511628211ULL;
         }
-        FILE *fp = fopen(resultFilePath, "w");
-        fputs(newOutput, fp);
-        fclose(fp);
-        return newOutput;
     }
+    fclose(fp);
+    return hash == 0 ? 1 : hash;
+}
 
-    // Wait for child process to finish
-    int status;
-    waitpid(pid, &status, 0);
-    logAABAC(__func__, __LINE__, 0, INFO, "exit value: %d\n", status);
+int loadBMCProgress(char *path, unsigned long long fingerprint) {
+    FILE *fp = fopen(path, "r");
+    if (fp == NULL) {
+        logAABAC(__func__, __LINE__, errno, WARNING, "cannot open bmc progress file %s\n", path);
+        return -1;
+    }
+    unsigned long long key;
+    int depth, deepest = -1;
+    while (fscanf(fp, "%llx %d", &key, &depth) == 2) {
+        if (key == fingerprint && depth > deepest) {
+            deepest = depth;
+        }
+    }
+    fclose(fp);
+    return deepest;
+}
 
-    // if (WIFEXITED(status) && WEXITSTATUS(status) != 0) {
-    //     logAABAC(__func__, __LINE__, 0, ERROR, "Command execution failed");
-    //     if (output) {
-    //         free(output);
-    //     }
-    //     return strdup("Command execution failed");
-    // }
+int saveBMCProgress(char *path, unsigned long long fingerprint, int depth) {
+    FILE *fp = fopen(path, "a");
+    int failed = fp == NULL || fprintf(fp, "%016llx %d\n", fingerprint, depth) < 0;
+    if (fp != NULL && fclose(fp) != 0) {
+        failed = 1;
+    }
+    if (failed) {
+        logAABAC(__func__, __LINE__, errno, WARNING, "cannot record bmc progress in %s\n", path);
+        return -1;
+    }
+    logAABAC(__func__, __LINE__, 0, INFO, "bmc checked up to length %d before the timeout, recorded in %s\n", depth, path);
+    return 0;
+}
 
-    FILE *fp = fopen(resultFilePath, "w");
-    if (output) {
-        fprintf(fp, "%s", output);
+/**
+ * 生成从指定长度继续BMC的交互命令：依次对from到bound的每个长度单独求解，与普通BMC逐个长度检查的过程相同，
+ * 只是跳过了已检查完的长度。长度过多时，超出RESUME_MAX_LENGTHS的部分合并为对上界的一次求解
+ * @param from[in]: 第一个长度
+ * @param bound[in]: 上界
+ * @return 命令，由调用者释放
+ */
+static char *resumeCommands(int from, char *bound) {
+    int last = atoi(bound), i;
+    if (from > last) {
+        from = last;
     }
-    fclose(fp);
+    int n = last - from + 1 > RESUME_MAX_LENGTHS ? RESUME_MAX_LENGTHS : last - from + 1;
+    char *commands = (char *)malloc((size_t)(n + 2) * 48);
+    if (commands == NULL) {
+        return NULL;
+    }
+    char *p = commands + sprintf(commands, "go_bmc\n");
+    for (i = 0; i < n; i++) {
+        p += sprintf(p, "check_ltlspec_bmc_onepb -l X -k %d\n", from + i);
+    }
+    if (from + n - 1 < last) {
+        // 没有环的长度bound的路径包含了所有更短的反例
+        sprintf(p, "check_ltlspec_bmc_onepb -l X -k %d\n", last);
+    }
+    return commands;
+}
 
-    return output ? output : strdup("");
+/* 一次BMC运行的进度记录状态 */
+typedef struct _BMCProgress {
+    int tracked;                     // 该次运行是否记录或恢复进度，只有LTLSPEC上带上界的BMC才会
+    unsigned long long fingerprint;  // 模型指纹，尚未计算时为0
+    int resumed;                     // 恢复前已检查完的最大长度，未恢复时为-1
+} BMCProgress;
+
+/**
+ * 判断BMC是否需要记录或恢复进度，恢复时计算模型指纹，并生成跳过已检查长度的命令。
+ * 只记录进度时不计算指纹，超时后才在recordProgress中计算
+ * @param engine[in]: 引擎，MC_ENGINE_*之一
+ * @param invarSpec[in]: 模型中的查询是否为INVARSPEC
+ * @param nusmvFilePath[in]: NuSMV模型路径
+ * @param bound[in]: 上界
+ * @param progress[out]: 进度记录状态
+ * @return 恢复时的命令，由调用者释放；不恢复时为NULL
+ */
+static char *prepareResume(int engine, int invarSpec, char *nusmvFilePath, char *bound, BMCProgress *progress) {
+    // 不变式没有逐个长度单独求解的命令，只记录和恢复LTLSPEC上的BMC
+    progress->tracked = engine == MC_ENGINE_BMC && !invarSpec && bound != NULL && (progressRecordPath != NULL || progressResumePath != NULL);
+    progress->fingerprint = 0;
+    progress->resumed = -1;
+    if (!progress->tracked || progressResumePath == NULL) {
+        return NULL;
+    }
+    progress->fingerprint = fingerprintModel(nusmvFilePath);
+    if (progress->fingerprint == 0) {
+        return NULL;
+    }
+    progress->resumed = loadBMCProgress(progressResumePath, progress->fingerprint);
+    if (progress->resumed < 0) {
+        return NULL;
+    }
+    logAABAC(__func__, __LINE__, 0, INFO, "resuming bmc of model %016llx after length %d\n", progress->fingerprint, progress->resumed);
+    return resumeCommands(progress->resumed + 1, bound);
 }
 
-char *runModelChecker(char *modelCheckerPath, char *nusmvFilePath, char *resultFilePath, long timeout, char *bound) {
-    int bmc;
-    char *args[6];
-    if (bound == NULL) {
-        logAABAC(__func__, __LINE__, 0, INFO, "[start] running model checker on smc mode\n");
-        bmc = 0;
-        args[0] = modelCheckerPath;
-        args[1] = nusmvFilePath;
-        args[2] = NULL;
+/**
+ * BMC超时时记录已检查完的最大长度，恢复运行时至少为恢复前的长度。尚未计算模型指纹时在此计算
+ * @param parser[in]: 解析器
+ * @param ret[in]: 运行结果
+ * @param nusmvFilePath[in]: NuSMV模型路径
+ * @param progress[in]: 进度记录状态
+ */
+static void recordProgress(OutputParser *parser, int ret, char *nusmvFilePath, BMCProgress *progress) {
+    int depth = parser->deepestBound > progress->resumed ? parser->deepestBound : progress->resumed;
+    if (ret != AABAC_RESULT_TIMEOUT || !progress->tracked || progressRecordPath == NULL || depth < 0) {
+        return;
+    }
+    if (progress->fingerprint == 0) {
+        progress->fingerprint = fingerprintModel(nusmvFilePath);
+    }
+    if (progress->fingerprint != 0) {
+        saveBMCProgress(progressRecordPath, progress->fingerprint, depth);
+    }
+}
+
+/**
+ * 将命令写入内存文件，供模型检测器通过-source选项或source命令执行
+ * @param name[in]: 内存文件名
+ * @param commands[in]: 命令
+ * @param trailer[in]: 追加在命令之后的内容
+ * @param path[out]: 内存文件的路径，由调用者释放
+ * @return 内存文件的描述符，失败时返回-1
+ */
+static int createScriptFile(char *name, char *commands, char *trailer, char **path) {
+    int fd = createModelMemFile(name, path);
+    if (fd < 0) {
+        return -1;
+    }
+    size_t len = strlen(commands), trailerLen = strlen(trailer);
+    if (write(fd, commands, len) != (ssize_t)len || write(fd, trailer, trailerLen) != (ssize_t)trailerLen) {
+        logAABAC(__func__, __LINE__, errno, ERROR, "Failed to write the script %s\n", name);
+        close(fd);
+        free(*path);
+        return -1;
+    }
+    return fd;
+}
+
+/**
+ * 准备以指定引擎运行模型检测器的命令参数。BDD以及LTLSPEC上的BMC直接使用批处理模式，
+ * 其余引擎的命令写入内存文件，通过-source执行
+ * @param e[out]: 引擎
+ * @param engine[in]: 引擎，MC_ENGINE_*之一
+ * @param invarSpec[in]: 模型中的查询是否为INVARSPEC
+ * @param modelCheckerPath[in]: 模型检测器路径
+ * @param nusmvFilePath[in]: NuSMV模型路径
+ * @param bound[in]: BMC和k-induction的上界，可以为NULL
+ * @param boundConclusive[in]: BMC在上界内找不到反例时能否断定unreachable
+ * @param commands[in]: 代替引擎默认命令通过-source执行的命令，如恢复BMC的命令，可以为NULL
+ * @return 0表示成功，-1表示无法创建命令脚本
+ */
+static int prepareEngine(Engine *e, int engine, int invarSpec, char *modelCheckerPath, char *nusmvFilePath, char *bound, int boundConclusive,
+                         char *commands) {
+    memset(e, 0, sizeof(Engine));
+    e->name = engineNames[engine];
+    e->bound = engine == MC_ENGINE_BMC || engine == MC_ENGINE_BMC_LENGTH ? bound : NULL;
+    e->unreachableConclusive = e->bound == NULL || boundConclusive;
+    e->scriptFd = -1;
+    e->args[0] = modelCheckerPath;
+    if (engine == MC_ENGINE_BDD) {
+        e->args[1] = nusmvFilePath;
+        return 0;
+    }
+    if (engine == MC_ENGINE_BMC && !invarSpec && bound != NULL && commands == NULL) {
+        e->args[1] = "-bmc";
+        e->args[2] = "-bmc_length";
+        e->args[3] = bound;
+        e->args[4] = nusmvFilePath;
+        return 0;
+    }
+
+    char defaultCommands[ENGINE_COMMANDS_LEN];
+    if (commands == NULL) {
+        engineCommands(defaultCommands, engine, invarSpec, bound);
+        commands = defaultCommands;
+    }
+    e->scriptFd = createScriptFile(e->name, commands, "quit\n", &e->scriptPath);
+    if (e->scriptFd < 0) {
+        return -1;
+    }
+    e->args[1] = "-source";
+    e->args[2] = e->scriptPath;
+    e->args[3] = nusmvFilePath;
+    return 0;
+}
+
+/**
+ * 释放引擎的命令脚本
+ * @param e[in]: 引擎
+ */
+static void releaseEngine(Engine *e) {
+    if (e->scriptFd >= 0) {
+        close(e->scriptFd);
+        free(e->scriptPath);
+        e->scriptFd = -1;
+    }
+}
+
+AABACResult runModelChecker(char *modelCheckerPath, char *nusmvFilePath, char *resultFilePath, double timeout, int engine, int invarSpec,
+                            char *bound, AABACInstance *pInst, int showRules) {
+    BMCProgress progress;
+    char *commands = prepareResume(engine, invarSpec, nusmvFilePath, bound, &progress);
+    Engine e;
+    int prepared = prepareEngine(&e, engine, invarSpec, modelCheckerPath, nusmvFilePath, bound, 1, commands);
+    free(commands);
+    if (prepared != 0) {
+        return (AABACResult){AABAC_RESULT_ERROR, NULL, NULL};
+    }
+    if (bound != NULL && engine != MC_ENGINE_BDD && engine != MC_ENGINE_IC3) {
+        logAABAC(__func__, __LINE__, 0, INFO, "[start] running model checker on %s mode, the bound is set to %s\n", e.name, bound);
     } else {
-        logAABAC(__func__, __LINE__, 0, INFO, "[start] running model checker on bmc mode, the bound is set to %s\n", bound);
-        bmc = 1;
-        args[0] = modelCheckerPath;
-        args[1] = "-bmc";
-        args[2] = "-bmc_length";
-        args[3] = bound;
-        args[4] = nusmvFilePath;
-        args[5] = NULL;
+        logAABAC(__func__, __LINE__, 0, INFO, "[start] running model checker on %s mode\n", e.name);
     }
-    clock_t startRun = clock();
+    double startRun = monotonicNow();
+
+    OutputParser parser;
+    initParser(&parser, e.bound, pInst);
+    int ret = run(modelCheckerPath, e.args, resultFilePath, timeout, &parser);
+    releaseEngine(&e);
+    recordProgress(&parser, ret, nusmvFilePath, &progress);
 
-    char *result = run(modelCheckerPath, args, resultFilePath, timeout);
+    double spentTime = (monotonicNow() - startRun) * 1000;
+    logAABAC(__func__, __LINE__, 0, INFO, "[end] running model checker on %s mode, cost => %.2fms\n", e.name, spentTime);
 
-    double spentTime = (clock() - startRun) / CLOCKS_PER_SEC * 1000;
-    logAABAC(__func__, __LINE__, 0, INFO, "[end] running model checker on %s mode, cost => %.2fms\n", bmc ? "bmc" : "smc", spentTime);
+    if (ret != 0) {
+        parser.failed = 1;
+    }
+    AABACResult result = finishParser(&parser, pInst, showRules);
+    if (ret == AABAC_RESULT_TIMEOUT) {
+        result.code = AABAC_RESULT_TIMEOUT;
+    }
     return result;
 }
 
-#include "AABACTranslator.h"
-#include <regex.h>
+/**
+ * 在结果文件路径的后缀前插入引擎名，如smvOutput0.txt变为smvOutput0.smc.txt
+ * @param resultFilePath[in]: 结果文件路径
+ * @param engineName[in]: 引擎名
+ * @return 引擎的结果文件路径，由调用者释放
+ */
+static char *engineResultFilePath(char *resultFilePath, char *engineName) {
+    char *dot = strrchr(resultFilePath, '.');
+    char *slash = strrchr(resultFilePath, '/');
+    int stemLen = (dot != NULL && (slash == NULL || dot > slash)) ? (int)(dot - resultFilePath) : (int)strlen(resultFilePath);
+    char *path = (char *)malloc(strlen(resultFilePath) + strlen(engineName) + 2);
+    sprintf(path, "%.*s.%s%s", stemLen, resultFilePath, engineName, resultFilePath + stemLen);
+    return path;
+}
 
-#define PATTERN_SMC_UNREACHABLE "-- specification .* is true"
-#define PATTERN_BMC_UNREACHABLE "-- no counterexample found with bound"
-#define PATTERN_BMC_UNREACHABLE_LEN 37
+/**
+ * 启动引擎
+ * @param engine[in]: 引擎
+ * @param modelCheckerPath[in]: 模型检测器路径
+ * @param resultFilePath[in]: 结果文件路径
+ * @param cpuLimit[in]: 引擎可使用的CPU时间，单位为秒，0表示不限制
+ * @param pInst[in]: 被验证的AABAC实例
+ * @return 0表示启动成功，-1表示失败
+ */
+static int startEngine(Engine *engine, char *modelCheckerPath, char *resultFilePath, long cpuLimit, AABACInstance *pInst) {
+    engine->pid = spawn(modelCheckerPath, engine->args, cpuLimit, &engine->fd);
+    if (engine->pid == -1) {
+        engine->pid = 0;
+        return -1;
+    }
+    char *path = engineResultFilePath(resultFilePath, engine->name);
+    engine->fp = openResultFile(path);
+    free(path);
+    engine->endsWithNewline = 1;
+    initParser(&engine->parser, engine->bound, pInst);
+    return 0;
+}
 
-int findRule(HashMap *state, HashBasedTable *pTableTargetAV2Rule, AdminstrativeAction action) {
-    int attrIdx = getAttrIndex(action.attr);
-    int valIdx;
-    if(getValueIndex(getAttrType(action.attr), action.val, &valIdx) != 0) {
-        return -2;
+/**
+ * 结束引擎的子进程，并关闭其输出管道和结果文件
+ * @param engine[in]: 引擎
+ * @param message[in]: 追加到结果文件末尾的信息，可以为NULL
+ */
+static void stopEngine(Engine *engine, char *message) {
+    kill(engine->pid, SIGKILL);
+    waitpid(engine->pid, NULL, 0);
+    close(engine->fd);
+    if (message != NULL) {
+        appendMessage(engine->fp, engine->endsWithNewline, message);
     }
-    HashSet **ppSetCandidateRules = (HashSet **)iHashBasedTable.Get(pTableTargetAV2Rule, &attrIdx, &valIdx);
-    if (ppSetCandidateRules != NULL) {
-        int ruleIdx;
-        Rule *pRule;
-        HashSetIterator *itSet = iHashSet.NewIterator(*ppSetCandidateRules);
-        while (itSet->HasNext(itSet)) {
-            ruleIdx = *(int *)itSet->GetNext(itSet);
-            pRule = (Rule *)iVector.GetElement(pVecRules, ruleIdx);
-            if (iRule.CanBeManaged(pRule, state)) {
-                iHashMap.Put(state, &attrIdx, &valIdx);
-                return ruleIdx;
-            }
-        }
+    if (engine->fp != NULL) {
+        fclose(engine->fp);
     }
-    return -1;
+    engine->pid = 0;
 }
 
-AABACResult analyzeModelCheckerOutput(char *output, AABACInstance *pInst, char *boundStr, int showRules) {
-    logAABAC(__func__, __LINE__, 0, INFO, "analyzing the output of NuSMV\n");
-
-    int waitAction = 0;
-    int reachable = 0;
-    char *attr, *val;
+AABACResult runModelCheckerPortfolio(char *modelCheckerPath, char *nusmvFilePath, char *resultFilePath, double timeout, char *bound,
+                                     int boundConclusive, int invarSpec, int maxEngines, double cpuBudget, AABACInstance *pInst, int showRules) {
+    logAABAC(__func__, __LINE__, 0, INFO, "[start] running model checker portfolio, at most %d engines at a time\n", maxEngines);
+    double startRun = monotonicNow();
+    double deadline = startRun + timeout;
 
-    if (output == NULL) {
-        logAABAC(__func__, __LINE__, 0, ERROR, "the output of NuSMV is NULL\n");
-        // todo: 错误处理
+    // 有界模型检测在上界处找不到反例时，只有上界足够大才能断定unreachable；其他引擎给出的结论都是最终结论。k-induction只适用于不变式
+    int kinds[PORTFOLIO_MAX_ENGINES], nKinds = 0;
+    if (bound != NULL) {
+        kinds[nKinds++] = MC_ENGINE_BMC;
+    }
+    kinds[nKinds++] = MC_ENGINE_BDD;
+    kinds[nKinds++] = MC_ENGINE_IC3;
+    if (invarSpec) {
+        kinds[nKinds++] = MC_ENGINE_KIND;
+    }
+    Engine engines[PORTFOLIO_MAX_ENGINES];
+    int nEngines = 0, i, n;
+    for (i = 0; i < nKinds; i++) {
+        if (prepareEngine(&engines[nEngines], kinds[i], invarSpec, modelCheckerPath, nusmvFilePath, bound, boundConclusive, NULL) == 0) {
+            nEngines++;
+        } else {
+            logAABAC(__func__, __LINE__, 0, WARNING, "engine %s cannot be prepared, running the portfolio without it\n", engineNames[kinds[i]]);
+        }
+    }
+    if (nEngines == 0) {
+        logAABAC(__func__, __LINE__, 0, ERROR, "no engine of the portfolio can be prepared\n");
         return (AABACResult){AABAC_RESULT_ERROR, NULL, NULL};
     }
-    char *line = strtok(output, "\n");
-    // 分析是否超时
-    if (strcmp(line, TIMEOUT_MESSAGE) == 0) {
-        return (AABACResult){AABAC_RESULT_TIMEOUT, NULL, NULL};
+
+    // CPU时间预算由本轮所有引擎平分，setrlimit只接受整数秒
+    long cpuLimit = 0;
+    if (cpuBudget > 0) {
+        cpuLimit = (long)(cpuBudget / nEngines + 0.999);
+        cpuLimit = cpuLimit < 1 ? 1 : cpuLimit;
     }
 
-    char *variable, *p;
-    Vector *pVecActions = iVector.Create(sizeof(AdminstrativeAction), 10);
-    AdminstrativeAction action;
-    regex_t pattern;
-    regcomp(&pattern, PATTERN_SMC_UNREACHABLE, REG_EXTENDED);
-    while (line != NULL) {
-        if (boundStr != NULL && strncmp(line, PATTERN_BMC_UNREACHABLE, PATTERN_BMC_UNREACHABLE_LEN) == 0) {
-            // 有界模型检测模式下，如果直到上界bound都没有counterexample被找到，那么说明结果为unreacheable
-            line = strtrim(line + PATTERN_BMC_UNREACHABLE_LEN);
-            if (strcmp(line, boundStr) == 0) {
-                regfree(&pattern);
-                return (AABACResult){AABAC_RESULT_UNREACHABLE, NULL, NULL};
+    AABACResult result = {AABAC_RESULT_ERROR, NULL, NULL};
+    Engine *winner = NULL;
+    struct pollfd pfds[PORTFOLIO_MAX_ENGINES];
+    int pollIdx[PORTFOLIO_MAX_ENGINES];
+    int next = 0, running = 0, timedOut = 0;
+    char *buffer = (char *)malloc(READ_BUFFER_SIZE);
+    while (winner == NULL && buffer != NULL) {
+        // 有空位时按顺序启动尚未运行的引擎
+        while (running < maxEngines && next < nEngines) {
+            if (startEngine(&engines[next], modelCheckerPath, resultFilePath, cpuLimit, pInst) == 0) {
+                running++;
             }
-            line = strtok(NULL, "\n");
-            continue;
+            next++;
         }
-
-        // 符号模型检测模型下，使用正则表达式匹配判断是否unreachable
-        if (regexec(&pattern, line, 0, NULL, 0) == 0) {
-            regfree(&pattern);
-            return (AABACResult){AABAC_RESULT_UNREACHABLE, NULL, NULL};
+        if (running == 0) {
+            break;
         }
 
-        if (strstr(line, "State:")) {
-            // 如果line中包含“State:”，意味者是目标状态是可达的，需要将解析出的管理操作记录下来
-            if (reachable) {
-                action = (AdminstrativeAction){pInst->queryUserIdx, pInst->queryUserIdx, attr, val};
-                iVector.Add(pVecActions, &action);
+        double remaining = deadline - monotonicNow();
+        if (remaining <= 0) {
+            timedOut = 1;
+            break;
+        }
+        for (i = 0, n = 0; i < nEngines; i++) {
+            if (engines[i].pid != 0) {
+                pfds[n] = (struct pollfd){engines[i].fd, POLLIN, 0};
+                pollIdx[n++] = i;
             }
-            reachable = 1;
-            waitAction = 1;
-            line = strtok(NULL, "\n");
-            continue;
         }
-        if (waitAction) {
-            // 已遇见"State:"，所以当前line是管理操作，需要解析
-            variable = strdup(line);
-            p = variable;
-            while (*p != '=' && *p != '\0') {
-                p++;
+        int ret = poll(pfds, n, (int)(remaining * 1000) + 1);
+        if (ret == -1) {
+            if (errno == EINTR) {
+                continue;
+            }
+            logAABAC(__func__, __LINE__, errno, ERROR, "Poll failed\n");
+            break;
+        }
+
+        for (i = 0; i < n && winner == NULL; i++) {
+            Engine *engine = &engines[pollIdx[i]];
+            if (pfds[i].revents == 0) {
+                continue;
+            }
+            ssize_t bytesRead = readChunk(engine->fd, engine->fp, buffer, &engine->parser, &engine->endsWithNewline);
+            if (bytesRead > 0 && !engine->parser.done && !engine->parser.failed) {
+                continue;
+            }
+            if (bytesRead == -1) {
+                // 读取失败时输出不完整，该引擎不给出结论
+                logAABAC(__func__, __LINE__, errno, ERROR, "Failed to read the output of %s engine\n", engine->name);
+                stopEngine(engine, NULL);
+                running--;
+                discardParser(&engine->parser);
+                continue;
+            }
+
+            // 引擎已给出结论、输出已结束或内存不足
+            stopEngine(engine, engine->parser.failed ? MEMORY_OUT_MESSAGE : NULL);
+            running--;
+            AABACResult engineResult = finishParser(&engine->parser, pInst, showRules);
+            if (engineResult.code == AABAC_RESULT_REACHABLE || (engineResult.code == AABAC_RESULT_UNREACHABLE && engine->unreachableConclusive)) {
+                winner = engine;
+                result = engineResult;
+                break;
             }
-            if (*p != '\0') {
-                *(p++) = '\0';
-            } else {
-                p = NULL;
+            logAABAC(__func__, __LINE__, 0, INFO, "%s engine is inconclusive, result code: %d\n", engine->name, engineResult.code);
+            if (engineResult.pVecActions != NULL) {
+                iVector.Finalize(engineResult.pVecActions);
             }
-            variable = strtrim(variable);
-            if (strcmp(variable, "attr") == 0) {
-                attr = p;
-                attr = strtrim(attr);
-                attr[strlen(attr) - ALIAS_SUFFIX_LEN] = '\0';
-            } else if (strcmp(variable, "val") == 0) {
-                val = p;
-                val = strtrim(val);
+            if (engineResult.pVecRules != NULL) {
+                iVector.Finalize(engineResult.pVecRules);
             }
         }
-        line = strtok(NULL, "\n");
     }
-    regfree(&pattern);
+    free(buffer);
 
-    if (!reachable) {
-        return (AABACResult){AABAC_RESULT_ERROR, NULL, NULL};
+    // 杀死仍在运行的引擎
+    for (i = 0; i < nEngines; i++) {
+        if (engines[i].pid != 0) {
+            stopEngine(&engines[i], timedOut ? TIMEOUT_MESSAGE : NULL);
+            discardParser(&engines[i].parser);
+        }
     }
-    if (showRules) {
-        HashMap *pMapState = iHashMap.Create(sizeof(int), sizeof(int), IntHashCode, IntEqual);
-        HashNode *node;
-        HashNodeIterator *itMap = iHashMap.NewIterator(iHashBasedTable.GetRow(pInst->pTableInitState, &pInst->queryUserIdx));
-        while (itMap->HasNext(itMap)) {
-            node = itMap->GetNext(itMap);
-            iHashMap.Put(pMapState, node->key, node->value);
+    for (i = 0; i < nEngines; i++) {
+        releaseEngine(&engines[i]);
+    }
+
+    if (winner != NULL) {
+        logAABAC(__func__, __LINE__, 0, INFO, "%s engine concluded first\n", winner->name);
+    } else if (timedOut) {
+        logAABAC(__func__, __LINE__, 0, WARNING, "Command execution timed out\n");
+        result.code = AABAC_RESULT_TIMEOUT;
+    }
+    double spentTime = (monotonicNow() - startRun) * 1000;
+    logAABAC(__func__, __LINE__, 0, INFO, "[end] running model checker portfolio, cost => %.2fms\n", spentTime);
+    return result;
+}
+
+/* 以交互模式（-int）持续运行的模型检测器进程，每轮通过标准输入发送一段命令脚本 */
+struct _MCSession {
+    char *modelCheckerPath; // 模型检测器路径
+    pid_t pid;              // 模型检测器进程，未启动或已结束时为0
+    int in;                 // 模型检测器标准输入的写端
+    int out;                // 模型检测器标准输出和标准错误的读端
+    int round;              // 已发送的命令脚本数，用于生成每轮的结束标记
+};
+
+MCSession *createModelCheckerSession(char *modelCheckerPath) {
+    MCSession *session = (MCSession *)calloc(1, sizeof(MCSession));
+    session->modelCheckerPath = modelCheckerPath;
+    // 会话进程意外退出后，向其标准输入写入不应终止整个程序
+    signal(SIGPIPE, SIG_IGN);
+    return session;
+}
+
+/**
+ * 以交互模式启动会话的模型检测器进程
+ * @param session[in]: 会话
+ * @return 0表示启动成功，-1表示失败
+ */
+static int startSession(MCSession *session) {
+    int inPipe[2], outPipe[2];
+    if (pipe(inPipe) == -1) {
+        logAABAC(__func__, __LINE__, errno, ERROR, "Failed to create pipe\n");
+        return -1;
+    }
+    if (pipe(outPipe) == -1) {
+        logAABAC(__func__, __LINE__, errno, ERROR, "Failed to create pipe\n");
+        close(inPipe[0]);
+        close(inPipe[1]);
+        return -1;
+    }
+
+    pid_t pid = fork();
+    if (pid == -1) {
+        logAABAC(__func__, __LINE__, errno, ERROR, "Failed to fork");
+        close(inPipe[0]);
+        close(inPipe[1]);
+        close(outPipe[0]);
+        close(outPipe[1]);
+        return -1;
+    }
+
+    if (pid == 0) { // 子进程
+        close(inPipe[1]);
+        close(outPipe[0]);
+        dup2(inPipe[0], STDIN_FILENO);
+        dup2(outPipe[1], STDOUT_FILENO);
+        dup2(outPipe[1], STDERR_FILENO);
+        close(inPipe[0]);
+        close(outPipe[1]);
+
+        char *args[] = {session->modelCheckerPath, "-int", NULL};
+        execv(session->modelCheckerPath, args);
+        logAABAC(__func__, __LINE__, errno, ERROR, "Failed to execute command\n");
+        exit(1);
+    }
+
+    // 父进程。与会话相连的管道端不能泄漏到之后创建的模型检测器子进程中
+    close(inPipe[0]);
+    close(outPipe[1]);
+    fcntl(inPipe[1], F_SETFD, FD_CLOEXEC);
+    fcntl(outPipe[0], F_SETFD, FD_CLOEXEC);
+    session->pid = pid;
+    session->in = inPipe[1];
+    session->out = outPipe[0];
+    logAABAC(__func__, __LINE__, 0, INFO, "model checker session started, pid: %d\n", (int)pid);
+    return 0;
+}
+
+/**
+ * 强制结束会话的模型检测器进程，下一轮将重新启动
+ * @param session[in]: 会话
+ */
+static void killSession(MCSession *session) {
+    if (session->pid == 0) {
+        return;
+    }
+    kill(session->pid, SIGKILL);
+    waitpid(session->pid, NULL, 0);
+    close(session->in);
+    close(session->out);
+    session->pid = 0;
+}
+
+/**
+ * 将命令脚本完整写入会话的标准输入
+ * @param session[in]: 会话
+ * @param script[in]: 命令脚本
+ * @return 0表示写入成功，-1表示会话进程已不再读取
+ */
+static int sendScript(MCSession *session, char *script) {
+    size_t len = strlen(script);
+    while (len > 0) {
+        ssize_t n = write(session->in, script, len);
+        if (n == -1) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return -1;
         }
-        iHashMap.DeleteIterator(itMap);
+        script += n;
+        len -= n;
+    }
+    return 0;
+}
 
-        Vector *pVecRules = iVector.Create(sizeof(Rule), iVector.Size(pVecActions));
-        int i;
-        for (i = 0; i < iVector.Size(pVecActions); i++) {
-            AdminstrativeAction action = *(AdminstrativeAction *)iVector.GetElement(pVecActions, i);
-            int ruleIdx = findRule(pMapState, pInst->pTableTargetAV2Rule, action);
-            if (ruleIdx < 0) {
-                logAABAC(__func__, __LINE__, 0, ERROR, "find no corresponding rule!\n");
+AABACResult runModelCheckerSession(MCSession *session, char *nusmvFilePath, char *resultFilePath, double timeout, int engine,
+                                   int invarSpec, char *bound, AABACInstance *pInst, int showRules) {
+    logAABAC(__func__, __LINE__, 0, INFO, "[start] running model checker session on %s mode\n", engineNames[engine]);
+    double startRun = monotonicNow();
+    double deadline = startRun + timeout;
+
+    OutputParser parser;
+    char sentinel[48];
+    BMCProgress progress;
+    char commands[ENGINE_COMMANDS_LEN];
+    char *resumeCmds = prepareResume(engine, invarSpec, nusmvFilePath, bound, &progress), *resumePath = NULL;
+    int resumeFd = -1;
+    if (resumeCmds != NULL) {
+        // 恢复BMC的命令可能很长，通过source执行，避免写入标准输入时与模型检测器的输出互相阻塞
+        resumeFd = createScriptFile("resume", resumeCmds, "", &resumePath);
+        free(resumeCmds);
+    }
+    if (resumeFd >= 0) {
+        snprintf(commands, sizeof(commands), "source \"%s\"\n", resumePath);
+    } else {
+        engineCommands(commands, engine, invarSpec, bound);
+    }
+    char *script = (char *)malloc(strlen(nusmvFilePath) + strlen(commands) + 96);
+    int ret = -1, parsed = 0, attempt;
+    // 会话进程意外退出时，重新启动并重试一次
+    for (attempt = 0; attempt < 2 && !parsed; attempt++) {
+        if (session->pid == 0 && startSession(session) != 0) {
+            break;
+        }
+        sprintf(sentinel, "%s%d", SESSION_SENTINEL, ++session->round);
+        sprintf(script, "reset\nread_model -i \"%s\"\n%secho %s\n", nusmvFilePath, commands, sentinel);
+        logAABAC(__func__, __LINE__, 0, INFO, "script: [%s]\n", script);
+        if (sendScript(session, script) != 0) {
+            logAABAC(__func__, __LINE__, errno, WARNING, "model checker session is gone, restarting it\n");
+            killSession(session);
+            continue;
+        }
+
+        initParser(&parser, engine == MC_ENGINE_BMC || engine == MC_ENGINE_BMC_LENGTH ? bound : NULL, pInst);
+        parser.sentinel = sentinel;
+        FILE *fp = openResultFile(resultFilePath);
+        ret = readOutput(session->out, fp, deadline, &parser);
+        if (fp != NULL) {
+            fclose(fp);
+        }
+        if (ret != 0) {
+            // 看门狗：会话超过截止时间仍无响应，杀死它，下一轮重新启动一个会话
+            logAABAC(__func__, __LINE__, 0, WARNING, "model checker session does not respond, killing it\n");
+            killSession(session);
+        } else if (!parser.sentinelSeen) {
+            logAABAC(__func__, __LINE__, 0, WARNING, "model checker session exited unexpectedly\n");
+            killSession(session);
+            if (attempt == 0 && !parser.done) {
+                discardParser(&parser);
+                continue;
             }
-            iVector.Add(pVecRules, &ruleIdx);
         }
-        return (AABACResult){AABAC_RESULT_REACHABLE, pVecActions, pVecRules};
+        parsed = 1;
     }
-    return (AABACResult){AABAC_RESULT_REACHABLE, pVecActions, NULL};
-}
\ No newline at end of file
+    free(script);
+    if (resumeFd >= 0) {
+        close(resumeFd);
+        free(resumePath);
+    }
+
+    double spentTime = (monotonicNow() - startRun) * 1000;
+    logAABAC(__func__, __LINE__, 0, INFO, "[end] running model checker session on %s mode, cost => %.2fms\n", engineNames[engine], spentTime);
+
+    if (!parsed) {
+        return (AABACResult){AABAC_RESULT_ERROR, NULL, NULL};
+    }
+    recordProgress(&parser, ret, nusmvFilePath, &progress);
+    if (ret != 0) {
+        parser.failed = 1;
+    }
+    AABACResult result = finishParser(&parser, pInst, showRules);
+    if (ret == AABAC_RESULT_TIMEOUT) {
+        result.code = AABAC_RESULT_TIMEOUT;
+    }
+    return result;
+}
+
+void destroyModelCheckerSession(MCSession *session) {
+    if (session->pid != 0) {
+        // 请求模型检测器正常退出，等待片刻后仍未退出则强制结束
+        sendScript(session, "quit\n");
+        close(session->in);
+        double deadline = monotonicNow() + SESSION_QUIT_WAIT;
+        while (waitpid(session->pid, NULL, WNOHANG) == 0) {
+            if (monotonicNow() >= deadline) {
+                kill(session->pid, SIGKILL);
+                waitpid(session->pid, NULL, 0);
+                break;
+            }
+            usleep(10000);
+        }
+        close(session->out);
+    }
+    free(session);
+}
+
+AABACResult runModelCheckerDeepening(char *modelCheckerPath, MCSession *session, char *nusmvFilePath, char *resultFilePath,
+                                     double timeout, int invarSpec, char *bound, int boundConclusive, int startLength, double factor,
+                                     double budget, AABACInstance *pInst, int showRules) {
+    logAABAC(__func__, __LINE__, 0, INFO, "[start] iterative deepening bmc from length %d, factor %.2f, up to bound %s\n", startLength,
+             factor, bound);
+    double startRun = monotonicNow();
+    double deadline = startRun + timeout;
+    double scheduleDeadline = startRun + timeout * budget;
+
+    long long fullLength = atoll(bound), length = startLength < 1 ? 1 : startLength, nextLength;
+    char lengthStr[24];
+    AABACResult result = {AABAC_RESULT_ERROR, NULL, NULL};
+    int engine, proved = 0;
+    while (monotonicNow() < scheduleDeadline) {
+        // 未到完整上界时每个长度只检查一次，到达完整上界时使用普通的BMC，其结果与不加深时相同
+        if (length >= fullLength) {
+            length = fullLength;
+            engine = MC_ENGINE_BMC;
+        } else {
+            engine = MC_ENGINE_BMC_LENGTH;
+        }
+        sprintf(lengthStr, "%lld", length);
+        if (session != NULL) {
+            result = runModelCheckerSession(session, nusmvFilePath, resultFilePath, scheduleDeadline - monotonicNow(), engine, invarSpec,
+                                            lengthStr, pInst, showRules);
+        } else {
+            result = runModelChecker(modelCheckerPath, nusmvFilePath, resultFilePath, scheduleDeadline - monotonicNow(), engine,
+                                     invarSpec, lengthStr, pInst, showRules);
+        }
+        if (result.code == AABAC_RESULT_REACHABLE) {
+            logAABAC(__func__, __LINE__, 0, INFO, "[end] iterative deepening bmc, counterexample within length %s, cost => %.2fms\n",
+                     lengthStr, (monotonicNow() - startRun) * 1000);
+            return result;
+        }
+        if (result.code != AABAC_RESULT_UNREACHABLE) {
+            // 超时或出错，即加深的预算已经用完
+            break;
+        }
+        if (engine == MC_ENGINE_BMC) {
+            proved = boundConclusive;
+            break;
+        }
+        nextLength = (long long)(length * factor);
+        length = nextLength > length ? nextLength : length + 1;
+    }
+    logAABAC(__func__, __LINE__, 0, INFO, "[end] iterative deepening bmc, stopped at length %lld, cost => %.2fms\n", length,
+             (monotonicNow() - startRun) * 1000);
+    if (proved) {
+        return result;
+    }
+
+    // 加深没有得到结论，剩余的时间交给完备的符号模型检测
+    double remaining = deadline - monotonicNow();
+    if (remaining <= 0) {
+        return (AABACResult){AABAC_RESULT_TIMEOUT, NULL, NULL};
+    }
+    if (session != NULL) {
+        return runModelCheckerSession(session, nusmvFilePath, resultFilePath, remaining, MC_ENGINE_BDD, invarSpec, NULL, pInst, showRules);
+    }
+    return runModelChecker(modelCheckerPath, nusmvFilePath, resultFilePath, remaining, MC_ENGINE_BDD, invarSpec, NULL, pInst, showRules);
+}
+
+AABACResult analyzeModelCheckerOutput(char *output, AABACInstance *pInst, char *boundStr, int showRules) {
+    logAABAC(__func__, __LINE__, 0, INFO, "analyzing the output of NuSMV\n");
+
+    if (output == NULL) {
+        logAABAC(__func__, __LINE__, 0, ERROR, "the output of NuSMV is NULL\n");
+        return (AABACResult){AABAC_RESULT_ERROR, NULL, NULL};
+    }
+    // 分析是否超时
+    char *p = output + strspn(output, "\n");
+    if (strncmp(p, TIMEOUT_MESSAGE, TIMEOUT_MESSAGE_LEN) == 0 && (p[TIMEOUT_MESSAGE_LEN] == '\n' || p[TIMEOUT_MESSAGE_LEN] == '\0')) {
+        return (AABACResult){AABAC_RESULT_TIMEOUT, NULL, NULL};
+    }
+
+    OutputParser parser;
+    initParser(&parser, boundStr, pInst);
+    feedParser(&parser, output, strlen(output));
+    return finishParser(&parser, pInst, showRules);
+}
@@ -0,0 +1,108 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "AABACUtils.h"
+#include "packedTable.h"
+
+static unsigned long long packKey(int row, int col) {
+    return ((unsigned long long)(unsigned int)row << 32) | (unsigned int)col;
+}
+
+/**
+ * Hash code of a packed key. The row is multiplied by an odd constant before being combined
+ * with the column, so that (row, col) and (col, row) do not collide for small dense indices.
+ */
+static unsigned int PackedKeyHashCode(void *pKey) {
+    unsigned long long key = *(unsigned long long *)pKey;
+    return (unsigned int)key ^ ((unsigned int)(key >> 32) * 0x85EBCA6Bu);
+}
+
+static int PackedKeyEqual(void *pKey1, void *pKey2) {
+    return *(unsigned long long *)pKey1 == *(unsigned long long *)pKey2;
+}
+
+static PackedTable *CreateInPool(Pool *pool, int valueSize, int withRowView) {
+    PackedTable *table = (PackedTable *)(pool != NULL ? iPool.Alloc(pool, sizeof(PackedTable)) : malloc(sizeof(PackedTable)));
+    if (table == NULL) {
+        logAABAC(__func__, __LINE__, 0, ERROR, "Failed to allocate memory for packed table\n");
+        return NULL;
+    }
+    table->pCellMap = iHashMap.CreateInPool(pool, sizeof(unsigned long long), valueSize, PackedKeyHashCode, PackedKeyEqual);
+    table->pRowView = NULL;
+    if (withRowView) {
+        table->pRowView = iHashMap.CreateInPool(pool, sizeof(int), sizeof(IntSet *), IntHashCode, IntEqual);
+        iHashMap.SetDestructValue(table->pRowView, iIntSet.DestructPointer);
+    }
+    table->valueSize = valueSize;
+    table->pool = pool;
+    return table;
+}
+
+static PackedTable *Create(int valueSize, int withRowView) {
+    return CreateInPool(NULL, valueSize, withRowView);
+}
+
+static int Put(PackedTable *table, int row, int col, void *value) {
+    unsigned long long key = packKey(row, col);
+    if (table->pRowView != NULL) {
+        IntSet *pSetCols, **ppSetCols = iHashMap.Get(table->pRowView, &row);
+        if (ppSetCols == NULL) {
+            pSetCols = iIntSet.CreateInPool(table->pool);
+            ppSetCols = &pSetCols;
+            iHashMap.Put(table->pRowView, &row, ppSetCols);
+        }
+        iIntSet.Add(*ppSetCols, col);
+    }
+    return iHashMap.Put(table->pCellMap, &key, value);
+}
+
+static void *Get(PackedTable *table, int row, int col) {
+    unsigned long long key = packKey(row, col);
+    return iHashMap.Get(table->pCellMap, &key);
+}
+
+static IntSet *GetRow(PackedTable *table, int row) {
+    if (table->pRowView == NULL) {
+        return NULL;
+    }
+    IntSet **ppSetCols = iHashMap.Get(table->pRowView, &row);
+    return ppSetCols == NULL ? NULL : *ppSetCols;
+}
+
+static int Size(PackedTable *table) {
+    return iHashMap.Size(table->pCellMap);
+}
+
+static DestructFn SetDestructValue(PackedTable *table, DestructFn destructValue) {
+    return iHashMap.SetDestructValue(table->pCellMap, destructValue);
+}
+
+static void Clear(PackedTable *table) {
+    iHashMap.Clear(table->pCellMap);
+    if (table->pRowView != NULL) {
+        iHashMap.Clear(table->pRowView);
+    }
+}
+
+static void Finalize(PackedTable *table) {
+    if (table->pool != NULL) {
+        return;
+    }
+    iHashMap.Finalize(table->pCellMap);
+    if (table->pRowView != NULL) {
+        iHashMap.Finalize(table->pRowView);
+    }
+    free(table);
+}
+
+PackedTableInterface iPackedTable = {
+    .Create = Create,
+    .CreateInPool = CreateInPool,
+    .Put = Put,
+    .Get = Get,
+    .GetRow = GetRow,
+    .Size = Size,
+    .SetDestructValue = SetDestructValue,
+    .Clear = Clear,
+    .Finalize = Finalize,
+};
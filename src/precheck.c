@@ -14,7 +14,7 @@ static AABACResult getReachableResultFromRules(AABACInstance *pInst, Vector *rul
         action.adminIdx = pInst->queryUserIdx;
         action.userIdx = pInst->queryUserIdx;
         action.attr = istrCollection.GetElement(pscAttrs, pRule->targetAttrIdx);
-        attrType = *(AttrType *)iHashMap.Get(pmapAttr2Type, &pRule->targetAttrIdx);
+        attrType = getAttrTypeByIdx(pRule->targetAttrIdx);
         action.val = getValueByIndex(attrType, pRule->targetValueIdx);
 
         iVector.Add(actions, &action);
@@ -27,7 +27,7 @@ static AABACResult getReachableResultFromRules(AABACInstance *pInst, Vector *rul
 
 AABACResult preCheck(AABACInstance *pInst) {
     HashMap *pmapQueryAVs = pInst->pmapQueryAVs;
-    HashBasedTable *pTableTargetAV2Rule = pInst->pTableTargetAV2Rule;
+    PackedTable *pTableTargetAV2Rule = pInst->pTableTargetAV2Rule;
     Vector *pVecSelectedRuleIdxes = iVector.Create(sizeof(int), 0);
 
     // 第一阶段，对于a1=v1,...,an=vn形式的查询，依次检查是否存在目标为ai=vi且条件为true的规则，如果都存在，则说明查询属性组是可达的
@@ -35,8 +35,8 @@ AABACResult preCheck(AABACInstance *pInst) {
     HashNodeIterator *itQueryAVs = iHashMap.NewIterator(pmapQueryAVs);
     HashNode *node;
     int queryAttrIdx, queryValueIdx, ruleIdx;
-    HashSet **ppSetRuleIdxes;
-    HashSetIterator *itRuleIdxes;
+    IntSet **ppSetRuleIdxes;
+    IntSetIterator *itRuleIdxes;
     Rule *pRule;
     while (itQueryAVs->HasNext(itQueryAVs)) {
         node = (HashNode *)itQueryAVs->GetNext(itQueryAVs);
@@ -46,14 +46,14 @@ AABACResult preCheck(AABACInstance *pInst) {
         if (queryValueIdx == getInitValue(pInst, pInst->queryUserIdx, queryAttrIdx)) {
             continue;
         }
-        ppSetRuleIdxes = (HashSet **)iHashBasedTable.Get(pTableTargetAV2Rule, &queryAttrIdx, &queryValueIdx);
+        ppSetRuleIdxes = (IntSet **)iPackedTable.Get(pTableTargetAV2Rule, queryAttrIdx, queryValueIdx);
         if (ppSetRuleIdxes == NULL) {
             // 一定不可达
             iHashMap.DeleteIterator(itQueryAVs);
             return (AABACResult){.code = AABAC_RESULT_UNREACHABLE};
         }
         found = 0;
-        itRuleIdxes = iHashSet.NewIterator(*ppSetRuleIdxes);
+        itRuleIdxes = iIntSet.NewIterator(*ppSetRuleIdxes);
         while (itRuleIdxes->HasNext(itRuleIdxes)) {
             ruleIdx = *(int *)itRuleIdxes->GetNext(itRuleIdxes);
             pRule = (Rule *)iVector.GetElement(pVecRules, ruleIdx);
@@ -63,7 +63,7 @@ AABACResult preCheck(AABACInstance *pInst) {
                 break;
             }
         }
-        iHashSet.DeleteIterator(itRuleIdxes);
+        iIntSet.DeleteIterator(itRuleIdxes);
         if (!found) {
             success = 0;
             break;
@@ -81,15 +81,15 @@ AABACResult preCheck(AABACInstance *pInst) {
         node = (HashNode *)itQueryAVs->GetNext(itQueryAVs);
         queryAttrIdx = *(int *)node->key;
         queryValueIdx = *(int *)node->value;
-        ppSetRuleIdxes = (HashSet **)iHashBasedTable.Get(pTableTargetAV2Rule, &queryAttrIdx, &queryValueIdx);
-        itRuleIdxes = iHashSet.NewIterator(*ppSetRuleIdxes);
+        ppSetRuleIdxes = (IntSet **)iPackedTable.Get(pTableTargetAV2Rule, queryAttrIdx, queryValueIdx);
+        itRuleIdxes = iIntSet.NewIterator(*ppSetRuleIdxes);
 
         HashNodeIterator *itUserCondValue;
         int condAttrIdx, condValueIdx;
-        HashSet *psetCondValueIdxes;
-        HashSetIterator *itCondValueIdxes;
-        HashSet **ppSetRuleIdxes2;
-        HashSetIterator *itRuleIdxes2;
+        IntSet *psetCondValueIdxes;
+        IntSetIterator *itCondValueIdxes;
+        IntSet **ppSetRuleIdxes2;
+        IntSetIterator *itRuleIdxes2;
         int ruleIdx2;
         Rule *pRule2;
         while (itRuleIdxes->HasNext(itRuleIdxes)) {
@@ -101,18 +101,18 @@ AABACResult preCheck(AABACInstance *pInst) {
             while (itUserCondValue->HasNext(itUserCondValue)) {
                 node = (HashNode *)itUserCondValue->GetNext(itUserCondValue);
                 condAttrIdx = *(int *)node->key;
-                psetCondValueIdxes = *(HashSet **)node->value;
+                psetCondValueIdxes = *(IntSet **)node->value;
                 condValueIdx = getInitValue(pInst, pInst->queryUserIdx, condAttrIdx);
-                if (!iHashSet.Contains(psetCondValueIdxes, &condValueIdx)) {
+                if (!iIntSet.Contains(psetCondValueIdxes, condValueIdx)) {
                     found = 0;
-                    itCondValueIdxes = iHashSet.NewIterator(psetCondValueIdxes);
+                    itCondValueIdxes = iIntSet.NewIterator(psetCondValueIdxes);
                     while (itCondValueIdxes->HasNext(itCondValueIdxes)) {
                         condValueIdx = *(int *)itCondValueIdxes->GetNext(itCondValueIdxes);
-                        ppSetRuleIdxes2 = (HashSet **)iHashBasedTable.Get(pTableTargetAV2Rule, &condAttrIdx, &condValueIdx);
+                        ppSetRuleIdxes2 = (IntSet **)iPackedTable.Get(pTableTargetAV2Rule, condAttrIdx, condValueIdx);
                         if (ppSetRuleIdxes2 == NULL) {
                             continue;
                         }
-                        itRuleIdxes2 = iHashSet.NewIterator(*ppSetRuleIdxes2);
+                        itRuleIdxes2 = iIntSet.NewIterator(*ppSetRuleIdxes2);
                         while (itRuleIdxes2->HasNext(itRuleIdxes2)) {
                             ruleIdx2 = *(int *)itRuleIdxes2->GetNext(itRuleIdxes2);
                             pRule2 = (Rule *)iVector.GetElement(pVecRules, ruleIdx2);
@@ -122,12 +122,12 @@ AABACResult preCheck(AABACInstance *pInst) {
                                 break;
                             }
                         }
-                        iHashSet.DeleteIterator(itRuleIdxes2);
+                        iIntSet.DeleteIterator(itRuleIdxes2);
                         if (found) {
                             break;
                         }
                     }
-                    iHashSet.DeleteIterator(itCondValueIdxes);
+                    iIntSet.DeleteIterator(itCondValueIdxes);
                     if (!found) {
                         success = 0;
                         break;
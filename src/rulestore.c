@@ -0,0 +1,439 @@
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "AABACUtils.h"
+#include "ruleStore.h"
+
+#define WORD_BITS RULESTORE_WORD_BITS
+
+static int wordOf(int value) {
+    return value >= 0 ? value / WORD_BITS : -1 - (-(value + 1)) / WORD_BITS;
+}
+
+static int bitOf(int value) {
+    return value - wordOf(value) * WORD_BITS;
+}
+
+static void *reallocOrDie(void *ptr, size_t size) {
+    void *newPtr = realloc(ptr, size);
+    if (newPtr == NULL) {
+        logAABAC(__func__, __LINE__, 0, ERROR, "Failed to allocate memory for rule store\n");
+        exit(-1);
+    }
+    return newPtr;
+}
+
+/**
+ * Make room for at least @{nConds} more condition entries and @{nWords} more bitmap words at the tail of the store.
+ */
+static void reserve(RuleStore *store, int nConds, int nWords) {
+    if (store->nConds + nConds > store->condCapacity) {
+        int capacity = store->condCapacity == 0 ? 16 : store->condCapacity;
+        while (capacity < store->nConds + nConds) {
+            capacity *= 2;
+        }
+        store->condAttrs = (int *)reallocOrDie(store->condAttrs, capacity * sizeof(int));
+        store->condFirstWord = (int *)reallocOrDie(store->condFirstWord, capacity * sizeof(int));
+        store->condWordBegin = (int *)reallocOrDie(store->condWordBegin, capacity * sizeof(int));
+        store->condWordEnd = (int *)reallocOrDie(store->condWordEnd, capacity * sizeof(int));
+        store->condCapacity = capacity;
+    }
+    if (store->nWords + nWords > store->wordCapacity) {
+        int capacity = store->wordCapacity == 0 ? 16 : store->wordCapacity;
+        while (capacity < store->nWords + nWords) {
+            capacity *= 2;
+        }
+        store->words = (unsigned long long *)reallocOrDie(store->words, capacity * sizeof(unsigned long long));
+        store->wordCapacity = capacity;
+    }
+}
+
+/**
+ * Get the words spanned by the values of a set.
+ *
+ * @return 1 if the set is not empty, 0 otherwise
+ */
+static int wordRange(IntSet *pSetVals, int *pFirstWord, int *pLastWord) {
+    int empty = 1;
+    INTSET_FOREACH(val, pSetVals) {
+        if (empty) {
+            *pFirstWord = wordOf(val);
+            empty = 0;
+        }
+        *pLastWord = wordOf(val);
+    }
+    return !empty;
+}
+
+/**
+ * Count the condition entries and bitmap words needed by the user condition of a rule.
+ */
+static void measureRule(Rule *r, int *pnConds, int *pnWords) {
+    *pnConds = 0;
+    *pnWords = 0;
+    HashMap *pmapUserCondValue = r->pmapUserCondValue;
+    if (pmapUserCondValue == NULL) {
+        return;
+    }
+    IntSet *pSetVals;
+    int firstWord, lastWord;
+    HASHMAP_FOREACH(slot, pmapUserCondValue) {
+        pSetVals = *(IntSet **)HashMapSlotValue(pmapUserCondValue, slot);
+        (*pnConds)++;
+        if (wordRange(pSetVals, &firstWord, &lastWord)) {
+            *pnWords += lastWord - firstWord + 1;
+        }
+    }
+}
+
+/**
+ * Write the condition entries of a rule starting at the given entry and word positions.
+ * The caller guarantees that enough room is available, see @{measureRule}.
+ */
+static void writeRule(RuleStore *store, int ruleIdx, Rule *r, int cond, int word) {
+    store->targetAttrs[ruleIdx] = r->targetAttrIdx;
+    store->targetValues[ruleIdx] = r->targetValueIdx;
+    store->condBegin[ruleIdx] = cond;
+    HashMap *pmapUserCondValue = r->pmapUserCondValue;
+    if (pmapUserCondValue != NULL) {
+        IntSet *pSetVals;
+        int firstWord, lastWord;
+        HASHMAP_FOREACH(slot, pmapUserCondValue) {
+            pSetVals = *(IntSet **)HashMapSlotValue(pmapUserCondValue, slot);
+            store->condAttrs[cond] = *(int *)HashMapSlotKey(pmapUserCondValue, slot);
+            store->condWordBegin[cond] = word;
+            store->condFirstWord[cond] = 0;
+            if (wordRange(pSetVals, &firstWord, &lastWord)) {
+                memset(store->words + word, 0, (lastWord - firstWord + 1) * sizeof(unsigned long long));
+                INTSET_FOREACH(val, pSetVals) {
+                    store->words[word + wordOf(val) - firstWord] |= 1ULL << bitOf(val);
+                }
+                store->condFirstWord[cond] = firstWord;
+                word += lastWord - firstWord + 1;
+            }
+            store->condWordEnd[cond] = word;
+            cond++;
+        }
+    }
+    store->condEnd[ruleIdx] = cond;
+}
+
+static RuleStore *Create(Vector *pVecRules) {
+    RuleStore *store = (RuleStore *)calloc(1, sizeof(RuleStore));
+    if (store == NULL) {
+        logAABAC(__func__, __LINE__, 0, ERROR, "Failed to allocate memory for rule store\n");
+        return NULL;
+    }
+    int nRules = iVector.Size(pVecRules);
+    store->nRules = nRules;
+    store->targetAttrs = (int *)reallocOrDie(NULL, (nRules + 1) * sizeof(int));
+    store->targetValues = (int *)reallocOrDie(NULL, (nRules + 1) * sizeof(int));
+    store->condBegin = (int *)reallocOrDie(NULL, (nRules + 1) * sizeof(int));
+    store->condEnd = (int *)reallocOrDie(NULL, (nRules + 1) * sizeof(int));
+
+    // Size the entry and word arrays exactly, then fill them in one pass
+    int ruleIdx, nConds, nWords, totalConds = 0, totalWords = 0;
+    for (ruleIdx = 0; ruleIdx < nRules; ruleIdx++) {
+        measureRule((Rule *)iVector.GetElement(pVecRules, ruleIdx), &nConds, &nWords);
+        totalConds += nConds;
+        totalWords += nWords;
+    }
+    reserve(store, totalConds, totalWords);
+    Rule *r;
+    for (ruleIdx = 0; ruleIdx < nRules; ruleIdx++) {
+        r = (Rule *)iVector.GetElement(pVecRules, ruleIdx);
+        measureRule(r, &nConds, &nWords);
+        writeRule(store, ruleIdx, r, store->nConds, store->nWords);
+        store->nConds += nConds;
+        store->nWords += nWords;
+    }
+    logAABAC(__func__, __LINE__, 0, DEBUG, "compiled %d rules into %d condition entries and %d bitmap words\n", nRules, store->nConds, store->nWords);
+    return store;
+}
+
+static RuleStore *Clone(RuleStore *store) {
+    RuleStore *newStore = (RuleStore *)calloc(1, sizeof(RuleStore));
+    if (newStore == NULL) {
+        logAABAC(__func__, __LINE__, 0, ERROR, "Failed to allocate memory for rule store\n");
+        return NULL;
+    }
+    int nRules = store->nRules;
+    newStore->nRules = nRules;
+    newStore->targetAttrs = (int *)reallocOrDie(NULL, (nRules + 1) * sizeof(int));
+    newStore->targetValues = (int *)reallocOrDie(NULL, (nRules + 1) * sizeof(int));
+    newStore->condBegin = (int *)reallocOrDie(NULL, (nRules + 1) * sizeof(int));
+    newStore->condEnd = (int *)reallocOrDie(NULL, (nRules + 1) * sizeof(int));
+    memcpy(newStore->targetAttrs, store->targetAttrs, nRules * sizeof(int));
+    memcpy(newStore->targetValues, store->targetValues, nRules * sizeof(int));
+    memcpy(newStore->condBegin, store->condBegin, nRules * sizeof(int));
+    memcpy(newStore->condEnd, store->condEnd, nRules * sizeof(int));
+    reserve(newStore, store->nConds, store->nWords);
+    memcpy(newStore->condAttrs, store->condAttrs, store->nConds * sizeof(int));
+    memcpy(newStore->condFirstWord, store->condFirstWord, store->nConds * sizeof(int));
+    memcpy(newStore->condWordBegin, store->condWordBegin, store->nConds * sizeof(int));
+    memcpy(newStore->condWordEnd, store->condWordEnd, store->nConds * sizeof(int));
+    memcpy(newStore->words, store->words, store->nWords * sizeof(unsigned long long));
+    newStore->nConds = store->nConds;
+    newStore->nWords = store->nWords;
+    return newStore;
+}
+
+/**
+ * Recompile a rule. Discretizing a condition only narrows it, so the new entries normally fit into the
+ * room of the old ones and are written in place; otherwise they are appended at the tail of the store.
+ */
+static void Update(RuleStore *store, int ruleIdx, Rule *r) {
+    if (ruleIdx < 0 || ruleIdx >= store->nRules) {
+        logAABAC(__func__, __LINE__, 0, ERROR, "rule index out of range: %d (size: %d)\n", ruleIdx, store->nRules);
+        exit(-1);
+    }
+    int nConds, nWords;
+    measureRule(r, &nConds, &nWords);
+    int begin = store->condBegin[ruleIdx], end = store->condEnd[ruleIdx];
+    int oldWords = end > begin ? store->condWordEnd[end - 1] - store->condWordBegin[begin] : 0;
+    if (nConds <= end - begin && nWords <= oldWords) {
+        writeRule(store, ruleIdx, r, begin, end > begin ? store->condWordBegin[begin] : 0);
+        return;
+    }
+    reserve(store, nConds, nWords);
+    writeRule(store, ruleIdx, r, store->nConds, store->nWords);
+    store->nConds += nConds;
+    store->nWords += nWords;
+}
+
+/**
+ * Check whether the bitmap of a condition entry shares a value with an IntSet.
+ */
+static int intersects(RuleStore *store, int cond, IntSet *pSetVals) {
+    int firstWord = store->condFirstWord[cond];
+    int nWords = store->condWordEnd[cond] - store->condWordBegin[cond];
+    unsigned long long *words = store->words + store->condWordBegin[cond];
+    if (pSetVals->words != NULL) {
+        // Both are bitmaps, AND the overlapping words
+        int from = firstWord > pSetVals->firstWord ? firstWord : pSetVals->firstWord;
+        int to = firstWord + nWords < pSetVals->firstWord + pSetVals->nWords ? firstWord + nWords : pSetVals->firstWord + pSetVals->nWords;
+        int w;
+        for (w = from; w < to; w++) {
+            if (words[w - firstWord] & pSetVals->words[w - pSetVals->firstWord]) {
+                return 1;
+            }
+        }
+        return 0;
+    }
+    int i, w;
+    for (i = 0; i < pSetVals->size; i++) {
+        w = wordOf(pSetVals->elements[i]) - firstWord;
+        if (w >= 0 && w < nWords && (words[w] >> bitOf(pSetVals->elements[i]) & 1)) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+static int Allows(RuleStore *store, int cond, int value) {
+    int w = wordOf(value) - store->condFirstWord[cond];
+    if (w < 0 || w >= store->condWordEnd[cond] - store->condWordBegin[cond]) {
+        return 0;
+    }
+    return (store->words[store->condWordBegin[cond] + w] >> bitOf(value)) & 1;
+}
+
+static int CountValues(RuleStore *store, int cond) {
+    int w, count = 0;
+    for (w = store->condWordBegin[cond]; w < store->condWordEnd[cond]; w++) {
+        count += __builtin_popcountll(store->words[w]);
+    }
+    return count;
+}
+
+static int IsEffective(RuleStore *store, int ruleIdx, HashMap *reachableAVs) {
+    IntSet **ppReachableValues;
+    RULESTORE_COND_FOREACH(cond, store, ruleIdx) {
+        // 每个条件属性至少有一个取值可达
+        ppReachableValues = iHashMap.Get(reachableAVs, &store->condAttrs[cond]);
+        if (ppReachableValues == NULL || !intersects(store, cond, *ppReachableValues)) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+static int CanBeManaged(RuleStore *store, int ruleIdx, HashMap *userState) {
+    int *pUserAttrVal;
+    RULESTORE_COND_FOREACH(cond, store, ruleIdx) {
+        pUserAttrVal = iHashMap.Get(userState, &store->condAttrs[cond]);
+        if (pUserAttrVal == NULL || !Allows(store, cond, *pUserAttrVal)) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+static void Finalize(RuleStore *store) {
+    if (store == NULL) {
+        return;
+    }
+    free(store->targetAttrs);
+    free(store->targetValues);
+    free(store->condBegin);
+    free(store->condEnd);
+    free(store->condAttrs);
+    free(store->condFirstWord);
+    free(store->condWordBegin);
+    free(store->condWordEnd);
+    free(store->words);
+    free(store);
+}
+
+/**
+ * Write the arrays of the store, compacted, in the order nRules, nConds, nWords, the per-rule arrays,
+ * the per-entry arrays and the bitmap words. All counts and indices are native ints.
+ */
+static int Save(RuleStore *store, FILE *fp) {
+    int nRules = store->nRules, nConds = 0, nWords = 0, ruleIdx, cond, begin, nCondWords;
+    for (ruleIdx = 0; ruleIdx < nRules; ruleIdx++) {
+        nConds += store->condEnd[ruleIdx] - store->condBegin[ruleIdx];
+        RULESTORE_COND_FOREACH(cond, store, ruleIdx) {
+            nWords += store->condWordEnd[cond] - store->condWordBegin[cond];
+        }
+    }
+    int header[3] = {nRules, nConds, nWords};
+    int *condBegin = (int *)malloc((nRules + 1) * sizeof(int));
+    int *condEnd = (int *)malloc((nRules + 1) * sizeof(int));
+    int *condWordBegin = (int *)malloc((nConds + 1) * sizeof(int));
+    int *condWordEnd = (int *)malloc((nConds + 1) * sizeof(int));
+    int *condAttrs = (int *)malloc((nConds + 1) * sizeof(int));
+    int *condFirstWord = (int *)malloc((nConds + 1) * sizeof(int));
+    unsigned long long *words = (unsigned long long *)malloc((nWords + 1) * sizeof(unsigned long long));
+    int iCond = 0, iWord = 0;
+    for (ruleIdx = 0; ruleIdx < nRules; ruleIdx++) {
+        begin = iCond;
+        for (cond = store->condBegin[ruleIdx]; cond < store->condEnd[ruleIdx]; cond++) {
+            condAttrs[iCond] = store->condAttrs[cond];
+            condFirstWord[iCond] = store->condFirstWord[cond];
+            nCondWords = store->condWordEnd[cond] - store->condWordBegin[cond];
+            memcpy(words + iWord, store->words + store->condWordBegin[cond], nCondWords * sizeof(unsigned long long));
+            condWordBegin[iCond] = iWord;
+            iWord += nCondWords;
+            condWordEnd[iCond] = iWord;
+            iCond++;
+        }
+        condBegin[ruleIdx] = begin;
+        condEnd[ruleIdx] = iCond;
+    }
+    int ok = fwrite(header, sizeof(int), 3, fp) == 3 &&
+             fwrite(store->targetAttrs, sizeof(int), nRules, fp) == (size_t)nRules &&
+             fwrite(store->targetValues, sizeof(int), nRules, fp) == (size_t)nRules &&
+             fwrite(condBegin, sizeof(int), nRules, fp) == (size_t)nRules &&
+             fwrite(condEnd, sizeof(int), nRules, fp) == (size_t)nRules &&
+             fwrite(condAttrs, sizeof(int), nConds, fp) == (size_t)nConds &&
+             fwrite(condFirstWord, sizeof(int), nConds, fp) == (size_t)nConds &&
+             fwrite(condWordBegin, sizeof(int), nConds, fp) == (size_t)nConds &&
+             fwrite(condWordEnd, sizeof(int), nConds, fp) == (size_t)nConds &&
+             fwrite(words, sizeof(unsigned long long), nWords, fp) == (size_t)nWords;
+    free(condBegin);
+    free(condEnd);
+    free(condWordBegin);
+    free(condWordEnd);
+    free(condAttrs);
+    free(condFirstWord);
+    free(words);
+    return ok ? 0 : -1;
+}
+
+/**
+ * Copy @{n} items of @{itemSize} bytes from the data into a new array and advance the cursor.
+ *
+ * @return The array, or NULL if the data is too short
+ */
+static void *takeArray(const char **pCur, const char *end, int n, size_t itemSize) {
+    size_t size = (size_t)n * itemSize;
+    if (n < 0 || (size_t)(end - *pCur) < size) {
+        return NULL;
+    }
+    void *array = reallocOrDie(NULL, size + itemSize);
+    memcpy(array, *pCur, size);
+    *pCur += size;
+    return array;
+}
+
+/**
+ * Check that the condition ranges of every rule and the bitmap ranges of every condition stay
+ * inside the arrays of the store, and that every value a bitmap can hold fits in an int.
+ */
+static int IsWellFormed(RuleStore *store) {
+    int i;
+    if (store->nRules < 0 || store->nConds < 0 || store->nWords < 0 || store->nWords > INT_MAX / RULESTORE_WORD_BITS) {
+        return 0;
+    }
+    for (i = 0; i < store->nRules; i++) {
+        if (store->condBegin[i] < 0 || store->condBegin[i] > store->condEnd[i] || store->condEnd[i] > store->nConds) {
+            return 0;
+        }
+    }
+    long long first, last;
+    for (i = 0; i < store->nConds; i++) {
+        if (store->condWordBegin[i] < 0 || store->condWordBegin[i] > store->condWordEnd[i] || store->condWordEnd[i] > store->nWords) {
+            return 0;
+        }
+        // 位图中最小与最大的取值
+        first = (long long)store->condFirstWord[i] * RULESTORE_WORD_BITS;
+        last = ((long long)store->condFirstWord[i] + store->condWordEnd[i] - store->condWordBegin[i]) * RULESTORE_WORD_BITS - 1;
+        if (first < INT_MIN || last > INT_MAX) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+static RuleStore *Load(const void *data, size_t size, size_t *pConsumed) {
+    const char *cur = (const char *)data, *end = cur + size;
+    int *header = (int *)takeArray(&cur, end, 3, sizeof(int));
+    if (header == NULL) {
+        return NULL;
+    }
+    RuleStore *store = (RuleStore *)calloc(1, sizeof(RuleStore));
+    int nRules = header[0], nConds = header[1], nWords = header[2];
+    free(header);
+    store->nRules = nRules;
+    store->targetAttrs = (int *)takeArray(&cur, end, nRules, sizeof(int));
+    store->targetValues = (int *)takeArray(&cur, end, nRules, sizeof(int));
+    store->condBegin = (int *)takeArray(&cur, end, nRules, sizeof(int));
+    store->condEnd = (int *)takeArray(&cur, end, nRules, sizeof(int));
+    store->condAttrs = (int *)takeArray(&cur, end, nConds, sizeof(int));
+    store->condFirstWord = (int *)takeArray(&cur, end, nConds, sizeof(int));
+    store->condWordBegin = (int *)takeArray(&cur, end, nConds, sizeof(int));
+    store->condWordEnd = (int *)takeArray(&cur, end, nConds, sizeof(int));
+    store->words = (unsigned long long *)takeArray(&cur, end, nWords, sizeof(unsigned long long));
+    store->nConds = store->condCapacity = nConds;
+    store->nWords = store->wordCapacity = nWords;
+    if (store->targetAttrs == NULL || store->targetValues == NULL || store->condBegin == NULL || store->condEnd == NULL ||
+        store->condAttrs == NULL || store->condFirstWord == NULL || store->condWordBegin == NULL || store->condWordEnd == NULL ||
+        store->words == NULL) {
+        logAABAC(__func__, __LINE__, 0, ERROR, "the rule store is truncated\n");
+        Finalize(store);
+        return NULL;
+    }
+    if (!IsWellFormed(store)) {
+        logAABAC(__func__, __LINE__, 0, ERROR, "the rule store is corrupted\n");
+        Finalize(store);
+        return NULL;
+    }
+    *pConsumed = cur - (const char *)data;
+    return store;
+}
+
+RuleStoreInterface iRuleStore = {
+    .Create = Create,
+    .Clone = Clone,
+    .Update = Update,
+    .IsEffective = IsEffective,
+    .CanBeManaged = CanBeManaged,
+    .Allows = Allows,
+    .CountValues = CountValues,
+    .Save = Save,
+    .Load = Load,
+    .Finalize = Finalize,
+};
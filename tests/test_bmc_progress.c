@@ -0,0 +1,64 @@
+/*
+ * Round trip of the BMC progress file read by -resume: lengths appended with saveBMCProgress must be read back by
+ * loadBMCProgress, the deepest one for each model fingerprint.
+ *
+ * usage: test_bmc_progress <work dir>
+ */
+#include <stdio.h>
+#include <string.h>
+
+#include "NuSMVRunner.h"
+
+#define CHECK(cond)                                                                  \
+    do {                                                                             \
+        if (!(cond)) {                                                               \
+            fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond); \
+            return 1;                                                                \
+        }                                                                            \
+    } while (0)
+
+int main(int argc, char *argv[]) {
+    if (argc != 2) {
+        fprintf(stderr, "usage: %s <work dir>\n", argv[0]);
+        return 2;
+    }
+    char path[4096], line[64];
+    snprintf(path, sizeof(path), "%s/bmcProgress.txt", argv[1]);
+    remove(path);
+
+    unsigned long long model1 = 0xdeadbeefULL, model2 = 0xfedcba9876543210ULL, model3 = 1;
+    CHECK(loadBMCProgress(path, model1) == -1);
+
+    // a model may be recorded several times, not necessarily in increasing order
+    CHECK(saveBMCProgress(path, model1, 3) == 0);
+    CHECK(saveBMCProgress(path, model2, 0) == 0);
+    CHECK(saveBMCProgress(path, model1, 12) == 0);
+    CHECK(saveBMCProgress(path, model1, 7) == 0);
+    CHECK(saveBMCProgress(path, model2, 2147483647) == 0);
+
+    CHECK(loadBMCProgress(path, model1) == 12);
+    CHECK(loadBMCProgress(path, model2) == 2147483647);
+    CHECK(loadBMCProgress(path, model3) == -1);
+
+    // one "<fingerprint> <length>" line per record, the fingerprint in 16 hexadecimal digits
+    FILE *fp = fopen(path, "r");
+    CHECK(fp != NULL);
+    CHECK(fgets(line, sizeof(line), fp) != NULL);
+    CHECK(strcmp(line, "00000000deadbeef 3\n") == 0);
+    CHECK(fgets(line, sizeof(line), fp) != NULL);
+    CHECK(strcmp(line, "fedcba9876543210 0\n") == 0);
+    fclose(fp);
+
+    // a file written by hand, with upper-case digits and without leading zeros, is read the same way
+    fp = fopen(path, "w");
+    CHECK(fp != NULL);
+    fprintf(fp, "DEADBEEF 5\n1 9\n");
+    fclose(fp);
+    CHECK(loadBMCProgress(path, model1) == 5);
+    CHECK(loadBMCProgress(path, model3) == 9);
+    CHECK(loadBMCProgress(path, model2) == -1);
+
+    remove(path);
+    printf("bmc progress round trip passed\n");
+    return 0;
+}
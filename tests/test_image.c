@@ -0,0 +1,239 @@
+/*
+ * Round trip of the binary image format: a policy is read and initialized, written with writeAABACImage and
+ * loaded back with readAABACImage. The loaded instance must print the same policy (up to the iteration order of
+ * the hash tables), an image of it must load to the same policy again, and a truncated image or an image with
+ * an index out of range must be rejected.
+ *
+ * usage: test_image <policy.aabac> <work dir>
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "AABACIO.h"
+
+#define CHECK(cond)                                                                  \
+    do {                                                                             \
+        if (!(cond)) {                                                               \
+            fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond); \
+            return 1;                                                                \
+        }                                                                            \
+    } while (0)
+
+static char *readFile(char *path, long *pSize) {
+    FILE *fp = fopen(path, "rb");
+    if (fp == NULL) {
+        return NULL;
+    }
+    fseek(fp, 0, SEEK_END);
+    long size = ftell(fp);
+    fseek(fp, 0, SEEK_SET);
+    char *data = (char *)malloc(size + 1);
+    if (fread(data, 1, size, fp) != (size_t)size) {
+        free(data);
+        fclose(fp);
+        return NULL;
+    }
+    data[size] = '\0';
+    fclose(fp);
+    *pSize = size;
+    return data;
+}
+
+static int compareStrings(const void *a, const void *b) {
+    return strcmp(*(char **)a, *(char **)b);
+}
+
+/*
+ * Sort the pieces of a string separated by sep in place. The first skip pieces keep their place. Lists printed from
+ * hash tables then compare equal whatever their iteration order
+ */
+static void sortPieces(char *s, char *sep, int skip) {
+    char *pieces[1024], *buffer = (char *)malloc(strlen(s) + 1), *p, *next;
+    int n = 0;
+    size_t sepLen = strlen(sep);
+    strcpy(buffer, s);
+    for (p = buffer; n < 1024; p = next + sepLen) {
+        pieces[n++] = p;
+        if ((next = strstr(p, sep)) == NULL) {
+            break;
+        }
+        *next = '\0';
+    }
+    if (n > skip) {
+        qsort(pieces + skip, n - skip, sizeof(char *), compareStrings);
+    }
+    s[0] = '\0';
+    for (int i = 0; i < n; i++) {
+        strcat(s, pieces[i]);
+        if (i + 1 < n) {
+            strcat(s, sep);
+        }
+    }
+    free(buffer);
+}
+
+/*
+ * Normalize a line written by writeAABACInstance in place: the ';' ending a section is dropped, the atoms of each
+ * condition, the fields after the first of a tuple (the attribute-value pairs of the query), the entries of a rule
+ * comment and the words of a list are sorted
+ */
+static void normalizeLine(char *line) {
+    size_t len = strlen(line);
+    char *comment, *end;
+    if (len > 0 && line[len - 1] == ';') {
+        line[--len] = '\0';
+    }
+    if ((comment = strstr(line, "\t/*{")) != NULL) {
+        // rule comment: /*{attr=[values], ...}*/
+        if ((end = strstr(comment, "}*/")) != NULL && end[-1] == ']') {
+            end[-1] = '\0';
+            sortPieces(comment + 4, "], ", 0);
+            end[-1] = ']';
+        }
+        *comment = '\0';
+        len = strlen(line);
+    }
+    if (len >= 2 && line[0] == '(' && line[len - 1] == ')') {
+        char *fields[64], *p, *next;
+        int n = 0;
+        line[len - 1] = '\0';
+        for (p = line + 1; n < 64; p = next + 2) {
+            fields[n++] = p;
+            if ((next = strstr(p, ", ")) == NULL) {
+                break;
+            }
+            *next = '\0';
+        }
+        for (int i = 0; i < n; i++) {
+            sortPieces(fields[i], " & ", 0);
+        }
+        for (int i = 0; i + 1 < n; i++) {
+            fields[i][strlen(fields[i])] = ',';
+        }
+        sortPieces(line + 1, ", ", 1);
+        line[len - 1] = ')';
+    } else {
+        sortPieces(line, " ", 0);
+    }
+    if (comment != NULL) {
+        *comment = '\t';
+    }
+}
+
+/* Read a policy written by writeAABACInstance as a sorted list of normalized lines */
+static char **readNormalized(char *path, int *pCount) {
+    long size;
+    char *data = readFile(path, &size);
+    if (data == NULL) {
+        return NULL;
+    }
+    int capacity = 64, n = 0;
+    char **lines = (char **)malloc(capacity * sizeof(char *));
+    for (char *line = strtok(data, "\n"); line != NULL; line = strtok(NULL, "\n")) {
+        if (n == capacity) {
+            capacity *= 2;
+            lines = (char **)realloc(lines, capacity * sizeof(char *));
+        }
+        lines[n] = (char *)malloc(strlen(line) + 1);
+        strcpy(lines[n], line);
+        normalizeLine(lines[n++]);
+    }
+    free(data);
+    qsort(lines, n, sizeof(char *), compareStrings);
+    *pCount = n;
+    return lines;
+}
+
+static int samePolicies(char *path1, char *path2) {
+    int n1, n2, same;
+    char **lines1 = readNormalized(path1, &n1), **lines2 = readNormalized(path2, &n2);
+    same = lines1 != NULL && lines2 != NULL && n1 == n2;
+    for (int i = 0; same && i < n1; i++) {
+        if (strcmp(lines1[i], lines2[i]) != 0) {
+            fprintf(stderr, "policies differ:\n  %s\n  %s\n", lines1[i], lines2[i]);
+            same = 0;
+        }
+    }
+    for (int i = 0; lines1 != NULL && i < n1; i++) {
+        free(lines1[i]);
+    }
+    for (int i = 0; lines2 != NULL && i < n2; i++) {
+        free(lines2[i]);
+    }
+    free(lines1);
+    free(lines2);
+    return same;
+}
+
+int main(int argc, char *argv[]) {
+    if (argc != 3) {
+        fprintf(stderr, "usage: %s <policy.aabac> <work dir>\n", argv[0]);
+        return 2;
+    }
+    char imagePath[4096], image2Path[4096], textPath[4096], text2Path[4096], truncatedPath[4096];
+    snprintf(imagePath, sizeof(imagePath), "%s/image.aabacb", argv[2]);
+    snprintf(image2Path, sizeof(image2Path), "%s/image2.aabacb", argv[2]);
+    snprintf(textPath, sizeof(textPath), "%s/policy.aabac", argv[2]);
+    snprintf(text2Path, sizeof(text2Path), "%s/policy2.aabac", argv[2]);
+    snprintf(truncatedPath, sizeof(truncatedPath), "%s/truncated.aabacb", argv[2]);
+
+    AABACInstance *pInst = readAABACInstance(argv[1]);
+    CHECK(pInst != NULL);
+    init(pInst);
+    CHECK(writeAABACInstance(pInst, textPath) == 0);
+    CHECK(writeAABACImage(pInst, imagePath) == 0);
+
+    AABACInstance *pLoaded = readAABACImage(imagePath);
+    CHECK(pLoaded != NULL);
+    CHECK(writeAABACInstance(pLoaded, text2Path) == 0);
+    CHECK(samePolicies(textPath, text2Path));
+    // an image of the loaded instance holds the same policy again
+    CHECK(writeAABACImage(pLoaded, image2Path) == 0);
+    AABACInstance *pReloaded = readAABACImage(image2Path);
+    CHECK(pReloaded != NULL);
+    CHECK(writeAABACInstance(pReloaded, text2Path) == 0);
+    CHECK(samePolicies(textPath, text2Path));
+
+    // every proper prefix of the image is incomplete
+    long size;
+    char *image = readFile(imagePath, &size);
+    CHECK(image != NULL && size > 0);
+    long cuts[] = {0, 1, size / 2, size - 1};
+    for (int i = 0; i < (int)(sizeof(cuts) / sizeof(cuts[0])); i++) {
+        FILE *fp = fopen(truncatedPath, "wb");
+        CHECK(fp != NULL);
+        CHECK(fwrite(image, 1, cuts[i], fp) == (size_t)cuts[i]);
+        fclose(fp);
+        CHECK(readAABACImage(truncatedPath) == NULL);
+    }
+
+    // an index past the end of its table is rejected: the image ends with a rule index of Precond2Rule
+    // (or the cell count of an empty table), and every other int is overwritten in turn to make sure
+    // that no corrupted field crashes the loader
+    int *ints = (int *)image;
+    for (long i = size / (long)sizeof(int) - 1; i >= 4; i--) {
+        int saved = ints[i];
+        ints[i] = 0x7fff0000;
+        FILE *fp = fopen(truncatedPath, "wb");
+        CHECK(fp != NULL);
+        CHECK(fwrite(image, 1, size, fp) == (size_t)size);
+        fclose(fp);
+        AABACInstance *pCorrupted = readAABACImage(truncatedPath);
+        if (i == size / (long)sizeof(int) - 1) {
+            CHECK(pCorrupted == NULL);
+        } else if (pCorrupted != NULL) {
+            finalizeAABACInstance(pCorrupted);
+        }
+        ints[i] = saved;
+    }
+    free(image);
+    // a rejected image leaves nothing behind that keeps a valid one from loading
+    pReloaded = readAABACImage(imagePath);
+    CHECK(pReloaded != NULL);
+    CHECK(writeAABACInstance(pReloaded, text2Path) == 0);
+    CHECK(samePolicies(textPath, text2Path));
+
+    printf("image round trip of %s passed\n", argv[1]);
+    return 0;
+}